@@ -0,0 +1,409 @@
+//*****************************************************************************
+// bench.c
+//
+// Benchmark suite: fixed, seeded workloads timed with the performance clock
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw_mb.h"
+#include "perf_clock.h"
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "miner.h"
+#include "miner_mt.h"
+#include "bench.h"
+
+//
+// Message data, filled from a fixed seed so every run hashes the same bytes.
+//
+static uint32_t g_pui32Message[BENCH_HASH_MAX / 4];
+
+//
+// Transactions of the generated blocks.
+//
+static char g_pcTx[BLOCK_TX_LEN + 1];
+
+static tBenchReport g_pfnReport;
+static void *g_pvReportArg;
+
+static void
+BenchReport(const char *pcCase, const char *pcParam, uint32_t ui32Size,
+            uint64_t ui64Count, uint64_t ui64Work, uint64_t ui64Ticks,
+            const char *pcUnit)
+{
+    tBenchResult sResult;
+
+    sResult.pcCase = pcCase;
+    sResult.pcParam = pcParam;
+    sResult.ui32Size = ui32Size;
+    sResult.ui64Count = ui64Count;
+    sResult.ui64Ticks = ui64Ticks;
+    sResult.ui64Rate = PerfClockRate(ui64Work, ui64Ticks);
+    sResult.pcUnit = pcUnit;
+    g_pfnReport(&sResult, g_pvReportArg);
+}
+
+//
+// Transaction i of the workload: the same text on every run.
+//
+static const char *
+BenchTx(uint32_t ui32Index)
+{
+    snprintf(g_pcTx, sizeof(g_pcTx), "tx%08u",
+             (unsigned int)(ui32Index % 100000000));
+
+    return g_pcTx;
+}
+
+//*****************************************************************************
+//
+//! Hash each message size with each algorithm. The engine without HMAC
+//! support (the software one) skips the HMAC modes.
+//!
+//! \param ui32Scale multiplies the bytes hashed per size
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+BenchHash(uint32_t ui32Scale)
+{
+    static const uint32_t pui32Sizes[] = BENCH_HASH_SIZES;
+    uint8_t pui8Digest[HASH_MAX_DIGEST_LEN];
+    const tHashAlgo *psAlgo;
+    uint32_t ui32Algo, ui32Size, ui32Count, ui32Idx;
+    uint64_t ui64Ticks;
+
+    for(ui32Algo = 0; ui32Algo < HashAlgoCount(); ui32Algo++)
+    {
+        psAlgo = HashAlgoAt(ui32Algo);
+        if(psAlgo->bHMAC && (g_psHashEngine == &g_sHashEngineSW))
+        {
+            continue;
+        }
+        for(ui32Size = 0;
+            ui32Size < (sizeof(pui32Sizes) / sizeof(pui32Sizes[0]));
+            ui32Size++)
+        {
+            ui32Count = (BENCH_HASH_BYTES / pui32Sizes[ui32Size]) * ui32Scale;
+            ui64Ticks = PerfClockNow();
+            for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+            {
+                GenerateHash(psAlgo->ui32Config,
+                             (unsigned char *)g_pui32Message, pui8Digest,
+                             pui32Sizes[ui32Size]);
+            }
+            ui64Ticks = PerfClockNow() - ui64Ticks;
+            BenchReport("hash", psAlgo->pcName, pui32Sizes[ui32Size],
+                        ui32Count,
+                        (uint64_t)ui32Count * pui32Sizes[ui32Size],
+                        ui64Ticks, "B/s");
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Block production: one-transaction blocks through gen_block(), and full
+//! blocks through the builder, which also maintains the Merkle tree. Every
+//! block is freed again, so the pool only ever holds one.
+//!
+//! \param psTip is the parent of every block made
+//! \param ui32Scale multiplies the block count
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+BenchBlocks(struct Block *psTip, uint32_t ui32Scale)
+{
+    static struct BlockBuilder sBuilder;
+    uint32_t ui32Count = 256 * ui32Scale;
+    uint32_t ui32Idx, ui32Tx;
+    uint64_t ui64Ticks;
+
+    ui64Ticks = PerfClockNow();
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        BlockPoolFree(gen_block(psTip, (char *)BenchTx(ui32Idx)));
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    BenchReport("block_gen", "1tx", BLOCK_TX_LEN, ui32Count, ui32Count,
+                ui64Ticks, "blocks/s");
+
+    ui64Ticks = PerfClockNow();
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        block_begin(&sBuilder, psTip);
+        for(ui32Tx = 0; ui32Tx < BLOCK_MAX_TX; ui32Tx++)
+        {
+            block_add_tx(&sBuilder, (const unsigned char *)BenchTx(ui32Tx),
+                         BLOCK_TX_LEN);
+        }
+        BlockPoolFree(block_seal(&sBuilder));
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    BenchReport("block_build", "full", BLOCK_DATA_LEN, ui32Count, ui32Count,
+                ui64Ticks, "blocks/s");
+}
+
+//*****************************************************************************
+//
+//! Batch block production: runs of single-transaction blocks through
+//! gen_blocks() at each run length, all on one parent. Every run is freed
+//! again.
+//!
+//! \param psTip is the parent of every run
+//! \param ui32Scale multiplies the block count
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+BenchBatch(struct Block *psTip, uint32_t ui32Scale)
+{
+    static const uint32_t pui32Sizes[] = BENCH_BATCH_SIZES;
+    static char ppcTx[BENCH_BATCH_MAX][BLOCK_TX_LEN + 1];
+    static char *ppcData[BENCH_BATCH_MAX];
+    static struct Block *ppsRun[BENCH_BATCH_MAX];
+    char pcSize[8];
+    uint32_t ui32Size, ui32Runs, ui32Run, ui32Made, ui32Idx;
+    uint64_t ui64Ticks, ui64Blocks;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_BATCH_MAX; ui32Idx++)
+    {
+        memcpy(ppcTx[ui32Idx], BenchTx(ui32Idx), sizeof(ppcTx[ui32Idx]));
+        ppcData[ui32Idx] = ppcTx[ui32Idx];
+    }
+
+    for(ui32Size = 0;
+        ui32Size < (sizeof(pui32Sizes) / sizeof(pui32Sizes[0]));
+        ui32Size++)
+    {
+        ui32Runs = (256 * ui32Scale) / pui32Sizes[ui32Size];
+        ui64Blocks = 0;
+        ui64Ticks = PerfClockNow();
+        for(ui32Run = 0; ui32Run < ui32Runs; ui32Run++)
+        {
+            ui32Made = gen_blocks(psTip, ppcData, pui32Sizes[ui32Size],
+                                  ppsRun);
+            for(ui32Idx = 0; ui32Idx < ui32Made; ui32Idx++)
+            {
+                BlockPoolFree(ppsRun[ui32Idx]);
+            }
+            ui64Blocks += ui32Made;
+        }
+        ui64Ticks = PerfClockNow() - ui64Ticks;
+        snprintf(pcSize, sizeof(pcSize), "%u",
+                 (unsigned int)pui32Sizes[ui32Size]);
+        BenchReport("block_batch", pcSize, BLOCK_TX_LEN, ui64Blocks,
+                    ui64Blocks, ui64Ticks, "blocks/s");
+    }
+}
+
+//*****************************************************************************
+//
+//! Verification of one block against its parent, and of the whole retained
+//! window in one pass
+//!
+//! \param psStore is a full store
+//! \param ui32Scale multiplies the repetitions
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+BenchVerify(tChainStore *psStore, uint32_t ui32Scale)
+{
+    struct Block *psTip = ChainStoreTip(psStore);
+    struct Block *psPrev;
+    uint32_t ui32Count, ui32Idx, ui32Bad;
+    uint64_t ui64Ticks;
+
+    psPrev = ChainStoreGet(psStore, psTip->header.height - 1);
+    ui32Count = 1024 * ui32Scale;
+    ui64Ticks = PerfClockNow();
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        verify_block(psTip, psPrev);
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    BenchReport("verify_block", "full", BLOCK_DATA_LEN, ui32Count, ui32Count,
+                ui64Ticks, "blocks/s");
+
+    ui32Count = 8 * ui32Scale;
+    ui64Ticks = PerfClockNow();
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        ChainStoreVerify(psStore, &ui32Bad);
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    BenchReport("verify_chain", "window", ChainStoreCount(psStore), ui32Count,
+                (uint64_t)ui32Count * ChainStoreCount(psStore), ui64Ticks,
+                "blocks/s");
+}
+
+//*****************************************************************************
+//
+//! Nonce search over a fixed number of nonces, against a target no hash can
+//! meet so that the work never ends early
+//!
+//! \param psTip is the block whose header is searched
+//! \param ui32Scale multiplies the nonce count
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+BenchMine(struct Block *psTip, uint32_t ui32Scale)
+{
+    uint8_t pui8Target[BLOCK_HASH_LEN];
+    uint32_t ui32Count = 65536 * ui32Scale;
+    tMinerResult sResult;
+    tMiner sMiner;
+    uint64_t ui64Ticks;
+
+    memset(pui8Target, 0, sizeof(pui8Target));
+    MinerPrepare(&sMiner, &psTip->header);
+
+    ui64Ticks = PerfClockNow();
+    MinerSearch(&sMiner, pui8Target, 0, ui32Count, &sResult);
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    BenchReport("mine", "1", 0, ui32Count, ui32Count, ui64Ticks, "H/s");
+
+#if !defined(cc3200)
+    {
+        char pcThreads[16];
+
+        snprintf(pcThreads, sizeof(pcThreads), "mt%u",
+                 (unsigned int)MinerMTGetThreads());
+        ui64Ticks = PerfClockNow();
+        MinerMTSearch(&sMiner, pui8Target, 0, ui32Count * 4, &sResult);
+        ui64Ticks = PerfClockNow() - ui64Ticks;
+        BenchReport("mine", pcThreads, 0, ui32Count * 4,
+                    (uint64_t)ui32Count * 4, ui64Ticks, "H/s");
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+//! Run the suite. It takes over the block pool and the given store: both
+//! are reset at the start and again at the end.
+//!
+//! \param psStore is a store to build the benchmark chain in
+//! \param ui32Scale multiplies every workload; results of different scales
+//! measure the same operations
+//! \param pfnReport receives each result as it is measured
+//! \param pvArg is passed to pfnReport
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BenchRun(tChainStore *psStore, uint32_t ui32Scale, tBenchReport pfnReport,
+         void *pvArg)
+{
+    static struct BlockBuilder sBuilder;
+    uint32_t ui32Idx, ui32Tx;
+
+    g_pfnReport = pfnReport;
+    g_pvReportArg = pvArg;
+    if(ui32Scale == 0)
+    {
+        ui32Scale = 1;
+    }
+
+    for(ui32Idx = 0; ui32Idx < (BENCH_HASH_MAX / 4); ui32Idx++)
+    {
+        g_pui32Message[ui32Idx] = (ui32Idx + 1) * 2654435761u;
+    }
+    BenchHash(ui32Scale);
+
+    //
+    // A full window of full blocks for the block and chain workloads.
+    //
+    BlockPoolInit();
+    ChainStoreInit(psStore);
+    ChainStoreAppend(psStore, gen_genesis_block());
+    BenchBatch(ChainStoreTip(psStore), ui32Scale);
+    for(ui32Idx = 1; ui32Idx < CHAIN_STORE_DEPTH; ui32Idx++)
+    {
+        block_begin(&sBuilder, ChainStoreTip(psStore));
+        for(ui32Tx = 0; ui32Tx < BLOCK_MAX_TX; ui32Tx++)
+        {
+            block_add_tx(&sBuilder,
+                         (const unsigned char *)BenchTx((ui32Idx *
+                                                         BLOCK_MAX_TX) +
+                                                        ui32Tx),
+                         BLOCK_TX_LEN);
+        }
+        ChainStoreAppend(psStore, block_seal(&sBuilder));
+    }
+
+    BenchBlocks(ChainStoreTip(psStore), ui32Scale);
+    BenchVerify(psStore, ui32Scale);
+    BenchMine(ChainStoreTip(psStore), ui32Scale);
+
+    BlockPoolInit();
+    ChainStoreInit(psStore);
+}
+
+//*****************************************************************************
+//
+//! Format the line that identifies a run
+//!
+//! \param ui32Scale is the scale of the run
+//! \param pcLine receives the line, without a terminator
+//! \param ui32Max is the size of pcLine
+//!
+//! \return the line length
+//
+//*****************************************************************************
+uint32_t
+BenchFormatInfo(uint32_t ui32Scale, char *pcLine, uint32_t ui32Max)
+{
+    int iLength;
+
+    iLength = snprintf(pcLine, ui32Max, "benchinfo,%u,%s,%s,%lu,%u",
+                       BENCH_FORMAT_VERSION, g_psHashEngine->pcName,
+                       SWSHA256MBKernel()->pcName,
+                       (unsigned long)PERF_CLOCK_HZ, (unsigned int)ui32Scale);
+
+    return ((iLength < 0) || ((uint32_t)iLength >= ui32Max)) ?
+           0 : (uint32_t)iLength;
+}
+
+//*****************************************************************************
+//
+//! Format a result as a CSV line
+//!
+//! \param psResult is the result
+//! \param pcLine receives the line, without a terminator
+//! \param ui32Max is the size of pcLine
+//!
+//! \return the line length
+//
+//*****************************************************************************
+uint32_t
+BenchFormat(const tBenchResult *psResult, char *pcLine, uint32_t ui32Max)
+{
+    int iLength;
+
+    iLength = snprintf(pcLine, ui32Max, "bench,%s,%s,%u,%lu,%lu,%lu,%s",
+                       psResult->pcCase, psResult->pcParam,
+                       (unsigned int)psResult->ui32Size,
+                       (unsigned long)psResult->ui64Count,
+                       (unsigned long)psResult->ui64Ticks,
+                       (unsigned long)psResult->ui64Rate, psResult->pcUnit);
+
+    return ((iLength < 0) || ((uint32_t)iLength >= ui32Max)) ?
+           0 : (uint32_t)iLength;
+}
@@ -0,0 +1,98 @@
+//*****************************************************************************
+// bench.h
+//
+// Benchmark suite over fixed workloads: hashing at several message sizes
+// for every named algorithm, block generation, batch block production at
+// several run lengths, block and chain verification, and mining. Results are
+// reported one record at a time and formatted as CSV lines, so that runs of
+// different firmware builds can be compared by a script.
+//
+// On the host the suite is run by tools/bench. On the board it runs at boot,
+// before the chain is loaded, when BENCH_AT_BOOT is defined in the project
+// settings.
+//
+//*****************************************************************************
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "chain_store.h"
+
+//*****************************************************************************
+//
+// Output format. Bump BENCH_FORMAT_VERSION whenever a column or a workload
+// changes, so that results of different versions are not compared.
+//
+//   benchinfo,<version>,<engine>,<sha256 kernel>,<clock hz>,<scale>
+//   bench,<case>,<param>,<size>,<count>,<ticks>,<rate>,<unit>
+//
+// count is the number of operations timed, ticks their total time in
+// PerfClockNow() ticks, and rate the operations (or bytes, for hashing)
+// per second.
+//
+//*****************************************************************************
+#define BENCH_FORMAT_VERSION    2
+#define BENCH_LINE_MAX          128
+
+//*****************************************************************************
+//
+// Message sizes hashed, and the bytes hashed per size and unit of scale.
+//
+//*****************************************************************************
+#define BENCH_HASH_SIZES        { 16, 64, 256, 1024, 4096 }
+#define BENCH_HASH_MAX          4096
+#define BENCH_HASH_BYTES        65536
+
+//*****************************************************************************
+//
+// Run lengths of batch block production (gen_blocks()). The longest must
+// fit in the block pool beside the genesis block.
+//
+//*****************************************************************************
+#define BENCH_BATCH_SIZES       { 1, 4, 16, 64 }
+#define BENCH_BATCH_MAX         64
+
+typedef struct
+{
+    const char *pcCase;
+    const char *pcParam;
+    uint32_t ui32Size;
+    uint64_t ui64Count;
+    uint64_t ui64Ticks;
+    uint64_t ui64Rate;
+    const char *pcUnit;
+} tBenchResult;
+
+typedef void (*tBenchReport)(const tBenchResult *psResult, void *pvArg);
+
+extern void BenchRun(tChainStore *psStore, uint32_t ui32Scale,
+                     tBenchReport pfnReport, void *pvArg);
+extern uint32_t BenchFormatInfo(uint32_t ui32Scale, char *pcLine,
+                                uint32_t ui32Max);
+extern uint32_t BenchFormat(const tBenchResult *psResult, char *pcLine,
+                            uint32_t ui32Max);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BENCH_H__
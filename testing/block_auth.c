@@ -0,0 +1,171 @@
+//*****************************************************************************
+// block_auth.c
+//
+// Block tags: HMAC-SHA256 of the block hash under the device key, computed
+// by the active engine from precomputed key pad states
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "blockchain.h"
+#include "block_auth.h"
+
+//
+// Hash states after the inner (key ^ 0x36) and outer (key ^ 0x5c) pads.
+//
+static tHashContext g_sInner;
+static tHashContext g_sOuter;
+static bool g_bKeyLoaded;
+
+//*****************************************************************************
+//
+//! Load the device key. Both pad blocks are hashed here, once; the key
+//! itself is not kept.
+//!
+//! \param pui8Key is the key
+//! \param ui32Length is the key length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockAuthLoadKey(const uint8_t *pui8Key, uint32_t ui32Length)
+{
+    uint8_t pui8Pad[BLOCK_AUTH_KEY_MAX];
+    uint32_t ui32Idx;
+
+    memset(pui8Pad, 0, sizeof(pui8Pad));
+    if(ui32Length > sizeof(pui8Pad))
+    {
+        GenerateHash(SHAMD5_ALGO_SHA256, (unsigned char *)pui8Key, pui8Pad,
+                     ui32Length);
+    }
+    else
+    {
+        memcpy(pui8Pad, pui8Key, ui32Length);
+    }
+
+    for(ui32Idx = 0; ui32Idx < sizeof(pui8Pad); ui32Idx++)
+    {
+        pui8Pad[ui32Idx] ^= 0x36;
+    }
+    HashInit(&g_sInner, SHAMD5_ALGO_SHA256);
+    HashUpdate(&g_sInner, pui8Pad, sizeof(pui8Pad));
+
+    for(ui32Idx = 0; ui32Idx < sizeof(pui8Pad); ui32Idx++)
+    {
+        pui8Pad[ui32Idx] ^= 0x36 ^ 0x5c;
+    }
+    HashInit(&g_sOuter, SHAMD5_ALGO_SHA256);
+    HashUpdate(&g_sOuter, pui8Pad, sizeof(pui8Pad));
+
+    memset(pui8Pad, 0, sizeof(pui8Pad));
+    g_bKeyLoaded = true;
+}
+
+//*****************************************************************************
+//
+//! Forget the device key; the chain is plain again
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockAuthClearKey(void)
+{
+    memset(&g_sInner, 0, sizeof(g_sInner));
+    memset(&g_sOuter, 0, sizeof(g_sOuter));
+    g_bKeyLoaded = false;
+}
+
+//*****************************************************************************
+//
+//! Whether the chain is authenticated
+//!
+//! \param None
+//!
+//! \return true once a key has been loaded
+//
+//*****************************************************************************
+bool
+BlockAuthEnabled(void)
+{
+    return g_bKeyLoaded;
+}
+
+//*****************************************************************************
+//
+//! Tag a block hash. The pad states are copied, not rehashed.
+//!
+//! \param pui8Hash is the block hash
+//! \param pui8Tag receives BLOCK_TAG_LEN bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockAuthTag(const uint8_t *pui8Hash, uint8_t *pui8Tag)
+{
+    uint8_t pui8Inner[BLOCK_TAG_LEN];
+    tHashContext sCtx;
+
+    HashClone(&sCtx, &g_sInner);
+    HashUpdate(&sCtx, pui8Hash, BLOCK_HASH_LEN);
+    HashFinal(&sCtx, pui8Inner);
+
+    HashClone(&sCtx, &g_sOuter);
+    HashUpdate(&sCtx, pui8Inner, sizeof(pui8Inner));
+    HashFinal(&sCtx, pui8Tag);
+}
+
+//*****************************************************************************
+//
+//! Tag a hashed block
+//!
+//! \param psBlock is the block; its hash must be final
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockAuthSign(struct Block *psBlock)
+{
+    BlockAuthTag(psBlock->hash, psBlock->tag);
+    psBlock->tag_len = BLOCK_TAG_LEN;
+}
+
+//*****************************************************************************
+//
+//! Check the tag of a block. The comparison takes the same time wherever
+//! the tags differ.
+//!
+//! \param psBlock is the block
+//!
+//! \return false if the block is untagged or its tag is wrong
+//
+//*****************************************************************************
+bool
+BlockAuthVerify(const struct Block *psBlock)
+{
+    uint8_t pui8Tag[BLOCK_TAG_LEN];
+    uint8_t ui8Diff = 0;
+    uint32_t ui32Idx;
+
+    if(psBlock->tag_len != BLOCK_TAG_LEN)
+    {
+        return false;
+    }
+    BlockAuthTag(psBlock->hash, pui8Tag);
+    for(ui32Idx = 0; ui32Idx < BLOCK_TAG_LEN; ui32Idx++)
+    {
+        ui8Diff |= pui8Tag[ui32Idx] ^ psBlock->tag[ui32Idx];
+    }
+
+    return ui8Diff == 0;
+}
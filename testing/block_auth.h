@@ -0,0 +1,66 @@
+//*****************************************************************************
+// block_auth.h
+//
+// Authenticated chain: every block carries an HMAC-SHA256 tag of its hash
+// under a device key (BLOCK_TAG_LEN in blockchain.h). Once a key is loaded,
+// the local producers (gen_block(), gen_blocks(), block_seal(), the miner)
+// tag each block they make, and verify_block() and verify_chain() reject
+// blocks whose tag is missing or wrong. Nothing else tags a block, so a
+// block stripped of its tag cannot be tagged again on the way in.
+//
+// The key is taken in once: the hash states after the inner and the outer
+// key pads are computed by the active engine then and kept, so a tag costs
+// two compressions, one over the block hash and one over the inner digest,
+// about as much as hashing the 84-byte header. SWHMAC() (hash_sw.h) gives
+// the same tags on the host without the engine.
+//
+// A device key is provisioned as CHAIN_AUTH_KEY in the project settings, a
+// string of up to BLOCK_AUTH_KEY_MAX bytes; the chain is plain without it.
+// It must be loaded before the log is read, and from the first block on: a
+// log of untagged blocks does not verify under a key.
+//
+//*****************************************************************************
+
+#ifndef __BLOCK_AUTH_H__
+#define __BLOCK_AUTH_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+
+//*****************************************************************************
+//
+// Longest key used as is; a longer one is hashed down first, as HMAC does.
+//
+//*****************************************************************************
+#define BLOCK_AUTH_KEY_MAX      64
+
+extern void BlockAuthLoadKey(const uint8_t *pui8Key, uint32_t ui32Length);
+extern void BlockAuthClearKey(void);
+extern bool BlockAuthEnabled(void);
+extern void BlockAuthTag(const uint8_t *pui8Hash, uint8_t *pui8Tag);
+extern void BlockAuthSign(struct Block *psBlock);
+extern bool BlockAuthVerify(const struct Block *psBlock);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BLOCK_AUTH_H__
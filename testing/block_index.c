@@ -0,0 +1,183 @@
+//*****************************************************************************
+// block_index.c
+//
+// Open-addressing hash index over pool blocks
+//
+// Blocks are keyed on the first four bytes of their hash: the low bits pick
+// the home slot and the top sixteen bits are kept in the slot as a tag next
+// to the pool index. Linear probing; removal shifts the rest of the probe
+// run back, so there are no tombstones to clean up.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "block_index.h"
+
+//
+// Room for the whole retained window at half load, and pool indices that
+// fit the low half of a slot.
+//
+typedef char tBlockIndexCapacityCheck[((CHAIN_INDEX_SIZE >=
+                                        2 * CHAIN_STORE_DEPTH) &&
+                                       (BLOCK_POOL_CAPACITY <=
+                                        BLOCK_POOL_NONE)) ? 1 : -1];
+
+#define BLOCK_INDEX_MASK        (CHAIN_INDEX_SIZE - 1)
+
+#define BLOCK_INDEX_SLOT(ui32Key, ui16Block)                                  \
+        (((ui32Key) & 0xFFFF0000) | (ui16Block))
+#define BLOCK_INDEX_TAG(ui32Slot)  ((ui32Slot) & 0xFFFF0000)
+#define BLOCK_INDEX_BLOCK(ui32Slot) ((uint16_t)((ui32Slot) & 0xFFFF))
+
+static uint32_t
+BlockIndexKey(const unsigned char *pucHash)
+{
+    return (uint32_t)pucHash[0] | ((uint32_t)pucHash[1] << 8) |
+           ((uint32_t)pucHash[2] << 16) | ((uint32_t)pucHash[3] << 24);
+}
+
+//*****************************************************************************
+//
+//! Empty an index
+//!
+//! \param psIndex is the index
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockIndexInit(tBlockIndex *psIndex)
+{
+    memset(psIndex->pui32Slots, 0xFF, sizeof(psIndex->pui32Slots));
+    psIndex->ui32Count = 0;
+}
+
+//*****************************************************************************
+//
+//! Index a pool block under its current hash
+//!
+//! \param psIndex is the index
+//! \param psBlock is a block from the block pool
+//!
+//! \return false if the index is full
+//
+//*****************************************************************************
+bool
+BlockIndexInsert(tBlockIndex *psIndex, const struct Block *psBlock)
+{
+    uint32_t ui32Key = BlockIndexKey(psBlock->hash);
+    uint32_t ui32Slot = ui32Key & BLOCK_INDEX_MASK;
+
+    //
+    // Keep one slot empty so that every probe run ends.
+    //
+    if(psIndex->ui32Count >= CHAIN_INDEX_SIZE - 1)
+    {
+        return false;
+    }
+
+    while(psIndex->pui32Slots[ui32Slot] != BLOCK_INDEX_EMPTY)
+    {
+        ui32Slot = (ui32Slot + 1) & BLOCK_INDEX_MASK;
+    }
+    psIndex->pui32Slots[ui32Slot] =
+        BLOCK_INDEX_SLOT(ui32Key, BlockPoolIndex(psBlock));
+    psIndex->ui32Count++;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Drop a block from the index. The block's hash must not have changed
+//! since it was inserted.
+//!
+//! \param psIndex is the index
+//! \param psBlock is an indexed block
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockIndexRemove(tBlockIndex *psIndex, const struct Block *psBlock)
+{
+    uint16_t ui16Block = BlockPoolIndex(psBlock);
+    uint32_t ui32Slot = BlockIndexKey(psBlock->hash) & BLOCK_INDEX_MASK;
+    uint32_t ui32Next, ui32Home;
+
+    while(BLOCK_INDEX_BLOCK(psIndex->pui32Slots[ui32Slot]) != ui16Block)
+    {
+        if(psIndex->pui32Slots[ui32Slot] == BLOCK_INDEX_EMPTY)
+        {
+            return;
+        }
+        ui32Slot = (ui32Slot + 1) & BLOCK_INDEX_MASK;
+    }
+    psIndex->ui32Count--;
+
+    //
+    // Refill the gap from later in the run: an entry may move back unless
+    // its home lies cyclically between the gap and where it sits now.
+    //
+    ui32Next = ui32Slot;
+    while(1)
+    {
+        psIndex->pui32Slots[ui32Slot] = BLOCK_INDEX_EMPTY;
+        do
+        {
+            ui32Next = (ui32Next + 1) & BLOCK_INDEX_MASK;
+            if(psIndex->pui32Slots[ui32Next] == BLOCK_INDEX_EMPTY)
+            {
+                return;
+            }
+            ui32Home = BlockIndexKey(BlockPoolAt(BLOCK_INDEX_BLOCK(
+                           psIndex->pui32Slots[ui32Next]))->hash) &
+                       BLOCK_INDEX_MASK;
+        }
+        while(((ui32Next - ui32Home) & BLOCK_INDEX_MASK) <
+              ((ui32Next - ui32Slot) & BLOCK_INDEX_MASK));
+
+        psIndex->pui32Slots[ui32Slot] = psIndex->pui32Slots[ui32Next];
+        ui32Slot = ui32Next;
+    }
+}
+
+//*****************************************************************************
+//
+//! Look a block up by hash
+//!
+//! \param psIndex is the index
+//! \param pucHash is the 32-byte block hash
+//!
+//! \return the block, or NULL if no indexed block has that hash
+//
+//*****************************************************************************
+struct Block *
+BlockIndexFind(const tBlockIndex *psIndex, const unsigned char *pucHash)
+{
+    uint32_t ui32Key = BlockIndexKey(pucHash);
+    uint32_t ui32Slot = ui32Key & BLOCK_INDEX_MASK;
+    uint32_t ui32Entry;
+    struct Block *psBlock;
+
+    while((ui32Entry = psIndex->pui32Slots[ui32Slot]) != BLOCK_INDEX_EMPTY)
+    {
+        if(BLOCK_INDEX_TAG(ui32Entry) == BLOCK_INDEX_TAG(ui32Key))
+        {
+            psBlock = BlockPoolAt(BLOCK_INDEX_BLOCK(ui32Entry));
+            if(memcmp(psBlock->hash, pucHash, BLOCK_HASH_LEN) == 0)
+            {
+                return psBlock;
+            }
+        }
+        ui32Slot = (ui32Slot + 1) & BLOCK_INDEX_MASK;
+    }
+
+    return NULL;
+}
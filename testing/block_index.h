@@ -0,0 +1,55 @@
+//*****************************************************************************
+// block_index.h
+//
+// Hash index over pool blocks. Each slot packs a 16-bit tag from the block
+// hash with the block's pool index, so the table costs four bytes per slot
+// and most misses are settled without touching the block itself.
+//
+//*****************************************************************************
+
+#ifndef __BLOCK_INDEX_H__
+#define __BLOCK_INDEX_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_config.h"
+
+#define BLOCK_INDEX_EMPTY       0xFFFFFFFF
+
+typedef struct
+{
+    uint32_t pui32Slots[CHAIN_INDEX_SIZE];
+    uint32_t ui32Count;
+} tBlockIndex;
+
+extern void BlockIndexInit(tBlockIndex *psIndex);
+extern bool BlockIndexInsert(tBlockIndex *psIndex,
+                             const struct Block *psBlock);
+extern void BlockIndexRemove(tBlockIndex *psIndex,
+                             const struct Block *psBlock);
+extern struct Block *BlockIndexFind(const tBlockIndex *psIndex,
+                                    const unsigned char *pucHash);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BLOCK_INDEX_H__
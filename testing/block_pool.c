@@ -0,0 +1,249 @@
+//*****************************************************************************
+// block_pool.c
+//
+// Fixed-capacity block store with an O(1) free list
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+
+//
+// Block indices are 16 bits wide.
+//
+typedef char tBlockPoolCapacityCheck[(BLOCK_POOL_CAPACITY < BLOCK_POOL_NONE) ?
+                                     1 : -1];
+
+static struct Block g_psBlocks[BLOCK_POOL_CAPACITY];
+
+//
+// Free list threaded through a parallel index array so that a freed block
+// keeps its contents until it is reused.
+//
+static uint16_t g_pui16Next[BLOCK_POOL_CAPACITY];
+static uint16_t g_ui16FreeHead = BLOCK_POOL_NONE;
+static bool g_bPoolReady;
+static tBlockPoolStats g_sStats;
+
+//*****************************************************************************
+//
+//! Put every block on the free list
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockPoolInit(void)
+{
+    uint16_t ui16Idx;
+
+    for(ui16Idx = 0; ui16Idx < BLOCK_POOL_CAPACITY; ui16Idx++)
+    {
+        g_pui16Next[ui16Idx] = ui16Idx + 1;
+    }
+    g_pui16Next[BLOCK_POOL_CAPACITY - 1] = BLOCK_POOL_NONE;
+    g_ui16FreeHead = 0;
+    g_sStats.ui32InUse = 0;
+    g_sStats.ui32HighWater = 0;
+    g_sStats.ui32Allocs = 0;
+    g_sStats.ui32Failures = 0;
+    g_bPoolReady = true;
+}
+
+//*****************************************************************************
+//
+//! Take a block from the pool
+//!
+//! \param None
+//!
+//! \return the block, or NULL if the pool is exhausted
+//
+//*****************************************************************************
+struct Block *
+BlockPoolAlloc(void)
+{
+    uint16_t ui16Idx;
+
+    if(!g_bPoolReady)
+    {
+        BlockPoolInit();
+    }
+
+    ui16Idx = g_ui16FreeHead;
+    if(ui16Idx == BLOCK_POOL_NONE)
+    {
+        g_sStats.ui32Failures++;
+        return NULL;
+    }
+    g_ui16FreeHead = g_pui16Next[ui16Idx];
+    g_pui16Next[ui16Idx] = BLOCK_POOL_NONE;
+
+    g_sStats.ui32Allocs++;
+    if(++g_sStats.ui32InUse > g_sStats.ui32HighWater)
+    {
+        g_sStats.ui32HighWater = g_sStats.ui32InUse;
+    }
+
+    return &g_psBlocks[ui16Idx];
+}
+
+//*****************************************************************************
+//
+//! Take a particular block from the pool, so that state saved with pool
+//! indices (a chain snapshot) can be put back where it was
+//!
+//! \param ui16Index is the index of the wanted block
+//!
+//! \return the block, or NULL if it is out of range or already in use
+//
+//*****************************************************************************
+struct Block *
+BlockPoolClaim(uint16_t ui16Index)
+{
+    uint16_t *pui16Link;
+
+    if(!g_bPoolReady)
+    {
+        BlockPoolInit();
+    }
+
+    for(pui16Link = &g_ui16FreeHead; *pui16Link != BLOCK_POOL_NONE;
+        pui16Link = &g_pui16Next[*pui16Link])
+    {
+        if(*pui16Link == ui16Index)
+        {
+            *pui16Link = g_pui16Next[ui16Index];
+            g_pui16Next[ui16Index] = BLOCK_POOL_NONE;
+            g_sStats.ui32Allocs++;
+            if(++g_sStats.ui32InUse > g_sStats.ui32HighWater)
+            {
+                g_sStats.ui32HighWater = g_sStats.ui32InUse;
+            }
+
+            return &g_psBlocks[ui16Index];
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+//! Return a block to the pool
+//!
+//! \param psBlock is a block from BlockPoolAlloc(), or NULL
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockPoolFree(struct Block *psBlock)
+{
+    uint16_t ui16Idx;
+
+    if(psBlock == NULL)
+    {
+        return;
+    }
+    ui16Idx = BlockPoolIndex(psBlock);
+    g_pui16Next[ui16Idx] = g_ui16FreeHead;
+    g_ui16FreeHead = ui16Idx;
+    g_sStats.ui32InUse--;
+}
+
+//*****************************************************************************
+//
+//! Position of a block in the pool. Indices are stable for the life of the
+//! block and are smaller than pointers, so other tables store them instead.
+//!
+//! \param psBlock is a pool block
+//!
+//! \return the block's index
+//
+//*****************************************************************************
+uint16_t
+BlockPoolIndex(const struct Block *psBlock)
+{
+    return (uint16_t)(psBlock - g_psBlocks);
+}
+
+//*****************************************************************************
+//
+//! Block at a pool index
+//!
+//! \param ui16Index is an index from BlockPoolIndex()
+//!
+//! \return the block, or NULL for BLOCK_POOL_NONE or an out of range index
+//
+//*****************************************************************************
+struct Block *
+BlockPoolAt(uint16_t ui16Index)
+{
+    if(ui16Index >= BLOCK_POOL_CAPACITY)
+    {
+        return NULL;
+    }
+
+    return &g_psBlocks[ui16Index];
+}
+
+//*****************************************************************************
+//
+//! Read the pool counters
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+BlockPoolStatsGet(tBlockPoolStats *psStats)
+{
+    *psStats = g_sStats;
+}
+
+//*****************************************************************************
+//
+//! Check the free list: every entry in range, none twice, and as many as
+//! the blocks not in use. It walks the whole list, so it is for tests.
+//!
+//! \param None
+//!
+//! \return true if the free list is sound
+//
+//*****************************************************************************
+bool
+BlockPoolCheck(void)
+{
+    static uint8_t pui8Seen[BLOCK_POOL_CAPACITY];
+    uint32_t ui32Free = 0;
+    uint16_t ui16Idx;
+
+    if(!g_bPoolReady)
+    {
+        return true;
+    }
+
+    for(ui16Idx = 0; ui16Idx < BLOCK_POOL_CAPACITY; ui16Idx++)
+    {
+        pui8Seen[ui16Idx] = 0;
+    }
+    for(ui16Idx = g_ui16FreeHead; ui16Idx != BLOCK_POOL_NONE;
+        ui16Idx = g_pui16Next[ui16Idx])
+    {
+        if((ui16Idx >= BLOCK_POOL_CAPACITY) || pui8Seen[ui16Idx])
+        {
+            return false;
+        }
+        pui8Seen[ui16Idx] = 1;
+        ui32Free++;
+    }
+
+    return (ui32Free + g_sStats.ui32InUse) == BLOCK_POOL_CAPACITY;
+}
@@ -0,0 +1,73 @@
+//*****************************************************************************
+// block_pool.h
+//
+// Fixed-capacity block store. All blocks live in one statically allocated
+// array and are handed out from a free list, so building and discarding
+// blocks never touches the heap.
+//
+//*****************************************************************************
+
+#ifndef __BLOCK_POOL_H__
+#define __BLOCK_POOL_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_config.h"
+
+//*****************************************************************************
+//
+// Number of blocks in the pool: the retained chain window plus the blocks
+// under construction. Override from the project settings.
+//
+//*****************************************************************************
+#ifndef BLOCK_POOL_CAPACITY
+#define BLOCK_POOL_CAPACITY     (CHAIN_STORE_DEPTH + CHAIN_BUILD_SPARE)
+#endif
+
+#define BLOCK_POOL_NONE         0xFFFF
+
+//*****************************************************************************
+//
+// Pool usage counters.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32InUse;
+    uint32_t ui32HighWater;
+    uint32_t ui32Allocs;
+    uint32_t ui32Failures;
+} tBlockPoolStats;
+
+extern void BlockPoolInit(void);
+extern struct Block *BlockPoolAlloc(void);
+extern struct Block *BlockPoolClaim(uint16_t ui16Index);
+extern void BlockPoolFree(struct Block *psBlock);
+extern uint16_t BlockPoolIndex(const struct Block *psBlock);
+extern struct Block *BlockPoolAt(uint16_t ui16Index);
+extern void BlockPoolStatsGet(tBlockPoolStats *psStats);
+extern bool BlockPoolCheck(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BLOCK_POOL_H__
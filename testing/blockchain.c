@@ -0,0 +1,513 @@
+#include <stddef.h>
+#include <string.h>
+#if defined(cc3200)
+// Driverlib includes
+#include "hw_types.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "prcm.h"
+#else
+#include <time.h>
+#endif
+
+#include "hash_engine.h"
+#if defined(HASH_ENGINE_SW)
+#include "hash_sw_mb.h"
+#endif
+#include "perf_probe.h"
+#include "blockchain.h"
+#include "block_pool.h"
+#include "block_auth.h"
+
+static void put_le32(unsigned char *p, uint32_t v){
+	p[0] = (unsigned char)v;
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_le32(const unsigned char *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+			((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//
+// Seconds for the header timestamp. The board has no calendar clock, so it
+// stamps blocks with the slow-clock RTC counter, which counts 32.768 kHz
+// ticks on its own from power-up and keeps counting across core resets
+// and idle spells.
+//
+#define BLOCK_RTC_HZ	32768
+
+static uint32_t block_time(void){
+#if defined(cc3200)
+	return (uint32_t)(MAP_PRCMSlowClkCtrGet() / BLOCK_RTC_HZ);
+#else
+	return (uint32_t)time(NULL);
+#endif
+}
+
+void block_header_serialize(const struct BlockHeader *hdr, unsigned char *out){
+	put_le32(out + BLOCK_HDR_OFS_VERSION, hdr->version);
+	put_le32(out + BLOCK_HDR_OFS_HEIGHT, hdr->height);
+	memcpy(out + BLOCK_HDR_OFS_PREV, hdr->pHash, BLOCK_HASH_LEN);
+	memcpy(out + BLOCK_HDR_OFS_MERKLE, hdr->merkle, BLOCK_HASH_LEN);
+	put_le32(out + BLOCK_HDR_OFS_TIME, hdr->time);
+	put_le32(out + BLOCK_HDR_OFS_NONCE, hdr->nonce);
+	put_le32(out + BLOCK_HDR_OFS_DATA_LEN, hdr->data_len);
+}
+
+//
+// Returns -1 for a header this build cannot interpret.
+//
+int block_header_deserialize(const unsigned char *in, struct BlockHeader *hdr){
+	hdr->version = get_le32(in + BLOCK_HDR_OFS_VERSION);
+	if(hdr->version != BLOCK_HEADER_VERSION){
+		return -1;
+	}
+	hdr->height = get_le32(in + BLOCK_HDR_OFS_HEIGHT);
+	memcpy(hdr->pHash, in + BLOCK_HDR_OFS_PREV, BLOCK_HASH_LEN);
+	memcpy(hdr->merkle, in + BLOCK_HDR_OFS_MERKLE, BLOCK_HASH_LEN);
+	hdr->time = get_le32(in + BLOCK_HDR_OFS_TIME);
+	hdr->nonce = get_le32(in + BLOCK_HDR_OFS_NONCE);
+	hdr->data_len = get_le32(in + BLOCK_HDR_OFS_DATA_LEN);
+	if(hdr->data_len > BLOCK_DATA_LEN || (hdr->data_len % BLOCK_TX_LEN)){
+		return -1;
+	}
+	return 0;
+}
+
+//
+// A block's hash covers its serialized header; the payload is bound in
+// through the Merkle root.
+//
+void block_hash_header(const struct BlockHeader *hdr, unsigned char *hash){
+	unsigned char raw[BLOCK_HEADER_LEN];
+	block_header_serialize(hdr, raw);
+	GenerateHash(SHAMD5_ALGO_SHA256, raw, hash, BLOCK_HEADER_LEN);
+}
+
+//
+// A payload is valid if it holds whole transactions; its root is the
+// Merkle root over them.
+//
+static int payload_valid(const struct BlockHeader *hdr){
+	return hdr->data_len <= BLOCK_DATA_LEN &&
+			(hdr->data_len % BLOCK_TX_LEN) == 0;
+}
+
+static void hash_payload(const unsigned char *data, uint32_t len,
+		unsigned char *merkle){
+	MerkleRootOf(data, BLOCK_TX_LEN, len / BLOCK_TX_LEN, merkle);
+}
+
+//
+// In an authenticated chain a block made here is tagged once its hash is
+// final. Only local producers call this: a block from anywhere else must
+// arrive with its tag.
+//
+static void sign_local(struct Block *b){
+	if(BlockAuthEnabled()){
+		BlockAuthSign(b);
+	}
+}
+
+struct Block *block_begin(struct BlockBuilder *bb, struct Block *lastb){
+	struct Block *b = BlockPoolAlloc();
+	bb->block = b;
+	if(b == NULL){
+		return NULL;
+	}
+	memset(b, 0, sizeof(struct Block));
+	b->header.version = BLOCK_HEADER_VERSION;
+	b->header.height = lastb->header.height + 1;
+	memcpy(b->header.pHash, lastb->hash, BLOCK_HASH_LEN);
+	MerkleInit(&bb->tree, bb->nodes, BLOCK_MAX_TX);
+	return b;
+}
+
+//
+// Append a transaction of up to BLOCK_TX_LEN bytes (zero padded). Only the
+// path from the new leaf to the root is re-hashed. Returns 0 when the block
+// is full.
+//
+int block_add_tx(struct BlockBuilder *bb, const unsigned char *tx,
+		unsigned int len){
+	struct Block *b = bb->block;
+	unsigned char *slot;
+
+	if(b == NULL || block_tx_count(b) >= BLOCK_MAX_TX || len > BLOCK_TX_LEN){
+		return 0;
+	}
+	slot = block_tx(b, block_tx_count(b));
+	memset(slot, 0, BLOCK_TX_LEN);
+	memcpy(slot, tx, len);
+	MerkleAppend(&bb->tree, slot, BLOCK_TX_LEN);
+	b->header.data_len += BLOCK_TX_LEN;
+	return 1;
+}
+
+struct Block *block_seal(struct BlockBuilder *bb){
+	struct Block *b = bb->block;
+	if(b == NULL){
+		return NULL;
+	}
+	memcpy(b->header.merkle, MerkleRoot(&bb->tree), BLOCK_HASH_LEN);
+	b->header.time = block_time();
+	block_hash_header(&b->header, b->hash);
+	sign_local(b);
+	return b;
+}
+
+int block_prove_tx(struct BlockBuilder *bb, unsigned int index,
+		tMerkleProof *proof){
+	return MerkleProve(&bb->tree, index, proof);
+}
+
+//
+// Check that a transaction of a block is covered by the block's root.
+//
+int block_verify_tx(const struct Block *block, unsigned int index,
+		const tMerkleProof *proof){
+	if(!payload_valid(&block->header) || index >= block_tx_count(block)){
+		return 0;
+	}
+	return MerkleVerify(block->header.merkle, block_tx(block, index),
+			BLOCK_TX_LEN, index, block_tx_count(block), proof);
+}
+
+//
+// Single-transaction block; data is a string of up to BLOCK_TX_LEN bytes.
+//
+struct Block* gen_block(struct Block* lastb, char* data ){
+
+	const char *end;
+	PERF_PROBE_START(ui64Start);
+	struct Block *b = BlockPoolAlloc();
+	PERF_PROBE_EVENT(PERF_SITE_BLOCK_ALLOC);
+	if(b == NULL){
+		return NULL;
+	}
+	memset(b, 0, sizeof(struct Block));
+	b->header.version = BLOCK_HEADER_VERSION;
+	b->header.height = lastb->header.height + 1;
+	memcpy(b->header.pHash, lastb->hash, BLOCK_HASH_LEN);
+	end = memchr(data, 0, BLOCK_TX_LEN);
+	memcpy(b->data, data, end ? (uint32_t)(end - data) : BLOCK_TX_LEN);
+	b->header.data_len = BLOCK_TX_LEN;
+	hash_payload(b->data, b->header.data_len, b->header.merkle);
+	b->header.time = block_time();
+	block_hash_header(&b->header, b->hash);
+	sign_local(b);
+	PERF_PROBE_STOP(PERF_SITE_GEN_BLOCK, ui64Start);
+	return b;
+
+}
+
+struct Block * gen_genesis_block(void){
+	struct Block *b = BlockPoolAlloc();
+	if(b == NULL){
+		return NULL;
+	}
+	memset(b, 0, sizeof(struct Block));
+	b->header.version = BLOCK_HEADER_VERSION;
+	b->header.data_len = BLOCK_TX_LEN;
+	memcpy(b->data, "genesis", 7);
+	hash_payload(b->data, b->header.data_len, b->header.merkle);
+	block_hash_header(&b->header, b->hash);
+	sign_local(b);
+	return b;
+
+
+}
+
+//
+// Check a block against its parent. In an authenticated chain the block must
+// also carry the right tag; an untagged one is refused, so that a block
+// stripped of its tag is never tagged again on our key.
+//
+int verify_block(struct Block * block, struct Block* lastb){
+	unsigned char h[BLOCK_HASH_LEN];
+
+	if(block->header.version != BLOCK_HEADER_VERSION ||
+			!payload_valid(&block->header)){
+		return 0;
+	}
+	hash_payload(block->data, block->header.data_len, h);
+	if(memcmp(h, block->header.merkle, BLOCK_HASH_LEN)){
+		return 0;
+	}
+	block_hash_header(&block->header, h);
+
+	return !memcmp(h, block->hash, BLOCK_HASH_LEN) &&
+			!memcmp(block->header.pHash, lastb->hash, BLOCK_HASH_LEN) &&
+			(block->header.height == lastb->header.height + 1) &&
+			(!BlockAuthEnabled() || BlockAuthVerify(block));
+}
+
+//
+// Blocks re-hashed per pass of verify_chain. The software engine hashes
+// the headers of a whole window as one multi-buffer batch; the SHAMD5 engine
+// gets one window of queued jobs.
+//
+#if defined(HASH_ENGINE_SW)
+#define VERIFY_WINDOW	64
+#else
+#define VERIFY_WINDOW	HASH_JOB_QUEUE_DEPTH
+#endif
+
+//
+// Window buffers of verify_chain. They would not fit on the board's 2 KB
+// stack next to the Merkle root computation, so they are static and
+// verify_chain must not be entered twice at once.
+//
+static unsigned char verify_raw[VERIFY_WINDOW][BLOCK_HEADER_LEN];
+static unsigned char verify_digests[2 * VERIFY_WINDOW][BLOCK_HASH_LEN];
+#if defined(HASH_ENGINE_SW)
+static const uint8_t *verify_msgs[VERIFY_WINDOW];
+static uint32_t verify_lens[VERIFY_WINDOW];
+static uint8_t *verify_outs[VERIFY_WINDOW];
+#else
+static tHashJob verify_jobs[VERIFY_WINDOW];
+#endif
+
+//
+// Recompute the transaction root and the header hash of each block in a
+// window. Results go to verify_digests[2 * i] (root) and
+// verify_digests[2 * i + 1] (header).
+//
+static void verify_hash_window(struct Block * const *blocks,
+		unsigned int count){
+	unsigned char (*raw)[BLOCK_HEADER_LEN] = verify_raw;
+	unsigned char (*digests)[BLOCK_HASH_LEN] = verify_digests;
+	unsigned int i;
+#if defined(HASH_ENGINE_SW)
+	const uint8_t **msgs = verify_msgs;
+	uint32_t *lens = verify_lens;
+	uint8_t **outs = verify_outs;
+
+	for(i = 0; i < count; i++){
+		hash_payload(blocks[i]->data, blocks[i]->header.data_len,
+				digests[2 * i]);
+		block_header_serialize(&blocks[i]->header, raw[i]);
+		msgs[i] = raw[i];
+		lens[i] = BLOCK_HEADER_LEN;
+		outs[i] = digests[2 * i + 1];
+	}
+	SWSHA256Batch(SHAMD5_ALGO_SHA256, msgs, lens, outs, count);
+#else
+	tHashJob *jobs = verify_jobs;
+
+	//
+	// The header jobs go to the engine back to back; the roots use the
+	// context interface, so they wait until the queue has drained.
+	//
+	for(i = 0; i < count; i++){
+		block_header_serialize(&blocks[i]->header, raw[i]);
+		HashJobInit(&jobs[i], SHAMD5_ALGO_SHA256, raw[i], BLOCK_HEADER_LEN,
+				digests[2 * i + 1], 0, 0);
+		while(!HashJobSubmit(&jobs[i])){
+		}
+	}
+	for(i = 0; i < count; i++){
+		HashJobWait(&jobs[i]);
+	}
+	for(i = 0; i < count; i++){
+		hash_payload(blocks[i]->data, blocks[i]->header.data_len,
+				digests[2 * i]);
+	}
+#endif
+}
+
+//
+// Verify a run of consecutive blocks. prev_hash is the hash of the block
+// before blocks[0], or NULL when blocks[0] is the genesis block. The cheap
+// linkage checks run first over the whole range; hashes are then recomputed
+// a window at a time up to the first linkage failure. Returns 1 if every
+// block is valid, otherwise 0 with the index of the first bad block in
+// *bad_index. In an authenticated chain every block must also carry the
+// right tag.
+//
+int verify_chain(struct Block * const *blocks, unsigned int count,
+		const unsigned char *prev_hash, unsigned int *bad_index){
+	unsigned char (*digests)[BLOCK_HASH_LEN] = verify_digests;
+	static const unsigned char zero[BLOCK_HASH_LEN];
+	unsigned int i, j, n, limit = count;
+	const unsigned char *link = prev_hash ? prev_hash : zero;
+
+	for(i = 0; i < count; i++){
+		if(blocks[i]->header.version != BLOCK_HEADER_VERSION ||
+				!payload_valid(&blocks[i]->header) ||
+				memcmp(blocks[i]->header.pHash, link, BLOCK_HASH_LEN) ||
+				(i == 0 && !prev_hash && blocks[0]->header.height != 0) ||
+				(i > 0 && blocks[i]->header.height !=
+					blocks[i - 1]->header.height + 1)){
+			limit = i;
+			break;
+		}
+		link = blocks[i]->hash;
+	}
+
+	for(i = 0; i < limit; i += n){
+		n = limit - i;
+		if(n > VERIFY_WINDOW){
+			n = VERIFY_WINDOW;
+		}
+		verify_hash_window(blocks + i, n);
+		for(j = 0; j < n; j++){
+			if(memcmp(digests[2 * j], blocks[i + j]->header.merkle,
+						BLOCK_HASH_LEN) ||
+					memcmp(digests[2 * j + 1], blocks[i + j]->hash,
+						BLOCK_HASH_LEN) ||
+					(BlockAuthEnabled() &&
+					 !BlockAuthVerify(blocks[i + j]))){
+				*bad_index = i + j;
+				return 0;
+			}
+		}
+	}
+
+	if(limit < count){
+		*bad_index = limit;
+		return 0;
+	}
+	return 1;
+}
+
+//
+// Blocks prepared per pass of gen_blocks. In software the roots of a window
+// are hashed as one multi-buffer batch; on the SHAMD5 engine the roots and
+// then the headers of a window go through one hash session.
+//
+#define GEN_WINDOW	VERIFY_WINDOW
+
+//
+// Window buffers of gen_blocks, static like those of verify_chain; gen_blocks
+// must not be entered twice at once either.
+//
+static unsigned char gen_leaves[GEN_WINDOW][1 + BLOCK_TX_LEN];
+#if defined(HASH_ENGINE_SW)
+static const uint8_t *gen_msgs[GEN_WINDOW];
+static uint32_t gen_lens[GEN_WINDOW];
+static uint8_t *gen_outs[GEN_WINDOW];
+#else
+static unsigned char gen_raw[BLOCK_HEADER_LEN];
+#endif
+
+//
+// Allocate and fill up to count single-transaction blocks following lastb,
+// everything but the previous hash and the root, and put the leaf of each
+// in gen_leaves. A block of one transaction has the hash of its leaf as
+// root. Returns the number of blocks allocated.
+//
+static unsigned int gen_prepare_window(struct Block *lastb,
+		char * const *data, unsigned int count, struct Block **blocks,
+		uint32_t now){
+	const char *end;
+	unsigned int n;
+
+	for(n = 0; n < count; n++){
+		struct Block *b = BlockPoolAlloc();
+		PERF_PROBE_EVENT(PERF_SITE_BLOCK_ALLOC);
+		if(b == NULL){
+			break;
+		}
+		memset(b, 0, sizeof(struct Block));
+		b->header.version = BLOCK_HEADER_VERSION;
+		b->header.height = lastb->header.height + 1 + n;
+		end = memchr(data[n], 0, BLOCK_TX_LEN);
+		memcpy(b->data, data[n],
+				end ? (uint32_t)(end - data[n]) : BLOCK_TX_LEN);
+		b->header.data_len = BLOCK_TX_LEN;
+		b->header.time = now;
+		gen_leaves[n][0] = MERKLE_LEAF_PREFIX;
+		memcpy(gen_leaves[n] + 1, b->data, BLOCK_TX_LEN);
+		blocks[n] = b;
+	}
+	return n;
+}
+
+//
+// Hash the roots of a prepared window, then link and hash its headers. Each
+// header needs the hash of the one before, so that part is serial; on the
+// SHAMD5 engine the next header is serialized while the current one is
+// hashed, and the whole window is one session on a once-configured engine.
+//
+static void gen_hash_window(struct Block *lastb, struct Block **blocks,
+		unsigned int count){
+	unsigned int i;
+#if defined(HASH_ENGINE_SW)
+	for(i = 0; i < count; i++){
+		gen_msgs[i] = gen_leaves[i];
+		gen_lens[i] = sizeof(gen_leaves[i]);
+		gen_outs[i] = blocks[i]->header.merkle;
+	}
+	SWSHA256Batch(SHAMD5_ALGO_SHA256, gen_msgs, gen_lens, gen_outs, count);
+	for(i = 0; i < count; i++){
+		memcpy(blocks[i]->header.pHash, lastb->hash, BLOCK_HASH_LEN);
+		block_hash_header(&blocks[i]->header, blocks[i]->hash);
+		lastb = blocks[i];
+	}
+#else
+	HashSessionBegin(SHAMD5_ALGO_SHA256);
+	for(i = 0; i < count; i++){
+		HashSessionPut(gen_leaves[i], sizeof(gen_leaves[i]),
+				blocks[i]->header.merkle);
+	}
+	memcpy(blocks[0]->header.pHash, lastb->hash, BLOCK_HASH_LEN);
+	HashSessionWait();
+
+	//
+	// The engine has taken a header once HashSessionPut returns, so the
+	// next one is serialized into the same buffer; only its previous hash
+	// has to wait for the digest.
+	//
+	block_header_serialize(&blocks[0]->header, gen_raw);
+	for(i = 0; i < count; i++){
+		HashSessionPut(gen_raw, BLOCK_HEADER_LEN, blocks[i]->hash);
+		if(i + 1 < count){
+			block_header_serialize(&blocks[i + 1]->header, gen_raw);
+			HashSessionWait();
+			memcpy(blocks[i + 1]->header.pHash, blocks[i]->hash,
+					BLOCK_HASH_LEN);
+			memcpy(gen_raw + BLOCK_HDR_OFS_PREV, blocks[i]->hash,
+					BLOCK_HASH_LEN);
+		}
+	}
+	HashSessionEnd();
+#endif
+}
+
+//
+// Produce a linked run of single-transaction blocks on lastb, one per entry
+// of data, into blocks[]. The blocks equal what gen_block would make one by
+// one within the same second, but a window at a time: the roots of a window
+// are hashed together and the clock is read once for the run. The run stops
+// early when the block pool runs out. Returns the number of blocks made;
+// they are not yet appended anywhere.
+//
+unsigned int gen_blocks(struct Block *lastb, char * const *data,
+		unsigned int count, struct Block **blocks){
+	uint32_t now = block_time();
+	unsigned int i, j, n, made;
+
+	for(i = 0; i < count; i += made){
+		n = count - i;
+		if(n > GEN_WINDOW){
+			n = GEN_WINDOW;
+		}
+		made = gen_prepare_window(lastb, data + i, n, blocks + i, now);
+		if(made == 0){
+			break;
+		}
+		gen_hash_window(lastb, blocks + i, made);
+		for(j = 0; j < made; j++){
+			sign_local(blocks[i + j]);
+		}
+		lastb = blocks[i + made - 1];
+		if(made < n){
+			return i + made;
+		}
+	}
+	return i;
+}
@@ -0,0 +1,147 @@
+//*****************************************************************************
+// blockchain.h
+//
+// Block structure and the chain primitives (block construction and
+// verification). Independent of the board so it also runs on the host.
+//
+//*****************************************************************************
+
+#ifndef __BLOCKCHAIN_H__
+#define __BLOCKCHAIN_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "merkle.h"
+
+#define BLOCK_HASH_LEN      32
+
+//*****************************************************************************
+//
+// A block's payload is a list of fixed-size transactions, summarized in the
+// header by their Merkle root. BLOCK_MAX_TX bounds the list; every block in
+// the pool reserves room for it, so it sizes the retained chain as well.
+//
+//*****************************************************************************
+#define BLOCK_TX_LEN        10
+#ifndef BLOCK_MAX_TX
+#define BLOCK_MAX_TX        8
+#endif
+#define BLOCK_DATA_LEN      (BLOCK_MAX_TX * BLOCK_TX_LEN)
+
+//*****************************************************************************
+//
+// Authentication tag of a block in an authenticated chain: HMAC-SHA256 of
+// the block hash under the device key (block_auth.h). It is not part of the
+// header, so tagging a block does not change its hash. tag_len is 0 for an
+// untagged block.
+//
+//*****************************************************************************
+#define BLOCK_TAG_LEN       32
+
+//*****************************************************************************
+//
+// Serialized block header, version 1. All integers are little-endian and
+// there is no padding:
+//
+//   offset  size  field
+//        0     4  version
+//        4     4  height
+//        8    32  previous block hash
+//       40    32  Merkle root of the transactions
+//       72     4  timestamp (seconds)
+//       76     4  nonce
+//       80     4  payload length (a multiple of BLOCK_TX_LEN)
+//
+// The block hash is SHA-256 over these 84 bytes. The first 64 bytes do not
+// depend on the timestamp or the nonce, so their hash state can be reused
+// while only the tail changes.
+//
+//*****************************************************************************
+#define BLOCK_HEADER_VERSION        1
+#define BLOCK_HEADER_LEN            84
+
+#define BLOCK_HDR_OFS_VERSION       0
+#define BLOCK_HDR_OFS_HEIGHT        4
+#define BLOCK_HDR_OFS_PREV          8
+#define BLOCK_HDR_OFS_MERKLE        40
+#define BLOCK_HDR_OFS_TIME          72
+#define BLOCK_HDR_OFS_NONCE         76
+#define BLOCK_HDR_OFS_DATA_LEN      80
+
+struct BlockHeader{
+    uint32_t version;
+    uint32_t height;
+    unsigned char pHash[BLOCK_HASH_LEN];
+    unsigned char merkle[BLOCK_HASH_LEN];
+    uint32_t time;
+    uint32_t nonce;
+    uint32_t data_len;
+};
+
+struct Block{
+    struct BlockHeader header;
+    unsigned char hash[BLOCK_HASH_LEN];
+    unsigned char data[BLOCK_DATA_LEN];
+    unsigned char tag[BLOCK_TAG_LEN];
+    uint32_t tag_len;
+};
+
+#define block_tx_count(b)   ((b)->header.data_len / BLOCK_TX_LEN)
+#define block_tx(b, i)      ((b)->data + ((i) * BLOCK_TX_LEN))
+
+//
+// Builds a block one transaction at a time. The Merkle tree is kept so that
+// the root is updated incrementally and inclusion proofs can be issued.
+//
+struct BlockBuilder{
+    struct Block *block;
+    tMerkleTree tree;
+    uint8_t nodes[MERKLE_NODES(BLOCK_MAX_TX)][MERKLE_HASH_LEN];
+};
+
+extern void block_header_serialize(const struct BlockHeader *hdr,
+        unsigned char *out);
+extern int block_header_deserialize(const unsigned char *in,
+        struct BlockHeader *hdr);
+extern void block_hash_header(const struct BlockHeader *hdr,
+        unsigned char *hash);
+
+extern struct Block *block_begin(struct BlockBuilder *bb,
+        struct Block *lastb);
+extern int block_add_tx(struct BlockBuilder *bb, const unsigned char *tx,
+        unsigned int len);
+extern struct Block *block_seal(struct BlockBuilder *bb);
+extern int block_prove_tx(struct BlockBuilder *bb, unsigned int index,
+        tMerkleProof *proof);
+extern int block_verify_tx(const struct Block *block, unsigned int index,
+        const tMerkleProof *proof);
+
+extern struct Block *gen_genesis_block(void);
+extern struct Block *gen_block(struct Block *lastb, char *data);
+extern unsigned int gen_blocks(struct Block *lastb, char * const *data,
+        unsigned int count, struct Block **blocks);
+extern int verify_block(struct Block *block, struct Block *lastb);
+extern int verify_chain(struct Block * const *blocks, unsigned int count,
+        const unsigned char *prev_hash, unsigned int *bad_index);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BLOCKCHAIN_H__
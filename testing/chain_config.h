@@ -0,0 +1,59 @@
+//*****************************************************************************
+// chain_config.h
+//
+// Compile-time sizing of the in-RAM chain, derived from the application
+// data RAM described in cc3200v1p32.cmd
+//
+//*****************************************************************************
+
+#ifndef __CHAIN_CONFIG_H__
+#define __CHAIN_CONFIG_H__
+
+//*****************************************************************************
+//
+// Length of the SRAM_DATA region in cc3200v1p32.cmd. Keep the two in sync.
+//
+//*****************************************************************************
+#define CHAIN_SRAM_DATA_BYTES   0x23000
+
+//*****************************************************************************
+//
+// Fraction of SRAM_DATA (1/n) given over to retained blocks. The rest is
+// left for the stack, the heap and the other tables.
+//
+//*****************************************************************************
+#ifndef CHAIN_STORE_RAM_DIVISOR
+#define CHAIN_STORE_RAM_DIVISOR 4
+#endif
+
+//*****************************************************************************
+//
+// Number of most recent blocks kept in RAM.
+//
+//*****************************************************************************
+#ifndef CHAIN_STORE_DEPTH
+#define CHAIN_STORE_DEPTH       (CHAIN_SRAM_DATA_BYTES /                      \
+                                 CHAIN_STORE_RAM_DIVISOR /                    \
+                                 sizeof(struct Block))
+#endif
+
+//*****************************************************************************
+//
+// The block pool holds the retained window plus the blocks being built.
+//
+//*****************************************************************************
+#define CHAIN_BUILD_SPARE       4
+
+//*****************************************************************************
+//
+// Slots in the block hash index, as a power of two. At least twice the
+// retained window, so that a lookup rarely probes more than a slot or two.
+//
+//*****************************************************************************
+#ifndef CHAIN_INDEX_BITS
+#define CHAIN_INDEX_BITS        9
+#endif
+
+#define CHAIN_INDEX_SIZE        (1u << CHAIN_INDEX_BITS)
+
+#endif // __CHAIN_CONFIG_H__
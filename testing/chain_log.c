@@ -0,0 +1,582 @@
+//*****************************************************************************
+// chain_log.c
+//
+// Append-only block log: record encoding, write batching, checkpoints and
+// startup recovery. The storage itself is in chain_log_fs.c.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "chain_log.h"
+#include "chain_snapshot.h"
+#include "crc32.h"
+
+//
+// A batch must hold at least one record.
+//
+typedef char tChainLogBatchCheck[(CHAIN_LOG_BATCH_BYTES >=
+                                  CHAIN_LOG_RECORD_MAX) ? 1 : -1];
+
+//
+// Records waiting to be written. During recovery the same buffer holds the
+// record being read.
+//
+static uint8_t g_pui8Batch[CHAIN_LOG_BATCH_BYTES];
+static uint32_t g_ui32BatchLen;
+
+//
+// Durable length of the log, and the last block logged (durable or not).
+//
+static uint32_t g_ui32LogLength;
+static bool g_bLogOpen;
+static bool g_bHaveLast;
+static uint32_t g_ui32LastHeight;
+static uint8_t g_pui8LastHash[BLOCK_HASH_LEN];
+
+//
+// Height covered by the checkpoint on storage.
+//
+static bool g_bHaveCheckpoint;
+static uint32_t g_ui32CheckpointHeight;
+
+//
+// Store the log was opened into, and the tip height of the last snapshot
+// taken of it.
+//
+static tChainStore *g_psStore;
+static bool g_bSnapshots;
+static bool g_bHaveSnapshot;
+static uint32_t g_ui32SnapshotHeight;
+
+static tChainLogStats g_sStats;
+
+static void
+ChainLogPut32(uint8_t *pui8Out, uint32_t ui32Value)
+{
+    pui8Out[0] = (uint8_t)ui32Value;
+    pui8Out[1] = (uint8_t)(ui32Value >> 8);
+    pui8Out[2] = (uint8_t)(ui32Value >> 16);
+    pui8Out[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static uint32_t
+ChainLogGet32(const uint8_t *pui8In)
+{
+    return (uint32_t)pui8In[0] | ((uint32_t)pui8In[1] << 8) |
+           ((uint32_t)pui8In[2] << 16) | ((uint32_t)pui8In[3] << 24);
+}
+
+//
+// Snapshot the store once its tip is the last durable record and enough
+// blocks (with bForce, any block) have been added since the last snapshot.
+//
+static void
+ChainLogSnapshot(bool bForce)
+{
+    struct Block *psTip;
+
+    if(!g_bSnapshots || (CHAIN_LOG_SNAPSHOT_BLOCKS == 0))
+    {
+        return;
+    }
+
+    psTip = ChainStoreTip(g_psStore);
+    if((psTip == NULL) || (g_ui32BatchLen != 0) || !g_bHaveLast ||
+       (psTip->header.height != g_ui32LastHeight) ||
+       memcmp(psTip->hash, g_pui8LastHash, BLOCK_HASH_LEN))
+    {
+        return;
+    }
+    if(g_bHaveSnapshot &&
+       (g_ui32LastHeight - g_ui32SnapshotHeight <
+        (bForce ? 1 : CHAIN_LOG_SNAPSHOT_BLOCKS)))
+    {
+        return;
+    }
+
+    if(!ChainSnapshotSave(g_psStore, g_ui32LogLength))
+    {
+        g_sStats.ui32Failures++;
+        return;
+    }
+    g_bHaveSnapshot = true;
+    g_ui32SnapshotHeight = g_ui32LastHeight;
+    g_sStats.ui32Snapshots++;
+
+    //
+    // A restore reads back the tip's record; everything before it can go.
+    //
+    if(!ChainLogFsDiscard(g_ui32LogLength - ChainLogRecordLen(psTip)))
+    {
+        g_sStats.ui32Failures++;
+    }
+}
+
+//
+// Record the durable tip in the checkpoint.
+//
+static bool
+ChainLogCheckpoint(void)
+{
+    uint8_t pui8Ckpt[CHAIN_LOG_CKPT_LEN];
+
+    ChainLogPut32(pui8Ckpt, CHAIN_LOG_CKPT_MAGIC);
+    ChainLogPut32(pui8Ckpt + 4, g_ui32LastHeight);
+    ChainLogPut32(pui8Ckpt + 8, g_ui32LogLength);
+    memcpy(pui8Ckpt + 12, g_pui8LastHash, BLOCK_HASH_LEN);
+    ChainLogPut32(pui8Ckpt + 44, Crc32(0, pui8Ckpt, 44));
+
+    if(!ChainLogFsWriteCheckpoint(pui8Ckpt))
+    {
+        g_sStats.ui32Failures++;
+        return false;
+    }
+    g_bHaveCheckpoint = true;
+    g_ui32CheckpointHeight = g_ui32LastHeight;
+    g_sStats.ui32Checkpoints++;
+    ChainLogSnapshot(false);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Length of the log record of a block
+//!
+//! \param psBlock is the block
+//!
+//! \return the record length in bytes
+//
+//*****************************************************************************
+uint32_t
+ChainLogRecordLen(const struct Block *psBlock)
+{
+    return CHAIN_LOG_RECORD_HDR + CHAIN_LOG_PAYLOAD_MIN +
+           psBlock->header.data_len + psBlock->tag_len + CHAIN_LOG_RECORD_CRC;
+}
+
+//*****************************************************************************
+//
+//! Encode a block as a log record
+//!
+//! \param psBlock is the block, already hashed
+//! \param pui8Record receives the record, up to CHAIN_LOG_RECORD_MAX bytes
+//!
+//! \return the record length in bytes
+//
+//*****************************************************************************
+uint32_t
+ChainLogEncode(const struct Block *psBlock, uint8_t *pui8Record)
+{
+    uint32_t ui32Payload = CHAIN_LOG_PAYLOAD_MIN + psBlock->header.data_len +
+                           psBlock->tag_len;
+
+    ChainLogPut32(pui8Record, CHAIN_LOG_MAGIC);
+    ChainLogPut32(pui8Record + 4, ui32Payload);
+    block_header_serialize(&psBlock->header,
+                           pui8Record + CHAIN_LOG_RECORD_HDR);
+    memcpy(pui8Record + CHAIN_LOG_RECORD_HDR + BLOCK_HEADER_LEN,
+           psBlock->hash, BLOCK_HASH_LEN);
+    memcpy(pui8Record + CHAIN_LOG_RECORD_HDR + CHAIN_LOG_PAYLOAD_MIN,
+           psBlock->data, psBlock->header.data_len);
+    memcpy(pui8Record + CHAIN_LOG_RECORD_HDR + CHAIN_LOG_PAYLOAD_MIN +
+           psBlock->header.data_len, psBlock->tag, psBlock->tag_len);
+    ChainLogPut32(pui8Record + CHAIN_LOG_RECORD_HDR + ui32Payload,
+                  Crc32(0, pui8Record, CHAIN_LOG_RECORD_HDR + ui32Payload));
+
+    return CHAIN_LOG_RECORD_HDR + ui32Payload + CHAIN_LOG_RECORD_CRC;
+}
+
+//*****************************************************************************
+//
+//! Check and decode a log record
+//!
+//! \param pui8Record is the record
+//! \param ui32Length is the number of bytes available at pui8Record
+//! \param psBlock receives the header, hash, transactions and tag
+//!
+//! \return the record length in bytes, or 0 if the record is short, has a
+//! bad checksum or does not hold a valid block
+//
+//*****************************************************************************
+uint32_t
+ChainLogDecode(const uint8_t *pui8Record, uint32_t ui32Length,
+               struct Block *psBlock)
+{
+    const uint8_t *pui8Payload = pui8Record + CHAIN_LOG_RECORD_HDR;
+    uint32_t ui32Payload;
+
+    if(ui32Length < CHAIN_LOG_RECORD_HDR)
+    {
+        return 0;
+    }
+    ui32Payload = ChainLogGet32(pui8Record + 4);
+    if((ChainLogGet32(pui8Record) != CHAIN_LOG_MAGIC) ||
+       (ui32Payload < CHAIN_LOG_PAYLOAD_MIN) ||
+       (ui32Payload > CHAIN_LOG_PAYLOAD_MAX) ||
+       (ui32Length - CHAIN_LOG_RECORD_HDR <
+        ui32Payload + CHAIN_LOG_RECORD_CRC) ||
+       (ChainLogGet32(pui8Payload + ui32Payload) !=
+        Crc32(0, pui8Record, CHAIN_LOG_RECORD_HDR + ui32Payload)))
+    {
+        return 0;
+    }
+
+    if(block_header_deserialize(pui8Payload, &psBlock->header) != 0)
+    {
+        return 0;
+    }
+    psBlock->tag_len = ui32Payload - CHAIN_LOG_PAYLOAD_MIN -
+                       psBlock->header.data_len;
+    if((ui32Payload < CHAIN_LOG_PAYLOAD_MIN + psBlock->header.data_len) ||
+       ((psBlock->tag_len != 0) && (psBlock->tag_len != BLOCK_TAG_LEN)))
+    {
+        return 0;
+    }
+    memcpy(psBlock->hash, pui8Payload + BLOCK_HEADER_LEN, BLOCK_HASH_LEN);
+    memcpy(psBlock->data, pui8Payload + CHAIN_LOG_PAYLOAD_MIN,
+           psBlock->header.data_len);
+    memcpy(psBlock->tag, pui8Payload + CHAIN_LOG_PAYLOAD_MIN +
+           psBlock->header.data_len, psBlock->tag_len);
+
+    return CHAIN_LOG_RECORD_HDR + ui32Payload + CHAIN_LOG_RECORD_CRC;
+}
+
+//*****************************************************************************
+//
+//! Open the log and rebuild the chain from it. A usable snapshot restores
+//! the retained window directly and only the records after it are read.
+//! Blocks covered by the checkpoint are only checked for their record
+//! checksum and their link to the previous block; blocks after it are fully
+//! re-verified. The log is cut back to the last good record.
+//!
+//! \param pcName is the log name
+//! \param psStore is an empty chain store that receives the blocks
+//! \param bSnapshot enables restoring from, and taking, snapshots; without
+//! it the whole log is replayed
+//!
+//! \return false if the log cannot be opened
+//
+//*****************************************************************************
+bool
+ChainLogOpen(const char *pcName, tChainStore *psStore, bool bSnapshot)
+{
+    uint8_t pui8Ckpt[CHAIN_LOG_CKPT_LEN];
+    uint32_t ui32CkptLength = 0;
+    uint32_t ui32CkptHeight = 0;
+    uint32_t ui32Length, ui32Offset, ui32Payload, ui32Record;
+    struct Block *psBlock, *psTip;
+    unsigned int uiBad;
+    bool bTrusted, bValid;
+
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    g_ui32BatchLen = 0;
+    g_bHaveLast = false;
+    g_bHaveCheckpoint = false;
+    g_psStore = psStore;
+    g_bSnapshots = bSnapshot;
+    g_bHaveSnapshot = false;
+    if(!ChainLogFsOpen(pcName))
+    {
+        g_bLogOpen = false;
+        return false;
+    }
+    ui32Length = ChainLogFsLength();
+
+    //
+    // A checkpoint is only used if it is intact and within the log.
+    //
+    if(ChainLogFsReadCheckpoint(pui8Ckpt) &&
+       (ChainLogGet32(pui8Ckpt) == CHAIN_LOG_CKPT_MAGIC) &&
+       (ChainLogGet32(pui8Ckpt + 44) == Crc32(0, pui8Ckpt, 44)) &&
+       (ChainLogGet32(pui8Ckpt + 8) <= ui32Length))
+    {
+        ui32CkptHeight = ChainLogGet32(pui8Ckpt + 4);
+        ui32CkptLength = ChainLogGet32(pui8Ckpt + 8);
+    }
+
+    //
+    // Start after the snapshot if there is one that matches the log, else
+    // at the oldest record kept.
+    //
+    ui32Offset = ChainLogFsStart();
+    if(g_bSnapshots && (CHAIN_LOG_SNAPSHOT_BLOCKS != 0) &&
+       ChainSnapshotLoad(psStore, ui32Length, &ui32Offset))
+    {
+        g_sStats.ui32Restored = ChainStoreCount(psStore);
+        g_bHaveSnapshot = true;
+        g_ui32SnapshotHeight = ChainStoreTip(psStore)->header.height;
+    }
+
+    while(ui32Offset + CHAIN_LOG_RECORD_HDR <= ui32Length)
+    {
+        if(ChainLogFsRead(ui32Offset, g_pui8Batch, CHAIN_LOG_RECORD_HDR) !=
+           CHAIN_LOG_RECORD_HDR)
+        {
+            break;
+        }
+        ui32Payload = ChainLogGet32(g_pui8Batch + 4);
+        ui32Record = CHAIN_LOG_RECORD_HDR + ui32Payload + CHAIN_LOG_RECORD_CRC;
+        if((ChainLogGet32(g_pui8Batch) != CHAIN_LOG_MAGIC) ||
+           (ui32Payload < CHAIN_LOG_PAYLOAD_MIN) ||
+           (ui32Payload > CHAIN_LOG_PAYLOAD_MAX) ||
+           (ui32Record > ui32Length - ui32Offset))
+        {
+            break;
+        }
+        if(ChainLogFsRead(ui32Offset + CHAIN_LOG_RECORD_HDR,
+                          g_pui8Batch + CHAIN_LOG_RECORD_HDR,
+                          ui32Payload + CHAIN_LOG_RECORD_CRC) !=
+           ui32Payload + CHAIN_LOG_RECORD_CRC)
+        {
+            break;
+        }
+
+        psBlock = BlockPoolAlloc();
+        if(psBlock == NULL)
+        {
+            break;
+        }
+        psTip = ChainStoreTip(psStore);
+        bTrusted = (ui32Offset + ui32Record <= ui32CkptLength);
+        bValid = (ChainLogDecode(g_pui8Batch, ui32Record, psBlock) != 0);
+        if(bValid && bTrusted)
+        {
+            bValid = (psTip == NULL) ||
+                     ((psBlock->header.height == psTip->header.height + 1) &&
+                      !memcmp(psBlock->header.pHash, psTip->hash,
+                              BLOCK_HASH_LEN));
+
+            //
+            // The record the checkpoint ends on must be the block it names.
+            //
+            if(bValid && (ui32Offset + ui32Record == ui32CkptLength))
+            {
+                bValid = (psBlock->header.height == ui32CkptHeight) &&
+                         !memcmp(psBlock->hash, pui8Ckpt + 12,
+                                 BLOCK_HASH_LEN);
+            }
+        }
+        else if(bValid)
+        {
+            //
+            // In an authenticated chain both checks also require the tag.
+            //
+            bValid = (psTip != NULL) ?
+                     verify_block(psBlock, psTip) :
+                     verify_chain(&psBlock, 1, psBlock->header.pHash, &uiBad);
+        }
+        if(!bValid || !ChainStoreAppend(psStore, psBlock))
+        {
+            BlockPoolFree(psBlock);
+            break;
+        }
+
+        g_sStats.ui32Recovered++;
+        if(bTrusted)
+        {
+            g_sStats.ui32Trusted++;
+        }
+        else
+        {
+            g_sStats.ui32Verified++;
+        }
+        ui32Offset += ui32Record;
+    }
+
+    //
+    // Drop a torn or damaged tail so that new records follow good ones.
+    //
+    if(ui32Offset < ui32Length)
+    {
+        g_sStats.ui32DroppedBytes = ui32Length - ui32Offset;
+        if(!ChainLogFsTruncate(ui32Offset, g_pui8Batch,
+                               sizeof(g_pui8Batch)))
+        {
+            g_sStats.ui32Failures++;
+            ChainLogFsClose();
+            g_bLogOpen = false;
+            return false;
+        }
+    }
+    g_ui32LogLength = ui32Offset;
+    g_bLogOpen = true;
+
+    psTip = ChainStoreTip(psStore);
+    if(psTip != NULL)
+    {
+        g_bHaveLast = true;
+        g_ui32LastHeight = psTip->header.height;
+        memcpy(g_pui8LastHash, psTip->hash, BLOCK_HASH_LEN);
+        if((ui32CkptLength != 0) && (ui32CkptLength <= ui32Offset))
+        {
+            g_bHaveCheckpoint = true;
+            g_ui32CheckpointHeight = ui32CkptHeight;
+        }
+
+        //
+        // Move the checkpoint over what was just verified so that the next
+        // start does not verify it again. A checkpoint past the cut is
+        // replaced before it can vouch for records written after it.
+        //
+        if(!g_bHaveCheckpoint || (g_sStats.ui32Verified != 0))
+        {
+            ChainLogCheckpoint();
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Queue a block for the log. The block is written with the rest of its
+//! batch; a full batch, or a full checkpoint interval, is written first.
+//!
+//! \param psBlock is the new tip, already hashed
+//!
+//! \return false if the log is not open or a write failed; the block is
+//! then not logged, and counted in ui32Unlogged
+//
+//*****************************************************************************
+bool
+ChainLogAppend(const struct Block *psBlock)
+{
+    uint32_t ui32Record;
+
+    if(!g_bLogOpen || (psBlock->header.data_len > BLOCK_DATA_LEN))
+    {
+        g_sStats.ui32Unlogged++;
+        return false;
+    }
+
+    ui32Record = ChainLogRecordLen(psBlock);
+    if((g_ui32BatchLen + ui32Record > sizeof(g_pui8Batch)) &&
+       !ChainLogFlush())
+    {
+        g_sStats.ui32Unlogged++;
+        return false;
+    }
+    g_ui32BatchLen += ChainLogEncode(psBlock, g_pui8Batch + g_ui32BatchLen);
+
+    g_bHaveLast = true;
+    g_ui32LastHeight = psBlock->header.height;
+    memcpy(g_pui8LastHash, psBlock->hash, BLOCK_HASH_LEN);
+    g_sStats.ui32Logged++;
+
+    if(!g_bHaveCheckpoint ||
+       (g_ui32LastHeight - g_ui32CheckpointHeight >=
+        CHAIN_LOG_CHECKPOINT_BLOCKS))
+    {
+        return ChainLogFlush();
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Write the queued records, then move the checkpoint if it is a full
+//! interval behind
+//!
+//! \param None
+//!
+//! \return false if the write failed; the records stay queued
+//
+//*****************************************************************************
+bool
+ChainLogFlush(void)
+{
+    if(!g_bLogOpen)
+    {
+        return false;
+    }
+
+    if(g_ui32BatchLen != 0)
+    {
+        if(!ChainLogFsAppend(g_pui8Batch, g_ui32BatchLen))
+        {
+            g_sStats.ui32Failures++;
+            return false;
+        }
+        g_ui32LogLength += g_ui32BatchLen;
+        g_sStats.ui32Flushes++;
+        g_sStats.ui32BytesWritten += g_ui32BatchLen;
+        g_ui32BatchLen = 0;
+    }
+
+    if(g_bHaveLast &&
+       (!g_bHaveCheckpoint ||
+        (g_ui32LastHeight - g_ui32CheckpointHeight >=
+         CHAIN_LOG_CHECKPOINT_BLOCKS)))
+    {
+        return ChainLogCheckpoint();
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Write everything queued, checkpoint and snapshot the tip and close the
+//! log
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ChainLogClose(void)
+{
+    if(!g_bLogOpen)
+    {
+        return;
+    }
+
+    if(ChainLogFlush() && g_bHaveLast &&
+       (g_ui32CheckpointHeight != g_ui32LastHeight))
+    {
+        ChainLogCheckpoint();
+    }
+    ChainLogSnapshot(true);
+    ChainLogFsClose();
+    g_bLogOpen = false;
+}
+
+//*****************************************************************************
+//
+//! Durable length of the log
+//!
+//! \param None
+//!
+//! \return the bytes written so far, not counting queued records
+//
+//*****************************************************************************
+uint32_t
+ChainLogLength(void)
+{
+    return g_ui32LogLength;
+}
+
+//*****************************************************************************
+//
+//! Get a snapshot of the log statistics
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ChainLogStatsGet(tChainLogStats *psStats)
+{
+    *psStats = g_sStats;
+}
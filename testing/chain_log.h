@@ -0,0 +1,191 @@
+//*****************************************************************************
+// chain_log.h
+//
+// Persistent, append-only block log. Blocks are written as checksummed
+// records in batches; a checkpoint of the durable tip lets startup trust
+// everything it covers and re-verify only the blocks logged after it. On
+// the board the log lives on the serial flash file system, on the host in
+// an ordinary file.
+//
+//*****************************************************************************
+
+#ifndef __CHAIN_LOG_H__
+#define __CHAIN_LOG_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_store.h"
+
+//*****************************************************************************
+//
+// Log record. All integers are little-endian:
+//
+//   offset  size  field
+//        0     4  CHAIN_LOG_MAGIC
+//        4     4  payload length n
+//        8    84  serialized block header
+//       92    32  block hash
+//      124     -  transactions (header data_len bytes)
+//        -    32  authentication tag, in an authenticated chain only
+//      8+n     4  CRC-32 of bytes 0 .. 8+n-1
+//
+// A record has a tag exactly when n is 116 + data_len + BLOCK_TAG_LEN, so
+// logs written before tags existed read unchanged.
+//
+// A record that is short, has a bad checksum or does not follow the
+// previous block ends the log; anything after it is cut off at startup.
+//
+//*****************************************************************************
+#define CHAIN_LOG_MAGIC             0x314B4C42
+#define CHAIN_LOG_RECORD_HDR        8
+#define CHAIN_LOG_RECORD_CRC        4
+#define CHAIN_LOG_PAYLOAD_MIN       (BLOCK_HEADER_LEN + BLOCK_HASH_LEN)
+#define CHAIN_LOG_PAYLOAD_MAX       (CHAIN_LOG_PAYLOAD_MIN + BLOCK_DATA_LEN + \
+                                     BLOCK_TAG_LEN)
+#define CHAIN_LOG_RECORD_MAX        (CHAIN_LOG_RECORD_HDR +                   \
+                                     CHAIN_LOG_PAYLOAD_MAX +                  \
+                                     CHAIN_LOG_RECORD_CRC)
+
+//*****************************************************************************
+//
+// Checkpoint, kept beside the log:
+//
+//   offset  size  field
+//        0     4  CHAIN_LOG_CKPT_MAGIC
+//        4     4  height of the checkpointed block
+//        8     4  log length up to and including that block's record
+//       12    32  hash of the checkpointed block
+//       44     4  CRC-32 of bytes 0 .. 43
+//
+//*****************************************************************************
+#define CHAIN_LOG_CKPT_MAGIC        0x31504B43
+#define CHAIN_LOG_CKPT_LEN          48
+
+//*****************************************************************************
+//
+// Records are collected in RAM and written CHAIN_LOG_BATCH_BYTES at a time,
+// which on the board is one flash file per batch. A batch is also written,
+// and the checkpoint moved, once CHAIN_LOG_CHECKPOINT_BLOCKS blocks have
+// been logged since the last checkpoint; that bounds both the blocks a
+// reset can lose and the blocks startup has to re-hash.
+//
+//*****************************************************************************
+#ifndef CHAIN_LOG_BATCH_BYTES
+#if defined(cc3200)
+#define CHAIN_LOG_BATCH_BYTES       2048
+#else
+#define CHAIN_LOG_BATCH_BYTES       65536
+#endif
+#endif
+
+#ifndef CHAIN_LOG_CHECKPOINT_BLOCKS
+#define CHAIN_LOG_CHECKPOINT_BLOCKS 64
+#endif
+
+//*****************************************************************************
+//
+// A snapshot of the chain store (chain_snapshot.h) is taken with the first
+// checkpoint at least CHAIN_LOG_SNAPSHOT_BLOCKS blocks after the previous
+// snapshot, and when the log is closed. Startup restores it and replays
+// only the records after it, so once it is written the log before its tip's
+// record is no longer needed and the board deletes it. 0 turns snapshots
+// off, and with them that cleanup.
+//
+//*****************************************************************************
+#ifndef CHAIN_LOG_SNAPSHOT_BLOCKS
+#define CHAIN_LOG_SNAPSHOT_BLOCKS   256
+#endif
+
+//*****************************************************************************
+//
+// Log name: a file name on the host, the stem of the segment files on the
+// board.
+//
+//*****************************************************************************
+#ifndef CHAIN_LOG_NAME
+#define CHAIN_LOG_NAME              "chain.log"
+#endif
+
+#define CHAIN_LOG_NAME_LEN          64
+
+typedef struct
+{
+    uint32_t ui32Restored;
+    uint32_t ui32Recovered;
+    uint32_t ui32Trusted;
+    uint32_t ui32Verified;
+    uint32_t ui32DroppedBytes;
+    uint32_t ui32Logged;
+    uint32_t ui32Unlogged;
+    uint32_t ui32Flushes;
+    uint32_t ui32BytesWritten;
+    uint32_t ui32Checkpoints;
+    uint32_t ui32Snapshots;
+    uint32_t ui32Failures;
+} tChainLogStats;
+
+extern uint32_t ChainLogRecordLen(const struct Block *psBlock);
+extern uint32_t ChainLogEncode(const struct Block *psBlock,
+                               uint8_t *pui8Record);
+extern uint32_t ChainLogDecode(const uint8_t *pui8Record, uint32_t ui32Length,
+                               struct Block *psBlock);
+extern bool ChainLogOpen(const char *pcName, tChainStore *psStore,
+                         bool bSnapshot);
+extern bool ChainLogAppend(const struct Block *psBlock);
+extern bool ChainLogFlush(void);
+extern void ChainLogClose(void);
+extern uint32_t ChainLogLength(void);
+extern void ChainLogStatsGet(tChainLogStats *psStats);
+
+//*****************************************************************************
+//
+// Storage back end, one per build: a segmented log on the SimpleLink file
+// system (chain_log_fs.c, board) or a single file (host). Offsets are
+// positions in the log as if it were one file. ChainLogFsDiscard() lets the
+// back end drop storage wholly before an offset; the log then begins at
+// ChainLogFsStart() instead of 0.
+//
+//*****************************************************************************
+extern bool ChainLogFsOpen(const char *pcName);
+extern uint32_t ChainLogFsStart(void);
+extern uint32_t ChainLogFsLength(void);
+extern uint32_t ChainLogFsRead(uint32_t ui32Offset, uint8_t *pui8Data,
+                               uint32_t ui32Length);
+extern bool ChainLogFsAppend(const uint8_t *pui8Data, uint32_t ui32Length);
+extern bool ChainLogFsTruncate(uint32_t ui32Length, uint8_t *pui8Scratch,
+                               uint32_t ui32ScratchLen);
+extern bool ChainLogFsDiscard(uint32_t ui32Offset);
+extern bool ChainLogFsReadCheckpoint(uint8_t *pui8Data);
+extern bool ChainLogFsWriteCheckpoint(const uint8_t *pui8Data);
+extern bool ChainLogFsSnapshotOpen(bool bWrite, uint32_t ui32MaxLength);
+extern uint32_t ChainLogFsSnapshotRead(uint32_t ui32Offset, uint8_t *pui8Data,
+                                       uint32_t ui32Length);
+extern bool ChainLogFsSnapshotWrite(uint32_t ui32Offset,
+                                    const uint8_t *pui8Data,
+                                    uint32_t ui32Length);
+extern bool ChainLogFsSnapshotClose(bool bCommit);
+extern void ChainLogFsClose(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CHAIN_LOG_H__
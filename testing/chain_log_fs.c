@@ -0,0 +1,732 @@
+//*****************************************************************************
+// chain_log_fs.c
+//
+// Storage for the block log
+//
+// The SimpleLink file system on the board cannot append to an existing file:
+// opening one for writing starts it afresh. The log is therefore a series of
+// segment files, "<name>.0", "<name>.1", ..., one per written batch, each
+// created with the commit flag so that a reset during the write leaves
+// either the whole segment or none of it. Segments wholly before the last
+// snapshot are deleted once it is written, and "<name>.head" records where
+// the remaining ones start. The checkpoint is a single fail-safe file,
+// "<name>.ckpt", and so is the chain snapshot, "<name>.snap". The network
+// processor must be started (sl_Start) before the log is opened.
+//
+// On the host the log is one file, appended with write and fsync and never
+// shortened at the front, and the checkpoint and snapshot are replaced
+// atomically by renaming a temporary file over them.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(cc3200)
+#include "simplelink.h"
+#else
+#include <unistd.h>
+#endif
+
+#include "chain_log.h"
+#include "crc32.h"
+
+static char g_pcLogName[CHAIN_LOG_NAME_LEN];
+
+#if defined(cc3200)
+//*****************************************************************************
+//
+// Board: segment files on the serial flash
+//
+//*****************************************************************************
+
+//
+// Most segments kept at once. Each costs a flash file; at one per batch this
+// is CHAIN_LOG_MAX_SEGMENTS * CHAIN_LOG_BATCH_BYTES of blocks written since
+// the last snapshot, which is far more than CHAIN_LOG_SNAPSHOT_BLOCKS.
+//
+#ifndef CHAIN_LOG_MAX_SEGMENTS
+#define CHAIN_LOG_MAX_SEGMENTS  128
+#endif
+
+#define CHAIN_LOG_FS_FLAGS      (_FS_FILE_OPEN_FLAG_COMMIT |                  \
+                                 _FS_FILE_PUBLIC_WRITE)
+
+//
+// Start of the log after discarded segments:
+//
+//   offset  size  field
+//        0     4  CHAIN_LOG_HEAD_MAGIC
+//        4     4  number of the first segment kept
+//        8     4  log offset that segment starts at
+//       12     4  CRC-32 of bytes 0 .. 11
+//
+// Without the file the log starts with segment 0 at offset 0.
+//
+#define CHAIN_LOG_HEAD_MAGIC    0x31444548
+#define CHAIN_LOG_HEAD_LEN      16
+
+static uint32_t g_ui32FirstSegment;
+static uint32_t g_ui32FirstStart;
+
+//
+// End offset in the log of each segment kept, oldest first.
+//
+static uint32_t g_pui32SegmentEnd[CHAIN_LOG_MAX_SEGMENTS];
+static uint32_t g_ui32Segments;
+
+//
+// The segment being read stays open between reads; recovery reads record
+// by record.
+//
+static _i32 g_i32ReadHandle = -1;
+static uint32_t g_ui32ReadSegment;
+
+static char g_pcFileName[CHAIN_LOG_NAME_LEN + 16];
+
+static void
+ChainLogFsPut32(uint8_t *pui8Out, uint32_t ui32Value)
+{
+    pui8Out[0] = (uint8_t)ui32Value;
+    pui8Out[1] = (uint8_t)(ui32Value >> 8);
+    pui8Out[2] = (uint8_t)(ui32Value >> 16);
+    pui8Out[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static uint32_t
+ChainLogFsGet32(const uint8_t *pui8In)
+{
+    return (uint32_t)pui8In[0] | ((uint32_t)pui8In[1] << 8) |
+           ((uint32_t)pui8In[2] << 16) | ((uint32_t)pui8In[3] << 24);
+}
+
+//
+// File name of segment number ui32Number.
+//
+static unsigned char *
+ChainLogFsNumberedName(uint32_t ui32Number)
+{
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.%u", g_pcLogName,
+             (unsigned int)ui32Number);
+
+    return (unsigned char *)g_pcFileName;
+}
+
+//
+// File name of the ui32Segment'th segment kept.
+//
+static unsigned char *
+ChainLogFsSegmentName(uint32_t ui32Segment)
+{
+    return ChainLogFsNumberedName(g_ui32FirstSegment + ui32Segment);
+}
+
+static uint32_t
+ChainLogFsSegmentStart(uint32_t ui32Segment)
+{
+    return (ui32Segment == 0) ? g_ui32FirstStart :
+           g_pui32SegmentEnd[ui32Segment - 1];
+}
+
+static void
+ChainLogFsCloseRead(void)
+{
+    if(g_i32ReadHandle >= 0)
+    {
+        sl_FsClose(g_i32ReadHandle, NULL, NULL, 0);
+        g_i32ReadHandle = -1;
+    }
+}
+
+//
+// Write one new segment; a failed write is abandoned so that the previous
+// state of the file system is kept.
+//
+static bool
+ChainLogFsWriteSegment(uint32_t ui32Segment, const uint8_t *pui8Data,
+                       uint32_t ui32Length)
+{
+    _i32 i32Handle;
+    _i32 i32Written;
+
+    sl_FsDel(ChainLogFsSegmentName(ui32Segment), 0);
+    if(sl_FsOpen(ChainLogFsSegmentName(ui32Segment),
+                 FS_MODE_OPEN_CREATE(ui32Length, CHAIN_LOG_FS_FLAGS), NULL,
+                 &i32Handle) < 0)
+    {
+        return false;
+    }
+    i32Written = sl_FsWrite(i32Handle, 0, (unsigned char *)pui8Data,
+                            ui32Length);
+    if(i32Written != (_i32)ui32Length)
+    {
+        sl_FsClose(i32Handle, NULL, (unsigned char *)"A", 1);
+        return false;
+    }
+
+    return sl_FsClose(i32Handle, NULL, NULL, 0) == 0;
+}
+
+//
+// Read a small file written by ChainLogFsWriteSmall(), "<name>.<suffix>".
+//
+static bool
+ChainLogFsReadSmall(const char *pcSuffix, uint8_t *pui8Data,
+                    uint32_t ui32Length)
+{
+    _i32 i32Handle;
+    _i32 i32Read;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.%s", g_pcLogName,
+             pcSuffix);
+    if(sl_FsOpen((unsigned char *)g_pcFileName, FS_MODE_OPEN_READ, NULL,
+                 &i32Handle) < 0)
+    {
+        return false;
+    }
+    i32Read = sl_FsRead(i32Handle, 0, pui8Data, ui32Length);
+    sl_FsClose(i32Handle, NULL, NULL, 0);
+
+    return i32Read == (_i32)ui32Length;
+}
+
+//
+// Replace a small file, "<name>.<suffix>". The file is fail-safe: until the
+// close commits it, a reset leaves the previous contents in place.
+//
+static bool
+ChainLogFsWriteSmall(const char *pcSuffix, const uint8_t *pui8Data,
+                     uint32_t ui32Length)
+{
+    _i32 i32Handle;
+    _i32 i32Written;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.%s", g_pcLogName,
+             pcSuffix);
+    if((sl_FsOpen((unsigned char *)g_pcFileName, FS_MODE_OPEN_WRITE, NULL,
+                  &i32Handle) < 0) &&
+       (sl_FsOpen((unsigned char *)g_pcFileName,
+                  FS_MODE_OPEN_CREATE(ui32Length, CHAIN_LOG_FS_FLAGS),
+                  NULL, &i32Handle) < 0))
+    {
+        return false;
+    }
+    i32Written = sl_FsWrite(i32Handle, 0, (unsigned char *)pui8Data,
+                            ui32Length);
+    if(i32Written != (_i32)ui32Length)
+    {
+        sl_FsClose(i32Handle, NULL, (unsigned char *)"A", 1);
+        return false;
+    }
+
+    return sl_FsClose(i32Handle, NULL, NULL, 0) == 0;
+}
+
+bool
+ChainLogFsOpen(const char *pcName)
+{
+    uint8_t pui8Head[CHAIN_LOG_HEAD_LEN];
+    SlFsFileInfo_t sInfo;
+    uint32_t ui32Number;
+
+    strncpy(g_pcLogName, pcName, sizeof(g_pcLogName) - 1);
+    g_pcLogName[sizeof(g_pcLogName) - 1] = '\0';
+    g_i32ReadHandle = -1;
+
+    g_ui32FirstSegment = 0;
+    g_ui32FirstStart = 0;
+    if(ChainLogFsReadSmall("head", pui8Head, sizeof(pui8Head)) &&
+       (ChainLogFsGet32(pui8Head) == CHAIN_LOG_HEAD_MAGIC) &&
+       (ChainLogFsGet32(pui8Head + 12) == Crc32(0, pui8Head, 12)))
+    {
+        g_ui32FirstSegment = ChainLogFsGet32(pui8Head + 4);
+        g_ui32FirstStart = ChainLogFsGet32(pui8Head + 8);
+    }
+
+    //
+    // A reset part way through ChainLogFsDiscard() leaves the newest of
+    // the segments it dropped behind; they go now.
+    //
+    for(ui32Number = g_ui32FirstSegment;
+        (ui32Number > 0) &&
+        (sl_FsDel(ChainLogFsNumberedName(ui32Number - 1), 0) == 0);
+        ui32Number--)
+    {
+    }
+
+    for(g_ui32Segments = 0; g_ui32Segments < CHAIN_LOG_MAX_SEGMENTS;
+        g_ui32Segments++)
+    {
+        if(sl_FsGetInfo(ChainLogFsSegmentName(g_ui32Segments), 0,
+                        &sInfo) < 0)
+        {
+            break;
+        }
+        g_pui32SegmentEnd[g_ui32Segments] =
+            ChainLogFsSegmentStart(g_ui32Segments) + sInfo.FileLen;
+    }
+
+    return true;
+}
+
+uint32_t
+ChainLogFsStart(void)
+{
+    return g_ui32FirstStart;
+}
+
+uint32_t
+ChainLogFsLength(void)
+{
+    return ChainLogFsSegmentStart(g_ui32Segments);
+}
+
+uint32_t
+ChainLogFsRead(uint32_t ui32Offset, uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Segment, ui32Chunk, ui32Done = 0;
+
+    for(ui32Segment = 0; (ui32Segment < g_ui32Segments) &&
+        (g_pui32SegmentEnd[ui32Segment] <= ui32Offset); ui32Segment++)
+    {
+    }
+
+    while((ui32Done < ui32Length) && (ui32Segment < g_ui32Segments))
+    {
+        if((g_i32ReadHandle < 0) || (g_ui32ReadSegment != ui32Segment))
+        {
+            ChainLogFsCloseRead();
+            if(sl_FsOpen(ChainLogFsSegmentName(ui32Segment),
+                         FS_MODE_OPEN_READ, NULL, &g_i32ReadHandle) < 0)
+            {
+                g_i32ReadHandle = -1;
+                break;
+            }
+            g_ui32ReadSegment = ui32Segment;
+        }
+
+        ui32Chunk = g_pui32SegmentEnd[ui32Segment] - ui32Offset;
+        if(ui32Chunk > ui32Length - ui32Done)
+        {
+            ui32Chunk = ui32Length - ui32Done;
+        }
+        if(sl_FsRead(g_i32ReadHandle,
+                     ui32Offset - ChainLogFsSegmentStart(ui32Segment),
+                     pui8Data + ui32Done, ui32Chunk) != (_i32)ui32Chunk)
+        {
+            break;
+        }
+        ui32Done += ui32Chunk;
+        ui32Offset += ui32Chunk;
+        ui32Segment++;
+    }
+
+    return ui32Done;
+}
+
+bool
+ChainLogFsAppend(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    if(g_ui32Segments == CHAIN_LOG_MAX_SEGMENTS)
+    {
+        return false;
+    }
+
+    ChainLogFsCloseRead();
+    if(!ChainLogFsWriteSegment(g_ui32Segments, pui8Data, ui32Length))
+    {
+        return false;
+    }
+    g_pui32SegmentEnd[g_ui32Segments] =
+        ChainLogFsSegmentStart(g_ui32Segments) + ui32Length;
+    g_ui32Segments++;
+
+    return true;
+}
+
+bool
+ChainLogFsTruncate(uint32_t ui32Length, uint8_t *pui8Scratch,
+                   uint32_t ui32ScratchLen)
+{
+    uint32_t ui32Keep, ui32Prefix;
+
+    //
+    // Segments wholly before the cut stay; the one the cut falls in keeps
+    // its head, which is rewritten as a new segment.
+    //
+    for(ui32Keep = 0; (ui32Keep < g_ui32Segments) &&
+        (g_pui32SegmentEnd[ui32Keep] <= ui32Length); ui32Keep++)
+    {
+    }
+    ui32Prefix = ui32Length - ChainLogFsSegmentStart(ui32Keep);
+    if((ui32Prefix > ui32ScratchLen) ||
+       (ChainLogFsRead(ChainLogFsSegmentStart(ui32Keep), pui8Scratch,
+                       ui32Prefix) != ui32Prefix))
+    {
+        return false;
+    }
+
+    ChainLogFsCloseRead();
+    while(g_ui32Segments > ui32Keep)
+    {
+        sl_FsDel(ChainLogFsSegmentName(--g_ui32Segments), 0);
+    }
+
+    return (ui32Prefix == 0) ||
+           ChainLogFsAppend(pui8Scratch, ui32Prefix);
+}
+
+bool
+ChainLogFsDiscard(uint32_t ui32Offset)
+{
+    uint8_t pui8Head[CHAIN_LOG_HEAD_LEN];
+    uint32_t ui32Drop, ui32Idx;
+
+    for(ui32Drop = 0; (ui32Drop < g_ui32Segments) &&
+        (g_pui32SegmentEnd[ui32Drop] <= ui32Offset); ui32Drop++)
+    {
+    }
+    if(ui32Drop == 0)
+    {
+        return true;
+    }
+
+    //
+    // The new start is committed before any segment goes, so a reset in
+    // between leaves only files that the next open deletes.
+    //
+    ChainLogFsPut32(pui8Head, CHAIN_LOG_HEAD_MAGIC);
+    ChainLogFsPut32(pui8Head + 4, g_ui32FirstSegment + ui32Drop);
+    ChainLogFsPut32(pui8Head + 8, g_pui32SegmentEnd[ui32Drop - 1]);
+    ChainLogFsPut32(pui8Head + 12, Crc32(0, pui8Head, 12));
+    if(!ChainLogFsWriteSmall("head", pui8Head, sizeof(pui8Head)))
+    {
+        return false;
+    }
+
+    ChainLogFsCloseRead();
+    for(ui32Idx = 0; ui32Idx < ui32Drop; ui32Idx++)
+    {
+        sl_FsDel(ChainLogFsSegmentName(ui32Idx), 0);
+    }
+    g_ui32FirstStart = g_pui32SegmentEnd[ui32Drop - 1];
+    g_ui32FirstSegment += ui32Drop;
+    g_ui32Segments -= ui32Drop;
+    memmove(g_pui32SegmentEnd, g_pui32SegmentEnd + ui32Drop,
+            g_ui32Segments * sizeof(g_pui32SegmentEnd[0]));
+
+    return true;
+}
+
+bool
+ChainLogFsReadCheckpoint(uint8_t *pui8Data)
+{
+    return ChainLogFsReadSmall("ckpt", pui8Data, CHAIN_LOG_CKPT_LEN);
+}
+
+bool
+ChainLogFsWriteCheckpoint(const uint8_t *pui8Data)
+{
+    return ChainLogFsWriteSmall("ckpt", pui8Data, CHAIN_LOG_CKPT_LEN);
+}
+
+//
+// The snapshot file is fail-safe like the checkpoint: writes go to a shadow
+// copy that the closing commit swaps in, and an aborted close keeps the old
+// snapshot.
+//
+static _i32 g_i32SnapshotHandle = -1;
+
+bool
+ChainLogFsSnapshotOpen(bool bWrite, uint32_t ui32MaxLength)
+{
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.snap", g_pcLogName);
+    if(!bWrite)
+    {
+        return sl_FsOpen((unsigned char *)g_pcFileName, FS_MODE_OPEN_READ,
+                         NULL, &g_i32SnapshotHandle) >= 0;
+    }
+
+    if((sl_FsOpen((unsigned char *)g_pcFileName, FS_MODE_OPEN_WRITE, NULL,
+                  &g_i32SnapshotHandle) < 0) &&
+       (sl_FsOpen((unsigned char *)g_pcFileName,
+                  FS_MODE_OPEN_CREATE(ui32MaxLength, CHAIN_LOG_FS_FLAGS),
+                  NULL, &g_i32SnapshotHandle) < 0))
+    {
+        g_i32SnapshotHandle = -1;
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t
+ChainLogFsSnapshotRead(uint32_t ui32Offset, uint8_t *pui8Data,
+                       uint32_t ui32Length)
+{
+    _i32 i32Read;
+
+    i32Read = sl_FsRead(g_i32SnapshotHandle, ui32Offset, pui8Data,
+                        ui32Length);
+
+    return (i32Read < 0) ? 0 : (uint32_t)i32Read;
+}
+
+bool
+ChainLogFsSnapshotWrite(uint32_t ui32Offset, const uint8_t *pui8Data,
+                        uint32_t ui32Length)
+{
+    return sl_FsWrite(g_i32SnapshotHandle, ui32Offset,
+                      (unsigned char *)pui8Data, ui32Length) ==
+           (_i32)ui32Length;
+}
+
+bool
+ChainLogFsSnapshotClose(bool bCommit)
+{
+    _i32 i32Result;
+
+    if(g_i32SnapshotHandle < 0)
+    {
+        return false;
+    }
+    i32Result = bCommit ?
+                sl_FsClose(g_i32SnapshotHandle, NULL, NULL, 0) :
+                sl_FsClose(g_i32SnapshotHandle, NULL, (unsigned char *)"A",
+                           1);
+    g_i32SnapshotHandle = -1;
+
+    return bCommit && (i32Result == 0);
+}
+
+void
+ChainLogFsClose(void)
+{
+    ChainLogFsCloseRead();
+}
+#else
+//*****************************************************************************
+//
+// Host: one ordinary file
+//
+//*****************************************************************************
+static FILE *g_psLogFile;
+static uint32_t g_ui32LogFileLength;
+static char g_pcFileName[CHAIN_LOG_NAME_LEN + 16];
+
+bool
+ChainLogFsOpen(const char *pcName)
+{
+    long lLength;
+
+    strncpy(g_pcLogName, pcName, sizeof(g_pcLogName) - 1);
+    g_pcLogName[sizeof(g_pcLogName) - 1] = '\0';
+
+    g_psLogFile = fopen(g_pcLogName, "r+b");
+    if(g_psLogFile == NULL)
+    {
+        g_psLogFile = fopen(g_pcLogName, "w+b");
+    }
+    if((g_psLogFile == NULL) || (fseek(g_psLogFile, 0, SEEK_END) != 0) ||
+       ((lLength = ftell(g_psLogFile)) < 0))
+    {
+        ChainLogFsClose();
+        return false;
+    }
+    g_ui32LogFileLength = (uint32_t)lLength;
+
+    return true;
+}
+
+uint32_t
+ChainLogFsStart(void)
+{
+    return 0;
+}
+
+uint32_t
+ChainLogFsLength(void)
+{
+    return g_ui32LogFileLength;
+}
+
+uint32_t
+ChainLogFsRead(uint32_t ui32Offset, uint8_t *pui8Data, uint32_t ui32Length)
+{
+    if(fseek(g_psLogFile, (long)ui32Offset, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)fread(pui8Data, 1, ui32Length, g_psLogFile);
+}
+
+bool
+ChainLogFsAppend(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    if((fseek(g_psLogFile, (long)g_ui32LogFileLength, SEEK_SET) != 0) ||
+       (fwrite(pui8Data, 1, ui32Length, g_psLogFile) != ui32Length) ||
+       (fflush(g_psLogFile) != 0) || (fsync(fileno(g_psLogFile)) != 0))
+    {
+        //
+        // The length is not advanced, so the next append overwrites any
+        // partial batch, and recovery cuts off whatever is left past it.
+        //
+        return false;
+    }
+    g_ui32LogFileLength += ui32Length;
+
+    return true;
+}
+
+bool
+ChainLogFsTruncate(uint32_t ui32Length, uint8_t *pui8Scratch,
+                   uint32_t ui32ScratchLen)
+{
+    (void)pui8Scratch;
+    (void)ui32ScratchLen;
+
+    if((fflush(g_psLogFile) != 0) ||
+       (ftruncate(fileno(g_psLogFile), (off_t)ui32Length) != 0))
+    {
+        return false;
+    }
+    g_ui32LogFileLength = ui32Length;
+
+    return true;
+}
+
+bool
+ChainLogFsDiscard(uint32_t ui32Offset)
+{
+    (void)ui32Offset;
+
+    return true;
+}
+
+bool
+ChainLogFsReadCheckpoint(uint8_t *pui8Data)
+{
+    FILE *psFile;
+    size_t szRead;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.ckpt", g_pcLogName);
+    psFile = fopen(g_pcFileName, "rb");
+    if(psFile == NULL)
+    {
+        return false;
+    }
+    szRead = fread(pui8Data, 1, CHAIN_LOG_CKPT_LEN, psFile);
+    fclose(psFile);
+
+    return szRead == CHAIN_LOG_CKPT_LEN;
+}
+
+bool
+ChainLogFsWriteCheckpoint(const uint8_t *pui8Data)
+{
+    char pcTemp[CHAIN_LOG_NAME_LEN + 16];
+    FILE *psFile;
+    bool bOk;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.ckpt", g_pcLogName);
+    snprintf(pcTemp, sizeof(pcTemp), "%s.ckpt.tmp", g_pcLogName);
+    psFile = fopen(pcTemp, "wb");
+    if(psFile == NULL)
+    {
+        return false;
+    }
+    bOk = (fwrite(pui8Data, 1, CHAIN_LOG_CKPT_LEN, psFile) ==
+           CHAIN_LOG_CKPT_LEN) &&
+          (fflush(psFile) == 0) && (fsync(fileno(psFile)) == 0);
+    fclose(psFile);
+
+    return bOk && (rename(pcTemp, g_pcFileName) == 0);
+}
+
+//
+// A new snapshot is written beside the old one and renamed over it once
+// it is complete.
+//
+static FILE *g_psSnapshotFile;
+static bool g_bSnapshotWrite;
+
+bool
+ChainLogFsSnapshotOpen(bool bWrite, uint32_t ui32MaxLength)
+{
+    (void)ui32MaxLength;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.snap%s", g_pcLogName,
+             bWrite ? ".tmp" : "");
+    g_psSnapshotFile = fopen(g_pcFileName, bWrite ? "wb" : "rb");
+    g_bSnapshotWrite = bWrite;
+
+    return g_psSnapshotFile != NULL;
+}
+
+uint32_t
+ChainLogFsSnapshotRead(uint32_t ui32Offset, uint8_t *pui8Data,
+                       uint32_t ui32Length)
+{
+    if(fseek(g_psSnapshotFile, (long)ui32Offset, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)fread(pui8Data, 1, ui32Length, g_psSnapshotFile);
+}
+
+bool
+ChainLogFsSnapshotWrite(uint32_t ui32Offset, const uint8_t *pui8Data,
+                        uint32_t ui32Length)
+{
+    return (fseek(g_psSnapshotFile, (long)ui32Offset, SEEK_SET) == 0) &&
+           (fwrite(pui8Data, 1, ui32Length, g_psSnapshotFile) == ui32Length);
+}
+
+bool
+ChainLogFsSnapshotClose(bool bCommit)
+{
+    char pcFinal[CHAIN_LOG_NAME_LEN + 16];
+    bool bOk;
+
+    if(g_psSnapshotFile == NULL)
+    {
+        return false;
+    }
+    if(!g_bSnapshotWrite)
+    {
+        fclose(g_psSnapshotFile);
+        g_psSnapshotFile = NULL;
+        return bCommit;
+    }
+
+    bOk = bCommit && (fflush(g_psSnapshotFile) == 0) &&
+          (fsync(fileno(g_psSnapshotFile)) == 0);
+    fclose(g_psSnapshotFile);
+    g_psSnapshotFile = NULL;
+
+    snprintf(g_pcFileName, sizeof(g_pcFileName), "%s.snap.tmp", g_pcLogName);
+    snprintf(pcFinal, sizeof(pcFinal), "%s.snap", g_pcLogName);
+    if(!bOk)
+    {
+        remove(g_pcFileName);
+        return false;
+    }
+
+    return rename(g_pcFileName, pcFinal) == 0;
+}
+
+void
+ChainLogFsClose(void)
+{
+    if(g_psLogFile != NULL)
+    {
+        fclose(g_psLogFile);
+        g_psLogFile = NULL;
+    }
+}
+#endif
@@ -0,0 +1,553 @@
+//*****************************************************************************
+// chain_map.c
+//
+// Memory-mapped block log reader (host build only)
+//
+// The log is mapped read-only and walked record by record. Every record is
+// checked against its CRC as it is visited. Verification hashes the
+// serialized headers straight out of the map with the multi-buffer SHA-256
+// kernels and computes the transaction roots over the mapped transactions,
+// so no block is ever copied.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hash_engine.h"
+#include "hash_sw_mb.h"
+#include "blockchain.h"
+#include "merkle.h"
+#include "chain_log.h"
+#include "chain_map.h"
+#include "crc32.h"
+
+//
+// Headers hashed per multi-buffer batch during verification.
+//
+#define CHAIN_MAP_VERIFY_WINDOW 64
+
+static uint32_t
+ChainMapGet32(const uint8_t *pui8In)
+{
+    return (uint32_t)pui8In[0] | ((uint32_t)pui8In[1] << 8) |
+           ((uint32_t)pui8In[2] << 16) | ((uint32_t)pui8In[3] << 24);
+}
+
+static uint64_t
+ChainMapHashKey(const uint8_t *pui8Hash)
+{
+    return (uint64_t)ChainMapGet32(pui8Hash) |
+           ((uint64_t)ChainMapGet32(pui8Hash + 4) << 32);
+}
+
+//
+// Decode the record at ui64Offset, checking its framing and CRC.
+//
+static bool
+ChainMapDecode(const tChainMap *psMap, uint64_t ui64Offset,
+               tChainMapBlock *psBlock, uint64_t *pui64Record)
+{
+    const uint8_t *pui8Record = psMap->pui8Base + ui64Offset;
+    uint64_t ui64Left = psMap->ui64Size - ui64Offset;
+    uint32_t ui32Payload, ui32Tag;
+
+    if((ui64Offset > psMap->ui64Size) || (ui64Left < CHAIN_LOG_RECORD_HDR))
+    {
+        return false;
+    }
+    ui32Payload = ChainMapGet32(pui8Record + 4);
+    if((ChainMapGet32(pui8Record) != CHAIN_LOG_MAGIC) ||
+       (ui32Payload < CHAIN_LOG_PAYLOAD_MIN) ||
+       (ui32Payload > CHAIN_LOG_PAYLOAD_MAX) ||
+       (ui64Left < (uint64_t)CHAIN_LOG_RECORD_HDR + ui32Payload +
+                   CHAIN_LOG_RECORD_CRC) ||
+       (ChainMapGet32(pui8Record + CHAIN_LOG_RECORD_HDR + ui32Payload) !=
+        Crc32(0, pui8Record, CHAIN_LOG_RECORD_HDR + ui32Payload)))
+    {
+        return false;
+    }
+
+    psBlock->pui8Header = pui8Record + CHAIN_LOG_RECORD_HDR;
+    if((block_header_deserialize(psBlock->pui8Header, &psBlock->sHeader) !=
+        0) ||
+       (ui32Payload < CHAIN_LOG_PAYLOAD_MIN + psBlock->sHeader.data_len))
+    {
+        return false;
+    }
+    ui32Tag = ui32Payload - CHAIN_LOG_PAYLOAD_MIN - psBlock->sHeader.data_len;
+    if((ui32Tag != 0) && (ui32Tag != BLOCK_TAG_LEN))
+    {
+        return false;
+    }
+    psBlock->pui8Hash = psBlock->pui8Header + BLOCK_HEADER_LEN;
+    psBlock->pui8Data = psBlock->pui8Header + CHAIN_LOG_PAYLOAD_MIN;
+    psBlock->pui8Tag = ui32Tag ? (psBlock->pui8Data +
+                                  psBlock->sHeader.data_len) : NULL;
+    psBlock->ui64Offset = ui64Offset;
+    *pui64Record = CHAIN_LOG_RECORD_HDR + ui32Payload + CHAIN_LOG_RECORD_CRC;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Map a block log
+//!
+//! \param psMap is the map
+//! \param pcPath is the log file
+//!
+//! \return false if the file cannot be opened or mapped
+//
+//*****************************************************************************
+bool
+ChainMapOpen(tChainMap *psMap, const char *pcPath)
+{
+    struct stat sStat;
+    void *pvBase;
+
+    memset(psMap, 0, sizeof(*psMap));
+    psMap->iFd = open(pcPath, O_RDONLY);
+    if(psMap->iFd < 0)
+    {
+        return false;
+    }
+    if(fstat(psMap->iFd, &sStat) != 0)
+    {
+        ChainMapClose(psMap);
+        return false;
+    }
+
+    psMap->ui64Size = (uint64_t)sStat.st_size;
+    if(psMap->ui64Size != 0)
+    {
+        pvBase = mmap(NULL, (size_t)psMap->ui64Size, PROT_READ, MAP_SHARED,
+                      psMap->iFd, 0);
+        if(pvBase == MAP_FAILED)
+        {
+            ChainMapClose(psMap);
+            return false;
+        }
+        madvise(pvBase, (size_t)psMap->ui64Size, MADV_SEQUENTIAL);
+        psMap->pui8Base = pvBase;
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Unmap a log and free its index
+//!
+//! \param psMap is the map
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ChainMapClose(tChainMap *psMap)
+{
+    if(psMap->pui8Base != NULL)
+    {
+        munmap((void *)psMap->pui8Base, (size_t)psMap->ui64Size);
+    }
+    if(psMap->iFd >= 0)
+    {
+        close(psMap->iFd);
+    }
+    free(psMap->pui64Offsets);
+    free(psMap->pui32Table);
+    memset(psMap, 0, sizeof(*psMap));
+    psMap->iFd = -1;
+}
+
+//*****************************************************************************
+//
+//! Visit the block at an offset and step past it
+//!
+//! \param psMap is the map
+//! \param pui64Offset is the record offset, 0 for the first block; it is
+//! advanced to the next record
+//! \param psBlock receives the block
+//!
+//! \return false at the end of the log or at a damaged record
+//
+//*****************************************************************************
+bool
+ChainMapNext(const tChainMap *psMap, uint64_t *pui64Offset,
+             tChainMapBlock *psBlock)
+{
+    uint64_t ui64Record;
+
+    if(!ChainMapDecode(psMap, *pui64Offset, psBlock, &ui64Record))
+    {
+        return false;
+    }
+    *pui64Offset += ui64Record;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Index the log: the offset of every record, and a hash table from block
+//! hash to position. Indexing stops at the first damaged record.
+//!
+//! \param psMap is the map
+//!
+//! \return the number of blocks indexed
+//
+//*****************************************************************************
+uint32_t
+ChainMapIndex(tChainMap *psMap)
+{
+    tChainMapBlock sBlock;
+    uint64_t ui64Offset = 0, ui64Capacity = 0, ui64Slot;
+    uint64_t *pui64Grown;
+    uint32_t ui32Pos;
+
+    free(psMap->pui64Offsets);
+    free(psMap->pui32Table);
+    psMap->pui64Offsets = NULL;
+    psMap->pui32Table = NULL;
+    psMap->ui32Blocks = 0;
+
+    for(ui32Pos = 0; ui32Pos < CHAIN_MAP_NONE; ui32Pos++)
+    {
+        if(ui32Pos == ui64Capacity)
+        {
+            ui64Capacity = ui64Capacity ? (2 * ui64Capacity) : 4096;
+            pui64Grown = realloc(psMap->pui64Offsets,
+                                 ui64Capacity * sizeof(uint64_t));
+            if(pui64Grown == NULL)
+            {
+                break;
+            }
+            psMap->pui64Offsets = pui64Grown;
+        }
+        psMap->pui64Offsets[ui32Pos] = ui64Offset;
+        if(!ChainMapNext(psMap, &ui64Offset, &sBlock))
+        {
+            break;
+        }
+    }
+    psMap->ui32Blocks = ui32Pos;
+    psMap->ui64Valid = ui64Offset;
+
+    //
+    // Open addressing at no more than half load.
+    //
+    for(ui64Capacity = 16; ui64Capacity < 2 * (uint64_t)ui32Pos;
+        ui64Capacity *= 2)
+    {
+    }
+    psMap->pui32Table = malloc(ui64Capacity * sizeof(uint32_t));
+    if(psMap->pui32Table == NULL)
+    {
+        return psMap->ui32Blocks;
+    }
+    memset(psMap->pui32Table, 0xFF, ui64Capacity * sizeof(uint32_t));
+    psMap->ui64TableMask = ui64Capacity - 1;
+
+    for(ui32Pos = 0; ui32Pos < psMap->ui32Blocks; ui32Pos++)
+    {
+        ui64Slot = ChainMapHashKey(psMap->pui8Base +
+                                   psMap->pui64Offsets[ui32Pos] +
+                                   CHAIN_LOG_RECORD_HDR + BLOCK_HEADER_LEN) &
+                   psMap->ui64TableMask;
+        while(psMap->pui32Table[ui64Slot] != CHAIN_MAP_NONE)
+        {
+            ui64Slot = (ui64Slot + 1) & psMap->ui64TableMask;
+        }
+        psMap->pui32Table[ui64Slot] = ui32Pos;
+    }
+
+    return psMap->ui32Blocks;
+}
+
+//*****************************************************************************
+//
+//! Block at a position in the log
+//!
+//! \param psMap is an indexed map
+//! \param ui32Position is the position, 0 for the first record
+//! \param psBlock receives the block
+//!
+//! \return false if there is no such block
+//
+//*****************************************************************************
+bool
+ChainMapAt(const tChainMap *psMap, uint32_t ui32Position,
+           tChainMapBlock *psBlock)
+{
+    uint64_t ui64Record;
+
+    if(ui32Position >= psMap->ui32Blocks)
+    {
+        return false;
+    }
+
+    return ChainMapDecode(psMap, psMap->pui64Offsets[ui32Position], psBlock,
+                          &ui64Record);
+}
+
+//*****************************************************************************
+//
+//! Block at a height. Heights are consecutive in a log, so this is a
+//! position lookup.
+//!
+//! \param psMap is an indexed map
+//! \param ui32Height is the height
+//! \param psBlock receives the block
+//!
+//! \return false if the log does not hold that height
+//
+//*****************************************************************************
+bool
+ChainMapFindHeight(const tChainMap *psMap, uint32_t ui32Height,
+                   tChainMapBlock *psBlock)
+{
+    if(!ChainMapAt(psMap, 0, psBlock) ||
+       (ui32Height < psBlock->sHeader.height))
+    {
+        return false;
+    }
+
+    return ChainMapAt(psMap, ui32Height - psBlock->sHeader.height, psBlock) &&
+           (psBlock->sHeader.height == ui32Height);
+}
+
+//*****************************************************************************
+//
+//! Block with a given hash
+//!
+//! \param psMap is an indexed map
+//! \param pui8Hash is the 32-byte hash
+//! \param psBlock receives the block
+//!
+//! \return false if no block has that hash
+//
+//*****************************************************************************
+bool
+ChainMapFind(const tChainMap *psMap, const uint8_t *pui8Hash,
+             tChainMapBlock *psBlock)
+{
+    uint64_t ui64Slot;
+    uint32_t ui32Pos;
+
+    if(psMap->pui32Table == NULL)
+    {
+        return false;
+    }
+
+    ui64Slot = ChainMapHashKey(pui8Hash) & psMap->ui64TableMask;
+    while((ui32Pos = psMap->pui32Table[ui64Slot]) != CHAIN_MAP_NONE)
+    {
+        if(!memcmp(psMap->pui8Base + psMap->pui64Offsets[ui32Pos] +
+                   CHAIN_LOG_RECORD_HDR + BLOCK_HEADER_LEN, pui8Hash,
+                   BLOCK_HASH_LEN))
+        {
+            return ChainMapAt(psMap, ui32Pos, psBlock);
+        }
+        ui64Slot = (ui64Slot + 1) & psMap->ui64TableMask;
+    }
+
+    return false;
+}
+
+//
+// Transaction roots of a window of blocks, one tree level at a time across
+// the whole window so that every level is a single multi-buffer batch.
+// Gives the same roots as MerkleRootOf().
+//
+static void
+ChainMapRoots(const tChainMapBlock *psWindow, uint32_t ui32Count,
+              uint8_t (*ppui8Roots)[BLOCK_HASH_LEN])
+{
+    static uint8_t ppui8Nodes[CHAIN_MAP_VERIFY_WINDOW * BLOCK_MAX_TX]
+                             [MERKLE_HASH_LEN];
+    static uint8_t ppui8Msg[CHAIN_MAP_VERIFY_WINDOW * BLOCK_MAX_TX]
+                           [1 + (2 * MERKLE_HASH_LEN)];
+    static const uint8_t *ppui8Msgs[CHAIN_MAP_VERIFY_WINDOW * BLOCK_MAX_TX];
+    static uint8_t *ppui8Outs[CHAIN_MAP_VERIFY_WINDOW * BLOCK_MAX_TX];
+    static uint32_t pui32Lens[CHAIN_MAP_VERIFY_WINDOW * BLOCK_MAX_TX];
+    uint32_t pui32Level[CHAIN_MAP_VERIFY_WINDOW];
+    uint32_t ui32Block, ui32Node, ui32Msgs, ui32Base;
+    bool bMore;
+
+    //
+    // Leaves.
+    //
+    ui32Msgs = 0;
+    for(ui32Block = 0; ui32Block < ui32Count; ui32Block++)
+    {
+        ui32Base = ui32Block * BLOCK_MAX_TX;
+        pui32Level[ui32Block] = psWindow[ui32Block].sHeader.data_len /
+                                BLOCK_TX_LEN;
+        for(ui32Node = 0; ui32Node < pui32Level[ui32Block]; ui32Node++)
+        {
+            ppui8Msg[ui32Msgs][0] = MERKLE_LEAF_PREFIX;
+            memcpy(&ppui8Msg[ui32Msgs][1], psWindow[ui32Block].pui8Data +
+                   (ui32Node * BLOCK_TX_LEN), BLOCK_TX_LEN);
+            ppui8Msgs[ui32Msgs] = ppui8Msg[ui32Msgs];
+            pui32Lens[ui32Msgs] = 1 + BLOCK_TX_LEN;
+            ppui8Outs[ui32Msgs++] = ppui8Nodes[ui32Base + ui32Node];
+        }
+    }
+    SWSHA256Batch(SHAMD5_ALGO_SHA256, ppui8Msgs, pui32Lens, ppui8Outs,
+                  ui32Msgs);
+
+    //
+    // Interior levels. Each pair is copied into its message before the
+    // batch runs, so the parents can overwrite the front of the level.
+    //
+    do
+    {
+        bMore = false;
+        ui32Msgs = 0;
+        for(ui32Block = 0; ui32Block < ui32Count; ui32Block++)
+        {
+            if(pui32Level[ui32Block] < 2)
+            {
+                continue;
+            }
+            ui32Base = ui32Block * BLOCK_MAX_TX;
+            for(ui32Node = 0; ui32Node + 1 < pui32Level[ui32Block];
+                ui32Node += 2)
+            {
+                ppui8Msg[ui32Msgs][0] = MERKLE_NODE_PREFIX;
+                memcpy(&ppui8Msg[ui32Msgs][1], ppui8Nodes[ui32Base + ui32Node],
+                       2 * MERKLE_HASH_LEN);
+                ppui8Msgs[ui32Msgs] = ppui8Msg[ui32Msgs];
+                pui32Lens[ui32Msgs] = 1 + (2 * MERKLE_HASH_LEN);
+                ppui8Outs[ui32Msgs++] = ppui8Nodes[ui32Base + (ui32Node / 2)];
+            }
+            if(pui32Level[ui32Block] & 1)
+            {
+                memcpy(ppui8Nodes[ui32Base + (ui32Node / 2)],
+                       ppui8Nodes[ui32Base + ui32Node], MERKLE_HASH_LEN);
+            }
+            pui32Level[ui32Block] = (pui32Level[ui32Block] + 1) / 2;
+            bMore |= (pui32Level[ui32Block] > 1);
+        }
+        SWSHA256Batch(SHAMD5_ALGO_SHA256, ppui8Msgs, pui32Lens, ppui8Outs,
+                      ui32Msgs);
+    }
+    while(bMore);
+
+    for(ui32Block = 0; ui32Block < ui32Count; ui32Block++)
+    {
+        if(psWindow[ui32Block].sHeader.data_len == 0)
+        {
+            MerkleRootOf(NULL, BLOCK_TX_LEN, 0, ppui8Roots[ui32Block]);
+        }
+        else
+        {
+            memcpy(ppui8Roots[ui32Block], ppui8Nodes[ui32Block * BLOCK_MAX_TX],
+                   MERKLE_HASH_LEN);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Verify every indexed block in place: linkage and heights, transaction
+//! roots and header hashes. A log that starts above height 0 is anchored on
+//! its first block's previous hash.
+//!
+//! \param psMap is an indexed map
+//! \param pui32BadPosition receives the position of the first bad block
+//!
+//! \return true if every block is valid
+//
+//*****************************************************************************
+bool
+ChainMapVerify(const tChainMap *psMap, uint32_t *pui32BadPosition)
+{
+    static const uint8_t pui8Zero[BLOCK_HASH_LEN];
+    tChainMapBlock psWindow[CHAIN_MAP_VERIFY_WINDOW];
+    const uint8_t *ppui8Msgs[CHAIN_MAP_VERIFY_WINDOW];
+    uint32_t pui32Lens[CHAIN_MAP_VERIFY_WINDOW];
+    uint8_t ppui8Digests[CHAIN_MAP_VERIFY_WINDOW][BLOCK_HASH_LEN];
+    uint8_t *ppui8Outs[CHAIN_MAP_VERIFY_WINDOW];
+    uint8_t ppui8Roots[CHAIN_MAP_VERIFY_WINDOW][BLOCK_HASH_LEN];
+    const uint8_t *pui8Link = NULL;
+    uint32_t ui32Height = 0;
+    uint32_t ui32Pos, ui32Count, ui32Idx;
+    tChainMapBlock *psBlock;
+
+    for(ui32Idx = 0; ui32Idx < CHAIN_MAP_VERIFY_WINDOW; ui32Idx++)
+    {
+        pui32Lens[ui32Idx] = BLOCK_HEADER_LEN;
+        ppui8Outs[ui32Idx] = ppui8Digests[ui32Idx];
+    }
+
+    for(ui32Pos = 0; ui32Pos < psMap->ui32Blocks; ui32Pos += ui32Count)
+    {
+        ui32Count = psMap->ui32Blocks - ui32Pos;
+        if(ui32Count > CHAIN_MAP_VERIFY_WINDOW)
+        {
+            ui32Count = CHAIN_MAP_VERIFY_WINDOW;
+        }
+
+        //
+        // Linkage first; it only compares bytes already in the map.
+        //
+        for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+        {
+            psBlock = &psWindow[ui32Idx];
+            if(!ChainMapAt(psMap, ui32Pos + ui32Idx, psBlock) ||
+               (psBlock->sHeader.data_len % BLOCK_TX_LEN))
+            {
+                *pui32BadPosition = ui32Pos + ui32Idx;
+                return false;
+            }
+            if(pui8Link == NULL)
+            {
+                pui8Link = (psBlock->sHeader.height == 0) ?
+                           pui8Zero : psBlock->sHeader.pHash;
+                ui32Height = psBlock->sHeader.height;
+            }
+            else
+            {
+                ui32Height++;
+            }
+            if((psBlock->sHeader.height != ui32Height) ||
+               memcmp(psBlock->sHeader.pHash, pui8Link, BLOCK_HASH_LEN))
+            {
+                *pui32BadPosition = ui32Pos + ui32Idx;
+                return false;
+            }
+            pui8Link = psBlock->pui8Hash;
+            ppui8Msgs[ui32Idx] = psBlock->pui8Header;
+        }
+
+        SWSHA256Batch(SHAMD5_ALGO_SHA256, ppui8Msgs, pui32Lens, ppui8Outs,
+                      ui32Count);
+        ChainMapRoots(psWindow, ui32Count, ppui8Roots);
+        for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+        {
+            psBlock = &psWindow[ui32Idx];
+            if(memcmp(ppui8Roots[ui32Idx], psBlock->sHeader.merkle,
+                      BLOCK_HASH_LEN) ||
+               memcmp(ppui8Digests[ui32Idx], psBlock->pui8Hash,
+                      BLOCK_HASH_LEN))
+            {
+                *pui32BadPosition = ui32Pos + ui32Idx;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,92 @@
+//*****************************************************************************
+// chain_map.h
+//
+// Read-only access to a block log through a memory map (host build only).
+// Blocks are iterated, indexed and verified where they lie in the file, so
+// logs far larger than RAM can be analyzed without copying them out.
+//
+//*****************************************************************************
+
+#ifndef __CHAIN_MAP_H__
+#define __CHAIN_MAP_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+
+#if !defined(cc3200)
+
+#define CHAIN_MAP_NONE          0xFFFFFFFF
+
+//*****************************************************************************
+//
+// A mapped log. ChainMapIndex() fills in the record offsets (by position in
+// the log) and a hash table of positions keyed on the block hash.
+//
+//*****************************************************************************
+typedef struct
+{
+    const uint8_t *pui8Base;
+    uint64_t ui64Size;
+    uint64_t ui64Valid;
+    uint32_t ui32Blocks;
+    uint64_t *pui64Offsets;
+    uint32_t *pui32Table;
+    uint64_t ui64TableMask;
+    int iFd;
+} tChainMap;
+
+//*****************************************************************************
+//
+// One block as it lies in the map. The header is decoded; the hash, the
+// serialized header, the transactions and the tag point into the mapped
+// file. pui8Tag is NULL for an untagged block.
+//
+//*****************************************************************************
+typedef struct
+{
+    struct BlockHeader sHeader;
+    const uint8_t *pui8Header;
+    const uint8_t *pui8Hash;
+    const uint8_t *pui8Data;
+    const uint8_t *pui8Tag;
+    uint64_t ui64Offset;
+} tChainMapBlock;
+
+extern bool ChainMapOpen(tChainMap *psMap, const char *pcPath);
+extern void ChainMapClose(tChainMap *psMap);
+extern bool ChainMapNext(const tChainMap *psMap, uint64_t *pui64Offset,
+                         tChainMapBlock *psBlock);
+extern uint32_t ChainMapIndex(tChainMap *psMap);
+extern bool ChainMapAt(const tChainMap *psMap, uint32_t ui32Position,
+                       tChainMapBlock *psBlock);
+extern bool ChainMapFindHeight(const tChainMap *psMap, uint32_t ui32Height,
+                               tChainMapBlock *psBlock);
+extern bool ChainMapFind(const tChainMap *psMap, const uint8_t *pui8Hash,
+                         tChainMapBlock *psBlock);
+extern bool ChainMapVerify(const tChainMap *psMap, uint32_t *pui32BadPosition);
+
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CHAIN_MAP_H__
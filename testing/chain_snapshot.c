@@ -0,0 +1,387 @@
+//*****************************************************************************
+// chain_snapshot.c
+//
+// Chain snapshots: write the retained window with its ring and index state,
+// and put it back at startup after a checksum and a check against the log
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "block_index.h"
+#include "chain_store.h"
+#include "chain_log.h"
+#include "chain_snapshot.h"
+#include "crc32.h"
+
+//
+// Snapshot I/O goes through this buffer: it is filled and written in
+// pieces, and at the end of a restore it holds the tip's record twice, as
+// encoded from RAM and as read from the log. Its size follows the largest
+// record, so builds with a larger BLOCK_MAX_TX get a larger buffer; it is
+// rounded up to whole words for the word reads of the header and index.
+//
+#define CHAIN_SNAPSHOT_BUF_LEN  (((2 * CHAIN_LOG_RECORD_MAX) + 3) & ~3u)
+
+static uint8_t g_pui8Buf[CHAIN_SNAPSHOT_BUF_LEN];
+static uint32_t g_ui32BufLen;
+static uint32_t g_ui32Offset;
+static uint32_t g_ui32Crc;
+static bool g_bOk;
+
+static void
+ChainSnapshotPut32(uint8_t *pui8Out, uint32_t ui32Value)
+{
+    pui8Out[0] = (uint8_t)ui32Value;
+    pui8Out[1] = (uint8_t)(ui32Value >> 8);
+    pui8Out[2] = (uint8_t)(ui32Value >> 16);
+    pui8Out[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static uint32_t
+ChainSnapshotGet32(const uint8_t *pui8In)
+{
+    return (uint32_t)pui8In[0] | ((uint32_t)pui8In[1] << 8) |
+           ((uint32_t)pui8In[2] << 16) | ((uint32_t)pui8In[3] << 24);
+}
+
+//
+// Write out the buffer, folding it into the running CRC.
+//
+static void
+ChainSnapshotFlush(void)
+{
+    if(g_bOk && (g_ui32BufLen != 0))
+    {
+        g_ui32Crc = Crc32(g_ui32Crc, g_pui8Buf, g_ui32BufLen);
+        g_bOk = ChainLogFsSnapshotWrite(g_ui32Offset, g_pui8Buf,
+                                        g_ui32BufLen);
+        g_ui32Offset += g_ui32BufLen;
+    }
+    g_ui32BufLen = 0;
+}
+
+//
+// Room for ui32Length more bytes in the buffer.
+//
+static uint8_t *
+ChainSnapshotReserve(uint32_t ui32Length)
+{
+    if(g_ui32BufLen + ui32Length > sizeof(g_pui8Buf))
+    {
+        ChainSnapshotFlush();
+    }
+
+    return g_pui8Buf + g_ui32BufLen;
+}
+
+static void
+ChainSnapshotEmit32(uint32_t ui32Value)
+{
+    uint8_t *pui8Out = ChainSnapshotReserve(4);
+
+    ChainSnapshotPut32(pui8Out, ui32Value);
+    g_ui32BufLen += 4;
+}
+
+//
+// Read the next ui32Length bytes of the snapshot, folding them into the
+// running CRC.
+//
+static bool
+ChainSnapshotRead(uint8_t *pui8Data, uint32_t ui32Length)
+{
+    if(ChainLogFsSnapshotRead(g_ui32Offset, pui8Data, ui32Length) !=
+       ui32Length)
+    {
+        return false;
+    }
+    g_ui32Crc = Crc32(g_ui32Crc, pui8Data, ui32Length);
+    g_ui32Offset += ui32Length;
+
+    return true;
+}
+
+//
+// Read ui32Count words into pui32Words.
+//
+static bool
+ChainSnapshotReadWords(uint32_t *pui32Words, uint32_t ui32Count)
+{
+    uint32_t ui32Chunk, ui32Idx;
+
+    while(ui32Count != 0)
+    {
+        ui32Chunk = ui32Count;
+        if(ui32Chunk > sizeof(g_pui8Buf) / 4)
+        {
+            ui32Chunk = sizeof(g_pui8Buf) / 4;
+        }
+        if(!ChainSnapshotRead(g_pui8Buf, 4 * ui32Chunk))
+        {
+            return false;
+        }
+        for(ui32Idx = 0; ui32Idx < ui32Chunk; ui32Idx++)
+        {
+            *pui32Words++ = ChainSnapshotGet32(g_pui8Buf + (4 * ui32Idx));
+        }
+        ui32Count -= ui32Chunk;
+    }
+
+    return true;
+}
+
+static struct Block *
+ChainSnapshotBlock(const tChainStore *psStore, uint32_t ui32Position)
+{
+    return psStore->ppsRing[(psStore->ui32Head + ui32Position) %
+                            CHAIN_STORE_DEPTH];
+}
+
+//
+// Fill an initialized store from the open snapshot. Blocks are claimed as
+// they are placed, so on failure the store's count says what to give back.
+//
+static bool
+ChainSnapshotRestore(tChainStore *psStore, uint32_t ui32LogLength,
+                     uint32_t *pui32Covered)
+{
+    uint32_t pui32Pool[CHAIN_STORE_DEPTH];
+    uint32_t ui32Length, ui32Count, ui32Idx, ui32Payload, ui32Record;
+    struct Block *psBlock, *psPrev = NULL;
+
+    g_ui32Offset = 0;
+    g_ui32Crc = 0;
+    if(!ChainSnapshotRead(g_pui8Buf, CHAIN_SNAPSHOT_HDR_LEN))
+    {
+        return false;
+    }
+    ui32Length = ChainSnapshotGet32(g_pui8Buf + 4);
+    *pui32Covered = ChainSnapshotGet32(g_pui8Buf + 8);
+    ui32Count = ChainSnapshotGet32(g_pui8Buf + 28);
+    if((ChainSnapshotGet32(g_pui8Buf) != CHAIN_SNAPSHOT_MAGIC) ||
+       (ui32Length > CHAIN_SNAPSHOT_MAX_LEN) ||
+       (*pui32Covered > ui32LogLength) ||
+       (ChainSnapshotGet32(g_pui8Buf + 12) != CHAIN_STORE_DEPTH) ||
+       (ChainSnapshotGet32(g_pui8Buf + 16) != CHAIN_INDEX_SIZE) ||
+       (ChainSnapshotGet32(g_pui8Buf + 20) != BLOCK_POOL_CAPACITY) ||
+       (ChainSnapshotGet32(g_pui8Buf + 24) >= CHAIN_STORE_DEPTH) ||
+       (ui32Count == 0) || (ui32Count > CHAIN_STORE_DEPTH) ||
+       (ChainSnapshotGet32(g_pui8Buf + 36) > 1) ||
+       (ChainSnapshotGet32(g_pui8Buf + 76) != ui32Count))
+    {
+        return false;
+    }
+    psStore->ui32Head = ChainSnapshotGet32(g_pui8Buf + 24);
+    psStore->ui32BaseHeight = ChainSnapshotGet32(g_pui8Buf + 32);
+    psStore->bPruned = (ChainSnapshotGet32(g_pui8Buf + 36) != 0);
+    psStore->ui32PrunedHeight = ChainSnapshotGet32(g_pui8Buf + 40);
+    memcpy(psStore->pucPrunedHash, g_pui8Buf + 44, BLOCK_HASH_LEN);
+
+    //
+    // Each block goes back into the pool slot it had, which keeps the
+    // saved index slots valid as they are.
+    //
+    if(!ChainSnapshotReadWords(pui32Pool, ui32Count))
+    {
+        return false;
+    }
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        psBlock = (pui32Pool[ui32Idx] < BLOCK_POOL_NONE) ?
+                  BlockPoolClaim((uint16_t)pui32Pool[ui32Idx]) : NULL;
+        if(psBlock == NULL)
+        {
+            return false;
+        }
+        psStore->ppsRing[(psStore->ui32Head + ui32Idx) % CHAIN_STORE_DEPTH] =
+            psBlock;
+        psStore->ui32Count++;
+    }
+    if(!ChainSnapshotReadWords(psStore->sIndex.pui32Slots, CHAIN_INDEX_SIZE))
+    {
+        return false;
+    }
+    psStore->sIndex.ui32Count = ui32Count;
+
+    //
+    // The blocks themselves. Their hashes are not recomputed; consecutive
+    // heights and matching links are enough to catch a misplaced record.
+    //
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        psBlock = ChainSnapshotBlock(psStore, ui32Idx);
+        if(!ChainSnapshotRead(g_pui8Buf, CHAIN_LOG_RECORD_HDR))
+        {
+            return false;
+        }
+        ui32Payload = ChainSnapshotGet32(g_pui8Buf + 4);
+        if(ui32Payload > CHAIN_LOG_PAYLOAD_MAX)
+        {
+            return false;
+        }
+        ui32Record = CHAIN_LOG_RECORD_HDR + ui32Payload + CHAIN_LOG_RECORD_CRC;
+        if(!ChainSnapshotRead(g_pui8Buf + CHAIN_LOG_RECORD_HDR,
+                              ui32Record - CHAIN_LOG_RECORD_HDR) ||
+           (ChainLogDecode(g_pui8Buf, ui32Record, psBlock) != ui32Record) ||
+           (psBlock->header.height != psStore->ui32BaseHeight + ui32Idx) ||
+           ((psPrev != NULL) &&
+            memcmp(psBlock->header.pHash, psPrev->hash, BLOCK_HASH_LEN)))
+        {
+            return false;
+        }
+        psPrev = psBlock;
+    }
+    if((g_ui32Offset + 4 != ui32Length) ||
+       (ChainLogFsSnapshotRead(g_ui32Offset, g_pui8Buf, 4) != 4) ||
+       (ChainSnapshotGet32(g_pui8Buf) != g_ui32Crc))
+    {
+        return false;
+    }
+
+    //
+    // The snapshot must describe this log: the record that ends where it
+    // says it does must be its tip, byte for byte.
+    //
+    ui32Record = ChainLogRecordLen(psPrev);
+    if((ui32Record > *pui32Covered) ||
+       (ChainLogEncode(psPrev, g_pui8Buf) != ui32Record) ||
+       (ChainLogFsRead(*pui32Covered - ui32Record,
+                       g_pui8Buf + CHAIN_LOG_RECORD_MAX, ui32Record) !=
+        ui32Record) ||
+       memcmp(g_pui8Buf, g_pui8Buf + CHAIN_LOG_RECORD_MAX, ui32Record))
+    {
+        return false;
+    }
+
+    return BlockIndexFind(&psStore->sIndex, psPrev->hash) == psPrev;
+}
+
+//*****************************************************************************
+//
+//! Write a snapshot of a chain store, replacing the previous one only once
+//! the new one is complete
+//!
+//! \param psStore is the store
+//! \param ui32LogLength is the log length whose last record is the store's
+//! tip
+//!
+//! \return false if the store is empty or the snapshot could not be written
+//
+//*****************************************************************************
+bool
+ChainSnapshotSave(const tChainStore *psStore, uint32_t ui32LogLength)
+{
+    uint32_t ui32Length, ui32Idx;
+    struct Block *psBlock;
+    uint8_t *pui8Hdr, *pui8Record;
+
+    if(psStore->ui32Count == 0)
+    {
+        return false;
+    }
+
+    ui32Length = CHAIN_SNAPSHOT_HDR_LEN + (4 * psStore->ui32Count) +
+                 (4 * CHAIN_INDEX_SIZE) + 4;
+    for(ui32Idx = 0; ui32Idx < psStore->ui32Count; ui32Idx++)
+    {
+        ui32Length += ChainLogRecordLen(ChainSnapshotBlock(psStore,
+                                                           ui32Idx));
+    }
+    if(!ChainLogFsSnapshotOpen(true, CHAIN_SNAPSHOT_MAX_LEN))
+    {
+        return false;
+    }
+    g_ui32BufLen = 0;
+    g_ui32Offset = 0;
+    g_ui32Crc = 0;
+    g_bOk = true;
+
+    pui8Hdr = ChainSnapshotReserve(CHAIN_SNAPSHOT_HDR_LEN);
+    ChainSnapshotPut32(pui8Hdr, CHAIN_SNAPSHOT_MAGIC);
+    ChainSnapshotPut32(pui8Hdr + 4, ui32Length);
+    ChainSnapshotPut32(pui8Hdr + 8, ui32LogLength);
+    ChainSnapshotPut32(pui8Hdr + 12, CHAIN_STORE_DEPTH);
+    ChainSnapshotPut32(pui8Hdr + 16, CHAIN_INDEX_SIZE);
+    ChainSnapshotPut32(pui8Hdr + 20, BLOCK_POOL_CAPACITY);
+    ChainSnapshotPut32(pui8Hdr + 24, psStore->ui32Head);
+    ChainSnapshotPut32(pui8Hdr + 28, psStore->ui32Count);
+    ChainSnapshotPut32(pui8Hdr + 32, psStore->ui32BaseHeight);
+    ChainSnapshotPut32(pui8Hdr + 36, psStore->bPruned ? 1 : 0);
+    ChainSnapshotPut32(pui8Hdr + 40, psStore->ui32PrunedHeight);
+    memcpy(pui8Hdr + 44, psStore->pucPrunedHash, BLOCK_HASH_LEN);
+    ChainSnapshotPut32(pui8Hdr + 76, psStore->sIndex.ui32Count);
+    g_ui32BufLen += CHAIN_SNAPSHOT_HDR_LEN;
+
+    for(ui32Idx = 0; ui32Idx < psStore->ui32Count; ui32Idx++)
+    {
+        ChainSnapshotEmit32(BlockPoolIndex(ChainSnapshotBlock(psStore,
+                                                              ui32Idx)));
+    }
+    for(ui32Idx = 0; ui32Idx < CHAIN_INDEX_SIZE; ui32Idx++)
+    {
+        ChainSnapshotEmit32(psStore->sIndex.pui32Slots[ui32Idx]);
+    }
+    for(ui32Idx = 0; ui32Idx < psStore->ui32Count; ui32Idx++)
+    {
+        psBlock = ChainSnapshotBlock(psStore, ui32Idx);
+        pui8Record = ChainSnapshotReserve(ChainLogRecordLen(psBlock));
+        g_ui32BufLen += ChainLogEncode(psBlock, pui8Record);
+    }
+    ChainSnapshotFlush();
+    ChainSnapshotEmit32(g_ui32Crc);
+    ChainSnapshotFlush();
+
+    return ChainLogFsSnapshotClose(g_bOk) && g_bOk &&
+           (g_ui32Offset == ui32Length);
+}
+
+//*****************************************************************************
+//
+//! Restore a chain store from the snapshot. The snapshot is used only if
+//! its checksum is good, it was written by a build with the same layout,
+//! and its tip is the record that ends at the log length it covers.
+//!
+//! \param psStore is an empty store; it is left empty if nothing is restored
+//! \param ui32LogLength is the current length of the log
+//! \param pui32Covered receives the log length the restored window covers;
+//! records after it still have to be replayed
+//!
+//! \return true if the store was restored
+//
+//*****************************************************************************
+bool
+ChainSnapshotLoad(tChainStore *psStore, uint32_t ui32LogLength,
+                  uint32_t *pui32Covered)
+{
+    uint32_t ui32Idx, ui32Covered;
+    bool bOk;
+
+    if(!ChainLogFsSnapshotOpen(false, 0))
+    {
+        return false;
+    }
+    ChainStoreInit(psStore);
+    bOk = ChainSnapshotRestore(psStore, ui32LogLength, &ui32Covered);
+    ChainLogFsSnapshotClose(false);
+
+    if(!bOk)
+    {
+        for(ui32Idx = 0; ui32Idx < psStore->ui32Count; ui32Idx++)
+        {
+            BlockPoolFree(ChainSnapshotBlock(psStore, ui32Idx));
+        }
+        ChainStoreInit(psStore);
+    }
+    else
+    {
+        *pui32Covered = ui32Covered;
+    }
+
+    return bOk;
+}
@@ -0,0 +1,81 @@
+//*****************************************************************************
+// chain_snapshot.h
+//
+// Snapshot of the in-RAM chain: the retained window, the ring and hash
+// index that find its blocks, and the pruned tip below it. Restoring one
+// at startup replaces replaying the block log from the beginning.
+//
+//*****************************************************************************
+
+#ifndef __CHAIN_SNAPSHOT_H__
+#define __CHAIN_SNAPSHOT_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_config.h"
+#include "chain_store.h"
+#include "chain_log.h"
+
+//*****************************************************************************
+//
+// Snapshot file. All integers are little-endian:
+//
+//   offset  size  field
+//        0     4  CHAIN_SNAPSHOT_MAGIC
+//        4     4  snapshot length, including the CRC
+//        8     4  log length covered; the window's tip is the record
+//                 ending there
+//       12     4  CHAIN_STORE_DEPTH of the build that wrote it
+//       16     4  CHAIN_INDEX_SIZE of the build that wrote it
+//       20     4  BLOCK_POOL_CAPACITY of the build that wrote it
+//       24     4  ring head
+//       28     4  retained block count n
+//       32     4  base height
+//       36     4  1 if blocks have been pruned
+//       40     4  newest pruned height
+//       44    32  newest pruned hash
+//       76     4  index entry count
+//       80    4n  pool index of each retained block, oldest first
+//        -  4*CHAIN_INDEX_SIZE  hash index slots
+//        -     -  n log records (chain_log.h), oldest first
+//        -     4  CRC-32 of everything before it
+//
+// The layout words tie the ring positions, pool indices and index slots to
+// one build; a snapshot from a differently sized build is ignored.
+//
+//*****************************************************************************
+#define CHAIN_SNAPSHOT_MAGIC    0x314E5343
+#define CHAIN_SNAPSHOT_HDR_LEN  80
+#define CHAIN_SNAPSHOT_MAX_LEN  (CHAIN_SNAPSHOT_HDR_LEN +                     \
+                                 (CHAIN_STORE_DEPTH *                         \
+                                  (4 + CHAIN_LOG_RECORD_MAX)) +               \
+                                 (4 * CHAIN_INDEX_SIZE) + 4)
+
+extern bool ChainSnapshotSave(const tChainStore *psStore,
+                              uint32_t ui32LogLength);
+extern bool ChainSnapshotLoad(tChainStore *psStore, uint32_t ui32LogLength,
+                              uint32_t *pui32Covered);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CHAIN_SNAPSHOT_H__
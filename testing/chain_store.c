@@ -0,0 +1,249 @@
+//*****************************************************************************
+// chain_store.c
+//
+// Circular chain store with pruning of old blocks
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+
+//*****************************************************************************
+//
+//! Empty a chain store
+//!
+//! \param psStore is the store
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ChainStoreInit(tChainStore *psStore)
+{
+    memset(psStore, 0, sizeof(*psStore));
+    BlockIndexInit(&psStore->sIndex);
+}
+
+//*****************************************************************************
+//
+//! Append a block at the tip. When the window is full the oldest block is
+//! pruned: it goes back to the block pool and only its hash and height are
+//! kept. Blocks are stored as given: in an authenticated chain they are
+//! tagged by whoever made them (blockchain.c, miner.c), never here.
+//!
+//! \param psStore is the store
+//! \param psBlock is the new tip; its height must follow the current tip
+//! and its previous hash must be the hash of the current tip
+//!
+//! \return false if the block does not extend the tip
+//
+//*****************************************************************************
+bool
+ChainStoreAppend(tChainStore *psStore, struct Block *psBlock)
+{
+    struct Block *psOldest;
+    uint32_t ui32Slot;
+
+    if(psBlock == NULL)
+    {
+        return false;
+    }
+    if(psStore->ui32Count == 0)
+    {
+        if(psStore->bPruned &&
+           ((psBlock->header.height != psStore->ui32PrunedHeight + 1) ||
+            memcmp(psBlock->header.pHash, psStore->pucPrunedHash,
+                   BLOCK_HASH_LEN)))
+        {
+            return false;
+        }
+        psStore->ui32BaseHeight = psBlock->header.height;
+    }
+    else if((psBlock->header.height !=
+             psStore->ui32BaseHeight + psStore->ui32Count) ||
+            memcmp(psBlock->header.pHash, ChainStoreTip(psStore)->hash,
+                   BLOCK_HASH_LEN))
+    {
+        return false;
+    }
+
+    if(psStore->ui32Count == CHAIN_STORE_DEPTH)
+    {
+        psOldest = psStore->ppsRing[psStore->ui32Head];
+        memcpy(psStore->pucPrunedHash, psOldest->hash, BLOCK_HASH_LEN);
+        psStore->ui32PrunedHeight = psStore->ui32BaseHeight;
+        psStore->bPruned = true;
+        BlockIndexRemove(&psStore->sIndex, psOldest);
+        BlockPoolFree(psOldest);
+
+        psStore->ui32Head = (psStore->ui32Head + 1) % CHAIN_STORE_DEPTH;
+        psStore->ui32BaseHeight++;
+        psStore->ui32Count--;
+    }
+
+    ui32Slot = (psStore->ui32Head + psStore->ui32Count) % CHAIN_STORE_DEPTH;
+    psStore->ppsRing[ui32Slot] = psBlock;
+    psStore->ui32Count++;
+    BlockIndexInsert(&psStore->sIndex, psBlock);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Newest block
+//!
+//! \param psStore is the store
+//!
+//! \return the tip, or NULL if the store is empty
+//
+//*****************************************************************************
+struct Block *
+ChainStoreTip(const tChainStore *psStore)
+{
+    if(psStore->ui32Count == 0)
+    {
+        return NULL;
+    }
+
+    return psStore->ppsRing[(psStore->ui32Head + psStore->ui32Count - 1) %
+                            CHAIN_STORE_DEPTH];
+}
+
+//*****************************************************************************
+//
+//! Block at a height
+//!
+//! \param psStore is the store
+//! \param ui32Height is the block height
+//!
+//! \return the block, or NULL if it was pruned or does not exist yet
+//
+//*****************************************************************************
+struct Block *
+ChainStoreGet(const tChainStore *psStore, uint32_t ui32Height)
+{
+    uint32_t ui32Offset = ui32Height - psStore->ui32BaseHeight;
+
+    if((ui32Height < psStore->ui32BaseHeight) ||
+       (ui32Offset >= psStore->ui32Count))
+    {
+        return NULL;
+    }
+
+    return psStore->ppsRing[(psStore->ui32Head + ui32Offset) %
+                            CHAIN_STORE_DEPTH];
+}
+
+//*****************************************************************************
+//
+//! Retained block with a given hash, e.g. the parent named by an incoming
+//! block's previous hash
+//!
+//! \param psStore is the store
+//! \param pucHash is the 32-byte block hash
+//!
+//! \return the block, or NULL if it was pruned or is unknown
+//
+//*****************************************************************************
+struct Block *
+ChainStoreFind(const tChainStore *psStore, const unsigned char *pucHash)
+{
+    return BlockIndexFind(&psStore->sIndex, pucHash);
+}
+
+//*****************************************************************************
+//
+//! Number of retained blocks
+//!
+//! \param psStore is the store
+//!
+//! \return the block count of the window
+//
+//*****************************************************************************
+uint32_t
+ChainStoreCount(const tChainStore *psStore)
+{
+    return psStore->ui32Count;
+}
+
+//*****************************************************************************
+//
+//! Height of the oldest retained block
+//!
+//! \param psStore is the store
+//!
+//! \return the base height of the window
+//
+//*****************************************************************************
+uint32_t
+ChainStoreBaseHeight(const tChainStore *psStore)
+{
+    return psStore->ui32BaseHeight;
+}
+
+//*****************************************************************************
+//
+//! Verify the retained window: hashes, payload roots and linkage back to
+//! the newest pruned block (or to genesis when nothing has been pruned)
+//!
+//! \param psStore is the store
+//! \param pui32BadHeight receives the height of the first bad block
+//!
+//! \return true if every retained block is valid
+//
+//*****************************************************************************
+bool
+ChainStoreVerify(const tChainStore *psStore, uint32_t *pui32BadHeight)
+{
+    const unsigned char *pucPrev = NULL;
+    unsigned int uiFirst, uiBad;
+
+    if(psStore->ui32Count == 0)
+    {
+        return true;
+    }
+
+    //
+    // A store that was started mid-chain has nothing to link its first
+    // block to, so that block's own previous hash is taken as the anchor.
+    //
+    if(psStore->bPruned)
+    {
+        pucPrev = psStore->pucPrunedHash;
+    }
+    else if(psStore->ui32BaseHeight != 0)
+    {
+        pucPrev = psStore->ppsRing[psStore->ui32Head]->header.pHash;
+    }
+
+    //
+    // The window is at most two runs of the ring.
+    //
+    uiFirst = CHAIN_STORE_DEPTH - psStore->ui32Head;
+    if(uiFirst > psStore->ui32Count)
+    {
+        uiFirst = psStore->ui32Count;
+    }
+    if(!verify_chain(&psStore->ppsRing[psStore->ui32Head], uiFirst, pucPrev,
+                     &uiBad))
+    {
+        *pui32BadHeight = psStore->ui32BaseHeight + uiBad;
+        return false;
+    }
+    if((uiFirst < psStore->ui32Count) &&
+       !verify_chain(&psStore->ppsRing[0], psStore->ui32Count - uiFirst,
+                     psStore->ppsRing[CHAIN_STORE_DEPTH - 1]->hash, &uiBad))
+    {
+        *pui32BadHeight = psStore->ui32BaseHeight + uiFirst + uiBad;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+//*****************************************************************************
+// chain_store.h
+//
+// Circular chain store. Keeps the most recent CHAIN_STORE_DEPTH blocks in
+// RAM; older blocks are pruned back to the block pool and only the hash and
+// height of the newest pruned block are remembered. Retained blocks can be
+// found by height (through the ring) or by hash (through a block index).
+//
+//*****************************************************************************
+
+#ifndef __CHAIN_STORE_H__
+#define __CHAIN_STORE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_config.h"
+#include "block_index.h"
+
+typedef struct
+{
+    struct Block *ppsRing[CHAIN_STORE_DEPTH];
+    uint32_t ui32Head;
+    uint32_t ui32Count;
+    uint32_t ui32BaseHeight;
+    bool bPruned;
+    uint32_t ui32PrunedHeight;
+    unsigned char pucPrunedHash[BLOCK_HASH_LEN];
+    tBlockIndex sIndex;
+} tChainStore;
+
+extern void ChainStoreInit(tChainStore *psStore);
+extern bool ChainStoreAppend(tChainStore *psStore, struct Block *psBlock);
+extern struct Block *ChainStoreTip(const tChainStore *psStore);
+extern struct Block *ChainStoreGet(const tChainStore *psStore,
+                                   uint32_t ui32Height);
+extern struct Block *ChainStoreFind(const tChainStore *psStore,
+                                    const unsigned char *pucHash);
+extern uint32_t ChainStoreCount(const tChainStore *psStore);
+extern uint32_t ChainStoreBaseHeight(const tChainStore *psStore);
+extern bool ChainStoreVerify(const tChainStore *psStore,
+                             uint32_t *pui32BadHeight);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CHAIN_STORE_H__
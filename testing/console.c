@@ -0,0 +1,639 @@
+//*****************************************************************************
+// console.c
+//
+// Text command interpreter: hashing, chain inspection, block production
+// and statistics
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "chain_log.h"
+#include "mempool.h"
+#include "miner.h"
+#include "miner_mt.h"
+#include "uart_buf.h"
+#include "perf_probe.h"
+#include "console.h"
+
+//*****************************************************************************
+//
+// A command. ui32MinArgs and ui32MaxArgs count the words of the command,
+// its name included; the last of ui32MaxArgs words is the rest of the line.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t (*pfnHandler)(uint32_t ui32Argc, char **ppcArgv);
+    uint32_t ui32MinArgs;
+    uint32_t ui32MaxArgs;
+    const char *pcUsage;
+} tConsoleCmd;
+
+static tChainStore *g_psStore;
+static tConsoleAppend g_pfnAppend;
+static tConsoleStats g_sStats;
+static struct BlockBuilder g_sBuilder;
+
+//
+// Writer of the command being run.
+//
+static tConsoleWrite g_pfnWrite;
+static void *g_pvWriteArg;
+
+//*****************************************************************************
+//
+//! Format one line of output and pass it to the writer in a single call
+//!
+//! \param pcFormat is the printf format
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+ConsolePrintf(const char *pcFormat, ...)
+{
+    char pcText[CONSOLE_PRINT_MAX];
+    va_list vaArgs;
+    int iLength;
+
+    va_start(vaArgs, pcFormat);
+    iLength = vsnprintf(pcText, sizeof(pcText), pcFormat, vaArgs);
+    va_end(vaArgs);
+    if(iLength <= 0)
+    {
+        return;
+    }
+    if(iLength >= (int)sizeof(pcText))
+    {
+        iLength = sizeof(pcText) - 1;
+    }
+    g_pfnWrite(g_pvWriteArg, pcText, (uint32_t)iLength);
+}
+
+//*****************************************************************************
+//
+//! Format bytes as hex into a buffer
+//!
+//! \param pcHex receives 2 * ui32Length characters and a NUL
+//! \param pui8Data is the data
+//! \param ui32Length is the data length
+//!
+//! \return pcHex
+//
+//*****************************************************************************
+static const char *
+ConsoleHex(char *pcHex, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    static const char pcDigits[] = "0123456789abcdef";
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < ui32Length; ui32Idx++)
+    {
+        pcHex[2 * ui32Idx] = pcDigits[pui8Data[ui32Idx] >> 4];
+        pcHex[(2 * ui32Idx) + 1] = pcDigits[pui8Data[ui32Idx] & 15];
+    }
+    pcHex[2 * ui32Length] = '\0';
+
+    return pcHex;
+}
+
+static void
+ConsolePrintBlock(const struct Block *psBlock)
+{
+    char pcHex[(2 * BLOCK_HASH_LEN) + 1];
+
+    ConsolePrintf("height %u txs %u nonce %u hash %s\n\r",
+                  (unsigned int)psBlock->header.height,
+                  (unsigned int)block_tx_count(psBlock),
+                  (unsigned int)psBlock->header.nonce,
+                  ConsoleHex(pcHex, psBlock->hash, BLOCK_HASH_LEN));
+}
+
+//
+// Seal a block from the highest priority transactions in the mempool.
+//
+static struct Block *
+ConsoleSeal(void)
+{
+    if((MempoolCount() == 0) || (g_pfnAppend == NULL) ||
+       (block_begin(&g_sBuilder, ChainStoreTip(g_psStore)) == NULL))
+    {
+        return NULL;
+    }
+    MempoolFillBlock(&g_sBuilder, MEMPOOL_ORDER_PRIORITY);
+
+    return block_seal(&g_sBuilder);
+}
+
+static uint32_t
+ConsoleCmdBlock(uint32_t ui32Argc, char **ppcArgv)
+{
+    struct Block *psBlock;
+
+    (void)ui32Argc;
+    psBlock = ChainStoreGet(g_psStore, (uint32_t)strtoul(ppcArgv[1], NULL,
+                                                         10));
+    if(psBlock == NULL)
+    {
+        ConsolePrintf("not retained\n\r");
+        return CONSOLE_ERR_FAILED;
+    }
+    ConsolePrintBlock(psBlock);
+
+    return CONSOLE_OK;
+}
+
+static uint32_t
+ConsoleCmdHash(uint32_t ui32Argc, char **ppcArgv)
+{
+    uint8_t pui8Digest[HASH_MAX_DIGEST_LEN];
+    char pcHex[(2 * HASH_MAX_DIGEST_LEN) + 1];
+    const tHashAlgo *psAlgo;
+    char *pcMessage = (ui32Argc > 2) ? ppcArgv[2] : "";
+
+    psAlgo = HashAlgoFind(ppcArgv[1]);
+    if(psAlgo == NULL)
+    {
+        ConsolePrintf("unknown algorithm %s\n\r", ppcArgv[1]);
+        return CONSOLE_ERR_ARGS;
+    }
+    if(psAlgo->bHMAC)
+    {
+        ConsolePrintf("%s needs a key\n\r", psAlgo->pcName);
+        return CONSOLE_ERR_ARGS;
+    }
+    GenerateHash(psAlgo->ui32Config, (unsigned char *)pcMessage, pui8Digest,
+                 (unsigned int)strlen(pcMessage));
+    ConsolePrintf("%s\n\r", ConsoleHex(pcHex, pui8Digest,
+                                       psAlgo->ui32DigestLength));
+
+    return CONSOLE_OK;
+}
+
+static uint32_t ConsoleCmdHelp(uint32_t ui32Argc, char **ppcArgv);
+
+static uint32_t
+ConsoleCmdMine(uint32_t ui32Argc, char **ppcArgv)
+{
+    uint8_t pui8Target[BLOCK_HASH_LEN];
+    uint32_t ui32Bits = MINER_DEFAULT_BITS;
+    tMinerResult sResult;
+    struct Block *psBlock;
+    bool bMined;
+
+    if(ui32Argc > 1)
+    {
+        ui32Bits = (uint32_t)strtoul(ppcArgv[1], NULL, 10);
+        if((ui32Bits == 0) || (ui32Bits > 32))
+        {
+            ConsolePrintf("bits must be 1 to 32\n\r");
+            return CONSOLE_ERR_ARGS;
+        }
+    }
+    psBlock = ConsoleSeal();
+    if(psBlock == NULL)
+    {
+        ConsolePrintf("mempool empty\n\r");
+        return CONSOLE_ERR_FAILED;
+    }
+    MinerTargetFromBits(ui32Bits, pui8Target);
+#if defined(cc3200)
+    bMined = MinerMineBlock(psBlock, pui8Target, 0xFFFFFFFFu, &sResult);
+#else
+    bMined = MinerMTMineBlock(psBlock, pui8Target, 0xFFFFFFFFu, &sResult);
+#endif
+    if(!bMined || !g_pfnAppend(psBlock))
+    {
+        BlockPoolFree(psBlock);
+        MempoolRestoreFill();
+        ConsolePrintf("mining failed\n\r");
+        return CONSOLE_ERR_FAILED;
+    }
+    ConsolePrintBlock(psBlock);
+    ConsolePrintf("%u hashes, %lu H/s\n\r", (unsigned int)sResult.ui32Hashes,
+                  (unsigned long)MinerHashRate(&sResult));
+
+    return CONSOLE_OK;
+}
+
+static uint32_t
+ConsoleCmdSeal(uint32_t ui32Argc, char **ppcArgv)
+{
+    struct Block *psBlock;
+
+    (void)ui32Argc;
+    (void)ppcArgv;
+    psBlock = ConsoleSeal();
+    if(psBlock == NULL)
+    {
+        ConsolePrintf("mempool empty\n\r");
+        return CONSOLE_ERR_FAILED;
+    }
+    if(!g_pfnAppend(psBlock))
+    {
+        BlockPoolFree(psBlock);
+        MempoolRestoreFill();
+        ConsolePrintf("append failed\n\r");
+        return CONSOLE_ERR_FAILED;
+    }
+    ConsolePrintBlock(psBlock);
+
+    return CONSOLE_OK;
+}
+
+#if defined(PERF_PROBES)
+//*****************************************************************************
+//
+//! Print one probe site on a line: count, then the average, minimum and
+//! maximum ticks, then the histogram from its first to its last non-empty
+//! bucket, e.g. "hash n 40 avg 812 min 640 max 2301 h4:12,26,2" for 12
+//! intervals of 4^4 to 4^5-1 ticks, 26 of the next bucket and 2 of the one
+//! after.
+//!
+//! \param ui32Site is the site (PERF_SITE_*)
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+ConsolePrintProbe(uint32_t ui32Site)
+{
+    char pcHistogram[CONSOLE_PRINT_MAX / 2];
+    tPerfProbe sProbe;
+    uint32_t ui32First, ui32Last, ui32Used, ui32Idx;
+
+    PerfProbeGet(ui32Site, &sProbe);
+    if(sProbe.ui64Ticks == 0)
+    {
+        ConsolePrintf("%s n %u\n\r", PerfProbeName(ui32Site),
+                      (unsigned int)sProbe.ui32Count);
+        return;
+    }
+
+    for(ui32First = 0; sProbe.pui32Histogram[ui32First] == 0; ui32First++)
+    {
+    }
+    for(ui32Last = PERF_PROBE_BUCKETS - 1;
+        sProbe.pui32Histogram[ui32Last] == 0; ui32Last--)
+    {
+    }
+    ui32Used = 0;
+    for(ui32Idx = ui32First;
+        (ui32Idx <= ui32Last) && (ui32Used < sizeof(pcHistogram)); ui32Idx++)
+    {
+        ui32Used += snprintf(pcHistogram + ui32Used,
+                             sizeof(pcHistogram) - ui32Used,
+                             (ui32Idx == ui32First) ? "%u" : ",%u",
+                             (unsigned int)sProbe.pui32Histogram[ui32Idx]);
+    }
+    ConsolePrintf("%s n %u avg %lu min %u max %u h%u:%s\n\r",
+                  PerfProbeName(ui32Site), (unsigned int)sProbe.ui32Count,
+                  (unsigned long)(sProbe.ui64Ticks / sProbe.ui32Count),
+                  (unsigned int)sProbe.ui32Min, (unsigned int)sProbe.ui32Max,
+                  (unsigned int)ui32First, pcHistogram);
+}
+#endif
+
+static uint32_t
+ConsoleCmdStats(uint32_t ui32Argc, char **ppcArgv)
+{
+    tBlockPoolStats sPool;
+    tMempoolStats sMempool;
+    tUartBufStats sUart;
+    tChainLogStats sLog;
+
+    (void)ppcArgv;
+    if(ui32Argc > 1)
+    {
+#if defined(PERF_PROBES)
+        uint32_t ui32Site;
+
+        if(strcmp(ppcArgv[1], "probes") == 0)
+        {
+            for(ui32Site = 0; ui32Site < PERF_SITE_COUNT; ui32Site++)
+            {
+                ConsolePrintProbe(ui32Site);
+            }
+            return CONSOLE_OK;
+        }
+        if(strcmp(ppcArgv[1], "reset") == 0)
+        {
+            PerfProbeReset();
+            return CONSOLE_OK;
+        }
+        ConsolePrintf("usage: stats [probes|reset]\n\r");
+        return CONSOLE_ERR_ARGS;
+#else
+        ConsolePrintf("probes not built in\n\r");
+        return CONSOLE_ERR_FAILED;
+#endif
+    }
+
+    BlockPoolStatsGet(&sPool);
+    MempoolStatsGet(&sMempool);
+    UartBufStatsGet(&sUart);
+    ChainLogStatsGet(&sLog);
+    ConsolePrintf("chain tip %u retained %u from %u\n\r",
+                  (unsigned int)ChainStoreTip(g_psStore)->header.height,
+                  (unsigned int)ChainStoreCount(g_psStore),
+                  (unsigned int)ChainStoreBaseHeight(g_psStore));
+    ConsolePrintf("pool in use %u high water %u failures %u\n\r",
+                  (unsigned int)sPool.ui32InUse,
+                  (unsigned int)sPool.ui32HighWater,
+                  (unsigned int)sPool.ui32Failures);
+    ConsolePrintf("mempool %u queued %u duplicates %u evicted\n\r",
+                  (unsigned int)sMempool.ui32Count,
+                  (unsigned int)sMempool.ui32Duplicates,
+                  (unsigned int)sMempool.ui32Evicted);
+    ConsolePrintf("log %u blocks %u not logged %u failures\n\r",
+                  (unsigned int)sLog.ui32Logged,
+                  (unsigned int)sLog.ui32Unlogged,
+                  (unsigned int)sLog.ui32Failures);
+    ConsolePrintf("uart tx %u rx %u high water tx %u rx %u overruns %u\n\r",
+                  (unsigned int)sUart.ui32TxBytes,
+                  (unsigned int)sUart.ui32RxBytes,
+                  (unsigned int)sUart.ui32TxHighWater,
+                  (unsigned int)sUart.ui32RxHighWater,
+                  (unsigned int)sUart.ui32RxOverruns);
+    ConsolePrintf("console %u commands %u errors\n\r",
+                  (unsigned int)g_sStats.ui32Commands,
+                  (unsigned int)g_sStats.ui32Errors);
+
+    return CONSOLE_OK;
+}
+
+static uint32_t
+ConsoleCmdTip(uint32_t ui32Argc, char **ppcArgv)
+{
+    (void)ui32Argc;
+    (void)ppcArgv;
+    ConsolePrintBlock(ChainStoreTip(g_psStore));
+
+    return CONSOLE_OK;
+}
+
+static uint32_t
+ConsoleCmdTx(uint32_t ui32Argc, char **ppcArgv)
+{
+    static const char * const ppcResult[] =
+    {
+        "added", "duplicate", "rejected"
+    };
+    uint32_t ui32Result;
+
+    (void)ui32Argc;
+    ui32Result = MempoolAddLine(ppcArgv[1]);
+    ConsolePrintf("%s\n\r", ppcResult[ui32Result]);
+
+    return (ui32Result == MEMPOOL_REJECTED) ? CONSOLE_ERR_FAILED :
+                                              CONSOLE_OK;
+}
+
+static uint32_t
+ConsoleCmdVerify(uint32_t ui32Argc, char **ppcArgv)
+{
+    uint32_t ui32BadHeight;
+
+    (void)ui32Argc;
+    (void)ppcArgv;
+    if(!ChainStoreVerify(g_psStore, &ui32BadHeight))
+    {
+        ConsolePrintf("bad block at height %u\n\r",
+                      (unsigned int)ui32BadHeight);
+        return CONSOLE_ERR_FAILED;
+    }
+    ConsolePrintf("%u blocks verified\n\r",
+                  (unsigned int)ChainStoreCount(g_psStore));
+
+    return CONSOLE_OK;
+}
+
+//*****************************************************************************
+//
+// The commands, sorted by name for ConsoleFind().
+//
+//*****************************************************************************
+static const tConsoleCmd g_psCommands[] =
+{
+    { "block",  ConsoleCmdBlock,  2, 2, "block <height>" },
+    { "hash",   ConsoleCmdHash,   2, 3, "hash <algorithm> [message]" },
+    { "help",   ConsoleCmdHelp,   1, 1, "help" },
+    { "mine",   ConsoleCmdMine,   1, 2, "mine [bits]" },
+    { "seal",   ConsoleCmdSeal,   1, 1, "seal" },
+    { "stats",  ConsoleCmdStats,  1, 2, "stats [probes|reset]" },
+    { "tip",    ConsoleCmdTip,    1, 1, "tip" },
+    { "tx",     ConsoleCmdTx,     2, 2, "tx [priority] <transaction>" },
+    { "verify", ConsoleCmdVerify, 1, 1, "verify" },
+};
+
+#define CONSOLE_CMD_COUNT       (sizeof(g_psCommands) /                     \
+                                 sizeof(g_psCommands[0]))
+
+static uint32_t
+ConsoleCmdHelp(uint32_t ui32Argc, char **ppcArgv)
+{
+    uint32_t ui32Idx;
+
+    (void)ui32Argc;
+    (void)ppcArgv;
+    for(ui32Idx = 0; ui32Idx < CONSOLE_CMD_COUNT; ui32Idx++)
+    {
+        ConsolePrintf("%s\n\r", g_psCommands[ui32Idx].pcUsage);
+    }
+    ConsolePrintf("algorithms:");
+    for(ui32Idx = 0; ui32Idx < HashAlgoCount(); ui32Idx++)
+    {
+        ConsolePrintf(" %s", HashAlgoAt(ui32Idx)->pcName);
+    }
+    ConsolePrintf("\n\r");
+
+    return CONSOLE_OK;
+}
+
+//*****************************************************************************
+//
+//! Look up a command by name
+//!
+//! \param pcName is the name
+//!
+//! \return the command, or NULL if the name is unknown
+//
+//*****************************************************************************
+static const tConsoleCmd *
+ConsoleFind(const char *pcName)
+{
+    uint32_t ui32Low = 0, ui32High = CONSOLE_CMD_COUNT, ui32Mid;
+    int iOrder;
+
+    while(ui32Low < ui32High)
+    {
+        ui32Mid = (ui32Low + ui32High) / 2;
+        iOrder = strcmp(pcName, g_psCommands[ui32Mid].pcName);
+        if(iOrder == 0)
+        {
+            return &g_psCommands[ui32Mid];
+        }
+        if(iOrder < 0)
+        {
+            ui32High = ui32Mid;
+        }
+        else
+        {
+            ui32Low = ui32Mid + 1;
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+//! Split a line into words in place. The last of ui32Max words is the rest
+//! of the line.
+//!
+//! \param pcLine is the line; separators are overwritten with NULs
+//! \param ppcArgv receives the words
+//! \param ui32Max is the most words to split off
+//!
+//! \return the number of words
+//
+//*****************************************************************************
+static uint32_t
+ConsoleSplit(char *pcLine, char **ppcArgv, uint32_t ui32Max)
+{
+    uint32_t ui32Argc = 0;
+
+    while(ui32Argc < ui32Max)
+    {
+        while(*pcLine == ' ')
+        {
+            pcLine++;
+        }
+        if(*pcLine == '\0')
+        {
+            break;
+        }
+        ppcArgv[ui32Argc++] = pcLine;
+        if(ui32Argc == ui32Max)
+        {
+            break;
+        }
+        while((*pcLine != '\0') && (*pcLine != ' '))
+        {
+            pcLine++;
+        }
+        if(*pcLine != '\0')
+        {
+            *pcLine++ = '\0';
+        }
+    }
+
+    return ui32Argc;
+}
+
+//*****************************************************************************
+//
+//! Set up the interpreter
+//!
+//! \param psStore is the chain store commands work on
+//! \param pfnAppend adds a sealed or mined block to the chain and its log
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ConsoleInit(tChainStore *psStore, tConsoleAppend pfnAppend)
+{
+    g_psStore = psStore;
+    g_pfnAppend = pfnAppend;
+    memset(&g_sStats, 0, sizeof(g_sStats));
+}
+
+//*****************************************************************************
+//
+//! Run one command line
+//!
+//! \param pcLine is the line, without its terminator; it is split in place
+//! \param pfnWrite receives the output
+//! \param pvArg is passed to pfnWrite
+//!
+//! \return CONSOLE_OK or one of the CONSOLE_ERR_ codes
+//
+//*****************************************************************************
+uint32_t
+ConsoleExecute(char *pcLine, tConsoleWrite pfnWrite, void *pvArg)
+{
+    char *ppcArgv[CONSOLE_MAX_ARGS];
+    const tConsoleCmd *psCmd;
+    uint32_t ui32Argc, ui32Status;
+    char *pcEnd, cSaved;
+
+    g_pfnWrite = pfnWrite;
+    g_pvWriteArg = pvArg;
+    g_sStats.ui32Commands++;
+
+    //
+    // The name first, to learn how many words the rest splits into.
+    //
+    while(*pcLine == ' ')
+    {
+        pcLine++;
+    }
+    pcEnd = pcLine + strcspn(pcLine, " ");
+    cSaved = *pcEnd;
+    *pcEnd = '\0';
+    psCmd = ConsoleFind(pcLine);
+    if(psCmd == NULL)
+    {
+        if(*pcLine != '\0')
+        {
+            ConsolePrintf("unknown command %s\n\r", pcLine);
+        }
+        g_sStats.ui32Errors++;
+        return CONSOLE_ERR_UNKNOWN;
+    }
+    *pcEnd = cSaved;
+
+    ui32Argc = ConsoleSplit(pcLine, ppcArgv, psCmd->ui32MaxArgs);
+    if(ui32Argc < psCmd->ui32MinArgs)
+    {
+        ConsolePrintf("usage: %s\n\r", psCmd->pcUsage);
+        ui32Status = CONSOLE_ERR_ARGS;
+    }
+    else
+    {
+        ui32Status = psCmd->pfnHandler(ui32Argc, ppcArgv);
+    }
+    if(ui32Status != CONSOLE_OK)
+    {
+        g_sStats.ui32Errors++;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! Get the counters
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+ConsoleStatsGet(tConsoleStats *psStats)
+{
+    *psStats = g_sStats;
+}
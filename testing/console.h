@@ -0,0 +1,83 @@
+//*****************************************************************************
+// console.h
+//
+// Text command interpreter of the node. A command line is split in place
+// and dispatched through a table sorted by name, so running a command
+// allocates nothing and costs a binary search rather than a strcmp chain.
+// Output goes to a writer supplied with each line: the UART, a protocol
+// reply (WIRE_COMMAND in wire.h) or stdout on the host.
+//
+//*****************************************************************************
+
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_store.h"
+
+//*****************************************************************************
+//
+// Longest command line, and longest line of output formatted at once.
+//
+//*****************************************************************************
+#define CONSOLE_LINE_MAX        128
+#define CONSOLE_PRINT_MAX       128
+
+//*****************************************************************************
+//
+// Most words a command takes, its name included. The last word a command
+// takes is the rest of the line, spaces and all, e.g. the message of
+// "hash sha256 two words".
+//
+//*****************************************************************************
+#define CONSOLE_MAX_ARGS        4
+
+//*****************************************************************************
+//
+// Outcome of ConsoleExecute().
+//
+//*****************************************************************************
+#define CONSOLE_OK              0
+#define CONSOLE_ERR_UNKNOWN     1
+#define CONSOLE_ERR_ARGS        2
+#define CONSOLE_ERR_FAILED      3
+
+typedef void (*tConsoleWrite)(void *pvArg, const char *pcText,
+                              uint32_t ui32Length);
+typedef bool (*tConsoleAppend)(struct Block *psBlock);
+
+typedef struct
+{
+    uint32_t ui32Commands;
+    uint32_t ui32Errors;
+} tConsoleStats;
+
+extern void ConsoleInit(tChainStore *psStore, tConsoleAppend pfnAppend);
+extern uint32_t ConsoleExecute(char *pcLine, tConsoleWrite pfnWrite,
+                               void *pvArg);
+extern void ConsoleStatsGet(tConsoleStats *psStats);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CONSOLE_H__
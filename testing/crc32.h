@@ -0,0 +1,37 @@
+//*****************************************************************************
+// crc32.h
+//
+// CRC-32 (IEEE 802.3, as used by zlib and Ethernet) for record and frame
+// checksums.
+//
+//*****************************************************************************
+
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+extern uint32_t Crc32(uint32_t ui32Crc, const uint8_t *pui8Data,
+                      uint32_t ui32Length);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CRC32_H__
@@ -0,0 +1,329 @@
+//*****************************************************************************
+// hash_dma.c
+//
+// Ping-pong chunk scheduling for uDMA-fed hashing, the host-side simulated
+// channel, and CPU vs DMA throughput measurement
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+#include "hash_dma.h"
+#include "perf_clock.h"
+
+//*****************************************************************************
+//
+//! Check whether a message can be fed by DMA. The channel moves 32-bit words,
+//! so the source must be word aligned; short messages are not worth it.
+//!
+//! \param pui8Data is the message
+//! \param ui32Length is the message length in bytes
+//!
+//! \return true if the DMA path should be used
+//
+//*****************************************************************************
+bool
+HashDMACapable(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    return (ui32Length >= HASH_DMA_MIN_BYTES) &&
+           (((uintptr_t)pui8Data & 3) == 0);
+}
+
+//*****************************************************************************
+//
+//! Prepare a message for chunked transfer
+//!
+//! \param psStream is the scheduler state
+//! \param pui8Data is the message; must stay valid until the stream completes
+//! \param ui32Length is the message length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashDMAStreamInit(tHashDMAStream *psStream, const uint8_t *pui8Data,
+                  uint32_t ui32Length)
+{
+    psStream->pui8Data = pui8Data;
+    psStream->ui32Length = ui32Length;
+    psStream->ui32Next = 0;
+    psStream->ui32InFlight = 0;
+    psStream->bTailQueued = false;
+}
+
+//*****************************************************************************
+//
+//! Get the next chunk to program into a free descriptor half
+//!
+//! \param psStream is the scheduler state
+//! \param ppui8Src receives the chunk address (word aligned)
+//! \param pui32Bytes receives the chunk length, a multiple of 64
+//!
+//! \return false if every chunk has already been handed out
+//
+//*****************************************************************************
+bool
+HashDMAStreamNext(tHashDMAStream *psStream, const uint8_t **ppui8Src,
+                  uint32_t *pui32Bytes)
+{
+    uint32_t ui32Body = psStream->ui32Length & ~63u;
+    uint32_t ui32Tail = psStream->ui32Length & 63u;
+    uint32_t ui32Bytes;
+
+    if(psStream->ui32Next < ui32Body)
+    {
+        ui32Bytes = ui32Body - psStream->ui32Next;
+        if(ui32Bytes > HASH_DMA_CHUNK_BYTES)
+        {
+            ui32Bytes = HASH_DMA_CHUNK_BYTES;
+        }
+        *ppui8Src = psStream->pui8Data + psStream->ui32Next;
+        *pui32Bytes = ui32Bytes;
+        psStream->ui32Next += ui32Bytes;
+        psStream->ui32InFlight++;
+        return true;
+    }
+
+    if(ui32Tail && !psStream->bTailQueued)
+    {
+        memset(psStream->pui8Tail, 0, sizeof(psStream->pui8Tail));
+        memcpy(psStream->pui8Tail, psStream->pui8Data + ui32Body, ui32Tail);
+        *ppui8Src = psStream->pui8Tail;
+        *pui32Bytes = sizeof(psStream->pui8Tail);
+        psStream->bTailQueued = true;
+        psStream->ui32InFlight++;
+        return true;
+    }
+
+    return false;
+}
+
+//*****************************************************************************
+//
+//! Retire a chunk whose transfer finished
+//!
+//! \param psStream is the scheduler state
+//!
+//! \return true once the whole message has been transferred
+//
+//*****************************************************************************
+bool
+HashDMAStreamComplete(tHashDMAStream *psStream)
+{
+    if(psStream->ui32InFlight)
+    {
+        psStream->ui32InFlight--;
+    }
+
+    return (psStream->ui32InFlight == 0) &&
+           (psStream->ui32Next == (psStream->ui32Length & ~63u)) &&
+           (((psStream->ui32Length & 63u) == 0) || psStream->bTailQueued);
+}
+
+//*****************************************************************************
+//
+//! Reset a simulated channel
+//!
+//! \param psChan is the channel
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashDMASimInit(tHashDMASimChannel *psChan)
+{
+    memset(psChan, 0, sizeof(*psChan));
+    psChan->ui32Active = HASH_DMA_PRIMARY;
+}
+
+//*****************************************************************************
+//
+//! Program one half of a simulated channel
+//!
+//! \param psChan is the channel
+//! \param ui32Half is HASH_DMA_PRIMARY or HASH_DMA_ALTERNATE
+//! \param pui8Src is the source buffer
+//! \param ui32Bytes is the transfer length
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashDMASimProgram(tHashDMASimChannel *psChan, uint32_t ui32Half,
+                  const uint8_t *pui8Src, uint32_t ui32Bytes)
+{
+    psChan->ppui8Src[ui32Half] = pui8Src;
+    psChan->pui32Bytes[ui32Half] = ui32Bytes;
+    psChan->pbArmed[ui32Half] = true;
+}
+
+//*****************************************************************************
+//
+//! Run the active half of a simulated channel to completion
+//!
+//! \param psChan is the channel
+//! \param pfnSink receives the transferred bytes, one 64-byte burst at a time
+//! \param pvArg is passed to the sink
+//! \param pui32Half receives the half that completed
+//!
+//! \return false if the active half is not armed (the channel has stopped)
+//
+//*****************************************************************************
+bool
+HashDMASimStep(tHashDMASimChannel *psChan, tHashDMASink pfnSink, void *pvArg,
+               uint32_t *pui32Half)
+{
+    uint32_t ui32Half = psChan->ui32Active;
+    uint32_t ui32Offset;
+
+    if(!psChan->pbArmed[ui32Half])
+    {
+        return false;
+    }
+
+    for(ui32Offset = 0; ui32Offset < psChan->pui32Bytes[ui32Half];
+        ui32Offset += 64)
+    {
+        pfnSink(pvArg, psChan->ppui8Src[ui32Half] + ui32Offset, 64);
+    }
+
+    psChan->pbArmed[ui32Half] = false;
+    psChan->ui32Active = ui32Half ^ 1;
+    psChan->ui32Transfers++;
+    *pui32Half = ui32Half;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Simulated SHAMD5 input FIFO: it hashes up to the programmed length and
+// drops the padding of the final block, as the engine does.
+//
+//*****************************************************************************
+typedef struct
+{
+    tSWHashContext sCtx;
+    uint32_t ui32Remain;
+} tHashDMASimFIFO;
+
+static void
+HashDMASimFIFOWrite(void *pvArg, const uint8_t *pui8Data, uint32_t ui32Bytes)
+{
+    tHashDMASimFIFO *psFIFO = (tHashDMASimFIFO *)pvArg;
+
+    if(ui32Bytes > psFIFO->ui32Remain)
+    {
+        ui32Bytes = psFIFO->ui32Remain;
+    }
+    SWHashUpdate(&psFIFO->sCtx, pui8Data, ui32Bytes);
+    psFIFO->ui32Remain -= ui32Bytes;
+}
+
+//*****************************************************************************
+//
+//! Hash a message through the simulated DMA channel. Exercises the same
+//! ping-pong scheduling and completion handling as the board.
+//!
+//! \param ui32Algo is the algorithm (SHAMD5_ALGO_*)
+//! \param pui8Data is the message
+//! \param ui32Length is the message length in bytes
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashDMASimHash(uint32_t ui32Algo, const uint8_t *pui8Data,
+               uint32_t ui32Length, uint8_t *pui8Result)
+{
+    tHashDMAStream sStream;
+    tHashDMASimChannel sChan;
+    tHashDMASimFIFO sFIFO;
+    const uint8_t *pui8Src;
+    uint32_t ui32Bytes, ui32Half;
+
+    SWHashInit(&sFIFO.sCtx, ui32Algo);
+    sFIFO.ui32Remain = ui32Length;
+    HashDMAStreamInit(&sStream, pui8Data, ui32Length);
+    HashDMASimInit(&sChan);
+
+    //
+    // Prime both halves, then refill each half as its completion "interrupt"
+    // arrives.
+    //
+    for(ui32Half = HASH_DMA_PRIMARY; ui32Half <= HASH_DMA_ALTERNATE;
+        ui32Half++)
+    {
+        if(!HashDMAStreamNext(&sStream, &pui8Src, &ui32Bytes))
+        {
+            break;
+        }
+        HashDMASimProgram(&sChan, ui32Half, pui8Src, ui32Bytes);
+    }
+
+    while(HashDMASimStep(&sChan, HashDMASimFIFOWrite, &sFIFO, &ui32Half))
+    {
+        if(HashDMAStreamComplete(&sStream))
+        {
+            break;
+        }
+        if(HashDMAStreamNext(&sStream, &pui8Src, &ui32Bytes))
+        {
+            HashDMASimProgram(&sChan, ui32Half, pui8Src, ui32Bytes);
+        }
+    }
+
+    SWHashFinal(&sFIFO.sCtx, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Measure SHA-256 throughput of the CPU-fed and the DMA-fed paths
+//!
+//! \param pui8Data is the test message (word aligned)
+//! \param ui32Length is the message length in bytes
+//! \param ui32Rounds is the number of hashes per path
+//! \param pui64CPUBytesPerSec receives the CPU-fed rate
+//! \param pui64DMABytesPerSec receives the DMA-fed rate
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashDMAMeasure(const uint8_t *pui8Data, uint32_t ui32Length,
+               uint32_t ui32Rounds, uint64_t *pui64CPUBytesPerSec,
+               uint64_t *pui64DMABytesPerSec)
+{
+    uint8_t pui8Result[HASH_MAX_DIGEST_LEN];
+    tHashJob sJob;
+    uint64_t ui64Start;
+    uint32_t ui32Round;
+
+    ui64Start = PerfClockNow();
+    for(ui32Round = 0; ui32Round < ui32Rounds; ui32Round++)
+    {
+        GenerateHash(SHAMD5_ALGO_SHA256, (unsigned char *)pui8Data,
+                     pui8Result, ui32Length);
+    }
+    *pui64CPUBytesPerSec = PerfClockRate((uint64_t)ui32Length * ui32Rounds,
+                                         PerfClockNow() - ui64Start);
+
+    ui64Start = PerfClockNow();
+    for(ui32Round = 0; ui32Round < ui32Rounds; ui32Round++)
+    {
+        HashJobInit(&sJob, SHAMD5_ALGO_SHA256, pui8Data, ui32Length,
+                    pui8Result, 0, 0);
+        sJob.ui32Flags |= HASH_JOB_FLAG_DMA;
+        while(!HashJobSubmit(&sJob))
+        {
+        }
+        HashJobWait(&sJob);
+    }
+    *pui64DMABytesPerSec = PerfClockRate((uint64_t)ui32Length * ui32Rounds,
+                                         PerfClockNow() - ui64Start);
+}
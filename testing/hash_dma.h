@@ -0,0 +1,123 @@
+//*****************************************************************************
+// hash_dma.h
+//
+// uDMA-fed hashing. A tHashDMAStream splits a message into ping-pong chunks
+// for the SHAMD5 data-in channel; it holds no hardware state so the same
+// scheduling runs against the real uDMA on the board and against the
+// simulated channel (tHashDMASimChannel) on the host.
+//
+//*****************************************************************************
+
+#ifndef __HASH_DMA_H__
+#define __HASH_DMA_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+//
+// Largest chunk per descriptor: the uDMA moves at most 1024 items per
+// transfer, and the engine is fed 32-bit words.
+//
+//*****************************************************************************
+#define HASH_DMA_CHUNK_BYTES    4096
+
+//*****************************************************************************
+//
+// Messages shorter than this are cheaper to push with the CPU than to set
+// up descriptors for.
+//
+//*****************************************************************************
+#define HASH_DMA_MIN_BYTES      256
+
+//*****************************************************************************
+//
+// Ping-pong descriptor halves.
+//
+//*****************************************************************************
+#define HASH_DMA_PRIMARY        0
+#define HASH_DMA_ALTERNATE      1
+
+//*****************************************************************************
+//
+// Chunk scheduler. Whole 64-byte blocks are transferred straight from the
+// message; the final partial block goes through a zero-padded bounce buffer
+// since the engine consumes whole blocks and takes the real length from its
+// length register.
+//
+//*****************************************************************************
+typedef struct
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32Length;
+    uint32_t ui32Next;
+    uint32_t ui32InFlight;
+    bool bTailQueued;
+    uint8_t pui8Tail[64];
+} tHashDMAStream;
+
+extern bool HashDMACapable(const uint8_t *pui8Data, uint32_t ui32Length);
+extern void HashDMAStreamInit(tHashDMAStream *psStream,
+                              const uint8_t *pui8Data, uint32_t ui32Length);
+extern bool HashDMAStreamNext(tHashDMAStream *psStream,
+                              const uint8_t **ppui8Src, uint32_t *pui32Bytes);
+extern bool HashDMAStreamComplete(tHashDMAStream *psStream);
+
+//*****************************************************************************
+//
+// Simulated ping-pong channel for the host. HashDMASimStep() performs the
+// transfer programmed in the active half: the bytes go to the sink (the
+// "FIFO"), the half is disarmed and the controller switches to the other
+// half, just as the uDMA does.
+//
+//*****************************************************************************
+typedef void (*tHashDMASink)(void *pvArg, const uint8_t *pui8Data,
+                             uint32_t ui32Bytes);
+
+typedef struct
+{
+    const uint8_t *ppui8Src[2];
+    uint32_t pui32Bytes[2];
+    bool pbArmed[2];
+    uint32_t ui32Active;
+    uint32_t ui32Transfers;
+} tHashDMASimChannel;
+
+extern void HashDMASimInit(tHashDMASimChannel *psChan);
+extern void HashDMASimProgram(tHashDMASimChannel *psChan, uint32_t ui32Half,
+                              const uint8_t *pui8Src, uint32_t ui32Bytes);
+extern bool HashDMASimStep(tHashDMASimChannel *psChan, tHashDMASink pfnSink,
+                           void *pvArg, uint32_t *pui32Half);
+extern void HashDMASimHash(uint32_t ui32Algo, const uint8_t *pui8Data,
+                           uint32_t ui32Length, uint8_t *pui8Result);
+
+//*****************************************************************************
+//
+// Throughput of the CPU-fed and DMA-fed paths of the active engine.
+//
+//*****************************************************************************
+extern void HashDMAMeasure(const uint8_t *pui8Data, uint32_t ui32Length,
+                           uint32_t ui32Rounds, uint64_t *pui64CPUBytesPerSec,
+                           uint64_t *pui64DMABytesPerSec);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HASH_DMA_H__
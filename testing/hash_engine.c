@@ -0,0 +1,433 @@
+//*****************************************************************************
+// hash_engine.c
+//
+// Build-time hash engine selection and the GenerateHash() front end
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw_mb.h"
+#include "perf_probe.h"
+
+#if defined(HASH_ENGINE_SW)
+const tHashEngine * const g_psHashEngine = &g_sHashEngineSW;
+#else
+const tHashEngine * const g_psHashEngine = &g_sHashEngineHW;
+#endif
+
+//*****************************************************************************
+//
+// Algorithm names, sorted by name (lower case) for HashAlgoFind().
+//
+//*****************************************************************************
+static const tHashAlgo g_psHashAlgos[] =
+{
+    { "hmac_md5",       SHAMD5_ALGO_HMAC_MD5,       16, true  },
+    { "hmac_sha1",      SHAMD5_ALGO_HMAC_SHA1,      20, true  },
+    { "hmac_sha224",    SHAMD5_ALGO_HMAC_SHA224,    28, true  },
+    { "hmac_sha256",    SHAMD5_ALGO_HMAC_SHA256,    32, true  },
+    { "md5",            SHAMD5_ALGO_MD5,            16, false },
+    { "sha1",           SHAMD5_ALGO_SHA1,           20, false },
+    { "sha224",         SHAMD5_ALGO_SHA224,         28, false },
+    { "sha256",         SHAMD5_ALGO_SHA256,         32, false },
+};
+
+#define HASH_ALGO_COUNT         (sizeof(g_psHashAlgos) /                    \
+                                 sizeof(g_psHashAlgos[0]))
+
+//*****************************************************************************
+//
+//! Initialize the selected hash engine, and choose the multi-buffer SHA-256
+//! kernel for this CPU. Called once at boot, before any thread is started.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashEngineInit(void)
+{
+    SWSHA256MBSelect(NULL);
+    if(g_psHashEngine->pfnInit)
+    {
+        g_psHashEngine->pfnInit();
+    }
+}
+
+//*****************************************************************************
+//
+//! Digest length of an algorithm
+//!
+//! \param ui32Config is one of the SHAMD5_ALGO_* values
+//!
+//! \return the digest length in bytes, or 0 for an unknown algorithm
+//
+//*****************************************************************************
+uint32_t
+HashDigestLength(uint32_t ui32Config)
+{
+    switch(ui32Config)
+    {
+        case SHAMD5_ALGO_MD5:
+        case SHAMD5_ALGO_HMAC_MD5:
+            return 16;
+        case SHAMD5_ALGO_SHA1:
+        case SHAMD5_ALGO_HMAC_SHA1:
+            return 20;
+        case SHAMD5_ALGO_SHA224:
+        case SHAMD5_ALGO_HMAC_SHA224:
+            return 28;
+        case SHAMD5_ALGO_SHA256:
+        case SHAMD5_ALGO_HMAC_SHA256:
+            return 32;
+        default:
+            return 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Generate the hash of a buffer with the selected engine
+//!
+//! \param uiConfig is the algorithm (SHAMD5_ALGO_*)
+//! \param puiData is the message
+//! \param puiResult receives the digest
+//! \param uiDataLength is the message length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+GenerateHash(unsigned int uiConfig, unsigned char *puiData,
+             unsigned char *puiResult, unsigned int uiDataLength)
+{
+    PERF_PROBE_START(ui64Start);
+
+    g_psHashEngine->pfnHash(uiConfig, puiData, uiDataLength, puiResult);
+    PERF_PROBE_STOP(PERF_SITE_HASH, ui64Start);
+}
+
+//*****************************************************************************
+//
+//! Fill in a hash job
+//!
+//! \param psJob is the job
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*)
+//! \param pui8Data is the message
+//! \param ui32DataLength is the message length in bytes
+//! \param pui8Result receives the digest
+//! \param pfnCallback is called on completion, may be 0
+//! \param pvArg is passed to the callback
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashJobInit(tHashJob *psJob, uint32_t ui32Config, const uint8_t *pui8Data,
+            uint32_t ui32DataLength, uint8_t *pui8Result,
+            tHashJobCallback pfnCallback, void *pvArg)
+{
+    psJob->ui32Config = ui32Config;
+    psJob->pui8Data = pui8Data;
+    psJob->ui32DataLength = ui32DataLength;
+    psJob->pui8Result = pui8Result;
+    psJob->pfnCallback = pfnCallback;
+    psJob->pvArg = pvArg;
+    psJob->ui32Flags = 0;
+    psJob->psCtx = 0;
+    psJob->ui32State = HASH_JOB_IDLE;
+}
+
+//*****************************************************************************
+//
+//! Queue a hash job on the selected engine
+//!
+//! \param psJob is a job prepared with HashJobInit()
+//!
+//! \return true if the job was queued, false if the queue is full
+//
+//*****************************************************************************
+bool
+HashJobSubmit(tHashJob *psJob)
+{
+    return g_psHashEngine->pfnSubmit(psJob);
+}
+
+//*****************************************************************************
+//
+//! Poll a hash job for completion
+//!
+//! \param psJob is the job
+//!
+//! \return true once the digest has been written
+//
+//*****************************************************************************
+bool
+HashJobIsDone(const tHashJob *psJob)
+{
+#if !defined(cc3200)
+    return __atomic_load_n(&psJob->ui32State, __ATOMIC_ACQUIRE) ==
+           HASH_JOB_DONE;
+#else
+    return psJob->ui32State == HASH_JOB_DONE;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Block until a hash job is done
+//!
+//! \param psJob is the job
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashJobWait(tHashJob *psJob)
+{
+    g_psHashEngine->pfnWait(psJob);
+}
+
+//*****************************************************************************
+//
+//! Start an incremental hash
+//!
+//! \param psCtx is the context
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*)
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashInit(tHashContext *psCtx, uint32_t ui32Config)
+{
+    g_psHashEngine->pfnCtxInit(psCtx, ui32Config);
+}
+
+//*****************************************************************************
+//
+//! Feed data into an incremental hash
+//!
+//! \param psCtx is the context
+//! \param pvData is the data
+//! \param ui32Length is the data length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashUpdate(tHashContext *psCtx, const void *pvData, uint32_t ui32Length)
+{
+    g_psHashEngine->pfnCtxUpdate(psCtx, (const uint8_t *)pvData, ui32Length);
+}
+
+//*****************************************************************************
+//
+//! Finish an incremental hash
+//!
+//! \param psCtx is the context; it must be re-initialized before reuse
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashFinal(tHashContext *psCtx, uint8_t *pui8Result)
+{
+    g_psHashEngine->pfnCtxFinal(psCtx, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Copy an incremental hash in progress
+//!
+//! \param psDst receives the copy
+//! \param psSrc is the context to copy
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashClone(tHashContext *psDst, const tHashContext *psSrc)
+{
+    memcpy(psDst, psSrc, sizeof(*psDst));
+}
+
+//*****************************************************************************
+//
+//! Start a hash session: a run of messages of one plain algorithm hashed
+//! back to back on an engine configured once for the whole run. Between
+//! HashSessionBegin() and HashSessionEnd() the caller owns the engine and
+//! must not hash through any other interface; jobs submitted meanwhile wait
+//! until the session ends. Only one session may be open at a time.
+//!
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*, not HMAC)
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashSessionBegin(uint32_t ui32Config)
+{
+    g_psHashEngine->pfnSessionBegin(ui32Config);
+}
+
+//*****************************************************************************
+//
+//! Hash one message of a session. Returns once the engine has taken the
+//! message, possibly before the digest is written; the message buffer may
+//! then be reused, the result buffer only after HashSessionWait() or the
+//! next HashSessionPut().
+//!
+//! \param pui8Data is the message
+//! \param ui32DataLength is the message length in bytes
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashSessionPut(const uint8_t *pui8Data, uint32_t ui32DataLength,
+               uint8_t *pui8Result)
+{
+    g_psHashEngine->pfnSessionPut(pui8Data, ui32DataLength, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Wait for the digest of the last message put into the session
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashSessionWait(void)
+{
+    if(g_psHashEngine->pfnSessionWait)
+    {
+        g_psHashEngine->pfnSessionWait();
+    }
+}
+
+//*****************************************************************************
+//
+//! End a hash session. The last digest is written and the engine is
+//! handed back to the job queue.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashSessionEnd(void)
+{
+    if(g_psHashEngine->pfnSessionEnd)
+    {
+        g_psHashEngine->pfnSessionEnd();
+    }
+}
+
+//*****************************************************************************
+//
+//! Compare a name with a lower-case table entry, ignoring the case of the
+//! name
+//!
+//! \param pcName is the name looked up
+//! \param pcEntry is the table entry
+//!
+//! \return less than, equal to or greater than 0, as strcmp()
+//
+//*****************************************************************************
+static int
+HashAlgoCompare(const char *pcName, const char *pcEntry)
+{
+    char cChar;
+
+    for(;;)
+    {
+        cChar = *pcName++;
+        if((cChar >= 'A') && (cChar <= 'Z'))
+        {
+            cChar += 'a' - 'A';
+        }
+        if((cChar != *pcEntry) || (cChar == '\0'))
+        {
+            return (unsigned char)cChar - (unsigned char)*pcEntry;
+        }
+        pcEntry++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Look up an algorithm by name
+//!
+//! \param pcName is the name, in any case
+//!
+//! \return the algorithm, or NULL if the name is unknown
+//
+//*****************************************************************************
+const tHashAlgo *
+HashAlgoFind(const char *pcName)
+{
+    uint32_t ui32Low = 0, ui32High = HASH_ALGO_COUNT, ui32Mid;
+    int iOrder;
+
+    while(ui32Low < ui32High)
+    {
+        ui32Mid = (ui32Low + ui32High) / 2;
+        iOrder = HashAlgoCompare(pcName, g_psHashAlgos[ui32Mid].pcName);
+        if(iOrder == 0)
+        {
+            return &g_psHashAlgos[ui32Mid];
+        }
+        if(iOrder < 0)
+        {
+            ui32High = ui32Mid;
+        }
+        else
+        {
+            ui32Low = ui32Mid + 1;
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+//! Number of named algorithms
+//!
+//! \param None
+//!
+//! \return the table size
+//
+//*****************************************************************************
+uint32_t
+HashAlgoCount(void)
+{
+    return HASH_ALGO_COUNT;
+}
+
+//*****************************************************************************
+//
+//! Get a named algorithm by position
+//!
+//! \param ui32Index is the position, below HashAlgoCount()
+//!
+//! \return the algorithm, or NULL past the end of the table
+//
+//*****************************************************************************
+const tHashAlgo *
+HashAlgoAt(uint32_t ui32Index)
+{
+    return (ui32Index < HASH_ALGO_COUNT) ? &g_psHashAlgos[ui32Index] : NULL;
+}
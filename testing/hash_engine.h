@@ -0,0 +1,243 @@
+//*****************************************************************************
+// hash_engine.h
+//
+// Pluggable hash engine interface. The chain code hashes through
+// GenerateHash(), which dispatches to the engine selected at build time:
+//
+//   - the DTHE SHAMD5 hardware accelerator (default when building for cc3200)
+//   - the portable software implementation in hash_sw.c (default on any other
+//     target, or on the board when HASH_ENGINE_SW is defined)
+//
+//*****************************************************************************
+
+#ifndef __HASH_ENGINE_H__
+#define __HASH_ENGINE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+//
+// Engine selection. Off the board there is no SHAMD5 block, so the software
+// engine is the only choice.
+//
+//*****************************************************************************
+#if !defined(cc3200) && !defined(HASH_ENGINE_SW)
+#define HASH_ENGINE_SW
+#endif
+
+//*****************************************************************************
+//
+// Algorithm identifiers. On the board these come from driverlib; the host
+// build mirrors the driverlib values so uiConfig means the same everywhere.
+//
+//*****************************************************************************
+#if defined(cc3200)
+#include "shamd5.h"
+#else
+#define SHAMD5_ALGO_MD5         0x00000018
+#define SHAMD5_ALGO_SHA1        0x0000001a
+#define SHAMD5_ALGO_SHA224      0x0000001c
+#define SHAMD5_ALGO_SHA256      0x0000001e
+#define SHAMD5_ALGO_HMAC_MD5    0x00000000
+#define SHAMD5_ALGO_HMAC_SHA1   0x00000002
+#define SHAMD5_ALGO_HMAC_SHA224 0x00000004
+#define SHAMD5_ALGO_HMAC_SHA256 0x00000006
+#endif
+
+//*****************************************************************************
+//
+// Largest digest produced by any supported algorithm, in bytes.
+//
+//*****************************************************************************
+#define HASH_MAX_DIGEST_LEN     32
+
+//*****************************************************************************
+//
+// Depth of the pending job queue of the asynchronous interface.
+//
+//*****************************************************************************
+#ifndef HASH_JOB_QUEUE_DEPTH
+#define HASH_JOB_QUEUE_DEPTH    8
+#endif
+
+//*****************************************************************************
+//
+// Job states.
+//
+//*****************************************************************************
+#define HASH_JOB_IDLE           0
+#define HASH_JOB_QUEUED         1
+#define HASH_JOB_RUNNING        2
+#define HASH_JOB_DONE           3
+
+//*****************************************************************************
+//
+// Job flags. HASH_JOB_FLAG_DMA asks for the input to be streamed into the
+// engine by uDMA (simulated on the host); it is ignored for messages that
+// HashDMACapable() rejects.
+//
+//*****************************************************************************
+#define HASH_JOB_FLAG_DMA       0x00000001
+
+//*****************************************************************************
+//
+// Flags used by the incremental interface. HASH_JOB_FLAG_RESUME starts from
+// the intermediate digest saved in psCtx instead of the algorithm's initial
+// value; HASH_JOB_FLAG_PARTIAL leaves the hash open (the input must then be
+// whole 64-byte blocks) and saves the intermediate digest back into psCtx
+// instead of producing a result.
+//
+//*****************************************************************************
+#define HASH_JOB_FLAG_RESUME    0x00000002
+#define HASH_JOB_FLAG_PARTIAL   0x00000004
+
+//*****************************************************************************
+//
+// Incremental hash context. pui32State holds the intermediate digest in the
+// format of the engine that produced it, so a context must be finished by
+// the engine it was started on. A context is plain data: it can be copied
+// with HashClone() at any point, e.g. after the constant prefix of a block
+// header, and each copy continued independently.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t pui32State[8];
+    uint64_t ui64Length;
+    uint32_t ui32Algo;
+    uint32_t ui32BufLen;
+    uint8_t pui8Buffer[64];
+} tHashContext;
+
+//*****************************************************************************
+//
+// An asynchronous hash request. The caller owns the job, the input and the
+// result buffer, all of which must stay valid until the job is done. The
+// callback runs in the completion context: the SHAMD5 interrupt on the board,
+// the worker thread on the host. It must not block. The job is marked done
+// only after its callback returns, and the engine does not touch it again.
+//
+//*****************************************************************************
+typedef struct sHashJob tHashJob;
+
+typedef void (*tHashJobCallback)(tHashJob *psJob, void *pvArg);
+
+struct sHashJob
+{
+    uint32_t ui32Config;
+    const uint8_t *pui8Data;
+    uint32_t ui32DataLength;
+    uint8_t *pui8Result;
+    tHashJobCallback pfnCallback;
+    void *pvArg;
+    uint32_t ui32Flags;
+    tHashContext *psCtx;
+    volatile uint32_t ui32State;
+};
+
+//*****************************************************************************
+//
+// A hash engine. pfnInit is called once at boot before any hashing;
+// pfnHash computes the digest of a contiguous buffer and returns when it is
+// ready; pfnSubmit queues a job and returns immediately (false when the queue
+// is full); pfnWait blocks until a submitted job is done; pfnCtxInit,
+// pfnCtxUpdate and pfnCtxFinal implement the incremental interface.
+//
+// pfnSessionBegin, pfnSessionPut, pfnSessionWait and pfnSessionEnd implement
+// a hash session (see HashSessionBegin()). An engine whose pfnSessionPut
+// returns with the digest written may leave pfnSessionWait and
+// pfnSessionEnd 0.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    void (*pfnInit)(void);
+    void (*pfnHash)(uint32_t ui32Config, const uint8_t *pui8Data,
+                    uint32_t ui32DataLength, uint8_t *pui8Result);
+    bool (*pfnSubmit)(tHashJob *psJob);
+    void (*pfnWait)(tHashJob *psJob);
+    void (*pfnCtxInit)(tHashContext *psCtx, uint32_t ui32Config);
+    void (*pfnCtxUpdate)(tHashContext *psCtx, const uint8_t *pui8Data,
+                         uint32_t ui32Length);
+    void (*pfnCtxFinal)(tHashContext *psCtx, uint8_t *pui8Result);
+    void (*pfnSessionBegin)(uint32_t ui32Config);
+    void (*pfnSessionPut)(const uint8_t *pui8Data, uint32_t ui32DataLength,
+                          uint8_t *pui8Result);
+    void (*pfnSessionWait)(void);
+    void (*pfnSessionEnd)(void);
+} tHashEngine;
+
+#if defined(cc3200)
+extern const tHashEngine g_sHashEngineHW;
+#endif
+extern const tHashEngine g_sHashEngineSW;
+
+//*****************************************************************************
+//
+// The engine selected at build time.
+//
+//*****************************************************************************
+extern const tHashEngine * const g_psHashEngine;
+
+//*****************************************************************************
+//
+// Algorithm names as typed on the console, e.g. "sha256" or "HMAC_SHA1".
+// HashAlgoFind() ignores case; HashAlgoAt() walks the table in name order.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Config;
+    uint32_t ui32DigestLength;
+    bool bHMAC;
+} tHashAlgo;
+
+extern void HashEngineInit(void);
+extern uint32_t HashDigestLength(uint32_t ui32Config);
+extern void GenerateHash(unsigned int uiConfig, unsigned char *puiData,
+                         unsigned char *puiResult, unsigned int uiDataLength);
+extern void HashJobInit(tHashJob *psJob, uint32_t ui32Config,
+                        const uint8_t *pui8Data, uint32_t ui32DataLength,
+                        uint8_t *pui8Result, tHashJobCallback pfnCallback,
+                        void *pvArg);
+extern bool HashJobSubmit(tHashJob *psJob);
+extern bool HashJobIsDone(const tHashJob *psJob);
+extern void HashJobWait(tHashJob *psJob);
+extern void HashInit(tHashContext *psCtx, uint32_t ui32Config);
+extern void HashUpdate(tHashContext *psCtx, const void *pvData,
+                       uint32_t ui32Length);
+extern void HashFinal(tHashContext *psCtx, uint8_t *pui8Result);
+extern void HashClone(tHashContext *psDst, const tHashContext *psSrc);
+extern void HashSessionBegin(uint32_t ui32Config);
+extern void HashSessionPut(const uint8_t *pui8Data, uint32_t ui32DataLength,
+                           uint8_t *pui8Result);
+extern void HashSessionWait(void);
+extern void HashSessionEnd(void);
+extern const tHashAlgo *HashAlgoFind(const char *pcName);
+extern uint32_t HashAlgoCount(void);
+extern const tHashAlgo *HashAlgoAt(uint32_t ui32Index);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HASH_ENGINE_H__
@@ -0,0 +1,807 @@
+//*****************************************************************************
+// hash_engine_hw.c
+//
+// Hash engine backed by the DTHE SHAMD5 hardware accelerator
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+
+#if defined(cc3200)
+
+// Driverlib includes
+#include "hw_shamd5.h"
+#include "hw_memmap.h"
+#include "hw_types.h"
+#include "hw_ints.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "shamd5.h"
+#include "interrupt.h"
+#include "prcm.h"
+#include "udma.h"
+
+#include "hash_dma.h"
+#include "perf_probe.h"
+
+//*****************************************************************************
+//
+// uDMA channel wired to the DTHE SHA data-in request. Override from the
+// project settings if the channel map differs.
+//
+//*****************************************************************************
+#ifndef HASH_DMA_CHANNEL
+#define HASH_DMA_CHANNEL        UDMA_CH17_SW
+#endif
+
+//*****************************************************************************
+//
+// Job queue. Jobs are appended by HWEngineSubmit() in thread context and
+// retired by SHAMD5IntHandler(); the head job is the one on the engine.
+//
+//*****************************************************************************
+static tHashJob * volatile g_ppsQueue[HASH_JOB_QUEUE_DEPTH];
+static volatile uint32_t g_ui32QueueHead;
+static volatile uint32_t g_ui32QueueCount;
+
+//*****************************************************************************
+//
+// Progress of the head job through the engine.
+//
+//*****************************************************************************
+#define HW_STATE_IDLE           0
+#define HW_STATE_CONTEXT        1   // waiting for CONTEXT_READY
+#define HW_STATE_INPUT          2   // feeding blocks on INPUT_READY
+#define HW_STATE_OUTPUT         3   // waiting for OUTPUT_READY
+#define HW_STATE_DMA            4   // input streamed by uDMA
+#define HW_STATE_PARTIAL        5   // waiting for PARTHASH_READY
+#define HW_STATE_SESSION        6   // held by a hash session, polled
+
+static volatile uint32_t g_ui32HWState = HW_STATE_IDLE;
+static uint32_t g_ui32InputOffset;
+static tHashDMAStream g_sDMAStream;
+
+//
+// Where the digest of the message on the engine goes, while a session has
+// one outstanding.
+//
+static uint8_t *g_pui8SessionResult;
+
+#if defined(PERF_PROBES)
+//
+// When the head job was started, for the interrupt latency probe.
+//
+static uint64_t g_ui64StartTicks;
+#endif
+
+//*****************************************************************************
+//
+//! Start the head job of the queue on the engine. The rest of the job is
+//! driven from SHAMD5IntHandler().
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineStartHead(void)
+{
+    g_ppsQueue[g_ui32QueueHead]->ui32State = HASH_JOB_RUNNING;
+    g_ui32InputOffset = 0;
+    g_ui32HWState = HW_STATE_CONTEXT;
+    PERF_PROBE_MARK(g_ui64StartTicks);
+    MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_CONTEXT_READY);
+}
+
+//*****************************************************************************
+//
+//! Load a saved intermediate digest into the engine
+//!
+//! \param psCtx is the context
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineContextLoad(const tHashContext *psCtx)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        HWREG(SHAMD5_BASE + SHAMD5_O_IDIGEST_A + (ui32Idx * 4)) =
+            psCtx->pui32State[ui32Idx];
+    }
+    HWREG(SHAMD5_BASE + SHAMD5_O_DIGEST_COUNT) =
+        (uint32_t)(psCtx->ui64Length - psCtx->ui32BufLen);
+}
+
+//*****************************************************************************
+//
+//! Save the intermediate digest of a partial hash from the engine
+//!
+//! \param psCtx is the context
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineContextSave(tHashContext *psCtx)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        psCtx->pui32State[ui32Idx] =
+            HWREG(SHAMD5_BASE + SHAMD5_O_IDIGEST_A + (ui32Idx * 4));
+    }
+}
+
+//*****************************************************************************
+//
+//! Program mode and length for a job. Resumed jobs start from the saved
+//! intermediate digest instead of the algorithm constants; partial jobs
+//! leave the hash open.
+//!
+//! \param psJob is the running job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineConfigure(tHashJob *psJob)
+{
+    uint32_t ui32Mode = psJob->ui32Config;
+
+    if(psJob->ui32Flags & HASH_JOB_FLAG_RESUME)
+    {
+        HWEngineContextLoad(psJob->psCtx);
+        ui32Mode &= ~SHAMD5_MODE_ALGO_CONSTANT;
+    }
+    if(psJob->ui32Flags & HASH_JOB_FLAG_PARTIAL)
+    {
+        ui32Mode &= ~SHAMD5_MODE_CLOSE_HASH;
+    }
+    MAP_SHAMD5ConfigSet(SHAMD5_BASE, ui32Mode);
+    MAP_SHAMD5HashLengthSet(SHAMD5_BASE, psJob->ui32DataLength);
+}
+
+//*****************************************************************************
+//
+//! All input of the running job is in: wait for the digest, or for the
+//! intermediate digest of a partial job.
+//!
+//! \param psJob is the running job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineAwaitResult(tHashJob *psJob)
+{
+    if(psJob->ui32Flags & HASH_JOB_FLAG_PARTIAL)
+    {
+        g_ui32HWState = HW_STATE_PARTIAL;
+        MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_PARTHASH_READY);
+    }
+    else
+    {
+        g_ui32HWState = HW_STATE_OUTPUT;
+        MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_OUTPUT_READY);
+    }
+}
+
+//*****************************************************************************
+//
+//! Complete the running job and start the next one
+//!
+//! \param psJob is the running job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineRetire(tHashJob *psJob)
+{
+    g_ui32QueueHead = (g_ui32QueueHead + 1) % HASH_JOB_QUEUE_DEPTH;
+    g_ui32QueueCount--;
+    g_ui32HWState = HW_STATE_IDLE;
+    if(psJob->pfnCallback)
+    {
+        psJob->pfnCallback(psJob, psJob->pvArg);
+    }
+    psJob->ui32State = HASH_JOB_DONE;
+
+    if(g_ui32QueueCount)
+    {
+        HWEngineStartHead();
+    }
+}
+
+//*****************************************************************************
+//
+//! Program one half of the ping-pong data-in channel
+//!
+//! \param ui32Select is UDMA_PRI_SELECT or UDMA_ALT_SELECT
+//! \param pui8Src is the chunk (word aligned)
+//! \param ui32Bytes is the chunk length, a multiple of 64
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineDMAProgram(uint32_t ui32Select, const uint8_t *pui8Src,
+                   uint32_t ui32Bytes)
+{
+    MAP_uDMAChannelControlSet(HASH_DMA_CHANNEL | ui32Select,
+                              UDMA_SIZE_32 | UDMA_SRC_INC_32 |
+                              UDMA_DST_INC_NONE | UDMA_ARB_16);
+    MAP_uDMAChannelTransferSet(HASH_DMA_CHANNEL | ui32Select,
+                               UDMA_MODE_PINGPONG, (void *)pui8Src,
+                               (void *)(SHAMD5_BASE + SHAMD5_O_DATA0_IN),
+                               ui32Bytes / 4);
+}
+
+//*****************************************************************************
+//
+//! Start streaming the running job into the engine: prime both descriptor
+//! halves and let the engine request data.
+//!
+//! \param psJob is the running job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineDMAStart(tHashJob *psJob)
+{
+    const uint8_t *pui8Src;
+    uint32_t ui32Bytes;
+
+    HashDMAStreamInit(&g_sDMAStream, psJob->pui8Data, psJob->ui32DataLength);
+
+    MAP_uDMAChannelAssign(HASH_DMA_CHANNEL);
+    MAP_uDMAChannelAttributeDisable(HASH_DMA_CHANNEL, UDMA_ATTR_ALTSELECT |
+                                    UDMA_ATTR_USEBURST | UDMA_ATTR_REQMASK);
+    if(HashDMAStreamNext(&g_sDMAStream, &pui8Src, &ui32Bytes))
+    {
+        HWEngineDMAProgram(UDMA_PRI_SELECT, pui8Src, ui32Bytes);
+    }
+    if(HashDMAStreamNext(&g_sDMAStream, &pui8Src, &ui32Bytes))
+    {
+        HWEngineDMAProgram(UDMA_ALT_SELECT, pui8Src, ui32Bytes);
+    }
+    MAP_uDMAChannelEnable(HASH_DMA_CHANNEL);
+
+    g_ui32HWState = HW_STATE_DMA;
+    MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_DMA_DATA_IN);
+    MAP_SHAMD5DMAEnable(SHAMD5_BASE, SHAMD5_INT_DMA_DATA_IN);
+}
+
+//*****************************************************************************
+//
+//! Handle a data-in DMA done event: refill whichever half has stopped.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineDMAService(void)
+{
+    const uint8_t *pui8Src;
+    uint32_t ui32Bytes, ui32Select;
+
+    MAP_SHAMD5IntClear(SHAMD5_BASE, SHAMD5_INT_DMA_DATA_IN);
+    if(HashDMAStreamComplete(&g_sDMAStream))
+    {
+        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_DMA_DATA_IN);
+        MAP_SHAMD5DMADisable(SHAMD5_BASE, SHAMD5_INT_DMA_DATA_IN);
+        MAP_uDMAChannelDisable(HASH_DMA_CHANNEL);
+        HWEngineAwaitResult(g_ppsQueue[g_ui32QueueHead]);
+        return;
+    }
+    if(HashDMAStreamNext(&g_sDMAStream, &pui8Src, &ui32Bytes))
+    {
+        ui32Select = (MAP_uDMAChannelModeGet(HASH_DMA_CHANNEL |
+                                             UDMA_PRI_SELECT) ==
+                      UDMA_MODE_STOP) ? UDMA_PRI_SELECT : UDMA_ALT_SELECT;
+        HWEngineDMAProgram(ui32Select, pui8Src, ui32Bytes);
+    }
+}
+
+//*****************************************************************************
+//
+//! Write the next 64-byte block of the running job into the engine. The
+//! final partial block is zero padded; the engine uses the programmed length.
+//!
+//! \param psJob is the running job
+//!
+//! \return true once all input has been written
+//
+//*****************************************************************************
+static bool
+HWEngineFeed(tHashJob *psJob)
+{
+    uint8_t pui8Block[64];
+    uint32_t ui32Remain = psJob->ui32DataLength - g_ui32InputOffset;
+
+    //
+    // The offset only advances if the engine actually took the block.
+    //
+    if(ui32Remain >= 64)
+    {
+        if(MAP_SHAMD5DataWriteNonBlocking(SHAMD5_BASE,
+                              (uint8_t *)psJob->pui8Data + g_ui32InputOffset))
+        {
+            g_ui32InputOffset += 64;
+        }
+    }
+    else if(ui32Remain)
+    {
+        memset(pui8Block, 0, sizeof(pui8Block));
+        memcpy(pui8Block, psJob->pui8Data + g_ui32InputOffset, ui32Remain);
+        if(MAP_SHAMD5DataWriteNonBlocking(SHAMD5_BASE, pui8Block))
+        {
+            g_ui32InputOffset += ui32Remain;
+        }
+    }
+
+    return g_ui32InputOffset == psJob->ui32DataLength;
+}
+
+//*****************************************************************************
+//
+//! SHAMD5 interrupt handler. Advances the head job through
+//! context ready -> input ready -> output ready, completes it and starts the
+//! next queued job. For DMA-fed jobs the input ready step is replaced by
+//! data-in DMA done events, one per ping-pong half; partial jobs of the
+//! incremental interface end on PARTHASH_READY instead of output ready.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SHAMD5IntHandler(void)
+{
+    uint32_t ui32IntStatus;
+    tHashJob *psJob;
+    //
+    // Read the SHA/MD5 masked interrupt status.
+    //
+    ui32IntStatus = MAP_SHAMD5IntStatus(SHAMD5_BASE, true);
+    if(g_ui32QueueCount == 0)
+    {
+        MAP_SHAMD5IntDisable(SHAMD5_BASE, ui32IntStatus);
+        return;
+    }
+    psJob = g_ppsQueue[g_ui32QueueHead];
+
+    if((ui32IntStatus & SHAMD5_INT_CONTEXT_READY) &&
+       (g_ui32HWState == HW_STATE_CONTEXT))
+    {
+        //
+        // Configure the SHA/MD5 module. Writing the length starts the
+        // operation.
+        //
+        PERF_PROBE_STOP(PERF_SITE_HASH_IRQ, g_ui64StartTicks);
+        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_CONTEXT_READY);
+        HWEngineConfigure(psJob);
+        if((psJob->ui32Flags & HASH_JOB_FLAG_DMA) &&
+           HashDMACapable(psJob->pui8Data, psJob->ui32DataLength))
+        {
+            HWEngineDMAStart(psJob);
+        }
+        else if(psJob->ui32DataLength)
+        {
+            g_ui32HWState = HW_STATE_INPUT;
+            MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_INPUT_READY);
+        }
+        else
+        {
+            HWEngineAwaitResult(psJob);
+        }
+        return;
+    }
+    if((ui32IntStatus & SHAMD5_INT_INPUT_READY) &&
+       (g_ui32HWState == HW_STATE_INPUT))
+    {
+        if(HWEngineFeed(psJob))
+        {
+            MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_INPUT_READY);
+            HWEngineAwaitResult(psJob);
+        }
+        return;
+    }
+    if((ui32IntStatus & SHAMD5_INT_DMA_DATA_IN) &&
+       (g_ui32HWState == HW_STATE_DMA))
+    {
+        HWEngineDMAService();
+    }
+    if((ui32IntStatus & SHAMD5_INT_OUTPUT_READY) &&
+       (g_ui32HWState == HW_STATE_OUTPUT))
+    {
+        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_OUTPUT_READY);
+        MAP_SHAMD5ResultRead(SHAMD5_BASE, psJob->pui8Result);
+        HWEngineRetire(psJob);
+    }
+    else if((ui32IntStatus & SHAMD5_INT_PARTHASH_READY) &&
+            (g_ui32HWState == HW_STATE_PARTIAL))
+    {
+        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_PARTHASH_READY);
+        HWEngineContextSave(psJob->psCtx);
+        HWEngineRetire(psJob);
+    }
+}
+
+//*****************************************************************************
+//
+//! Enable the DTHE clock and hook the SHAMD5 interrupt
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineInit(void)
+{
+    MAP_PRCMPeripheralClkEnable(PRCM_DTHE, PRCM_RUN_MODE_CLK);
+    MAP_SHAMD5IntRegister(SHAMD5_BASE, SHAMD5IntHandler);
+}
+
+//*****************************************************************************
+//
+//! Queue a job on the SHAMD5 engine
+//!
+//! \param psJob is the job
+//!
+//! \return true if queued, false if the queue is full
+//
+//*****************************************************************************
+static bool
+HWEngineSubmit(tHashJob *psJob)
+{
+    bool bMasked;
+    bool bQueued = false;
+
+    bMasked = MAP_IntMasterDisable();
+    if(g_ui32QueueCount < HASH_JOB_QUEUE_DEPTH)
+    {
+        psJob->ui32State = HASH_JOB_QUEUED;
+        g_ppsQueue[(g_ui32QueueHead + g_ui32QueueCount) %
+                   HASH_JOB_QUEUE_DEPTH] = psJob;
+        g_ui32QueueCount++;
+        if(g_ui32HWState == HW_STATE_IDLE)
+        {
+            HWEngineStartHead();
+        }
+        bQueued = true;
+    }
+    if(!bMasked)
+    {
+        MAP_IntMasterEnable();
+    }
+
+    return bQueued;
+}
+
+//*****************************************************************************
+//
+//! Wait for a job to complete
+//!
+//! \param psJob is the job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineWait(tHashJob *psJob)
+{
+    while(psJob->ui32State != HASH_JOB_DONE)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Hash a buffer on the SHAMD5 engine. Goes through the job queue so that it
+//! can be mixed freely with asynchronous submissions.
+//!
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*)
+//! \param pui8Data is the message
+//! \param ui32DataLength is the message length in bytes
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineHash(uint32_t ui32Config, const uint8_t *pui8Data,
+             uint32_t ui32DataLength, uint8_t *pui8Result)
+{
+    tHashJob sJob;
+
+    HashJobInit(&sJob, ui32Config, pui8Data, ui32DataLength, pui8Result, 0, 0);
+    while(!HWEngineSubmit(&sJob))
+    {
+    }
+    HWEngineWait(&sJob);
+}
+
+//*****************************************************************************
+//
+//! Run one step of an incremental hash on the engine and wait for it
+//!
+//! \param psCtx is the context
+//! \param pui8Data is the input
+//! \param ui32Length is the input length; whole blocks unless final
+//! \param pui8Result receives the digest of a final step, 0 otherwise
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineCtxRun(tHashContext *psCtx, const uint8_t *pui8Data,
+               uint32_t ui32Length, uint8_t *pui8Result)
+{
+    tHashJob sJob;
+
+    HashJobInit(&sJob, psCtx->ui32Algo, pui8Data, ui32Length, pui8Result,
+                0, 0);
+    sJob.psCtx = psCtx;
+    if(psCtx->ui64Length != psCtx->ui32BufLen)
+    {
+        sJob.ui32Flags |= HASH_JOB_FLAG_RESUME;
+    }
+    if(pui8Result == 0)
+    {
+        sJob.ui32Flags |= HASH_JOB_FLAG_PARTIAL;
+    }
+    while(!HWEngineSubmit(&sJob))
+    {
+    }
+    HWEngineWait(&sJob);
+}
+
+static void
+HWEngineCtxInit(tHashContext *psCtx, uint32_t ui32Config)
+{
+    memset(psCtx, 0, sizeof(*psCtx));
+    psCtx->ui32Algo = ui32Config;
+}
+
+//*****************************************************************************
+//
+//! Feed data into an incremental hash. Whole blocks are absorbed by the
+//! engine as partial hashes; the remainder waits in the context buffer.
+//!
+//! \param psCtx is the context
+//! \param pui8Data is the data
+//! \param ui32Length is the data length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineCtxUpdate(tHashContext *psCtx, const uint8_t *pui8Data,
+                  uint32_t ui32Length)
+{
+    uint32_t ui32Fill, ui32Whole;
+
+    if(psCtx->ui32BufLen)
+    {
+        ui32Fill = 64 - psCtx->ui32BufLen;
+        if(ui32Length < ui32Fill)
+        {
+            memcpy(psCtx->pui8Buffer + psCtx->ui32BufLen, pui8Data,
+                   ui32Length);
+            psCtx->ui32BufLen += ui32Length;
+            psCtx->ui64Length += ui32Length;
+            return;
+        }
+        memcpy(psCtx->pui8Buffer + psCtx->ui32BufLen, pui8Data, ui32Fill);
+        psCtx->ui32BufLen = 64;
+        psCtx->ui64Length += ui32Fill;
+        HWEngineCtxRun(psCtx, psCtx->pui8Buffer, 64, 0);
+        psCtx->ui32BufLen = 0;
+        pui8Data += ui32Fill;
+        ui32Length -= ui32Fill;
+    }
+
+    //
+    // The digest count loaded on resume is the bytes already absorbed, so
+    // the length is only advanced once the engine has taken the blocks.
+    //
+    ui32Whole = ui32Length & ~63u;
+    if(ui32Whole)
+    {
+        HWEngineCtxRun(psCtx, pui8Data, ui32Whole, 0);
+        psCtx->ui64Length += ui32Whole;
+        pui8Data += ui32Whole;
+        ui32Length -= ui32Whole;
+    }
+
+    if(ui32Length)
+    {
+        memcpy(psCtx->pui8Buffer, pui8Data, ui32Length);
+        psCtx->ui32BufLen = ui32Length;
+        psCtx->ui64Length += ui32Length;
+    }
+}
+
+static void
+HWEngineCtxFinal(tHashContext *psCtx, uint8_t *pui8Result)
+{
+    HWEngineCtxRun(psCtx, psCtx->pui8Buffer, psCtx->ui32BufLen, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Wait until the engine raises a status bit. Sessions poll the raw status
+//! with the SHAMD5 interrupts left disabled.
+//!
+//! \param ui32Status is one of the SHAMD5_INT_* bits
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineSessionPoll(uint32_t ui32Status)
+{
+    while(!(MAP_SHAMD5IntStatus(SHAMD5_BASE, false) & ui32Status))
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Take the engine for a session: wait for the job queue to drain, then
+//! program the mode once. The mode register keeps the algorithm, constant
+//! load and close-hash bits from one operation to the next, so each message
+//! of the session only writes its length.
+//!
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*, not HMAC)
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineSessionBegin(uint32_t ui32Config)
+{
+    bool bMasked;
+    bool bHeld = false;
+
+    while(!bHeld)
+    {
+        bMasked = MAP_IntMasterDisable();
+        if(g_ui32QueueCount == 0)
+        {
+            g_ui32HWState = HW_STATE_SESSION;
+            bHeld = true;
+        }
+        if(!bMasked)
+        {
+            MAP_IntMasterEnable();
+        }
+    }
+
+    g_pui8SessionResult = 0;
+    HWEngineSessionPoll(SHAMD5_INT_CONTEXT_READY);
+    MAP_SHAMD5ConfigSet(SHAMD5_BASE, ui32Config);
+}
+
+//*****************************************************************************
+//
+//! Wait for the digest of the message on the engine, if any
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineSessionWait(void)
+{
+    if(g_pui8SessionResult)
+    {
+        HWEngineSessionPoll(SHAMD5_INT_OUTPUT_READY);
+        MAP_SHAMD5ResultRead(SHAMD5_BASE, g_pui8SessionResult);
+        g_pui8SessionResult = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Start one message of a session. The digest of the previous message is
+//! collected first; this message is written in and left to the engine, so
+//! the caller can prepare the next one while it is hashed.
+//!
+//! \param pui8Data is the message
+//! \param ui32DataLength is the message length in bytes
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineSessionPut(const uint8_t *pui8Data, uint32_t ui32DataLength,
+                   uint8_t *pui8Result)
+{
+    uint8_t pui8Block[64];
+    uint32_t ui32Offset;
+
+    HWEngineSessionWait();
+
+    //
+    // Writing the length starts the operation with the session's mode.
+    //
+    HWEngineSessionPoll(SHAMD5_INT_CONTEXT_READY);
+    MAP_SHAMD5HashLengthSet(SHAMD5_BASE, ui32DataLength);
+    for(ui32Offset = 0; (ui32Offset + 64) <= ui32DataLength;
+        ui32Offset += 64)
+    {
+        MAP_SHAMD5DataWrite(SHAMD5_BASE, (uint8_t *)pui8Data + ui32Offset);
+    }
+    if(ui32Offset < ui32DataLength)
+    {
+        memset(pui8Block, 0, sizeof(pui8Block));
+        memcpy(pui8Block, pui8Data + ui32Offset, ui32DataLength - ui32Offset);
+        MAP_SHAMD5DataWrite(SHAMD5_BASE, pui8Block);
+    }
+    g_pui8SessionResult = pui8Result;
+}
+
+//*****************************************************************************
+//
+//! End a session and start any jobs queued while it held the engine
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HWEngineSessionEnd(void)
+{
+    bool bMasked;
+
+    HWEngineSessionWait();
+
+    bMasked = MAP_IntMasterDisable();
+    g_ui32HWState = HW_STATE_IDLE;
+    if(g_ui32QueueCount)
+    {
+        HWEngineStartHead();
+    }
+    if(!bMasked)
+    {
+        MAP_IntMasterEnable();
+    }
+}
+
+const tHashEngine g_sHashEngineHW =
+{
+    "shamd5",
+    HWEngineInit,
+    HWEngineHash,
+    HWEngineSubmit,
+    HWEngineWait,
+    HWEngineCtxInit,
+    HWEngineCtxUpdate,
+    HWEngineCtxFinal,
+    HWEngineSessionBegin,
+    HWEngineSessionPut,
+    HWEngineSessionWait,
+    HWEngineSessionEnd
+};
+
+#endif // cc3200
@@ -0,0 +1,290 @@
+//*****************************************************************************
+// hash_engine_sw.c
+//
+// Hash engine backed by the software algorithms in hash_sw.c
+//
+// On the host the asynchronous interface is served by a worker thread so that
+// submit/complete behaves as it does with the SHAMD5 interrupt on the board
+// (link with -pthread). On the board there are no threads, so a submitted
+// job is hashed immediately and completes before HashJobSubmit() returns.
+// DMA-flagged jobs on the host go through the simulated uDMA channel.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+#include "hash_dma.h"
+
+#if !defined(cc3200)
+#include <pthread.h>
+#endif
+
+//*****************************************************************************
+//
+//! Hash a buffer in software
+//!
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*)
+//! \param pui8Data is the message
+//! \param ui32DataLength is the message length in bytes
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+SWEngineHash(uint32_t ui32Config, const uint8_t *pui8Data,
+             uint32_t ui32DataLength, uint8_t *pui8Result)
+{
+    SWHash(ui32Config, pui8Data, ui32DataLength, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Start an incremental software hash. An algorithm the software engine
+//! cannot do (the HMAC configurations, which need a key) gives a context
+//! that produces no digest rather than one of another algorithm.
+//!
+//! \param psCtx is the context
+//! \param ui32Config is the algorithm (SHAMD5_ALGO_*)
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+SWEngineCtxInit(tHashContext *psCtx, uint32_t ui32Config)
+{
+    SWHashInit(psCtx, ui32Config);
+}
+
+//*****************************************************************************
+//
+// Algorithm of the open hash session. Software has no engine state to keep
+// configured, so a session is just a run of SWHash() calls.
+//
+//*****************************************************************************
+static uint32_t g_ui32SessionConfig;
+
+static void
+SWEngineSessionBegin(uint32_t ui32Config)
+{
+    g_ui32SessionConfig = ui32Config;
+}
+
+static void
+SWEngineSessionPut(const uint8_t *pui8Data, uint32_t ui32DataLength,
+                   uint8_t *pui8Result)
+{
+    SWHash(g_ui32SessionConfig, pui8Data, ui32DataLength, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Run a job and signal its completion. The owner may reuse or free the job
+//! as soon as it sees HASH_JOB_DONE, so that is stored last and the job is
+//! not read after it.
+//!
+//! \param psJob is the job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+SWEngineRunJob(tHashJob *psJob)
+{
+    tHashJobCallback pfnCallback = psJob->pfnCallback;
+    void *pvArg = psJob->pvArg;
+
+    psJob->ui32State = HASH_JOB_RUNNING;
+#if !defined(cc3200)
+    if((psJob->ui32Flags & HASH_JOB_FLAG_DMA) &&
+       HashDMACapable(psJob->pui8Data, psJob->ui32DataLength))
+    {
+        HashDMASimHash(psJob->ui32Config, psJob->pui8Data,
+                       psJob->ui32DataLength, psJob->pui8Result);
+    }
+    else
+#endif
+    {
+        SWHash(psJob->ui32Config, psJob->pui8Data, psJob->ui32DataLength,
+               psJob->pui8Result);
+    }
+    if(pfnCallback)
+    {
+        pfnCallback(psJob, pvArg);
+    }
+#if !defined(cc3200)
+    __atomic_store_n(&psJob->ui32State, HASH_JOB_DONE, __ATOMIC_RELEASE);
+#else
+    psJob->ui32State = HASH_JOB_DONE;
+#endif
+}
+
+#if !defined(cc3200)
+
+//*****************************************************************************
+//
+// Worker thread state. The queue is a ring of job pointers guarded by
+// g_sQueueLock; g_sQueueCond wakes the worker on submit and waiters on
+// completion.
+//
+//*****************************************************************************
+static pthread_mutex_t g_sQueueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sQueueCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_sDoneCond = PTHREAD_COND_INITIALIZER;
+static tHashJob *g_ppsQueue[HASH_JOB_QUEUE_DEPTH];
+static uint32_t g_ui32QueueHead;
+static uint32_t g_ui32QueueCount;
+static bool g_bWorkerStarted;
+static pthread_t g_sWorker;
+
+static void *
+SWEngineWorker(void *pvArg)
+{
+    tHashJob *psJob;
+
+    (void)pvArg;
+    for(;;)
+    {
+        pthread_mutex_lock(&g_sQueueLock);
+        while(g_ui32QueueCount == 0)
+        {
+            pthread_cond_wait(&g_sQueueCond, &g_sQueueLock);
+        }
+        psJob = g_ppsQueue[g_ui32QueueHead];
+        pthread_mutex_unlock(&g_sQueueLock);
+
+        SWEngineRunJob(psJob);
+
+        //
+        // The slot is released only after the job ran so that the queue
+        // depth bounds the jobs in flight, as it does on the board.
+        //
+        pthread_mutex_lock(&g_sQueueLock);
+        g_ui32QueueHead = (g_ui32QueueHead + 1) % HASH_JOB_QUEUE_DEPTH;
+        g_ui32QueueCount--;
+        pthread_cond_broadcast(&g_sDoneCond);
+        pthread_mutex_unlock(&g_sQueueLock);
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! Start the worker thread
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+SWEngineInit(void)
+{
+    pthread_mutex_lock(&g_sQueueLock);
+    if(!g_bWorkerStarted)
+    {
+        g_bWorkerStarted = (pthread_create(&g_sWorker, 0, SWEngineWorker,
+                                           0) == 0);
+        if(g_bWorkerStarted)
+        {
+            pthread_detach(g_sWorker);
+        }
+    }
+    pthread_mutex_unlock(&g_sQueueLock);
+}
+
+//*****************************************************************************
+//
+//! Queue a job for the worker thread
+//!
+//! \param psJob is the job
+//!
+//! \return true if queued, false if the queue is full
+//
+//*****************************************************************************
+static bool
+SWEngineSubmit(tHashJob *psJob)
+{
+    bool bQueued = false;
+
+    if(!g_bWorkerStarted)
+    {
+        SWEngineInit();
+    }
+
+    pthread_mutex_lock(&g_sQueueLock);
+    if(g_ui32QueueCount < HASH_JOB_QUEUE_DEPTH)
+    {
+        psJob->ui32State = HASH_JOB_QUEUED;
+        g_ppsQueue[(g_ui32QueueHead + g_ui32QueueCount) %
+                   HASH_JOB_QUEUE_DEPTH] = psJob;
+        g_ui32QueueCount++;
+        pthread_cond_signal(&g_sQueueCond);
+        bQueued = true;
+    }
+    pthread_mutex_unlock(&g_sQueueLock);
+
+    return bQueued;
+}
+
+//*****************************************************************************
+//
+//! Wait for a job to complete
+//!
+//! \param psJob is the job
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+SWEngineWait(tHashJob *psJob)
+{
+    pthread_mutex_lock(&g_sQueueLock);
+    while(__atomic_load_n(&psJob->ui32State, __ATOMIC_ACQUIRE) !=
+          HASH_JOB_DONE)
+    {
+        pthread_cond_wait(&g_sDoneCond, &g_sQueueLock);
+    }
+    pthread_mutex_unlock(&g_sQueueLock);
+}
+
+#else
+
+static bool
+SWEngineSubmit(tHashJob *psJob)
+{
+    SWEngineRunJob(psJob);
+    return true;
+}
+
+static void
+SWEngineWait(tHashJob *psJob)
+{
+    (void)psJob;
+}
+
+#endif // !cc3200
+
+const tHashEngine g_sHashEngineSW =
+{
+    "software",
+#if !defined(cc3200)
+    SWEngineInit,
+#else
+    0,
+#endif
+    SWEngineHash,
+    SWEngineSubmit,
+    SWEngineWait,
+    SWEngineCtxInit,
+    SWHashUpdate,
+    SWHashFinal,
+    SWEngineSessionBegin,
+    SWEngineSessionPut,
+    0,
+    0
+};
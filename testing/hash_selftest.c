@@ -0,0 +1,328 @@
+//*****************************************************************************
+// hash_selftest.c
+//
+// Known-answer checks against shamd5_vector.h. The vector file defines its
+// arrays in the header, so this must be the only file that includes it.
+//
+// The HMAC vectors are checked by building HMAC from the engine's own
+// incremental hash, H((K ^ opad) || H((K ^ ipad) || m)), which is how both
+// engines are driven by everything else in the tree.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "perf_clock.h"
+#include "hash_sw.h"
+#include "hash_sw_mb.h"
+#include "hash_selftest.h"
+#include "shamd5_vector.h"
+
+//
+// FIPS 180 and RFC 1321 digests of "abc".
+//
+static const uint8_t g_pui8MD5abc[16] =
+{
+    0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0, 0xd6, 0x96, 0x3f, 0x7d,
+    0x28, 0xe1, 0x7f, 0x72
+};
+static const uint8_t g_pui8SHA1abc[20] =
+{
+    0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71,
+    0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d
+};
+static const uint8_t g_pui8SHA224abc[28] =
+{
+    0x23, 0x09, 0x7d, 0x22, 0x34, 0x05, 0xd8, 0x22, 0x86, 0x42, 0xa4, 0x77,
+    0xbd, 0xa2, 0x55, 0xb3, 0x2a, 0xad, 0xbc, 0xe4, 0xbd, 0xa0, 0xb3, 0xf7,
+    0xe3, 0x6c, 0x9d, 0xa7
+};
+static const uint8_t g_pui8SHA256abc[32] =
+{
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde,
+    0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+//
+// The checks of HashSelfTest(). An HMAC check runs over the vector message
+// with the vector key; the others hash "abc" for the known answer. Every
+// check is timed over the vector message.
+//
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Algo;
+    bool bHMAC;
+    const uint8_t *pui8Expect;
+} tHashSelfTestCheck;
+
+static const tHashSelfTestCheck g_psChecks[HASH_SELFTEST_CHECKS] =
+{
+    { "md5",            SHAMD5_ALGO_MD5,    false, g_pui8MD5abc },
+    { "sha1",           SHAMD5_ALGO_SHA1,   false, g_pui8SHA1abc },
+    { "sha224",         SHAMD5_ALGO_SHA224, false, g_pui8SHA224abc },
+    { "sha256",         SHAMD5_ALGO_SHA256, false, g_pui8SHA256abc },
+    { "hmac_md5",       SHAMD5_ALGO_MD5,    true,
+      (const uint8_t *)pui32MD5HMACResult },
+    { "hmac_sha224",    SHAMD5_ALGO_SHA224, true,
+      (const uint8_t *)pui32SHA224HMACResult },
+};
+
+static tHashSelfTestStats g_sSelfTestStats;
+
+//*****************************************************************************
+//
+//! HMAC over the active engine's incremental hash
+//!
+//! \param ui32Algo is the underlying algorithm (SHAMD5_ALGO_MD5 etc.)
+//! \param pui8Key is a 64-byte key, used as is
+//! \param pui8Data is the message
+//! \param ui32Length is the message length in bytes
+//! \param pui8Result receives the MAC
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HashSelfTestHMAC(uint32_t ui32Algo, const uint8_t *pui8Key,
+                 const uint8_t *pui8Data, uint32_t ui32Length,
+                 uint8_t *pui8Result)
+{
+    uint8_t pui8Pad[64];
+    uint8_t pui8Inner[HASH_MAX_DIGEST_LEN];
+    tHashContext sCtx;
+    uint32_t i;
+
+    for(i = 0; i < 64; i++)
+    {
+        pui8Pad[i] = pui8Key[i] ^ 0x36;
+    }
+    HashInit(&sCtx, ui32Algo);
+    HashUpdate(&sCtx, pui8Pad, 64);
+    HashUpdate(&sCtx, pui8Data, ui32Length);
+    HashFinal(&sCtx, pui8Inner);
+
+    for(i = 0; i < 64; i++)
+    {
+        pui8Pad[i] = pui8Key[i] ^ 0x5c;
+    }
+    HashInit(&sCtx, ui32Algo);
+    HashUpdate(&sCtx, pui8Pad, 64);
+    HashUpdate(&sCtx, pui8Inner, HashDigestLength(ui32Algo));
+    HashFinal(&sCtx, pui8Result);
+}
+
+//*****************************************************************************
+//
+//! Run one check of the self-test on the vector message
+//!
+//! \param psCheck is the check
+//! \param pui8Result receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+HashSelfTestRun(const tHashSelfTestCheck *psCheck, uint8_t *pui8Result)
+{
+    const sShaMD5TestVector *psVector = &g_psHMACShaMD5TestVectors;
+
+    if(psCheck->bHMAC)
+    {
+        HashSelfTestHMAC(psCheck->ui32Algo, psVector->puiHMACKey,
+                         psVector->puiPlainText, psVector->uiDataLength,
+                         pui8Result);
+    }
+    else
+    {
+        GenerateHash(psCheck->ui32Algo, psVector->puiPlainText, pui8Result,
+                     psVector->uiDataLength);
+    }
+}
+
+//*****************************************************************************
+//
+//! Power-on self-test of the active engine. Every check is run against its
+//! known answer and then timed over HASH_SELFTEST_ROUNDS passes of the
+//! 1024-byte vector message; the results are kept for
+//! HashSelfTestStatsGet().
+//!
+//! \return true if every check matched (and, with HASH_SELFTEST_MAX_TPB
+//! set, was fast enough)
+//
+//*****************************************************************************
+bool
+HashSelfTest(void)
+{
+    const tHashSelfTestCheck *psCheck;
+    tHashSelfTestResult *psResult;
+    uint8_t pui8Digest[HASH_MAX_DIGEST_LEN];
+    uint32_t ui32Check, ui32Round, ui32Length;
+    uint64_t ui64Ticks;
+    bool bPass = true;
+
+    g_sSelfTestStats.pcEngine = g_psHashEngine->pcName;
+    g_sSelfTestStats.ui32Runs++;
+
+    for(ui32Check = 0; ui32Check < HASH_SELFTEST_CHECKS; ui32Check++)
+    {
+        psCheck = &g_psChecks[ui32Check];
+        psResult = &g_sSelfTestStats.psResult[ui32Check];
+        ui32Length = HashDigestLength(psCheck->ui32Algo);
+
+        if(psCheck->bHMAC)
+        {
+            HashSelfTestRun(psCheck, pui8Digest);
+        }
+        else
+        {
+            GenerateHash(psCheck->ui32Algo, (unsigned char *)"abc",
+                         pui8Digest, 3);
+        }
+        psResult->pcName = psCheck->pcName;
+        psResult->bPass = (memcmp(pui8Digest, psCheck->pui8Expect,
+                                  ui32Length) == 0);
+
+        ui64Ticks = PerfClockNow();
+        for(ui32Round = 0; ui32Round < HASH_SELFTEST_ROUNDS; ui32Round++)
+        {
+            HashSelfTestRun(psCheck, pui8Digest);
+        }
+        ui64Ticks = PerfClockNow() - ui64Ticks;
+
+        psResult->ui32Bytes = HASH_SELFTEST_ROUNDS *
+                              g_psHMACShaMD5TestVectors.uiDataLength;
+        psResult->ui64Ticks = ui64Ticks;
+        psResult->ui32TicksPerByte100 = (uint32_t)((ui64Ticks * 100) /
+                                                   psResult->ui32Bytes);
+        if(HASH_SELFTEST_MAX_TPB &&
+           (psResult->ui32TicksPerByte100 > HASH_SELFTEST_MAX_TPB))
+        {
+            psResult->bPass = false;
+        }
+        bPass &= psResult->bPass;
+    }
+
+    if(!bPass)
+    {
+        g_sSelfTestStats.ui32Failures++;
+    }
+
+    return bPass;
+}
+
+//*****************************************************************************
+//
+//! Results of the last HashSelfTest()
+//!
+//! \param psStats receives them
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+HashSelfTestStatsGet(tHashSelfTestStats *psStats)
+{
+    *psStats = g_sSelfTestStats;
+}
+
+#if !defined(cc3200)
+
+//
+// Messages per batch: enough to fill every lane of the widest kernel and
+// leave a partly filled group behind it.
+//
+#define SELFTEST_BATCH          (SW_SHA256_MB_MAX_LANES + 3)
+
+//*****************************************************************************
+//
+//! Check a multi-buffer kernel. Every lane computes the HMAC-SHA224 test
+//! vector (64-byte key, 1024-byte message) through SWSHA256Batch(), then
+//! prefixes of the vector data of assorted lengths are hashed in one batch
+//! and compared with the scalar SWHash().
+//!
+//! \param psKernel is the kernel; the previous selection is restored after
+//!
+//! \return true if every digest matched
+//
+//*****************************************************************************
+bool
+HashSelfTestMultiBuffer(const tSWSHA256MBKernel *psKernel)
+{
+    static uint8_t pui8Inner[64 + sizeof(puiRandomData)];
+    uint8_t pui8Outer[64 + 28];
+    uint8_t ppui8Digest[SELFTEST_BATCH][HASH_MAX_DIGEST_LEN];
+    uint8_t pui8Expect[HASH_MAX_DIGEST_LEN];
+    const uint8_t *ppui8Data[SELFTEST_BATCH];
+    uint8_t *ppui8Out[SELFTEST_BATCH];
+    uint32_t pui32Length[SELFTEST_BATCH];
+    const tSWSHA256MBKernel *psSaved = SWSHA256MBKernel();
+    const uint8_t *pui8Key = (const uint8_t *)puiHMACKey;
+    bool bPass = true;
+    uint32_t i;
+
+    SWSHA256MBSelect(psKernel);
+
+    //
+    // HMAC = H((K ^ opad) || H((K ^ ipad) || m)); the key is one block long
+    // so it is used as is.
+    //
+    for(i = 0; i < 64; i++)
+    {
+        pui8Inner[i] = pui8Key[i] ^ 0x36;
+        pui8Outer[i] = pui8Key[i] ^ 0x5c;
+    }
+    memcpy(pui8Inner + 64, puiRandomData, sizeof(puiRandomData));
+
+    for(i = 0; i < SELFTEST_BATCH; i++)
+    {
+        ppui8Data[i] = pui8Inner;
+        pui32Length[i] = sizeof(pui8Inner);
+        ppui8Out[i] = ppui8Digest[i];
+    }
+    SWSHA256Batch(SHAMD5_ALGO_SHA224, ppui8Data, pui32Length, ppui8Out,
+                  SELFTEST_BATCH);
+    for(i = 1; i < SELFTEST_BATCH; i++)
+    {
+        bPass &= (memcmp(ppui8Digest[i], ppui8Digest[0], 28) == 0);
+    }
+    memcpy(pui8Outer + 64, ppui8Digest[0], 28);
+
+    for(i = 0; i < SELFTEST_BATCH; i++)
+    {
+        ppui8Data[i] = pui8Outer;
+        pui32Length[i] = sizeof(pui8Outer);
+    }
+    SWSHA256Batch(SHAMD5_ALGO_SHA224, ppui8Data, pui32Length, ppui8Out,
+                  SELFTEST_BATCH);
+    for(i = 0; i < SELFTEST_BATCH; i++)
+    {
+        bPass &= (memcmp(ppui8Digest[i], pui32SHA224HMACResult, 28) == 0);
+    }
+
+    //
+    // Mixed lengths, so lanes finish on different blocks.
+    //
+    for(i = 0; i < SELFTEST_BATCH; i++)
+    {
+        ppui8Data[i] = (const uint8_t *)puiRandomData;
+        pui32Length[i] = (i * 167) % sizeof(puiRandomData);
+    }
+    SWSHA256Batch(SHAMD5_ALGO_SHA256, ppui8Data, pui32Length, ppui8Out,
+                  SELFTEST_BATCH);
+    for(i = 0; i < SELFTEST_BATCH; i++)
+    {
+        SWHash(SHAMD5_ALGO_SHA256, ppui8Data[i], pui32Length[i], pui8Expect);
+        bPass &= (memcmp(ppui8Digest[i], pui8Expect, 32) == 0);
+    }
+
+    SWSHA256MBSelect(psSaved);
+
+    return bPass;
+}
+
+#endif // !cc3200
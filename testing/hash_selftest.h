@@ -0,0 +1,94 @@
+//*****************************************************************************
+// hash_selftest.h
+//
+// Known-answer checks of the hash implementations against the TI test
+// vectors in shamd5_vector.h
+//
+// HashSelfTest() is the power-on self-test: it checks every algorithm of the
+// active engine against known answers and times it on the 1024-byte vector
+// message, so a unit proves its engine before it produces blocks. The
+// outcome stays readable through HashSelfTestStatsGet().
+//
+//*****************************************************************************
+
+#ifndef __HASH_SELFTEST_H__
+#define __HASH_SELFTEST_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hash_sw_mb.h"
+
+//*****************************************************************************
+//
+// Times each algorithm is run over the vector message when timing it.
+//
+//*****************************************************************************
+#ifndef HASH_SELFTEST_ROUNDS
+#define HASH_SELFTEST_ROUNDS    16
+#endif
+
+//*****************************************************************************
+//
+// Slowest acceptable hashing, in hundredths of a PerfClockNow() tick per
+// byte (on the board a tick is a CPU cycle). An algorithm slower than this
+// fails the self-test; 0 disables the check.
+//
+//*****************************************************************************
+#ifndef HASH_SELFTEST_MAX_TPB
+#define HASH_SELFTEST_MAX_TPB   0
+#endif
+
+//*****************************************************************************
+//
+// Checks made by HashSelfTest(), one per algorithm: the plain hashes against
+// FIPS "abc" answers, the HMAC modes against the TI vectors.
+//
+//*****************************************************************************
+#define HASH_SELFTEST_CHECKS    6
+
+typedef struct
+{
+    const char *pcName;
+    bool bPass;
+    uint32_t ui32Bytes;
+    uint64_t ui64Ticks;
+    uint32_t ui32TicksPerByte100;
+} tHashSelfTestResult;
+
+typedef struct
+{
+    const char *pcEngine;
+    uint32_t ui32Runs;
+    uint32_t ui32Failures;
+    tHashSelfTestResult psResult[HASH_SELFTEST_CHECKS];
+} tHashSelfTestStats;
+
+extern bool HashSelfTest(void);
+extern void HashSelfTestStatsGet(tHashSelfTestStats *psStats);
+
+#if !defined(cc3200)
+extern bool HashSelfTestMultiBuffer(const tSWSHA256MBKernel *psKernel);
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HASH_SELFTEST_H__
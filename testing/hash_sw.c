@@ -0,0 +1,674 @@
+//*****************************************************************************
+// hash_sw.c
+//
+// Portable software MD5, SHA-1, SHA-224 and SHA-256. Used as the hash engine
+// on the host build, and on the board when HASH_ENGINE_SW is defined.
+//
+// The compression functions are fully unrolled with the message schedule
+// kept in a rolling 16-word window, and whole blocks are hashed straight out
+// of the caller's buffer so that only the partial head and tail of a message
+// go through the context buffer.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+
+#define ROR32(x, n)     (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROL32(x, n)     (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define LOAD32_BE(p)    (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                         ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+#define LOAD32_LE(p)    (((uint32_t)(p)[3] << 24) | ((uint32_t)(p)[2] << 16) | \
+                         ((uint32_t)(p)[1] << 8) | (uint32_t)(p)[0])
+
+typedef void (*tCompressFn)(uint32_t *pui32State, const uint8_t *pui8Blocks,
+                            uint32_t ui32Count);
+
+//*****************************************************************************
+//
+// SHA-256 / SHA-224
+//
+//*****************************************************************************
+const uint32_t g_pui32SHA256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t g_pui32SHA256IV[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t g_pui32SHA224IV[8] =
+{
+    0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+    0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+};
+
+#define S256_S0(x)      (ROR32(x, 2) ^ ROR32(x, 13) ^ ROR32(x, 22))
+#define S256_S1(x)      (ROR32(x, 6) ^ ROR32(x, 11) ^ ROR32(x, 25))
+#define S256_G0(x)      (ROR32(x, 7) ^ ROR32(x, 18) ^ ((x) >> 3))
+#define S256_G1(x)      (ROR32(x, 17) ^ ROR32(x, 19) ^ ((x) >> 10))
+#define S256_CH(x, y, z)  (((x) & ((y) ^ (z))) ^ (z))
+#define S256_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+//
+// W[i] for i >= 16, computed in place in the 16-word window.
+//
+#define S256_W(i)       (W[(i) & 15] += S256_G1(W[((i) - 2) & 15]) +          \
+                                        W[((i) - 7) & 15] +                   \
+                                        S256_G0(W[((i) - 15) & 15]))
+
+#define S256_ROUND(a, b, c, d, e, f, g, h, i, w)                              \
+    do                                                                        \
+    {                                                                         \
+        uint32_t t1 = h + S256_S1(e) + S256_CH(e, f, g) +                     \
+                      g_pui32SHA256K[i] + (w);                                \
+        uint32_t t2 = S256_S0(a) + S256_MAJ(a, b, c);                         \
+        d += t1;                                                              \
+        h = t1 + t2;                                                          \
+    } while(0)
+
+#define S256_ROUND8(i, w)                                                     \
+    S256_ROUND(a, b, c, d, e, f, g, h, (i) + 0, w((i) + 0));                  \
+    S256_ROUND(h, a, b, c, d, e, f, g, (i) + 1, w((i) + 1));                  \
+    S256_ROUND(g, h, a, b, c, d, e, f, (i) + 2, w((i) + 2));                  \
+    S256_ROUND(f, g, h, a, b, c, d, e, (i) + 3, w((i) + 3));                  \
+    S256_ROUND(e, f, g, h, a, b, c, d, (i) + 4, w((i) + 4));                  \
+    S256_ROUND(d, e, f, g, h, a, b, c, (i) + 5, w((i) + 5));                  \
+    S256_ROUND(c, d, e, f, g, h, a, b, (i) + 6, w((i) + 6));                  \
+    S256_ROUND(b, c, d, e, f, g, h, a, (i) + 7, w((i) + 7))
+
+#define S256_WLOAD(i)   W[i]
+
+static void
+SHA256Compress(uint32_t *pui32State, const uint8_t *pui8Blocks,
+               uint32_t ui32Count)
+{
+    uint32_t W[16];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t i;
+
+    while(ui32Count--)
+    {
+        for(i = 0; i < 16; i++)
+        {
+            W[i] = LOAD32_BE(pui8Blocks + (i * 4));
+        }
+
+        a = pui32State[0];
+        b = pui32State[1];
+        c = pui32State[2];
+        d = pui32State[3];
+        e = pui32State[4];
+        f = pui32State[5];
+        g = pui32State[6];
+        h = pui32State[7];
+
+        S256_ROUND8(0, S256_WLOAD);
+        S256_ROUND8(8, S256_WLOAD);
+        S256_ROUND8(16, S256_W);
+        S256_ROUND8(24, S256_W);
+        S256_ROUND8(32, S256_W);
+        S256_ROUND8(40, S256_W);
+        S256_ROUND8(48, S256_W);
+        S256_ROUND8(56, S256_W);
+
+        pui32State[0] += a;
+        pui32State[1] += b;
+        pui32State[2] += c;
+        pui32State[3] += d;
+        pui32State[4] += e;
+        pui32State[5] += f;
+        pui32State[6] += g;
+        pui32State[7] += h;
+
+        pui8Blocks += 64;
+    }
+}
+
+//*****************************************************************************
+//
+//! Compress whole SHA-256 blocks into a state
+//!
+//! \param pui32State is the eight-word state, updated in place
+//! \param pui8Blocks is the block data, already padded by the caller
+//! \param ui32Count is the number of 64-byte blocks
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SWSHA256Blocks(uint32_t *pui32State, const uint8_t *pui8Blocks,
+               uint32_t ui32Count)
+{
+    SHA256Compress(pui32State, pui8Blocks, ui32Count);
+}
+
+//*****************************************************************************
+//
+// SHA-1
+//
+//*****************************************************************************
+static const uint32_t g_pui32SHA1IV[5] =
+{
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+#define SHA1_W(i)       (W[(i) & 15] = ROL32(W[((i) - 3) & 15] ^              \
+                                             W[((i) - 8) & 15] ^              \
+                                             W[((i) - 14) & 15] ^             \
+                                             W[(i) & 15], 1))
+
+#define SHA1_ROUND(a, b, c, d, e, fn, k, w)                                   \
+    do                                                                        \
+    {                                                                         \
+        e += ROL32(a, 5) + fn(b, c, d) + (k) + (w);                           \
+        b = ROL32(b, 30);                                                     \
+    } while(0)
+
+#define SHA1_F0(b, c, d)  (((b) & ((c) ^ (d))) ^ (d))
+#define SHA1_F1(b, c, d)  ((b) ^ (c) ^ (d))
+#define SHA1_F2(b, c, d)  (((b) & (c)) | ((d) & ((b) | (c))))
+
+#define SHA1_ROUND5(i, fn, k, w)                                              \
+    SHA1_ROUND(a, b, c, d, e, fn, k, w((i) + 0));                             \
+    SHA1_ROUND(e, a, b, c, d, fn, k, w((i) + 1));                             \
+    SHA1_ROUND(d, e, a, b, c, fn, k, w((i) + 2));                             \
+    SHA1_ROUND(c, d, e, a, b, fn, k, w((i) + 3));                             \
+    SHA1_ROUND(b, c, d, e, a, fn, k, w((i) + 4))
+
+#define SHA1_WLOAD(i)   W[i]
+
+static void
+SHA1Compress(uint32_t *pui32State, const uint8_t *pui8Blocks,
+             uint32_t ui32Count)
+{
+    uint32_t W[16];
+    uint32_t a, b, c, d, e;
+    uint32_t i;
+
+    while(ui32Count--)
+    {
+        for(i = 0; i < 16; i++)
+        {
+            W[i] = LOAD32_BE(pui8Blocks + (i * 4));
+        }
+
+        a = pui32State[0];
+        b = pui32State[1];
+        c = pui32State[2];
+        d = pui32State[3];
+        e = pui32State[4];
+
+        SHA1_ROUND5(0, SHA1_F0, 0x5a827999, SHA1_WLOAD);
+        SHA1_ROUND5(5, SHA1_F0, 0x5a827999, SHA1_WLOAD);
+        SHA1_ROUND5(10, SHA1_F0, 0x5a827999, SHA1_WLOAD);
+        SHA1_ROUND(a, b, c, d, e, SHA1_F0, 0x5a827999, W[15]);
+        SHA1_ROUND(e, a, b, c, d, SHA1_F0, 0x5a827999, SHA1_W(16));
+        SHA1_ROUND(d, e, a, b, c, SHA1_F0, 0x5a827999, SHA1_W(17));
+        SHA1_ROUND(c, d, e, a, b, SHA1_F0, 0x5a827999, SHA1_W(18));
+        SHA1_ROUND(b, c, d, e, a, SHA1_F0, 0x5a827999, SHA1_W(19));
+
+        SHA1_ROUND5(20, SHA1_F1, 0x6ed9eba1, SHA1_W);
+        SHA1_ROUND5(25, SHA1_F1, 0x6ed9eba1, SHA1_W);
+        SHA1_ROUND5(30, SHA1_F1, 0x6ed9eba1, SHA1_W);
+        SHA1_ROUND5(35, SHA1_F1, 0x6ed9eba1, SHA1_W);
+
+        SHA1_ROUND5(40, SHA1_F2, 0x8f1bbcdc, SHA1_W);
+        SHA1_ROUND5(45, SHA1_F2, 0x8f1bbcdc, SHA1_W);
+        SHA1_ROUND5(50, SHA1_F2, 0x8f1bbcdc, SHA1_W);
+        SHA1_ROUND5(55, SHA1_F2, 0x8f1bbcdc, SHA1_W);
+
+        SHA1_ROUND5(60, SHA1_F1, 0xca62c1d6, SHA1_W);
+        SHA1_ROUND5(65, SHA1_F1, 0xca62c1d6, SHA1_W);
+        SHA1_ROUND5(70, SHA1_F1, 0xca62c1d6, SHA1_W);
+        SHA1_ROUND5(75, SHA1_F1, 0xca62c1d6, SHA1_W);
+
+        pui32State[0] += a;
+        pui32State[1] += b;
+        pui32State[2] += c;
+        pui32State[3] += d;
+        pui32State[4] += e;
+
+        pui8Blocks += 64;
+    }
+}
+
+//*****************************************************************************
+//
+// MD5
+//
+//*****************************************************************************
+static const uint32_t g_pui32MD5IV[4] =
+{
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+};
+
+#define MD5_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z)  ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z)  ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z)  ((y) ^ ((x) | ~(z)))
+
+#define MD5_STEP(fn, a, b, c, d, x, t, s)                                     \
+    do                                                                        \
+    {                                                                         \
+        a += fn(b, c, d) + (x) + (t);                                         \
+        a = ROL32(a, s) + b;                                                  \
+    } while(0)
+
+static void
+MD5Compress(uint32_t *pui32State, const uint8_t *pui8Blocks,
+            uint32_t ui32Count)
+{
+    uint32_t X[16];
+    uint32_t a, b, c, d;
+    uint32_t i;
+
+    while(ui32Count--)
+    {
+        for(i = 0; i < 16; i++)
+        {
+            X[i] = LOAD32_LE(pui8Blocks + (i * 4));
+        }
+
+        a = pui32State[0];
+        b = pui32State[1];
+        c = pui32State[2];
+        d = pui32State[3];
+
+        MD5_STEP(MD5_F, a, b, c, d, X[0], 0xd76aa478, 7);
+        MD5_STEP(MD5_F, d, a, b, c, X[1], 0xe8c7b756, 12);
+        MD5_STEP(MD5_F, c, d, a, b, X[2], 0x242070db, 17);
+        MD5_STEP(MD5_F, b, c, d, a, X[3], 0xc1bdceee, 22);
+        MD5_STEP(MD5_F, a, b, c, d, X[4], 0xf57c0faf, 7);
+        MD5_STEP(MD5_F, d, a, b, c, X[5], 0x4787c62a, 12);
+        MD5_STEP(MD5_F, c, d, a, b, X[6], 0xa8304613, 17);
+        MD5_STEP(MD5_F, b, c, d, a, X[7], 0xfd469501, 22);
+        MD5_STEP(MD5_F, a, b, c, d, X[8], 0x698098d8, 7);
+        MD5_STEP(MD5_F, d, a, b, c, X[9], 0x8b44f7af, 12);
+        MD5_STEP(MD5_F, c, d, a, b, X[10], 0xffff5bb1, 17);
+        MD5_STEP(MD5_F, b, c, d, a, X[11], 0x895cd7be, 22);
+        MD5_STEP(MD5_F, a, b, c, d, X[12], 0x6b901122, 7);
+        MD5_STEP(MD5_F, d, a, b, c, X[13], 0xfd987193, 12);
+        MD5_STEP(MD5_F, c, d, a, b, X[14], 0xa679438e, 17);
+        MD5_STEP(MD5_F, b, c, d, a, X[15], 0x49b40821, 22);
+
+        MD5_STEP(MD5_G, a, b, c, d, X[1], 0xf61e2562, 5);
+        MD5_STEP(MD5_G, d, a, b, c, X[6], 0xc040b340, 9);
+        MD5_STEP(MD5_G, c, d, a, b, X[11], 0x265e5a51, 14);
+        MD5_STEP(MD5_G, b, c, d, a, X[0], 0xe9b6c7aa, 20);
+        MD5_STEP(MD5_G, a, b, c, d, X[5], 0xd62f105d, 5);
+        MD5_STEP(MD5_G, d, a, b, c, X[10], 0x02441453, 9);
+        MD5_STEP(MD5_G, c, d, a, b, X[15], 0xd8a1e681, 14);
+        MD5_STEP(MD5_G, b, c, d, a, X[4], 0xe7d3fbc8, 20);
+        MD5_STEP(MD5_G, a, b, c, d, X[9], 0x21e1cde6, 5);
+        MD5_STEP(MD5_G, d, a, b, c, X[14], 0xc33707d6, 9);
+        MD5_STEP(MD5_G, c, d, a, b, X[3], 0xf4d50d87, 14);
+        MD5_STEP(MD5_G, b, c, d, a, X[8], 0x455a14ed, 20);
+        MD5_STEP(MD5_G, a, b, c, d, X[13], 0xa9e3e905, 5);
+        MD5_STEP(MD5_G, d, a, b, c, X[2], 0xfcefa3f8, 9);
+        MD5_STEP(MD5_G, c, d, a, b, X[7], 0x676f02d9, 14);
+        MD5_STEP(MD5_G, b, c, d, a, X[12], 0x8d2a4c8a, 20);
+
+        MD5_STEP(MD5_H, a, b, c, d, X[5], 0xfffa3942, 4);
+        MD5_STEP(MD5_H, d, a, b, c, X[8], 0x8771f681, 11);
+        MD5_STEP(MD5_H, c, d, a, b, X[11], 0x6d9d6122, 16);
+        MD5_STEP(MD5_H, b, c, d, a, X[14], 0xfde5380c, 23);
+        MD5_STEP(MD5_H, a, b, c, d, X[1], 0xa4beea44, 4);
+        MD5_STEP(MD5_H, d, a, b, c, X[4], 0x4bdecfa9, 11);
+        MD5_STEP(MD5_H, c, d, a, b, X[7], 0xf6bb4b60, 16);
+        MD5_STEP(MD5_H, b, c, d, a, X[10], 0xbebfbc70, 23);
+        MD5_STEP(MD5_H, a, b, c, d, X[13], 0x289b7ec6, 4);
+        MD5_STEP(MD5_H, d, a, b, c, X[0], 0xeaa127fa, 11);
+        MD5_STEP(MD5_H, c, d, a, b, X[3], 0xd4ef3085, 16);
+        MD5_STEP(MD5_H, b, c, d, a, X[6], 0x04881d05, 23);
+        MD5_STEP(MD5_H, a, b, c, d, X[9], 0xd9d4d039, 4);
+        MD5_STEP(MD5_H, d, a, b, c, X[12], 0xe6db99e5, 11);
+        MD5_STEP(MD5_H, c, d, a, b, X[15], 0x1fa27cf8, 16);
+        MD5_STEP(MD5_H, b, c, d, a, X[2], 0xc4ac5665, 23);
+
+        MD5_STEP(MD5_I, a, b, c, d, X[0], 0xf4292244, 6);
+        MD5_STEP(MD5_I, d, a, b, c, X[7], 0x432aff97, 10);
+        MD5_STEP(MD5_I, c, d, a, b, X[14], 0xab9423a7, 15);
+        MD5_STEP(MD5_I, b, c, d, a, X[5], 0xfc93a039, 21);
+        MD5_STEP(MD5_I, a, b, c, d, X[12], 0x655b59c3, 6);
+        MD5_STEP(MD5_I, d, a, b, c, X[3], 0x8f0ccc92, 10);
+        MD5_STEP(MD5_I, c, d, a, b, X[10], 0xffeff47d, 15);
+        MD5_STEP(MD5_I, b, c, d, a, X[1], 0x85845dd1, 21);
+        MD5_STEP(MD5_I, a, b, c, d, X[8], 0x6fa87e4f, 6);
+        MD5_STEP(MD5_I, d, a, b, c, X[15], 0xfe2ce6e0, 10);
+        MD5_STEP(MD5_I, c, d, a, b, X[6], 0xa3014314, 15);
+        MD5_STEP(MD5_I, b, c, d, a, X[13], 0x4e0811a1, 21);
+        MD5_STEP(MD5_I, a, b, c, d, X[4], 0xf7537e82, 6);
+        MD5_STEP(MD5_I, d, a, b, c, X[11], 0xbd3af235, 10);
+        MD5_STEP(MD5_I, c, d, a, b, X[2], 0x2ad7d2bb, 15);
+        MD5_STEP(MD5_I, b, c, d, a, X[9], 0xeb86d391, 21);
+
+        pui32State[0] += a;
+        pui32State[1] += b;
+        pui32State[2] += c;
+        pui32State[3] += d;
+
+        pui8Blocks += 64;
+    }
+}
+
+//*****************************************************************************
+//
+// Algorithm of a context that SWHashInit() refused; SWHashUpdate() and
+// SWHashFinal() leave such a context and the digest buffer alone.
+//
+//*****************************************************************************
+#define SW_HASH_ALGO_NONE       0xFFFFFFFF
+
+//*****************************************************************************
+//
+// Algorithm dispatch
+//
+//*****************************************************************************
+static tCompressFn
+SWHashCompressGet(uint32_t ui32Algo)
+{
+    switch(ui32Algo)
+    {
+        case SHAMD5_ALGO_MD5:
+            return MD5Compress;
+        case SHAMD5_ALGO_SHA1:
+            return SHA1Compress;
+        case SHAMD5_ALGO_SHA224:
+        case SHAMD5_ALGO_SHA256:
+        default:
+            return SHA256Compress;
+    }
+}
+
+//*****************************************************************************
+//
+//! Initialize a software hash context
+//!
+//! \param psCtx is the context
+//! \param ui32Algo is SHAMD5_ALGO_MD5, _SHA1, _SHA224 or _SHA256. The
+//! SHAMD5_ALGO_HMAC_* values need a key and are refused, as is any other
+//! value; use SWHMAC() for those.
+//!
+//! \return false if the algorithm is refused. The context then hashes
+//! nothing and produces no digest.
+//
+//*****************************************************************************
+bool
+SWHashInit(tSWHashContext *psCtx, uint32_t ui32Algo)
+{
+    memset(psCtx, 0, sizeof(*psCtx));
+    psCtx->ui32Algo = ui32Algo;
+
+    switch(ui32Algo)
+    {
+        case SHAMD5_ALGO_MD5:
+            memcpy(psCtx->pui32State, g_pui32MD5IV, sizeof(g_pui32MD5IV));
+            break;
+        case SHAMD5_ALGO_SHA1:
+            memcpy(psCtx->pui32State, g_pui32SHA1IV, sizeof(g_pui32SHA1IV));
+            break;
+        case SHAMD5_ALGO_SHA224:
+            memcpy(psCtx->pui32State, g_pui32SHA224IV,
+                   sizeof(g_pui32SHA224IV));
+            break;
+        case SHAMD5_ALGO_SHA256:
+            memcpy(psCtx->pui32State, g_pui32SHA256IV,
+                   sizeof(g_pui32SHA256IV));
+            break;
+        default:
+            psCtx->ui32Algo = SW_HASH_ALGO_NONE;
+            return false;
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Feed data into a software hash context
+//!
+//! \param psCtx is the context
+//! \param pui8Data is the data
+//! \param ui32Length is the data length in bytes
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SWHashUpdate(tSWHashContext *psCtx, const uint8_t *pui8Data,
+             uint32_t ui32Length)
+{
+    tCompressFn pfnCompress = SWHashCompressGet(psCtx->ui32Algo);
+    uint32_t ui32Fill;
+
+    if(psCtx->ui32Algo == SW_HASH_ALGO_NONE)
+    {
+        return;
+    }
+    psCtx->ui64Length += ui32Length;
+
+    //
+    // Top up a partially filled buffer first.
+    //
+    if(psCtx->ui32BufLen)
+    {
+        ui32Fill = 64 - psCtx->ui32BufLen;
+        if(ui32Length < ui32Fill)
+        {
+            memcpy(psCtx->pui8Buffer + psCtx->ui32BufLen, pui8Data,
+                   ui32Length);
+            psCtx->ui32BufLen += ui32Length;
+            return;
+        }
+        memcpy(psCtx->pui8Buffer + psCtx->ui32BufLen, pui8Data, ui32Fill);
+        pfnCompress(psCtx->pui32State, psCtx->pui8Buffer, 1);
+        psCtx->ui32BufLen = 0;
+        pui8Data += ui32Fill;
+        ui32Length -= ui32Fill;
+    }
+
+    //
+    // Whole blocks are compressed in place.
+    //
+    if(ui32Length >= 64)
+    {
+        pfnCompress(psCtx->pui32State, pui8Data, ui32Length / 64);
+        pui8Data += ui32Length & ~63u;
+        ui32Length &= 63;
+    }
+
+    if(ui32Length)
+    {
+        memcpy(psCtx->pui8Buffer, pui8Data, ui32Length);
+        psCtx->ui32BufLen = ui32Length;
+    }
+}
+
+//*****************************************************************************
+//
+//! Pad and finish a software hash
+//!
+//! \param psCtx is the context; it must be re-initialized before reuse
+//! \param pui8Digest receives the digest
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SWHashFinal(tSWHashContext *psCtx, uint8_t *pui8Digest)
+{
+    tCompressFn pfnCompress = SWHashCompressGet(psCtx->ui32Algo);
+    uint64_t ui64Bits = psCtx->ui64Length * 8;
+    uint32_t ui32Words, i;
+
+    if(psCtx->ui32Algo == SW_HASH_ALGO_NONE)
+    {
+        return;
+    }
+    psCtx->pui8Buffer[psCtx->ui32BufLen++] = 0x80;
+    if(psCtx->ui32BufLen > 56)
+    {
+        memset(psCtx->pui8Buffer + psCtx->ui32BufLen, 0,
+               64 - psCtx->ui32BufLen);
+        pfnCompress(psCtx->pui32State, psCtx->pui8Buffer, 1);
+        psCtx->ui32BufLen = 0;
+    }
+    memset(psCtx->pui8Buffer + psCtx->ui32BufLen, 0, 56 - psCtx->ui32BufLen);
+
+    if(psCtx->ui32Algo == SHAMD5_ALGO_MD5)
+    {
+        for(i = 0; i < 8; i++)
+        {
+            psCtx->pui8Buffer[56 + i] = (uint8_t)(ui64Bits >> (8 * i));
+        }
+        pfnCompress(psCtx->pui32State, psCtx->pui8Buffer, 1);
+        for(i = 0; i < 16; i++)
+        {
+            pui8Digest[i] = (uint8_t)(psCtx->pui32State[i / 4] >>
+                                      (8 * (i % 4)));
+        }
+        return;
+    }
+
+    for(i = 0; i < 8; i++)
+    {
+        psCtx->pui8Buffer[63 - i] = (uint8_t)(ui64Bits >> (8 * i));
+    }
+    pfnCompress(psCtx->pui32State, psCtx->pui8Buffer, 1);
+
+    ui32Words = HashDigestLength(psCtx->ui32Algo) / 4;
+    for(i = 0; i < ui32Words; i++)
+    {
+        pui8Digest[(i * 4) + 0] = (uint8_t)(psCtx->pui32State[i] >> 24);
+        pui8Digest[(i * 4) + 1] = (uint8_t)(psCtx->pui32State[i] >> 16);
+        pui8Digest[(i * 4) + 2] = (uint8_t)(psCtx->pui32State[i] >> 8);
+        pui8Digest[(i * 4) + 3] = (uint8_t)(psCtx->pui32State[i]);
+    }
+}
+
+//*****************************************************************************
+//
+//! One-shot software hash of a buffer
+//!
+//! \param ui32Algo is the algorithm, as for SWHashInit()
+//! \param pui8Data is the message
+//! \param ui32Length is the message length in bytes
+//! \param pui8Digest receives the digest
+//!
+//! \return false, with pui8Digest untouched, if the algorithm is refused
+//
+//*****************************************************************************
+bool
+SWHash(uint32_t ui32Algo, const uint8_t *pui8Data, uint32_t ui32Length,
+       uint8_t *pui8Digest)
+{
+    tSWHashContext sCtx;
+
+    if(!SWHashInit(&sCtx, ui32Algo))
+    {
+        return false;
+    }
+    SWHashUpdate(&sCtx, pui8Data, ui32Length);
+    SWHashFinal(&sCtx, pui8Digest);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Software HMAC (RFC 2104) of a buffer. It does not touch the active
+//! engine, so a host can check tags made by the board's SHAMD5 engine.
+//!
+//! \param ui32Algo is either the engine's HMAC configuration
+//! (SHAMD5_ALGO_HMAC_MD5, _HMAC_SHA1, _HMAC_SHA224 or _HMAC_SHA256) or the
+//! underlying algorithm (SHAMD5_ALGO_MD5, _SHA1, _SHA224 or _SHA256); both
+//! give the same MAC
+//! \param pui8Key is the key; one longer than 64 bytes is hashed first
+//! \param ui32KeyLength is the key length in bytes
+//! \param pui8Data is the message
+//! \param ui32Length is the message length in bytes
+//! \param pui8Digest receives the MAC
+//!
+//! \return false, with pui8Digest untouched, for any other algorithm
+//
+//*****************************************************************************
+bool
+SWHMAC(uint32_t ui32Algo, const uint8_t *pui8Key, uint32_t ui32KeyLength,
+       const uint8_t *pui8Data, uint32_t ui32Length, uint8_t *pui8Digest)
+{
+    uint8_t pui8Block[64], pui8Inner[HASH_MAX_DIGEST_LEN];
+    tSWHashContext sCtx;
+    uint32_t ui32Idx;
+
+    switch(ui32Algo)
+    {
+        case SHAMD5_ALGO_HMAC_MD5:
+            ui32Algo = SHAMD5_ALGO_MD5;
+            break;
+        case SHAMD5_ALGO_HMAC_SHA1:
+            ui32Algo = SHAMD5_ALGO_SHA1;
+            break;
+        case SHAMD5_ALGO_HMAC_SHA224:
+            ui32Algo = SHAMD5_ALGO_SHA224;
+            break;
+        case SHAMD5_ALGO_HMAC_SHA256:
+            ui32Algo = SHAMD5_ALGO_SHA256;
+            break;
+        case SHAMD5_ALGO_MD5:
+        case SHAMD5_ALGO_SHA1:
+        case SHAMD5_ALGO_SHA224:
+        case SHAMD5_ALGO_SHA256:
+            break;
+        default:
+            return false;
+    }
+
+    memset(pui8Block, 0, sizeof(pui8Block));
+    if(ui32KeyLength > sizeof(pui8Block))
+    {
+        SWHash(ui32Algo, pui8Key, ui32KeyLength, pui8Block);
+    }
+    else
+    {
+        memcpy(pui8Block, pui8Key, ui32KeyLength);
+    }
+
+    for(ui32Idx = 0; ui32Idx < sizeof(pui8Block); ui32Idx++)
+    {
+        pui8Block[ui32Idx] ^= 0x36;
+    }
+    SWHashInit(&sCtx, ui32Algo);
+    SWHashUpdate(&sCtx, pui8Block, sizeof(pui8Block));
+    SWHashUpdate(&sCtx, pui8Data, ui32Length);
+    SWHashFinal(&sCtx, pui8Inner);
+
+    for(ui32Idx = 0; ui32Idx < sizeof(pui8Block); ui32Idx++)
+    {
+        pui8Block[ui32Idx] ^= 0x36 ^ 0x5c;
+    }
+    SWHashInit(&sCtx, ui32Algo);
+    SWHashUpdate(&sCtx, pui8Block, sizeof(pui8Block));
+    SWHashUpdate(&sCtx, pui8Inner, HashDigestLength(ui32Algo));
+    SWHashFinal(&sCtx, pui8Digest);
+
+    return true;
+}
@@ -0,0 +1,64 @@
+//*****************************************************************************
+// hash_sw.h
+//
+// Portable software implementations of the SHAMD5 algorithms
+//
+//*****************************************************************************
+
+#ifndef __HASH_SW_H__
+#define __HASH_SW_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hash_engine.h"
+
+//*****************************************************************************
+//
+// Streaming context. MD5, SHA-1, SHA-224 and SHA-256 all use 64-byte blocks
+// and at most eight 32-bit state words, so the engine context fits them all.
+//
+//*****************************************************************************
+typedef tHashContext tSWHashContext;
+
+extern bool SWHashInit(tSWHashContext *psCtx, uint32_t ui32Algo);
+extern void SWHashUpdate(tSWHashContext *psCtx, const uint8_t *pui8Data,
+                         uint32_t ui32Length);
+extern void SWHashFinal(tSWHashContext *psCtx, uint8_t *pui8Digest);
+extern bool SWHash(uint32_t ui32Algo, const uint8_t *pui8Data,
+                   uint32_t ui32Length, uint8_t *pui8Digest);
+extern bool SWHMAC(uint32_t ui32Algo, const uint8_t *pui8Key,
+                   uint32_t ui32KeyLength, const uint8_t *pui8Data,
+                   uint32_t ui32Length, uint8_t *pui8Digest);
+
+//*****************************************************************************
+//
+// Raw SHA-256 compression of whole 64-byte blocks into a state, for callers
+// that lay out their own padded blocks, and the SHA-256 round constants.
+//
+//*****************************************************************************
+extern const uint32_t g_pui32SHA256K[64];
+extern void SWSHA256Blocks(uint32_t *pui32State, const uint8_t *pui8Blocks,
+                           uint32_t ui32Count);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HASH_SW_H__
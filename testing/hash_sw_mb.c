@@ -0,0 +1,445 @@
+//*****************************************************************************
+// hash_sw_mb.c
+//
+// Multi-buffer SHA-256 kernels, run-time kernel selection and the batch
+// hashing front end
+//
+// The SSE2, AVX2 and AVX-512 kernels are one template (hash_sw_mb_kernel.h)
+// built with GCC vector extensions at 4, 8 and 16 lanes. The SHA-NI kernel
+// uses the SHA extensions on one message at a time but takes four per call
+// to keep the call overhead down.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+#include "hash_sw_mb.h"
+
+#if defined(SW_SHA256_MB_X86)
+#include <immintrin.h>
+#endif
+
+//*****************************************************************************
+//
+// Portable scalar kernel, always available.
+//
+//*****************************************************************************
+static void
+SWSHA256MBScalar(uint32_t (*ppui32State)[8], const uint8_t * const *ppui8Blocks)
+{
+    SWSHA256Blocks(ppui32State[0], ppui8Blocks[0], 1);
+}
+
+#if defined(SW_SHA256_MB_X86)
+
+//*****************************************************************************
+//
+// Vector forms of the SHA-256 round functions. They are written with plain
+// operators so that the same text works for any GCC vector width.
+//
+//*****************************************************************************
+#define MB_LOAD32_BE(p) (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                         ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+#define MB_ROR(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+#define MB_S0(x)        (MB_ROR(x, 2) ^ MB_ROR(x, 13) ^ MB_ROR(x, 22))
+#define MB_S1(x)        (MB_ROR(x, 6) ^ MB_ROR(x, 11) ^ MB_ROR(x, 25))
+#define MB_G0(x)        (MB_ROR(x, 7) ^ MB_ROR(x, 18) ^ ((x) >> 3))
+#define MB_G1(x)        (MB_ROR(x, 17) ^ MB_ROR(x, 19) ^ ((x) >> 10))
+#define MB_CH(x, y, z)  (((x) & ((y) ^ (z))) ^ (z))
+#define MB_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+#define MB_W(i)         (W[(i) & 15] += MB_G1(W[((i) - 2) & 15]) +            \
+                                        W[((i) - 7) & 15] +                   \
+                                        MB_G0(W[((i) - 15) & 15]))
+#define MB_WLOAD(i)     W[i]
+
+#define MB_ROUND(V, a, b, c, d, e, f, g, h, i, w)                             \
+    do                                                                        \
+    {                                                                         \
+        V t1 = h + MB_S1(e) + MB_CH(e, f, g) + g_pui32SHA256K[i] + (w);       \
+        V t2 = MB_S0(a) + MB_MAJ(a, b, c);                                    \
+        d += t1;                                                              \
+        h = t1 + t2;                                                          \
+    } while(0)
+
+#define MB_ROUND8(V, i, w)                                                    \
+    MB_ROUND(V, a, b, c, d, e, f, g, h, (i) + 0, w((i) + 0));                 \
+    MB_ROUND(V, h, a, b, c, d, e, f, g, (i) + 1, w((i) + 1));                 \
+    MB_ROUND(V, g, h, a, b, c, d, e, f, (i) + 2, w((i) + 2));                 \
+    MB_ROUND(V, f, g, h, a, b, c, d, e, (i) + 3, w((i) + 3));                 \
+    MB_ROUND(V, e, f, g, h, a, b, c, d, (i) + 4, w((i) + 4));                 \
+    MB_ROUND(V, d, e, f, g, h, a, b, c, (i) + 5, w((i) + 5));                 \
+    MB_ROUND(V, c, d, e, f, g, h, a, b, (i) + 6, w((i) + 6));                 \
+    MB_ROUND(V, b, c, d, e, f, g, h, a, (i) + 7, w((i) + 7))
+
+#define MB_KERNEL_NAME      SWSHA256MBSSE2
+#define MB_KERNEL_LANES     4
+#define MB_KERNEL_TARGET    "sse2"
+#include "hash_sw_mb_kernel.h"
+
+#define MB_KERNEL_NAME      SWSHA256MBAVX2
+#define MB_KERNEL_LANES     8
+#define MB_KERNEL_TARGET    "avx2"
+#include "hash_sw_mb_kernel.h"
+
+#define MB_KERNEL_NAME      SWSHA256MBAVX512
+#define MB_KERNEL_LANES     16
+#define MB_KERNEL_TARGET    "avx512f"
+#include "hash_sw_mb_kernel.h"
+
+//*****************************************************************************
+//
+// SHA-NI compression of one block. The state is kept in the ABEF/CDGH word
+// order the SHA256RNDS2 instruction expects; each loop pass runs four
+// rounds and extends the message schedule by four words.
+//
+//*****************************************************************************
+static __attribute__((target("sha,sse4.1"))) void
+SWSHA256NIBlock(uint32_t *pui32State, const uint8_t *pui8Block)
+{
+    const __m128i sMask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i sState0, sState1, sSave0, sSave1, sMsg, sTmp;
+    __m128i psW[4];
+    uint32_t i;
+
+    sTmp = _mm_loadu_si128((const __m128i *)&pui32State[0]);
+    sState1 = _mm_loadu_si128((const __m128i *)&pui32State[4]);
+    sTmp = _mm_shuffle_epi32(sTmp, 0xB1);
+    sState1 = _mm_shuffle_epi32(sState1, 0x1B);
+    sState0 = _mm_alignr_epi8(sTmp, sState1, 8);
+    sState1 = _mm_blend_epi16(sState1, sTmp, 0xF0);
+    sSave0 = sState0;
+    sSave1 = sState1;
+
+    for(i = 0; i < 4; i++)
+    {
+        psW[i] = _mm_shuffle_epi8(
+                     _mm_loadu_si128((const __m128i *)(pui8Block + (i * 16))),
+                     sMask);
+    }
+
+    for(i = 0; i < 16; i++)
+    {
+        if(i >= 4)
+        {
+            psW[i & 3] = _mm_sha256msg2_epu32(
+                             _mm_add_epi32(
+                                 _mm_sha256msg1_epu32(psW[i & 3],
+                                                      psW[(i + 1) & 3]),
+                                 _mm_alignr_epi8(psW[(i + 3) & 3],
+                                                 psW[(i + 2) & 3], 4)),
+                             psW[(i + 3) & 3]);
+        }
+        sMsg = _mm_add_epi32(psW[i & 3],
+                             _mm_loadu_si128((const __m128i *)
+                                             &g_pui32SHA256K[i * 4]));
+        sState1 = _mm_sha256rnds2_epu32(sState1, sState0, sMsg);
+        sMsg = _mm_shuffle_epi32(sMsg, 0x0E);
+        sState0 = _mm_sha256rnds2_epu32(sState0, sState1, sMsg);
+    }
+
+    sState0 = _mm_add_epi32(sState0, sSave0);
+    sState1 = _mm_add_epi32(sState1, sSave1);
+    sTmp = _mm_shuffle_epi32(sState0, 0x1B);
+    sState1 = _mm_shuffle_epi32(sState1, 0xB1);
+    sState0 = _mm_blend_epi16(sTmp, sState1, 0xF0);
+    sState1 = _mm_alignr_epi8(sState1, sTmp, 8);
+    _mm_storeu_si128((__m128i *)&pui32State[0], sState0);
+    _mm_storeu_si128((__m128i *)&pui32State[4], sState1);
+}
+
+static void
+SWSHA256MBSHANI(uint32_t (*ppui32State)[8], const uint8_t * const *ppui8Blocks)
+{
+    SWSHA256NIBlock(ppui32State[0], ppui8Blocks[0]);
+    SWSHA256NIBlock(ppui32State[1], ppui8Blocks[1]);
+    SWSHA256NIBlock(ppui32State[2], ppui8Blocks[2]);
+    SWSHA256NIBlock(ppui32State[3], ppui8Blocks[3]);
+}
+
+static bool
+SWSHA256MBHasSHANI(void)
+{
+    return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+}
+
+static bool
+SWSHA256MBHasAVX512(void)
+{
+    return __builtin_cpu_supports("avx512f");
+}
+
+static bool
+SWSHA256MBHasAVX2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool
+SWSHA256MBHasSSE2(void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+#endif // SW_SHA256_MB_X86
+
+//*****************************************************************************
+//
+// Kernels in order of preference, each with its CPU feature check. On
+// parts with both, sixteen AVX-512 lanes outrun SHA-NI on block-sized
+// messages.
+//
+//*****************************************************************************
+typedef struct
+{
+    tSWSHA256MBKernel sKernel;
+    bool (*pfnSupported)(void);
+} tSWSHA256MBEntry;
+
+static const tSWSHA256MBEntry g_psKernels[] =
+{
+#if defined(SW_SHA256_MB_X86)
+    { { "avx512", 16, SWSHA256MBAVX512 }, SWSHA256MBHasAVX512 },
+    { { "sha-ni", 4, SWSHA256MBSHANI }, SWSHA256MBHasSHANI },
+    { { "avx2", 8, SWSHA256MBAVX2 }, SWSHA256MBHasAVX2 },
+    { { "sse2", 4, SWSHA256MBSSE2 }, SWSHA256MBHasSSE2 },
+#endif
+    { { "scalar", 1, SWSHA256MBScalar }, 0 }
+};
+
+#define SW_SHA256_MB_KERNELS    (sizeof(g_psKernels) / sizeof(g_psKernels[0]))
+
+//
+// The kernel in use. It starts as the scalar kernel, which every CPU runs,
+// and HashEngineInit() switches it to the preferred one before any other
+// thread exists; after that it is only read, so the mining threads need no
+// lock around it.
+//
+static const tSWSHA256MBKernel *g_psSelected =
+    &g_psKernels[SW_SHA256_MB_KERNELS - 1].sKernel;
+
+//*****************************************************************************
+//
+//! Number of kernels this CPU can run
+//!
+//! \param None
+//!
+//! \return the kernel count, at least 1 (the scalar kernel)
+//
+//*****************************************************************************
+uint32_t
+SWSHA256MBKernelCount(void)
+{
+    uint32_t ui32Index, ui32Count = 0;
+
+    for(ui32Index = 0; ui32Index < SW_SHA256_MB_KERNELS; ui32Index++)
+    {
+        if(!g_psKernels[ui32Index].pfnSupported ||
+           g_psKernels[ui32Index].pfnSupported())
+        {
+            ui32Count++;
+        }
+    }
+
+    return ui32Count;
+}
+
+//*****************************************************************************
+//
+//! A kernel this CPU can run
+//!
+//! \param ui32Index is the kernel number, 0 being the preferred one
+//!
+//! \return the kernel, or NULL if ui32Index is out of range
+//
+//*****************************************************************************
+const tSWSHA256MBKernel *
+SWSHA256MBKernelAt(uint32_t ui32Index)
+{
+    uint32_t ui32Entry;
+
+    for(ui32Entry = 0; ui32Entry < SW_SHA256_MB_KERNELS; ui32Entry++)
+    {
+        if(!g_psKernels[ui32Entry].pfnSupported ||
+           g_psKernels[ui32Entry].pfnSupported())
+        {
+            if(ui32Index-- == 0)
+            {
+                return &g_psKernels[ui32Entry].sKernel;
+            }
+        }
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! Kernel used by SWSHA256Batch(); the preferred one unless overridden
+//!
+//! \param None
+//!
+//! \return the kernel
+//
+//*****************************************************************************
+const tSWSHA256MBKernel *
+SWSHA256MBKernel(void)
+{
+    return g_psSelected;
+}
+
+//*****************************************************************************
+//
+//! Override the kernel choice, e.g. to validate or benchmark each kernel.
+//! It must not be called while other threads are hashing.
+//!
+//! \param psKernel is a kernel from SWSHA256MBKernelAt(), or NULL for the
+//! preferred one
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SWSHA256MBSelect(const tSWSHA256MBKernel *psKernel)
+{
+    g_psSelected = psKernel ? psKernel : SWSHA256MBKernelAt(0);
+}
+
+//*****************************************************************************
+//
+//! Hash a batch of independent messages, one lane per message
+//!
+//! \param ui32Algo is SHAMD5_ALGO_SHA256 or SHAMD5_ALGO_SHA224; other
+//! algorithms fall back to one SWHash() per message
+//! \param ppui8Data holds the messages
+//! \param pui32Length holds the message lengths in bytes
+//! \param ppui8Digest holds the digest buffers
+//! \param ui32Count is the number of messages
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+SWSHA256Batch(uint32_t ui32Algo, const uint8_t * const *ppui8Data,
+              const uint32_t *pui32Length, uint8_t * const *ppui8Digest,
+              uint32_t ui32Count)
+{
+    static const uint8_t pui8Idle[64];
+    const tSWSHA256MBKernel *psKernel = SWSHA256MBKernel();
+    uint32_t ppui32State[SW_SHA256_MB_MAX_LANES][8];
+    const uint8_t *ppui8Blocks[SW_SHA256_MB_MAX_LANES];
+    uint8_t ppui8Tail[SW_SHA256_MB_MAX_LANES][128];
+    uint32_t pui32Full[SW_SHA256_MB_MAX_LANES];
+    uint32_t pui32Blocks[SW_SHA256_MB_MAX_LANES];
+    uint32_t pui32IV[8];
+    tSWHashContext sCtx;
+    uint32_t ui32Lanes, ui32Used, ui32Block, ui32Last, ui32Rem, ui32Words;
+    uint32_t ui32Msg, l, i;
+    uint64_t ui64Bits;
+
+    if((ui32Algo != SHAMD5_ALGO_SHA256) && (ui32Algo != SHAMD5_ALGO_SHA224))
+    {
+        for(ui32Msg = 0; ui32Msg < ui32Count; ui32Msg++)
+        {
+            SWHash(ui32Algo, ppui8Data[ui32Msg], pui32Length[ui32Msg],
+                   ppui8Digest[ui32Msg]);
+        }
+        return;
+    }
+
+    SWHashInit(&sCtx, ui32Algo);
+    memcpy(pui32IV, sCtx.pui32State, sizeof(pui32IV));
+    ui32Words = HashDigestLength(ui32Algo) / 4;
+    ui32Lanes = psKernel->ui32Lanes;
+
+    for(ui32Msg = 0; ui32Msg < ui32Count; ui32Msg += ui32Used)
+    {
+        ui32Used = ui32Count - ui32Msg;
+        if(ui32Used > ui32Lanes)
+        {
+            ui32Used = ui32Lanes;
+        }
+
+        //
+        // Whole blocks are read in place; the remainder and the padding go
+        // through a one- or two-block tail per lane.
+        //
+        ui32Last = 0;
+        for(l = 0; l < ui32Lanes; l++)
+        {
+            memcpy(ppui32State[l], pui32IV, sizeof(pui32IV));
+            if(l >= ui32Used)
+            {
+                pui32Full[l] = pui32Blocks[l] = 0;
+                continue;
+            }
+            pui32Full[l] = pui32Length[ui32Msg + l] / 64;
+            ui32Rem = pui32Length[ui32Msg + l] % 64;
+            pui32Blocks[l] = pui32Full[l] + ((ui32Rem < 56) ? 1 : 2);
+            memset(ppui8Tail[l], 0, sizeof(ppui8Tail[l]));
+            memcpy(ppui8Tail[l], ppui8Data[ui32Msg + l] + (pui32Full[l] * 64),
+                   ui32Rem);
+            ppui8Tail[l][ui32Rem] = 0x80;
+            ui64Bits = (uint64_t)pui32Length[ui32Msg + l] * 8;
+            for(i = 0; i < 8; i++)
+            {
+                ppui8Tail[l][((pui32Blocks[l] - pui32Full[l]) * 64) - 1 - i] =
+                    (uint8_t)(ui64Bits >> (8 * i));
+            }
+            if(pui32Blocks[l] > ui32Last)
+            {
+                ui32Last = pui32Blocks[l];
+            }
+        }
+
+        for(ui32Block = 0; ui32Block < ui32Last; ui32Block++)
+        {
+            for(l = 0; l < ui32Lanes; l++)
+            {
+                if(ui32Block < pui32Full[l])
+                {
+                    ppui8Blocks[l] = ppui8Data[ui32Msg + l] + (ui32Block * 64);
+                }
+                else if(ui32Block < pui32Blocks[l])
+                {
+                    ppui8Blocks[l] = ppui8Tail[l] +
+                                     ((ui32Block - pui32Full[l]) * 64);
+                }
+                else
+                {
+                    ppui8Blocks[l] = pui8Idle;
+                }
+            }
+
+            psKernel->pfnCompress(ppui32State, ppui8Blocks);
+
+            //
+            // A lane's state is final right after its last block; later
+            // passes only run idle blocks through it.
+            //
+            for(l = 0; l < ui32Used; l++)
+            {
+                if(ui32Block + 1 != pui32Blocks[l])
+                {
+                    continue;
+                }
+                for(i = 0; i < ui32Words; i++)
+                {
+                    ppui8Digest[ui32Msg + l][(i * 4) + 0] =
+                        (uint8_t)(ppui32State[l][i] >> 24);
+                    ppui8Digest[ui32Msg + l][(i * 4) + 1] =
+                        (uint8_t)(ppui32State[l][i] >> 16);
+                    ppui8Digest[ui32Msg + l][(i * 4) + 2] =
+                        (uint8_t)(ppui32State[l][i] >> 8);
+                    ppui8Digest[ui32Msg + l][(i * 4) + 3] =
+                        (uint8_t)(ppui32State[l][i]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+//*****************************************************************************
+// hash_sw_mb.h
+//
+// Multi-buffer software SHA-256: hashes several independent messages at
+// once, one per vector lane. On x86 hosts the widest supported kernel
+// (SHA-NI, AVX-512, AVX2 or SSE2) is picked at run time; everywhere else a
+// portable scalar kernel is used.
+//
+//*****************************************************************************
+
+#ifndef __HASH_SW_MB_H__
+#define __HASH_SW_MB_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+//
+// Widest kernel, in lanes. The vector kernels are built for x86-64 hosts
+// only; the board and other hosts use the one-lane scalar kernel.
+//
+//*****************************************************************************
+#if !defined(cc3200) && defined(__GNUC__) && defined(__x86_64__)
+#define SW_SHA256_MB_X86
+#define SW_SHA256_MB_MAX_LANES  16
+#else
+#define SW_SHA256_MB_MAX_LANES  1
+#endif
+
+//*****************************************************************************
+//
+// A kernel compresses one 64-byte block into each of ui32Lanes states.
+// ppui32State holds one eight-word state per lane and ppui8Blocks one block
+// pointer per lane.
+//
+//*****************************************************************************
+typedef void (*tSWSHA256MBCompress)(uint32_t (*ppui32State)[8],
+                                    const uint8_t * const *ppui8Blocks);
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Lanes;
+    tSWSHA256MBCompress pfnCompress;
+} tSWSHA256MBKernel;
+
+extern const tSWSHA256MBKernel *SWSHA256MBKernel(void);
+extern uint32_t SWSHA256MBKernelCount(void);
+extern const tSWSHA256MBKernel *SWSHA256MBKernelAt(uint32_t ui32Index);
+extern void SWSHA256MBSelect(const tSWSHA256MBKernel *psKernel);
+extern void SWSHA256Batch(uint32_t ui32Algo, const uint8_t * const *ppui8Data,
+                          const uint32_t *pui32Length,
+                          uint8_t * const *ppui8Digest, uint32_t ui32Count);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HASH_SW_MB_H__
@@ -0,0 +1,69 @@
+//*****************************************************************************
+// hash_sw_mb_kernel.h
+//
+// Multi-buffer SHA-256 compression template, included by hash_sw_mb.c once
+// per vector width. Before including, define:
+//
+//   MB_KERNEL_NAME     function name
+//   MB_KERNEL_LANES    lanes per call (vector width in 32-bit words)
+//   MB_KERNEL_TARGET   GCC target attribute string for the instruction set
+//
+// Each lane runs one independent compression; lane l of every vector holds
+// the state of message l. The function compresses one 64-byte block per
+// lane.
+//
+//*****************************************************************************
+
+static __attribute__((target(MB_KERNEL_TARGET))) void
+MB_KERNEL_NAME(uint32_t (*ppui32State)[8], const uint8_t * const *ppui8Blocks)
+{
+    typedef uint32_t tVec __attribute__((vector_size(MB_KERNEL_LANES * 4)));
+    tVec W[16];
+    tVec a, b, c, d, e, f, g, h;
+    uint32_t i, l;
+
+    for(i = 0; i < 16; i++)
+    {
+        for(l = 0; l < MB_KERNEL_LANES; l++)
+        {
+            W[i][l] = MB_LOAD32_BE(ppui8Blocks[l] + (i * 4));
+        }
+    }
+
+    for(l = 0; l < MB_KERNEL_LANES; l++)
+    {
+        a[l] = ppui32State[l][0];
+        b[l] = ppui32State[l][1];
+        c[l] = ppui32State[l][2];
+        d[l] = ppui32State[l][3];
+        e[l] = ppui32State[l][4];
+        f[l] = ppui32State[l][5];
+        g[l] = ppui32State[l][6];
+        h[l] = ppui32State[l][7];
+    }
+
+    MB_ROUND8(tVec, 0, MB_WLOAD);
+    MB_ROUND8(tVec, 8, MB_WLOAD);
+    MB_ROUND8(tVec, 16, MB_W);
+    MB_ROUND8(tVec, 24, MB_W);
+    MB_ROUND8(tVec, 32, MB_W);
+    MB_ROUND8(tVec, 40, MB_W);
+    MB_ROUND8(tVec, 48, MB_W);
+    MB_ROUND8(tVec, 56, MB_W);
+
+    for(l = 0; l < MB_KERNEL_LANES; l++)
+    {
+        ppui32State[l][0] += a[l];
+        ppui32State[l][1] += b[l];
+        ppui32State[l][2] += c[l];
+        ppui32State[l][3] += d[l];
+        ppui32State[l][4] += e[l];
+        ppui32State[l][5] += f[l];
+        ppui32State[l][6] += g[l];
+        ppui32State[l][7] += h[l];
+    }
+}
+
+#undef MB_KERNEL_NAME
+#undef MB_KERNEL_LANES
+#undef MB_KERNEL_TARGET
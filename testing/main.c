@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <string.h>
 
+#if defined(cc3200)
 // Driverlib includes
 #include "hw_shamd5.h"
 #include "hw_memmap.h"
@@ -18,34 +19,45 @@
 #include "prcm.h"
 #include "uart.h"
 #include "utils.h"
-#include "shamd5.h"
 
 // Common interface includes
 #include "uart_if.h"
+#include "simplelink.h"
 
 #include "pinmux.h"
-#include "shamd5_vector.h"
 #include "shamd5_userinput.h"
+#endif
 
+#include "hash_engine.h"
+#include "hash_dma.h"
+#include "perf_clock.h"
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "miner.h"
+#include "miner_mt.h"
+#include "hash_sw_mb.h"
+#include "hash_selftest.h"
+#include "mempool.h"
+#include "chain_log.h"
+#include "wire.h"
+#include "uart_buf.h"
+#include "crc32.h"
+#include "console.h"
+#include "bench.h"
+#include "block_auth.h"
+#include "hash_sw.h"
+
+#if defined(cc3200)
 #if defined(ccs)
 extern void (* const g_pfnVectors[])(void);
 #endif
 #if defined(ewarm)
 extern uVectorEntry __vector_table;
 #endif
-#define UART_PRINT           Report
-struct Block s;
+#define UART_PRINT           UartBufPrintf
 static void BoardInit(void);
 void SetKeys(void);
-void GenerateHash(unsigned int uiConfig,unsigned char
-        *puiData,unsigned char *puiResult,unsigned int uiDataLength);
-void SHAMD5IntHandler(void);
-int check_block(struct Block *b);
-
-volatile bool g_bContextReadyFlag;
-volatile bool g_bParthashReadyFlag;
-volatile bool g_bInputReadyFlag;
-volatile bool g_bOutputReadyFlag;222
 
 
 static void
@@ -72,158 +84,172 @@ BoardInit(void)
 
     PRCMCC3200MCUInit();
 }
-//****************************************************************************
+
+//*****************************************************************************
 //
-//! Main function
-//!
-//! \param none
-//! 
-//!
-//! \return None.
+// SimpleLink event handlers. The network processor is started only for its
+// file system, which holds the block log; no WLAN, network or socket
+// service is used, so there is nothing to handle, but the SimpleLink
+// library calls these and the application must provide them.
 //
-//***************************************************************************
-
+//*****************************************************************************
 void
-GenerateHash(unsigned int uiConfig,unsigned char *puiData,
-        unsigned char *puiResult,unsigned int uiDataLength)
+SimpleLinkWlanEventHandler(SlWlanEvent_t *pWlanEvent)
 {
+    (void)pWlanEvent;
+}
 
-	UART_PRINT("HASHING: %s\r\n", puiData);
-    //
-    // Step1: Enable Interrupts
-    // Step2: Wait for Context Ready Inteerupt
-    // Step3: Set the Configuration Parameters (Hash Algorithm)
-    // Step4: Set Key depends on Algorithm
-    // Step5: Start Hash Generation
-    //
-
-    //
-    // Clear the flags
-    //
-    g_bContextReadyFlag = false;
-    g_bInputReadyFlag = false;
-    //
-    // Enable interrupts.
-    //
-    MAP_SHAMD5IntEnable(SHAMD5_BASE, SHAMD5_INT_CONTEXT_READY |
-                    SHAMD5_INT_PARTHASH_READY |
-                    SHAMD5_INT_INPUT_READY |
-                    SHAMD5_INT_OUTPUT_READY);
-    //
-    // Wait for the context ready flag.
-    //
-    while(!g_bContextReadyFlag)
-    {
-    }
-    //
-    // Configure the SHA/MD5 module.
-    //
-    MAP_SHAMD5ConfigSet(SHAMD5_BASE, uiConfig);
-
-
-    //
-    // Perform the hashing operation
-    //
-    MAP_SHAMD5DataProcess(SHAMD5_BASE, puiData, uiDataLength,
-                          puiResult);
-
-
-
+void
+SimpleLinkNetAppEventHandler(SlNetAppEvent_t *pNetAppEvent)
+{
+    (void)pNetAppEvent;
 }
 
+void
+SimpleLinkHttpServerCallback(SlHttpServerEvent_t *pHttpEvent,
+                             SlHttpServerResponse_t *pHttpResponse)
+{
+    (void)pHttpEvent;
+    (void)pHttpResponse;
+}
 
 void
-SHAMD5IntHandler(void)
+SimpleLinkGeneralEventHandler(SlDeviceEvent_t *pDevEvent)
 {
-    uint32_t ui32IntStatus;
-    //
-    // Read the SHA/MD5 masked interrupt status.
-    //
-    ui32IntStatus = MAP_SHAMD5IntStatus(SHAMD5_BASE, true);
-    if(ui32IntStatus & SHAMD5_INT_CONTEXT_READY)
-    {
-        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_CONTEXT_READY);
-        g_bContextReadyFlag = true;
+    (void)pDevEvent;
+}
 
-    }
-    if(ui32IntStatus & SHAMD5_INT_PARTHASH_READY)
-    {
-        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_PARTHASH_READY);
-        g_bParthashReadyFlag=true;
+void
+SimpleLinkSockEventHandler(SlSockEvent_t *pSock)
+{
+    (void)pSock;
+}
 
-    }
-    if(ui32IntStatus & SHAMD5_INT_INPUT_READY)
-    {
-        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_INPUT_READY);
-        g_bInputReadyFlag = true;
+#if defined(BENCH_AT_BOOT)
+static void
+BenchPrint(const tBenchResult *psResult, void *pvArg)
+{
+    char pcLine[BENCH_LINE_MAX];
 
-    }
-    if(ui32IntStatus & SHAMD5_INT_OUTPUT_READY)
+    (void)pvArg;
+    if(BenchFormat(psResult, pcLine, sizeof(pcLine)))
     {
-        MAP_SHAMD5IntDisable(SHAMD5_BASE, SHAMD5_INT_OUTPUT_READY);
-        g_bOutputReadyFlag = true;
-
+        UART_PRINT("%s\n\r", pcLine);
     }
-
 }
+#endif
+#else
+#define UART_PRINT           printf
 
-struct Block{
-	int index;
-	unsigned char pHash[32];
-	unsigned char hash[32];
-	unsigned char data[10];
-};
-
-
-
-struct Block* gen_block(struct Block* lastb, char* data ){
-
-	struct Block *b = malloc(sizeof(struct Block));
-	//char data;
-	// prep the data
-	unsigned char d[42];
-	strcpy(d, lastb->hash);
-	strcpy(d+32, data);
-	memset(d+42, 0,1);
-	b->index = lastb->index +1;
-	strcpy(b->hash, lastb->hash);
-	GenerateHash(SHAMD5_ALGO_SHA256, d, b->hash, 42);
-	strcpy(b->data, d);
-	return b;
-
+static void
+ReportMinerRate(uint32_t ui32Threads, uint64_t ui64HashRate)
+{
+    UART_PRINT("mining %u threads: %lu H/s\n\r", (unsigned int)ui32Threads,
+               (unsigned long)ui64HashRate);
 }
 
-struct Block * gen_genesis_block(){
-	struct Block *b = malloc(sizeof(struct Block));
-	strcpy(b->data, "000000000");
-	GenerateHash(SHAMD5_ALGO_SHA256, "genesis block", b->hash, 13);
-	b->index = 0;
-	return b;
-
+//*****************************************************************************
+//
+// Loopback line for the simulated UART: what it sends comes straight back.
+//
+//*****************************************************************************
+static uint8_t g_pui8Line[64];
+static tUartRing g_sLine;
 
+static void
+LineTx(void *pvArg, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    (void)pvArg;
+    UartRingPut(&g_sLine, pui8Data, ui32Length);
 }
 
-int verify_block(struct Block * block, struct Block* lastb){
-	unsigned char h[32];
-	unsigned char d[32];
-	strcpy(d, lastb->hash);
-	strcpy(d+32, block->data);
-	memset(d+42, 0, 1);
-	GenerateHAsh(SHAMD5_ALGO_SHA256,d,h,32);
+static uint32_t
+LineRx(void *pvArg, uint8_t *pui8Data, uint32_t ui32Max)
+{
+    (void)pvArg;
+    return UartRingGet(&g_sLine, pui8Data, ui32Max);
+}
 
-	return strcmp(h, block->hash) && (block->index == lastb->index + 1);
+//*****************************************************************************
+//
+// Console output to stdout, or counted and dropped while timing.
+//
+//*****************************************************************************
+static void
+ConsoleOut(void *pvArg, const char *pcText, uint32_t ui32Length)
+{
+    (void)pvArg;
+    fwrite(pcText, 1, ui32Length, stdout);
 }
 
+static void
+ConsoleCount(void *pvArg, const char *pcText, uint32_t ui32Length)
+{
+    (void)pcText;
+    *(uint32_t *)pvArg += ui32Length;
+}
+#endif
 
 unsigned char *result;
 unsigned char* data;
 unsigned char *puiKey1;
 unsigned int uiDataLength;
 unsigned int u8count;
-struct Block *blocks[10];
+tChainStore g_sChain;
+struct Block *psTip;
+char pcBlockData[BLOCK_TX_LEN];
+tBlockPoolStats sPoolStats;
+uint8_t g_pui8Target[BLOCK_HASH_LEN];
+tMinerResult g_sMined;
+struct BlockBuilder g_sBuilder;
+tMerkleProof g_sProof;
+tMempoolStats g_sMempoolStats;
+tChainLogStats g_sLogStats;
+uint32_t ui32BadHeight, ui32Height;
+uint64_t ui64Ticks, ui64SerialTicks;
+bool bSelfTest, bTagged;
+uint8_t g_pui8Tag[BLOCK_TAG_LEN], g_pui8SWTag[BLOCK_TAG_LEN];
+uint8_t g_pui8Scratch[BLOCK_TAG_LEN], g_pui8Header[BLOCK_HEADER_LEN];
+uint32_t g_pui32Payload[1024];
+uint64_t ui64CPURate, ui64DMARate;
+tUartBufStats g_sUartStats;
+char pcLogLine[64];
+uint8_t g_pui8Echo[64];
+uint32_t ui32Sent, ui32Echoed, ui32SentCrc, ui32EchoCrc;
+char pcCommand[CONSOLE_LINE_MAX + 1];
+tConsoleStats g_sConsoleStats;
+tHashSelfTestStats g_sSelfTest;
 
 
 unsigned int iSize, uiMsgLen, uiConfig, uiHashLength;
+
+//*****************************************************************************
+//
+//! Extend the chain and log the new tip. A block the log cannot take stays
+//! on the chain; it is reported here and counted in the log statistics.
+//!
+//! \param psBlock is the new tip
+//!
+//! \return false if the block does not extend the chain
+//
+//*****************************************************************************
+static bool
+ChainAppend(struct Block *psBlock)
+{
+    if(!ChainStoreAppend(&g_sChain, psBlock))
+    {
+        return false;
+    }
+    if(!ChainLogAppend(psBlock))
+    {
+        UART_PRINT("block %u not logged\n\r",
+                   (unsigned int)psBlock->header.height);
+    }
+    WireNodeBlockAdded(psBlock);
+
+    return true;
+}
+
 int
 main()
 {
@@ -231,11 +257,13 @@ main()
     //
     // Initialize Board configurations
     //
+#if defined(cc3200)
     BoardInit();
     UDMAInit();
     PinMuxConfig();
     InitTerm();
-    MAP_PRCMPeripheralClkEnable(PRCM_DTHE, PRCM_RUN_MODE_CLK);
+    UartBufInit();
+#endif
 
     // Set up wireless connection
 
@@ -243,10 +271,145 @@ main()
       // Enable interrupts.
       //
     UART_PRINT("testing\n\r");
-    MAP_SHAMD5IntRegister(SHAMD5_BASE, SHAMD5IntHandler);
+    PerfClockInit();
+    HashEngineInit();
+    BlockPoolInit();
+    MempoolInit();
+    ChainStoreInit(&g_sChain);
 
-    UART_PRINT("enabled int\n\r");
-    blocks[0] = gen_genesis_block();
+    UART_PRINT("hash engine: %s\n\r", g_psHashEngine->pcName);
+
+    //
+    // A unit whose engine gives wrong answers must not produce blocks.
+    //
+    bSelfTest = HashSelfTest();
+    HashSelfTestStatsGet(&g_sSelfTest);
+    for(u8count=0;u8count<HASH_SELFTEST_CHECKS;u8count++)
+    {
+        UART_PRINT("self-test %s: %s, %u.%02u ticks/byte\n\r",
+                   g_sSelfTest.psResult[u8count].pcName,
+                   g_sSelfTest.psResult[u8count].bPass ? "pass" : "FAIL",
+                   (unsigned int)
+                   (g_sSelfTest.psResult[u8count].ui32TicksPerByte100 / 100),
+                   (unsigned int)
+                   (g_sSelfTest.psResult[u8count].ui32TicksPerByte100 % 100));
+    }
+    if(!bSelfTest)
+    {
+        UART_PRINT("hash self-test failed, halting\n\r");
+#if defined(cc3200)
+        UartBufFlush();
+        for(;;)
+        {
+        }
+#else
+        return 1;
+#endif
+    }
+#if !defined(cc3200)
+    for(u8count=0;u8count<SWSHA256MBKernelCount();u8count++)
+    {
+        UART_PRINT("sha256 kernel %s: %s\n\r",
+                   SWSHA256MBKernelAt(u8count)->pcName,
+                   HashSelfTestMultiBuffer(SWSHA256MBKernelAt(u8count)) ?
+                   "pass" : "FAIL");
+    }
+    UART_PRINT("sha256 kernel in use: %s\n\r", SWSHA256MBKernel()->pcName);
+#endif
+#if defined(cc3200) && defined(BENCH_AT_BOOT)
+    {
+        char pcLine[BENCH_LINE_MAX];
+
+        if(BenchFormatInfo(1, pcLine, sizeof(pcLine)))
+        {
+            UART_PRINT("%s\n\r", pcLine);
+        }
+        BenchRun(&g_sChain, 1, BenchPrint, NULL);
+    }
+#endif
+
+    //
+    // Tags made by the engine from the precomputed pads must match a plain
+    // software HMAC, and cost about one header hash. The chain itself is
+    // authenticated only with a provisioned key, which has to be in place
+    // before the log is read.
+    //
+    BlockAuthLoadKey((const uint8_t *)"bench key", 9);
+    memset(g_pui8Scratch, 0x5a, sizeof(g_pui8Scratch));
+    BlockAuthTag(g_pui8Scratch, g_pui8Tag);
+    SWHMAC(SHAMD5_ALGO_SHA256, (const uint8_t *)"bench key", 9,
+           g_pui8Scratch, BLOCK_HASH_LEN, g_pui8SWTag);
+    UART_PRINT("block tag %s software hmac\n\r",
+               memcmp(g_pui8Tag, g_pui8SWTag, BLOCK_TAG_LEN) ?
+               "DIFFERS from" : "matches");
+    UART_PRINT("software hash %s an hmac configuration\n\r",
+               SWHash(SHAMD5_ALGO_HMAC_SHA256, g_pui8Scratch, BLOCK_HASH_LEN,
+                      g_pui8SWTag) ? "ACCEPTS" : "refuses");
+    ui64Ticks = PerfClockNow();
+    for(u8count=0;u8count<1000;u8count++)
+    {
+        BlockAuthTag(g_pui8Scratch, g_pui8Tag);
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    ui64SerialTicks = PerfClockNow();
+    for(u8count=0;u8count<1000;u8count++)
+    {
+        GenerateHash(SHAMD5_ALGO_SHA256, g_pui8Header, g_pui8Tag,
+                     BLOCK_HEADER_LEN);
+    }
+    ui64SerialTicks = PerfClockNow() - ui64SerialTicks;
+    UART_PRINT("block tags %lu/s, header hashes %lu/s\n\r",
+               (unsigned long)PerfClockRate(1000, ui64Ticks),
+               (unsigned long)PerfClockRate(1000, ui64SerialTicks));
+    BlockAuthClearKey();
+#if defined(CHAIN_AUTH_KEY)
+    BlockAuthLoadKey((const uint8_t *)CHAIN_AUTH_KEY,
+                     sizeof(CHAIN_AUTH_KEY) - 1);
+    UART_PRINT("authenticated chain\n\r");
+#endif
+
+    //
+    // Pick the chain up from the log; only a fresh log starts from genesis.
+    // On the host a full replay of the log is timed first, for comparison
+    // with the snapshot restore that a normal start uses.
+    //
+#if defined(cc3200)
+    sl_Start(NULL, NULL, NULL);
+#else
+    ui64Ticks = PerfClockNow();
+    if(ChainLogOpen(CHAIN_LOG_NAME, &g_sChain, false))
+    {
+        ui64Ticks = PerfClockNow() - ui64Ticks;
+        ChainLogStatsGet(&g_sLogStats);
+        ChainLogClose();
+        UART_PRINT("chain ready by replay: %u blocks in %lu us\n\r",
+                   (unsigned int)g_sLogStats.ui32Recovered,
+                   (unsigned long)(ui64Ticks * 1000000 / PERF_CLOCK_HZ));
+    }
+    BlockPoolInit();
+    ChainStoreInit(&g_sChain);
+#endif
+    ui64Ticks = PerfClockNow();
+    if(!ChainLogOpen(CHAIN_LOG_NAME, &g_sChain, true))
+    {
+        UART_PRINT("chain log %s unavailable\n\r", CHAIN_LOG_NAME);
+    }
+    if(ChainStoreCount(&g_sChain) == 0)
+    {
+        ChainAppend(gen_genesis_block());
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    ChainLogStatsGet(&g_sLogStats);
+    UART_PRINT("chain log: %u blocks from snapshot, %u replayed (%u trusted, "
+               "%u verified), %u bytes dropped\n\r",
+               (unsigned int)g_sLogStats.ui32Restored,
+               (unsigned int)g_sLogStats.ui32Recovered,
+               (unsigned int)g_sLogStats.ui32Trusted,
+               (unsigned int)g_sLogStats.ui32Verified,
+               (unsigned int)g_sLogStats.ui32DroppedBytes);
+    UART_PRINT("chain ready at height %u in %lu us\n\r",
+               (unsigned int)ChainStoreTip(&g_sChain)->header.height,
+               (unsigned long)(ui64Ticks * 1000000 / PERF_CLOCK_HZ));
 
 //    uiConfig=SHAMD5_ALGO_SHA256;
 //    uiHashLength=32;
@@ -265,20 +428,349 @@ main()
 //    GenerateHash(uiConfig, "test",  result, 4);
     for(u8count=0;u8count<32;u8count++)
            {
-             UART_PRINT("%02x",*(blocks[0]->hash + u8count));
+             UART_PRINT("%02x",*(ChainStoreGet(&g_sChain,
+                     ChainStoreBaseHeight(&g_sChain))->hash + u8count));
            }
            UART_PRINT("\n\r");
 
-    blocks[1] = gen_block(blocks[0], "test00000");
-    UART_PRINT("block1 data: %s\r\n", blocks[1]->data);
-    UART_PRINT("block1 last hash: %s\r\n", blocks[1]->pHash);
+#if !defined(cc3200)
+    //
+    // Demonstration blocks. The board's chain is persisted to serial flash,
+    // so there it only gets genesis and the blocks it is asked to seal.
+    //
+    ChainAppend(gen_block(ChainStoreTip(&g_sChain), "test00000"));
+    psTip = ChainStoreTip(&g_sChain);
+    UART_PRINT("block1 data: %.*s\r\n", BLOCK_TX_LEN, psTip->data);
+    UART_PRINT("block1 last hash: ");
+    for(u8count=0;u8count<32;u8count++)
+               {
+                 UART_PRINT("%02x",*(psTip->header.pHash + u8count));
+               }
+               UART_PRINT("\n\r");
 
     for(u8count=0;u8count<32;u8count++)
                {
-                 UART_PRINT("%02x",*(blocks[1]->hash + u8count));
+                 UART_PRINT("%02x",*(psTip->hash + u8count));
                }
                UART_PRINT("\n\r");
 
+    //
+    // Keep extending the chain well past the ring depth; old blocks are
+    // pruned back to the pool so memory stays flat.
+    //
+    for(u8count=2;u8count<3*CHAIN_STORE_DEPTH;u8count++)
+    {
+        snprintf(pcBlockData, sizeof(pcBlockData), "b%08u", u8count);
+        if(!ChainAppend(gen_block(ChainStoreTip(&g_sChain), pcBlockData)))
+        {
+            UART_PRINT("append failed at %u\n\r", u8count);
+            break;
+        }
+    }
+    BlockPoolStatsGet(&sPoolStats);
+    UART_PRINT("chain tip %u, retained %u from %u, pool in use %u\n\r",
+               (unsigned int)ChainStoreTip(&g_sChain)->header.height,
+               (unsigned int)ChainStoreCount(&g_sChain),
+               (unsigned int)ChainStoreBaseHeight(&g_sChain),
+               (unsigned int)sPoolStats.ui32InUse);
+#endif
+
+    //
+    // Walk the retained window by hash: every block must be found under its
+    // own hash, and every block but the oldest must find its parent.
+    //
+    ui32BadHeight = 0;
+    ui64Ticks = PerfClockNow();
+    for(ui32Height = ChainStoreBaseHeight(&g_sChain);
+        ui32Height < ChainStoreBaseHeight(&g_sChain) + ChainStoreCount(&g_sChain);
+        ui32Height++)
+    {
+        psTip = ChainStoreGet(&g_sChain, ui32Height);
+        if((ChainStoreFind(&g_sChain, psTip->hash) != psTip) ||
+           ((ui32Height != ChainStoreBaseHeight(&g_sChain)) &&
+            (ChainStoreFind(&g_sChain, psTip->header.pHash) !=
+             ChainStoreGet(&g_sChain, ui32Height - 1))))
+        {
+            ui32BadHeight++;
+        }
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    UART_PRINT("hash index: %u lookups, %u wrong, %lu lookups/s\n\r",
+               (unsigned int)(2 * ChainStoreCount(&g_sChain) - 1),
+               (unsigned int)ui32BadHeight,
+               (unsigned long)PerfClockRate(2 * ChainStoreCount(&g_sChain) - 1,
+                                            ui64Ticks));
+
+#if !defined(cc3200)
+    //
+    // Queue transactions in the mempool, every third one twice, then fill
+    // a block from it highest priority first and prove one of them against
+    // the root in the header.
+    //
+    for(u8count=0;u8count<2*BLOCK_MAX_TX;u8count++)
+    {
+        snprintf(pcBlockData, sizeof(pcBlockData), "tx%07u", u8count);
+        MempoolAdd((uint8_t *)pcBlockData, BLOCK_TX_LEN, u8count % 4);
+        if((u8count % 3) == 0)
+        {
+            MempoolAdd((uint8_t *)pcBlockData, BLOCK_TX_LEN, u8count % 4);
+        }
+    }
+    MempoolStatsGet(&g_sMempoolStats);
+    UART_PRINT("mempool: %u queued, %u duplicates dropped\n\r",
+               (unsigned int)g_sMempoolStats.ui32Count,
+               (unsigned int)g_sMempoolStats.ui32Duplicates);
+    if(block_begin(&g_sBuilder, ChainStoreTip(&g_sChain)))
+    {
+        MempoolFillBlock(&g_sBuilder, MEMPOOL_ORDER_PRIORITY);
+        psTip = block_seal(&g_sBuilder);
+        ChainAppend(psTip);
+        block_prove_tx(&g_sBuilder, BLOCK_MAX_TX / 2, &g_sProof);
+        UART_PRINT("block %u: %u transactions, proof of tx %u %s\n\r",
+                   (unsigned int)psTip->header.height,
+                   (unsigned int)block_tx_count(psTip), BLOCK_MAX_TX / 2,
+                   block_verify_tx(psTip, BLOCK_MAX_TX / 2, &g_sProof) ?
+                   "verified" : "FAILED");
+    }
+    UART_PRINT("mempool: %u left for the next block\n\r",
+               (unsigned int)MempoolCount());
+#endif
+
+    //
+    // Verify the retained window in one pass, against a block-by-block
+    // walk, then check that a tampered payload is caught at its height.
+    //
+    ui64Ticks = PerfClockNow();
+    ChainStoreVerify(&g_sChain, &ui32BadHeight);
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    ui64SerialTicks = PerfClockNow();
+    for(ui32Height = ChainStoreBaseHeight(&g_sChain) + 1;
+        ui32Height < ChainStoreBaseHeight(&g_sChain) + ChainStoreCount(&g_sChain);
+        ui32Height++)
+    {
+        verify_block(ChainStoreGet(&g_sChain, ui32Height),
+                     ChainStoreGet(&g_sChain, ui32Height - 1));
+    }
+    ui64SerialTicks = PerfClockNow() - ui64SerialTicks;
+    UART_PRINT("verify %u blocks: chain %lu blocks/s, serial %lu blocks/s\n\r",
+               (unsigned int)ChainStoreCount(&g_sChain),
+               (unsigned long)PerfClockRate(ChainStoreCount(&g_sChain), ui64Ticks),
+               (unsigned long)PerfClockRate(ChainStoreCount(&g_sChain) - 1,
+                                            ui64SerialTicks));
+    ui32Height = ChainStoreBaseHeight(&g_sChain) + ChainStoreCount(&g_sChain) / 2;
+    ChainStoreGet(&g_sChain, ui32Height)->data[0] ^= 1;
+    if(!ChainStoreVerify(&g_sChain, &ui32BadHeight))
+    {
+        UART_PRINT("tampered block %u, first bad height %u\n\r",
+                   (unsigned int)ui32Height, (unsigned int)ui32BadHeight);
+    }
+    ChainStoreGet(&g_sChain, ui32Height)->data[0] ^= 1;
+    if(ChainStoreVerify(&g_sChain, &ui32BadHeight))
+    {
+        UART_PRINT("chain verified\n\r");
+    }
+
+    //
+    // A block at the next height but on another parent must be refused.
+    //
+    psTip = gen_block(ChainStoreTip(&g_sChain), "orphan");
+    if(psTip)
+    {
+        psTip->header.pHash[0] ^= 1;
+        block_hash_header(&psTip->header, psTip->hash);
+        if(ChainStoreAppend(&g_sChain, psTip))
+        {
+            UART_PRINT("block on another parent ACCEPTED\n\r");
+        }
+        else
+        {
+            UART_PRINT("block on another parent refused\n\r");
+            BlockPoolFree(psTip);
+        }
+    }
+
+    //
+    // In an authenticated chain a block made here is tagged, and the same
+    // block with its tag stripped must fail verification. Without a
+    // provisioned key the bench key stands in for the check.
+    //
+#if !defined(CHAIN_AUTH_KEY)
+    BlockAuthLoadKey((const uint8_t *)"bench key", 9);
+#endif
+    psTip = gen_block(ChainStoreTip(&g_sChain), "stripped");
+    if(psTip)
+    {
+        bTagged = verify_block(psTip, ChainStoreTip(&g_sChain));
+        psTip->tag_len = 0;
+        UART_PRINT("tagged block %s, stripped of its tag %s\n\r",
+                   bTagged ? "verified" : "FAILED",
+                   verify_block(psTip, ChainStoreTip(&g_sChain)) ?
+                   "ACCEPTED" : "refused");
+        BlockPoolFree(psTip);
+    }
+#if !defined(CHAIN_AUTH_KEY)
+    BlockAuthClearKey();
+#endif
+
+    //
+    // Mine the next block to the default difficulty. On the board it is
+    // only timed, not appended.
+    //
+    MinerTargetFromBits(MINER_DEFAULT_BITS, g_pui8Target);
+    psTip = gen_block(ChainStoreTip(&g_sChain), "mined");
+#if defined(cc3200)
+    if(psTip && MinerMineBlock(psTip, g_pui8Target, 0xFFFFFFFFu, &g_sMined) &&
+       verify_block(psTip, ChainStoreTip(&g_sChain)))
+#else
+    if(psTip && MinerMTMineBlock(psTip, g_pui8Target, 0xFFFFFFFFu, &g_sMined) &&
+       verify_block(psTip, ChainStoreTip(&g_sChain)) &&
+       ChainAppend(psTip))
+#endif
+    {
+        UART_PRINT("mined %u bits: nonce %u after %u hashes, %lu H/s\n\r",
+                   MINER_DEFAULT_BITS, (unsigned int)g_sMined.ui32Nonce,
+                   (unsigned int)g_sMined.ui32Hashes,
+                   (unsigned long)MinerHashRate(&g_sMined));
+        for(u8count=0;u8count<32;u8count++)
+        {
+            UART_PRINT("%02x",*(psTip->hash + u8count));
+        }
+        UART_PRINT("\n\r");
+    }
+#if defined(cc3200)
+    BlockPoolFree(psTip);
+#endif
+
+#if !defined(cc3200)
+    //
+    // Scaling of the host miner across thread counts.
+    //
+    MinerMTBenchmark(&psTip->header, 1u << 22, MinerMTCPUCount(),
+                     ReportMinerRate);
+#endif
+
+    //
+    // Compare CPU-fed and DMA-fed hashing of a 4 KB payload.
+    //
+    for(u8count=0;u8count<1024;u8count++)
+    {
+        g_pui32Payload[u8count] = u8count * 2654435761u;
+    }
+    HashDMAMeasure((uint8_t *)g_pui32Payload, sizeof(g_pui32Payload), 16,
+                   &ui64CPURate, &ui64DMARate);
+    UART_PRINT("sha256 %u bytes: cpu %lu B/s, dma %lu B/s\n\r",
+               (unsigned int)sizeof(g_pui32Payload),
+               (unsigned long)ui64CPURate, (unsigned long)ui64DMARate);
+
+#if !defined(cc3200)
+    //
+    // Produce block hashes while logging each one through the buffered
+    // UART. The simulated line is looped back and moves fewer bytes per
+    // block than are logged, so the transmit ring takes up the difference;
+    // everything sent must come back intact.
+    //
+    UartBufInit();
+    UartRingInit(&g_sLine, g_pui8Line, sizeof(g_pui8Line));
+    UartBufSimAttach(LineTx, LineRx, NULL);
+    ui32Sent = ui32Echoed = ui32SentCrc = ui32EchoCrc = 0;
+    for(u8count=0;u8count<1024;u8count++)
+    {
+        GenerateHash(SHAMD5_ALGO_SHA256, (unsigned char *)g_pui32Payload,
+                     (unsigned char *)g_pui8Echo, 256);
+        iSize = snprintf(pcLogLine, sizeof(pcLogLine),
+                         "block %u hash %02x%02x%02x%02x\n\r", u8count,
+                         g_pui8Echo[0], g_pui8Echo[1], g_pui8Echo[2],
+                         g_pui8Echo[3]);
+        UartBufWrite((uint8_t *)pcLogLine, iSize);
+        ui32SentCrc = Crc32(ui32SentCrc, (uint8_t *)pcLogLine, iSize);
+        ui32Sent += iSize;
+        UartBufSimStep(16);
+        while((iSize = UartBufRead(g_pui8Echo, sizeof(g_pui8Echo))) != 0)
+        {
+            ui32EchoCrc = Crc32(ui32EchoCrc, g_pui8Echo, iSize);
+            ui32Echoed += iSize;
+        }
+    }
+    do
+    {
+        u8count = UartBufSimStep(16);
+        while((iSize = UartBufRead(g_pui8Echo, sizeof(g_pui8Echo))) != 0)
+        {
+            ui32EchoCrc = Crc32(ui32EchoCrc, g_pui8Echo, iSize);
+            ui32Echoed += iSize;
+        }
+    } while(u8count);
+    UartBufStatsGet(&g_sUartStats);
+    UART_PRINT("uart loopback: %u bytes sent, %u echoed %s, %u transfers, "
+               "high water tx %u rx %u, %u stalls, %u overruns\n\r",
+               (unsigned int)ui32Sent, (unsigned int)ui32Echoed,
+               ((ui32Sent == ui32Echoed) && (ui32SentCrc == ui32EchoCrc)) ?
+               "intact" : "CORRUPT",
+               (unsigned int)g_sUartStats.ui32TxTransfers,
+               (unsigned int)g_sUartStats.ui32TxHighWater,
+               (unsigned int)g_sUartStats.ui32RxHighWater,
+               (unsigned int)g_sUartStats.ui32TxStalls,
+               (unsigned int)g_sUartStats.ui32RxOverruns);
+#endif
+
+#if !defined(cc3200)
+    //
+    // Drive the console interpreter as a soak script would: a few commands
+    // shown, then a timed mix of lookups and hashes.
+    //
+    ConsoleInit(&g_sChain, ChainAppend);
+    snprintf(pcCommand, sizeof(pcCommand), "hash SHA256 abc");
+    ConsoleExecute(pcCommand, ConsoleOut, NULL);
+    snprintf(pcCommand, sizeof(pcCommand), "tip");
+    ConsoleExecute(pcCommand, ConsoleOut, NULL);
+    snprintf(pcCommand, sizeof(pcCommand), "verify");
+    ConsoleExecute(pcCommand, ConsoleOut, NULL);
+    ui32Sent = 0;
+    ui64Ticks = PerfClockNow();
+    for(u8count=0;u8count<100000;u8count++)
+    {
+        snprintf(pcCommand, sizeof(pcCommand), (u8count & 1) ?
+                 "block %u" : "hash md5 message %u",
+                 ChainStoreBaseHeight(&g_sChain) + (u8count % 64));
+        ConsoleExecute(pcCommand, ConsoleCount, &ui32Sent);
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    ConsoleStatsGet(&g_sConsoleStats);
+    UART_PRINT("console: %u commands, %u errors, %lu commands/s\n\r",
+               (unsigned int)g_sConsoleStats.ui32Commands,
+               (unsigned int)g_sConsoleStats.ui32Errors,
+               (unsigned long)PerfClockRate(100000, ui64Ticks));
+#if defined(PERF_PROBES)
+    snprintf(pcCommand, sizeof(pcCommand), "stats probes");
+    ConsoleExecute(pcCommand, ConsoleOut, NULL);
+#endif
+#endif
+
+#if defined(cc3200)
+    //
+    // From here on the console carries frames only (wire.h): the host
+    // submits transactions and reads blocks, and each sealed block is
+    // logged as it is appended, so the log is never closed.
+    //
+    UART_PRINT("serving the framed protocol\n\r");
+    WireNodeInit(&g_sChain, ChainAppend);
+    for(;;)
+    {
+        WireNodePoll();
+    }
+#endif
+
+    ChainLogClose();
+    ChainLogStatsGet(&g_sLogStats);
+    UART_PRINT("chain log: %u blocks in %u writes, %u bytes, %u checkpoints, "
+               "%u snapshots, %u not logged\n\r",
+               (unsigned int)g_sLogStats.ui32Logged,
+               (unsigned int)g_sLogStats.ui32Flushes,
+               (unsigned int)g_sLogStats.ui32BytesWritten,
+               (unsigned int)g_sLogStats.ui32Checkpoints,
+               (unsigned int)g_sLogStats.ui32Snapshots,
+               (unsigned int)g_sLogStats.ui32Unlogged);
+
     UART_PRINT("end of main\n\r");
     return 0;
 }
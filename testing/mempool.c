@@ -0,0 +1,585 @@
+//*****************************************************************************
+// mempool.c
+//
+// Pending-transaction pool
+//
+// Every queued transaction lives in one slot of a static entry array. The
+// slot is reachable three ways: from the dedup table (open addressing,
+// linear probing, keyed on the transaction bytes), from the arrival list
+// (FIFO order) and from two binary heaps, one keyed on highest priority for
+// block building and one on lowest priority for eviction. Each entry records
+// its heap positions so that removing it from the middle of a heap is
+// O(log n).
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "mempool.h"
+
+//
+// Keep probe runs short, keep entry indices clear of MEMPOOL_NONE, and make
+// sure the byte budget holds at least one transaction.
+//
+typedef char tMempoolTableCheck[((MEMPOOL_TABLE_SIZE >= 2 * MEMPOOL_CAPACITY) &&
+                                 (MEMPOOL_CAPACITY < MEMPOOL_NONE) &&
+                                 (MEMPOOL_MAX_BYTES >= BLOCK_TX_LEN)) ?
+                                1 : -1];
+
+#define MEMPOOL_TABLE_MASK      (MEMPOOL_TABLE_SIZE - 1)
+
+typedef struct
+{
+    uint8_t pui8Tx[BLOCK_TX_LEN];
+    uint32_t ui32Priority;
+    uint32_t ui32Seq;
+
+    //
+    // Arrival list while queued, free list otherwise (ui32Next only).
+    //
+    uint32_t ui32Prev;
+    uint32_t ui32Next;
+
+    //
+    // Positions in the priority and eviction heaps.
+    //
+    uint32_t ui32MaxPos;
+    uint32_t ui32MinPos;
+} tMempoolEntry;
+
+static tMempoolEntry g_psEntries[MEMPOOL_CAPACITY];
+static uint32_t g_pui32Table[MEMPOOL_TABLE_SIZE];
+static uint32_t g_pui32MaxHeap[MEMPOOL_CAPACITY];
+static uint32_t g_pui32MinHeap[MEMPOOL_CAPACITY];
+static uint32_t g_ui32FreeHead = MEMPOOL_NONE;
+static uint32_t g_ui32Oldest = MEMPOOL_NONE;
+static uint32_t g_ui32Newest = MEMPOOL_NONE;
+static uint32_t g_ui32Seq;
+static bool g_bMempoolReady;
+static tMempoolStats g_sStats;
+
+//
+// The batch last moved into a block by MempoolFillBlock().
+//
+static uint8_t g_ppui8Filled[BLOCK_MAX_TX][BLOCK_TX_LEN];
+static uint32_t g_pui32FilledPriority[BLOCK_MAX_TX];
+static uint32_t g_ui32Filled;
+
+//*****************************************************************************
+//
+// Dedup table
+//
+//*****************************************************************************
+
+//
+// FNV-1a over the padded transaction. Collisions only cost a probe: the
+// table always compares the full transaction.
+//
+static uint32_t
+MempoolTxHash(const uint8_t *pui8Tx)
+{
+    uint32_t ui32Hash = 2166136261u;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < BLOCK_TX_LEN; ui32Idx++)
+    {
+        ui32Hash = (ui32Hash ^ pui8Tx[ui32Idx]) * 16777619u;
+    }
+
+    return ui32Hash ^ (ui32Hash >> 16);
+}
+
+//
+// Table slot holding the transaction, or the empty slot where it would go.
+//
+static uint32_t
+MempoolTableFind(const uint8_t *pui8Tx)
+{
+    uint32_t ui32Slot = MempoolTxHash(pui8Tx) & MEMPOOL_TABLE_MASK;
+
+    while((g_pui32Table[ui32Slot] != MEMPOOL_NONE) &&
+          (memcmp(g_psEntries[g_pui32Table[ui32Slot]].pui8Tx, pui8Tx,
+                  BLOCK_TX_LEN) != 0))
+    {
+        ui32Slot = (ui32Slot + 1) & MEMPOOL_TABLE_MASK;
+    }
+
+    return ui32Slot;
+}
+
+//
+// Empty a slot and shift later members of the probe run back into the gap,
+// so that lookups never need tombstones.
+//
+static void
+MempoolTableRemove(uint32_t ui32Slot)
+{
+    uint32_t ui32Next = ui32Slot;
+    uint32_t ui32Home;
+
+    while(1)
+    {
+        g_pui32Table[ui32Slot] = MEMPOOL_NONE;
+        do
+        {
+            ui32Next = (ui32Next + 1) & MEMPOOL_TABLE_MASK;
+            if(g_pui32Table[ui32Next] == MEMPOOL_NONE)
+            {
+                return;
+            }
+            ui32Home = MempoolTxHash(
+                           g_psEntries[g_pui32Table[ui32Next]].pui8Tx) &
+                       MEMPOOL_TABLE_MASK;
+        }
+        //
+        // Leave the entry alone if its home lies cyclically in (gap, next].
+        //
+        while(((ui32Next - ui32Home) & MEMPOOL_TABLE_MASK) <
+              ((ui32Next - ui32Slot) & MEMPOOL_TABLE_MASK));
+
+        g_pui32Table[ui32Slot] = g_pui32Table[ui32Next];
+        ui32Slot = ui32Next;
+    }
+}
+
+//*****************************************************************************
+//
+// Heaps. The priority heap puts the highest priority on top and the
+// eviction heap the lowest; both break ties by age, oldest first.
+//
+//*****************************************************************************
+static bool
+MempoolHeapBefore(bool bMin, uint32_t ui32A, uint32_t ui32B)
+{
+    const tMempoolEntry *psA = &g_psEntries[ui32A];
+    const tMempoolEntry *psB = &g_psEntries[ui32B];
+
+    if(psA->ui32Priority != psB->ui32Priority)
+    {
+        return bMin ? (psA->ui32Priority < psB->ui32Priority) :
+                      (psA->ui32Priority > psB->ui32Priority);
+    }
+
+    return (int32_t)(psA->ui32Seq - psB->ui32Seq) < 0;
+}
+
+static void
+MempoolHeapSet(bool bMin, uint32_t ui32Pos, uint32_t ui32Entry)
+{
+    if(bMin)
+    {
+        g_pui32MinHeap[ui32Pos] = ui32Entry;
+        g_psEntries[ui32Entry].ui32MinPos = ui32Pos;
+    }
+    else
+    {
+        g_pui32MaxHeap[ui32Pos] = ui32Entry;
+        g_psEntries[ui32Entry].ui32MaxPos = ui32Pos;
+    }
+}
+
+static void
+MempoolHeapSift(bool bMin, uint32_t ui32Pos, uint32_t ui32Size)
+{
+    uint32_t *pui32Heap = bMin ? g_pui32MinHeap : g_pui32MaxHeap;
+    uint32_t ui32Entry = pui32Heap[ui32Pos];
+    uint32_t ui32Parent, ui32Child;
+
+    //
+    // Up...
+    //
+    while(ui32Pos > 0)
+    {
+        ui32Parent = (ui32Pos - 1) / 2;
+        if(!MempoolHeapBefore(bMin, ui32Entry, pui32Heap[ui32Parent]))
+        {
+            break;
+        }
+        MempoolHeapSet(bMin, ui32Pos, pui32Heap[ui32Parent]);
+        ui32Pos = ui32Parent;
+    }
+
+    //
+    // ...or down.
+    //
+    while((ui32Child = (2 * ui32Pos) + 1) < ui32Size)
+    {
+        if((ui32Child + 1 < ui32Size) &&
+           MempoolHeapBefore(bMin, pui32Heap[ui32Child + 1],
+                             pui32Heap[ui32Child]))
+        {
+            ui32Child++;
+        }
+        if(!MempoolHeapBefore(bMin, pui32Heap[ui32Child], ui32Entry))
+        {
+            break;
+        }
+        MempoolHeapSet(bMin, ui32Pos, pui32Heap[ui32Child]);
+        ui32Pos = ui32Child;
+    }
+
+    MempoolHeapSet(bMin, ui32Pos, ui32Entry);
+}
+
+//
+// Both heaps hold g_sStats.ui32Count entries; call these with the count
+// after the insertion / before the removal.
+//
+static void
+MempoolHeapInsert(bool bMin, uint32_t ui32Entry, uint32_t ui32Size)
+{
+    MempoolHeapSet(bMin, ui32Size - 1, ui32Entry);
+    MempoolHeapSift(bMin, ui32Size - 1, ui32Size);
+}
+
+static void
+MempoolHeapRemove(bool bMin, uint32_t ui32Entry, uint32_t ui32Size)
+{
+    uint32_t *pui32Heap = bMin ? g_pui32MinHeap : g_pui32MaxHeap;
+    uint32_t ui32Pos = bMin ? g_psEntries[ui32Entry].ui32MinPos :
+                              g_psEntries[ui32Entry].ui32MaxPos;
+
+    if(ui32Pos != ui32Size - 1)
+    {
+        MempoolHeapSet(bMin, ui32Pos, pui32Heap[ui32Size - 1]);
+        MempoolHeapSift(bMin, ui32Pos, ui32Size - 1);
+    }
+}
+
+//*****************************************************************************
+//
+// Entry bookkeeping
+//
+//*****************************************************************************
+static void
+MempoolRemove(uint32_t ui32Entry)
+{
+    tMempoolEntry *psEntry = &g_psEntries[ui32Entry];
+
+    MempoolTableRemove(MempoolTableFind(psEntry->pui8Tx));
+    MempoolHeapRemove(false, ui32Entry, g_sStats.ui32Count);
+    MempoolHeapRemove(true, ui32Entry, g_sStats.ui32Count);
+
+    if(psEntry->ui32Prev == MEMPOOL_NONE)
+    {
+        g_ui32Oldest = psEntry->ui32Next;
+    }
+    else
+    {
+        g_psEntries[psEntry->ui32Prev].ui32Next = psEntry->ui32Next;
+    }
+    if(psEntry->ui32Next == MEMPOOL_NONE)
+    {
+        g_ui32Newest = psEntry->ui32Prev;
+    }
+    else
+    {
+        g_psEntries[psEntry->ui32Next].ui32Prev = psEntry->ui32Prev;
+    }
+
+    g_sStats.ui32Count--;
+    g_sStats.ui32Bytes -= BLOCK_TX_LEN;
+
+    psEntry->ui32Next = g_ui32FreeHead;
+    g_ui32FreeHead = ui32Entry;
+}
+
+//*****************************************************************************
+//
+//! Empty the pool
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MempoolInit(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < MEMPOOL_CAPACITY; ui32Idx++)
+    {
+        g_psEntries[ui32Idx].ui32Next = ui32Idx + 1;
+    }
+    g_psEntries[MEMPOOL_CAPACITY - 1].ui32Next = MEMPOOL_NONE;
+    memset(g_pui32Table, 0xFF, sizeof(g_pui32Table));
+
+    g_ui32FreeHead = 0;
+    g_ui32Oldest = MEMPOOL_NONE;
+    g_ui32Newest = MEMPOOL_NONE;
+    g_ui32Seq = 0;
+    g_ui32Filled = 0;
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    g_bMempoolReady = true;
+}
+
+//*****************************************************************************
+//
+//! Queue a transaction. When the pool is full, by entries or by bytes, the
+//! lowest-priority transaction (the oldest among equals) is evicted to make
+//! room, unless the newcomer's priority is lower still. Every transaction
+//! is charged BLOCK_TX_LEN bytes, the room it takes in a block, so one
+//! eviction always makes enough room.
+//!
+//! \param pui8Tx is the transaction
+//! \param ui32Length is its length, at most BLOCK_TX_LEN; shorter
+//! transactions are zero-padded as they will be in a block
+//! \param ui32Priority orders the transaction for MEMPOOL_ORDER_PRIORITY
+//!
+//! \return MEMPOOL_ADDED, MEMPOOL_DUPLICATE if the same transaction is
+//! already queued, or MEMPOOL_REJECTED
+//
+//*****************************************************************************
+uint32_t
+MempoolAdd(const uint8_t *pui8Tx, uint32_t ui32Length, uint32_t ui32Priority)
+{
+    uint8_t pui8Padded[BLOCK_TX_LEN];
+    tMempoolEntry *psEntry;
+    uint32_t ui32Slot, ui32Entry, ui32Victim;
+
+    if(!g_bMempoolReady)
+    {
+        MempoolInit();
+    }
+
+    if((ui32Length == 0) || (ui32Length > BLOCK_TX_LEN))
+    {
+        g_sStats.ui32Rejected++;
+        return MEMPOOL_REJECTED;
+    }
+
+    memset(pui8Padded, 0, sizeof(pui8Padded));
+    memcpy(pui8Padded, pui8Tx, ui32Length);
+    if(g_pui32Table[MempoolTableFind(pui8Padded)] != MEMPOOL_NONE)
+    {
+        g_sStats.ui32Duplicates++;
+        return MEMPOOL_DUPLICATE;
+    }
+
+    if((g_sStats.ui32Count == MEMPOOL_CAPACITY) ||
+       (g_sStats.ui32Bytes + BLOCK_TX_LEN > MEMPOOL_MAX_BYTES))
+    {
+        ui32Victim = g_pui32MinHeap[0];
+        if(g_psEntries[ui32Victim].ui32Priority > ui32Priority)
+        {
+            g_sStats.ui32Rejected++;
+            return MEMPOOL_REJECTED;
+        }
+        MempoolRemove(ui32Victim);
+        g_sStats.ui32Evicted++;
+    }
+
+    ui32Entry = g_ui32FreeHead;
+    psEntry = &g_psEntries[ui32Entry];
+    g_ui32FreeHead = psEntry->ui32Next;
+
+    memcpy(psEntry->pui8Tx, pui8Padded, BLOCK_TX_LEN);
+    psEntry->ui32Priority = ui32Priority;
+    psEntry->ui32Seq = g_ui32Seq++;
+    psEntry->ui32Prev = g_ui32Newest;
+    psEntry->ui32Next = MEMPOOL_NONE;
+    if(g_ui32Newest == MEMPOOL_NONE)
+    {
+        g_ui32Oldest = ui32Entry;
+    }
+    else
+    {
+        g_psEntries[g_ui32Newest].ui32Next = ui32Entry;
+    }
+    g_ui32Newest = ui32Entry;
+
+    //
+    // Evictions may have shifted the probe run, so look the slot up again.
+    //
+    ui32Slot = MempoolTableFind(pui8Padded);
+    g_pui32Table[ui32Slot] = ui32Entry;
+
+    g_sStats.ui32Count++;
+    g_sStats.ui32Bytes += BLOCK_TX_LEN;
+    MempoolHeapInsert(false, ui32Entry, g_sStats.ui32Count);
+    MempoolHeapInsert(true, ui32Entry, g_sStats.ui32Count);
+
+    g_sStats.ui32Added++;
+    if(g_sStats.ui32Count > g_sStats.ui32HighWater)
+    {
+        g_sStats.ui32HighWater = g_sStats.ui32Count;
+    }
+
+    return MEMPOOL_ADDED;
+}
+
+//*****************************************************************************
+//
+//! Check whether a transaction is queued
+//!
+//! \param pui8Tx is the transaction
+//! \param ui32Length is its length
+//!
+//! \return true if it is queued
+//
+//*****************************************************************************
+bool
+MempoolContains(const uint8_t *pui8Tx, uint32_t ui32Length)
+{
+    uint8_t pui8Padded[BLOCK_TX_LEN];
+
+    if(!g_bMempoolReady || (ui32Length > BLOCK_TX_LEN))
+    {
+        return false;
+    }
+
+    memset(pui8Padded, 0, sizeof(pui8Padded));
+    memcpy(pui8Padded, pui8Tx, ui32Length);
+
+    return g_pui32Table[MempoolTableFind(pui8Padded)] != MEMPOOL_NONE;
+}
+
+//*****************************************************************************
+//
+// Remove up to ui32Max transactions in the given order, recording each one's
+// priority in pui32Priority unless it is 0.
+//
+//*****************************************************************************
+static uint32_t
+MempoolTakeEntries(uint32_t ui32Order, uint8_t (*ppui8Tx)[BLOCK_TX_LEN],
+                   uint32_t *pui32Priority, uint32_t ui32Max)
+{
+    uint32_t ui32Taken, ui32Entry;
+
+    for(ui32Taken = 0; (ui32Taken < ui32Max) && (g_sStats.ui32Count > 0);
+        ui32Taken++)
+    {
+        ui32Entry = (ui32Order == MEMPOOL_ORDER_PRIORITY) ? g_pui32MaxHeap[0] :
+                                                            g_ui32Oldest;
+        memcpy(ppui8Tx[ui32Taken], g_psEntries[ui32Entry].pui8Tx,
+               BLOCK_TX_LEN);
+        if(pui32Priority)
+        {
+            pui32Priority[ui32Taken] = g_psEntries[ui32Entry].ui32Priority;
+        }
+        MempoolRemove(ui32Entry);
+    }
+
+    return ui32Taken;
+}
+
+//*****************************************************************************
+//
+//! Remove up to ui32Max transactions from the pool
+//!
+//! \param ui32Order is MEMPOOL_ORDER_FIFO (oldest first) or
+//! MEMPOOL_ORDER_PRIORITY (highest priority first, oldest among equals)
+//! \param ppui8Tx receives the zero-padded transactions
+//! \param ui32Max is the number of transactions wanted
+//!
+//! \return the number of transactions removed
+//
+//*****************************************************************************
+uint32_t
+MempoolTake(uint32_t ui32Order, uint8_t (*ppui8Tx)[BLOCK_TX_LEN],
+            uint32_t ui32Max)
+{
+    return MempoolTakeEntries(ui32Order, ppui8Tx, 0, ui32Max);
+}
+
+//*****************************************************************************
+//
+//! Move transactions from the pool into a block under construction until
+//! the block or the pool is exhausted
+//!
+//! \param psBuilder is a builder started with block_begin()
+//! \param ui32Order is MEMPOOL_ORDER_FIFO or MEMPOOL_ORDER_PRIORITY
+//!
+//! The batch is remembered, with its priorities, until the next call, so
+//! that MempoolRestoreFill() can queue it again if the block is dropped.
+//!
+//! \return the number of transactions added
+//
+//*****************************************************************************
+uint32_t
+MempoolFillBlock(struct BlockBuilder *psBuilder, uint32_t ui32Order)
+{
+    uint32_t ui32Room, ui32Idx;
+
+    g_ui32Filled = 0;
+    if(psBuilder->block == NULL)
+    {
+        return 0;
+    }
+
+    ui32Room = BLOCK_MAX_TX - block_tx_count(psBuilder->block);
+    g_ui32Filled = MempoolTakeEntries(ui32Order, g_ppui8Filled,
+                                      g_pui32FilledPriority, ui32Room);
+    for(ui32Idx = 0; ui32Idx < g_ui32Filled; ui32Idx++)
+    {
+        block_add_tx(psBuilder, g_ppui8Filled[ui32Idx], BLOCK_TX_LEN);
+    }
+
+    return g_ui32Filled;
+}
+
+//*****************************************************************************
+//
+//! Queue the last batch moved by MempoolFillBlock() again
+//!
+//! \param None
+//!
+//! Call this when the block it went into is not appended. Each transaction
+//! goes back at its old priority but as the newest entry, so eviction may
+//! still turn it away if the pool has filled up since.
+//!
+//! \return the number of transactions queued again
+//
+//*****************************************************************************
+uint32_t
+MempoolRestoreFill(void)
+{
+    uint32_t ui32Idx, ui32Restored;
+
+    ui32Restored = 0;
+    for(ui32Idx = 0; ui32Idx < g_ui32Filled; ui32Idx++)
+    {
+        if(MempoolAdd(g_ppui8Filled[ui32Idx], BLOCK_TX_LEN,
+                      g_pui32FilledPriority[ui32Idx]) == MEMPOOL_ADDED)
+        {
+            ui32Restored++;
+        }
+    }
+    g_ui32Filled = 0;
+
+    return ui32Restored;
+}
+
+//*****************************************************************************
+//
+//! Number of queued transactions
+//!
+//! \param None
+//!
+//! \return the count
+//
+//*****************************************************************************
+uint32_t
+MempoolCount(void)
+{
+    return g_sStats.ui32Count;
+}
+
+//*****************************************************************************
+//
+//! Get a snapshot of the pool statistics
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MempoolStatsGet(tMempoolStats *psStats)
+{
+    *psStats = g_sStats;
+}
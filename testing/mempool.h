@@ -0,0 +1,128 @@
+//*****************************************************************************
+// mempool.h
+//
+// Pending transactions waiting for a block. Fixed static footprint:
+// transactions are deduplicated through an open-addressing hash table, the
+// pool is capped in entries and bytes, and batches are handed to the block
+// builder oldest first or highest priority first.
+//
+//*****************************************************************************
+
+#ifndef __MEMPOOL_H__
+#define __MEMPOOL_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+
+//*****************************************************************************
+//
+// Entry capacity and dedup table size (a power of two, at least twice the
+// capacity to keep probe runs short). The host build is sized for millions
+// of entries; untouched pages of the tables cost nothing there. Override
+// from the project settings.
+//
+//*****************************************************************************
+#ifndef MEMPOOL_CAPACITY
+#if defined(cc3200)
+#define MEMPOOL_CAPACITY        128
+#define MEMPOOL_TABLE_BITS      8
+#else
+#define MEMPOOL_CAPACITY        (1u << 21)
+#define MEMPOOL_TABLE_BITS      22
+#endif
+#endif
+
+#define MEMPOOL_TABLE_SIZE      (1u << MEMPOOL_TABLE_BITS)
+
+//*****************************************************************************
+//
+// Byte budget for queued transactions. Each one is charged BLOCK_TX_LEN
+// bytes, the room it will take in a block.
+//
+//*****************************************************************************
+#ifndef MEMPOOL_MAX_BYTES
+#define MEMPOOL_MAX_BYTES       (MEMPOOL_CAPACITY * BLOCK_TX_LEN)
+#endif
+
+#define MEMPOOL_NONE            0xFFFFFFFF
+
+//*****************************************************************************
+//
+// Order in which MempoolTake() hands out transactions.
+//
+//*****************************************************************************
+#define MEMPOOL_ORDER_FIFO      0
+#define MEMPOOL_ORDER_PRIORITY  1
+
+//*****************************************************************************
+//
+// Outcome of MempoolAdd().
+//
+//*****************************************************************************
+#define MEMPOOL_ADDED           0
+#define MEMPOOL_DUPLICATE       1
+#define MEMPOOL_REJECTED        2
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Bytes;
+    uint32_t ui32HighWater;
+    uint32_t ui32Added;
+    uint32_t ui32Duplicates;
+    uint32_t ui32Evicted;
+    uint32_t ui32Rejected;
+} tMempoolStats;
+
+extern void MempoolInit(void);
+extern uint32_t MempoolAdd(const uint8_t *pui8Tx, uint32_t ui32Length,
+                           uint32_t ui32Priority);
+extern bool MempoolContains(const uint8_t *pui8Tx, uint32_t ui32Length);
+extern uint32_t MempoolTake(uint32_t ui32Order,
+                            uint8_t (*ppui8Tx)[BLOCK_TX_LEN],
+                            uint32_t ui32Max);
+extern uint32_t MempoolFillBlock(struct BlockBuilder *psBuilder,
+                                 uint32_t ui32Order);
+extern uint32_t MempoolRestoreFill(void);
+extern uint32_t MempoolCount(void);
+extern void MempoolStatsGet(tMempoolStats *psStats);
+
+//*****************************************************************************
+//
+// Transaction sources: one "<priority> <transaction>" line at a time, a
+// text file of such lines on the host ("-" reads stdin, so a socket or pipe
+// can feed it), or the console UART on the board. Once the board serves
+// the framed protocol (wire.h) the console is its own, and transactions
+// arrive as WIRE_TX_SUBMIT instead.
+//
+//*****************************************************************************
+extern uint32_t MempoolAddLine(const char *pcLine);
+#if defined(cc3200)
+extern uint32_t MempoolPollUART(void);
+#else
+extern uint32_t MempoolLoadFile(const char *pcPath);
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MEMPOOL_H__
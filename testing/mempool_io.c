@@ -0,0 +1,178 @@
+//*****************************************************************************
+// mempool_io.c
+//
+// Transaction sources for the mempool
+//
+// Transactions arrive as text lines of the form "<priority> <transaction>"
+// (the priority and its separating space are optional). The board reads them
+// from the console UART without blocking; the host reads a file, or stdin so
+// that a pipe or socket relay can stand in for the radio.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(cc3200)
+#include "uart_buf.h"
+#else
+#include <stdio.h>
+#endif
+
+#include "blockchain.h"
+#include "mempool.h"
+
+//
+// Longest line accepted: a ten-digit priority, a space and a transaction.
+//
+#define MEMPOOL_LINE_LEN        (11 + BLOCK_TX_LEN + 1)
+
+//*****************************************************************************
+//
+//! Queue one transaction line
+//!
+//! \param pcLine is "<priority> <transaction>" or just "<transaction>",
+//! without the line terminator
+//!
+//! \return the MempoolAdd() status
+//
+//*****************************************************************************
+uint32_t
+MempoolAddLine(const char *pcLine)
+{
+    const char *pcTx = pcLine;
+    uint32_t ui32Priority = 0;
+
+    if((*pcTx >= '0') && (*pcTx <= '9'))
+    {
+        while((*pcTx >= '0') && (*pcTx <= '9'))
+        {
+            ui32Priority = (ui32Priority * 10) + (uint32_t)(*pcTx++ - '0');
+        }
+
+        //
+        // A bare number is a transaction, not a priority.
+        //
+        if(*pcTx == ' ')
+        {
+            pcTx++;
+        }
+        else
+        {
+            pcTx = pcLine;
+            ui32Priority = 0;
+        }
+    }
+
+    return MempoolAdd((const uint8_t *)pcTx, (uint32_t)strlen(pcTx),
+                      ui32Priority);
+}
+
+#if defined(cc3200)
+//*****************************************************************************
+//
+//! Drain the console receive ring into the mempool. Never blocks: a
+//! partial line is kept until the rest of it arrives on a later call.
+//!
+//! \param None
+//!
+//! \return the number of transactions added by this call
+//
+//*****************************************************************************
+uint32_t
+MempoolPollUART(void)
+{
+    static char pcLine[MEMPOOL_LINE_LEN + 1];
+    static uint32_t ui32Len;
+    static bool bOverflow;
+    uint32_t ui32Added = 0;
+    uint8_t ui8Char;
+
+    while(UartBufRead(&ui8Char, 1) != 0)
+    {
+        if((ui8Char == '\r') || (ui8Char == '\n'))
+        {
+            pcLine[ui32Len] = '\0';
+            if((ui32Len > 0) && !bOverflow &&
+               (MempoolAddLine(pcLine) == MEMPOOL_ADDED))
+            {
+                ui32Added++;
+            }
+            ui32Len = 0;
+            bOverflow = false;
+        }
+        else if(ui32Len < MEMPOOL_LINE_LEN)
+        {
+            pcLine[ui32Len++] = (char)ui8Char;
+        }
+        else
+        {
+            //
+            // Drop the rest of an over-long line rather than queueing a
+            // truncated transaction.
+            //
+            bOverflow = true;
+        }
+    }
+
+    return ui32Added;
+}
+#else
+//*****************************************************************************
+//
+//! Queue every transaction line of a file
+//!
+//! \param pcPath is the file, or "-" for stdin
+//!
+//! \return the number of transactions added, or 0 if the file cannot be
+//! opened
+//
+//*****************************************************************************
+uint32_t
+MempoolLoadFile(const char *pcPath)
+{
+    char pcLine[MEMPOOL_LINE_LEN + 2];
+    FILE *psFile;
+    uint32_t ui32Added = 0;
+    size_t szLen;
+    bool bOverflow = false;
+
+    psFile = (strcmp(pcPath, "-") == 0) ? stdin : fopen(pcPath, "r");
+    if(psFile == NULL)
+    {
+        return 0;
+    }
+
+    while(fgets(pcLine, sizeof(pcLine), psFile) != NULL)
+    {
+        szLen = strlen(pcLine);
+        if((szLen > 0) && (pcLine[szLen - 1] != '\n') && !feof(psFile))
+        {
+            //
+            // Over-long line: skip it up to its end.
+            //
+            bOverflow = true;
+            continue;
+        }
+        while((szLen > 0) &&
+              ((pcLine[szLen - 1] == '\n') || (pcLine[szLen - 1] == '\r')))
+        {
+            pcLine[--szLen] = '\0';
+        }
+        if((szLen > 0) && !bOverflow &&
+           (MempoolAddLine(pcLine) == MEMPOOL_ADDED))
+        {
+            ui32Added++;
+        }
+        bOverflow = false;
+    }
+
+    if(psFile != stdin)
+    {
+        fclose(psFile);
+    }
+
+    return ui32Added;
+}
+#endif
@@ -0,0 +1,319 @@
+//*****************************************************************************
+// merkle.c
+//
+// Incremental Merkle tree with inclusion proofs
+//
+// The nodes are stored level by level in one caller-supplied array: level 0
+// holds the leaf hashes, level 1 their parents, and so on. Each level is
+// sized for a full tree of the configured capacity.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "merkle.h"
+
+static void
+MerkleHashLeaf(const uint8_t *pui8Leaf, uint32_t ui32Length,
+               uint8_t *pui8Hash)
+{
+    static const uint8_t ui8Prefix = MERKLE_LEAF_PREFIX;
+    tHashContext sCtx;
+
+    HashInit(&sCtx, SHAMD5_ALGO_SHA256);
+    HashUpdate(&sCtx, &ui8Prefix, 1);
+    HashUpdate(&sCtx, pui8Leaf, ui32Length);
+    HashFinal(&sCtx, pui8Hash);
+}
+
+static void
+MerkleHashNode(const uint8_t *pui8Left, const uint8_t *pui8Right,
+               uint8_t *pui8Hash)
+{
+    static const uint8_t ui8Prefix = MERKLE_NODE_PREFIX;
+    tHashContext sCtx;
+
+    HashInit(&sCtx, SHAMD5_ALGO_SHA256);
+    HashUpdate(&sCtx, &ui8Prefix, 1);
+    HashUpdate(&sCtx, pui8Left, MERKLE_HASH_LEN);
+    HashUpdate(&sCtx, pui8Right, MERKLE_HASH_LEN);
+    HashFinal(&sCtx, pui8Hash);
+}
+
+//*****************************************************************************
+//
+//! Start an empty tree
+//!
+//! \param psTree is the tree
+//! \param ppui8Nodes is node storage of MERKLE_NODES(ui32Capacity) entries
+//! \param ui32Capacity is the largest number of leaves
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MerkleInit(tMerkleTree *psTree, uint8_t (*ppui8Nodes)[MERKLE_HASH_LEN],
+           uint32_t ui32Capacity)
+{
+    psTree->ppui8Nodes = ppui8Nodes;
+    psTree->ui32Capacity = ui32Capacity;
+    psTree->ui32Leaves = 0;
+
+    //
+    // The root of no leaves is the hash of nothing, as in RFC 6962.
+    //
+    GenerateHash(SHAMD5_ALGO_SHA256, (unsigned char *)"", psTree->pui8Root,
+                 0);
+}
+
+//*****************************************************************************
+//
+//! Append a leaf and update the root. Only the new leaf's ancestors are
+//! recomputed, one hash per level.
+//!
+//! \param psTree is the tree
+//! \param pui8Leaf is the leaf data (a transaction)
+//! \param ui32Length is the leaf length in bytes
+//!
+//! \return false if the tree is full
+//
+//*****************************************************************************
+bool
+MerkleAppend(tMerkleTree *psTree, const uint8_t *pui8Leaf,
+             uint32_t ui32Length)
+{
+    uint32_t ui32Index, ui32Size, ui32Offset, ui32Level;
+
+    if(psTree->ui32Leaves >= psTree->ui32Capacity)
+    {
+        return false;
+    }
+
+    ui32Index = psTree->ui32Leaves++;
+    ui32Size = psTree->ui32Leaves;
+    ui32Offset = 0;
+    ui32Level = psTree->ui32Capacity;
+    MerkleHashLeaf(pui8Leaf, ui32Length, psTree->ppui8Nodes[ui32Index]);
+
+    while(ui32Size > 1)
+    {
+        //
+        // The new node is always the last one of its level: either it
+        // completes a pair or it is carried up alone.
+        //
+        if(ui32Index & 1)
+        {
+            MerkleHashNode(psTree->ppui8Nodes[ui32Offset + ui32Index - 1],
+                           psTree->ppui8Nodes[ui32Offset + ui32Index],
+                           psTree->ppui8Nodes[ui32Offset + ui32Level +
+                                              (ui32Index >> 1)]);
+        }
+        else
+        {
+            memcpy(psTree->ppui8Nodes[ui32Offset + ui32Level +
+                                      (ui32Index >> 1)],
+                   psTree->ppui8Nodes[ui32Offset + ui32Index],
+                   MERKLE_HASH_LEN);
+        }
+        ui32Offset += ui32Level;
+        ui32Level = (ui32Level + 1) / 2;
+        ui32Size = (ui32Size + 1) / 2;
+        ui32Index >>= 1;
+    }
+
+    memcpy(psTree->pui8Root, psTree->ppui8Nodes[ui32Offset + ui32Index],
+           MERKLE_HASH_LEN);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Number of leaves
+//!
+//! \param psTree is the tree
+//!
+//! \return the leaf count
+//
+//*****************************************************************************
+uint32_t
+MerkleLeafCount(const tMerkleTree *psTree)
+{
+    return psTree->ui32Leaves;
+}
+
+//*****************************************************************************
+//
+//! Current root
+//!
+//! \param psTree is the tree
+//!
+//! \return the root hash, valid until the next append
+//
+//*****************************************************************************
+const uint8_t *
+MerkleRoot(const tMerkleTree *psTree)
+{
+    return psTree->pui8Root;
+}
+
+//*****************************************************************************
+//
+//! Build the inclusion proof of a leaf: the sibling on each level where the
+//! path has one
+//!
+//! \param psTree is the tree
+//! \param ui32Index is the leaf index
+//! \param psProof receives the proof
+//!
+//! \return false if the leaf does not exist
+//
+//*****************************************************************************
+bool
+MerkleProve(const tMerkleTree *psTree, uint32_t ui32Index,
+            tMerkleProof *psProof)
+{
+    uint32_t ui32Size = psTree->ui32Leaves;
+    uint32_t ui32Offset = 0;
+    uint32_t ui32Level = psTree->ui32Capacity;
+    uint32_t ui32Sibling;
+
+    if(ui32Index >= psTree->ui32Leaves)
+    {
+        return false;
+    }
+
+    psProof->ui32Steps = 0;
+    while(ui32Size > 1)
+    {
+        ui32Sibling = ui32Index ^ 1;
+        if(ui32Sibling < ui32Size)
+        {
+            memcpy(psProof->ppui8Sibling[psProof->ui32Steps++],
+                   psTree->ppui8Nodes[ui32Offset + ui32Sibling],
+                   MERKLE_HASH_LEN);
+        }
+        ui32Offset += ui32Level;
+        ui32Level = (ui32Level + 1) / 2;
+        ui32Size = (ui32Size + 1) / 2;
+        ui32Index >>= 1;
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Check an inclusion proof
+//!
+//! \param pui8Root is the trusted root (e.g. from a block header)
+//! \param pui8Leaf is the leaf data
+//! \param ui32Length is the leaf length in bytes
+//! \param ui32Index is the leaf's index
+//! \param ui32Leaves is the number of leaves under the root
+//! \param psProof is the proof
+//!
+//! \return true if the leaf is at ui32Index in the tree with that root
+//
+//*****************************************************************************
+bool
+MerkleVerify(const uint8_t *pui8Root, const uint8_t *pui8Leaf,
+             uint32_t ui32Length, uint32_t ui32Index, uint32_t ui32Leaves,
+             const tMerkleProof *psProof)
+{
+    uint8_t pui8Hash[MERKLE_HASH_LEN];
+    uint32_t ui32Step = 0;
+
+    if((ui32Index >= ui32Leaves) || (psProof->ui32Steps > MERKLE_MAX_DEPTH))
+    {
+        return false;
+    }
+
+    MerkleHashLeaf(pui8Leaf, ui32Length, pui8Hash);
+    while(ui32Leaves > 1)
+    {
+        if(ui32Index & 1)
+        {
+            if(ui32Step >= psProof->ui32Steps)
+            {
+                return false;
+            }
+            MerkleHashNode(psProof->ppui8Sibling[ui32Step++], pui8Hash,
+                           pui8Hash);
+        }
+        else if(ui32Index + 1 < ui32Leaves)
+        {
+            if(ui32Step >= psProof->ui32Steps)
+            {
+                return false;
+            }
+            MerkleHashNode(pui8Hash, psProof->ppui8Sibling[ui32Step++],
+                           pui8Hash);
+        }
+        ui32Leaves = (ui32Leaves + 1) / 2;
+        ui32Index >>= 1;
+    }
+
+    return (ui32Step == psProof->ui32Steps) &&
+           (memcmp(pui8Hash, pui8Root, MERKLE_HASH_LEN) == 0);
+}
+
+//*****************************************************************************
+//
+//! Compute the root of a list of fixed-size leaves without keeping a tree.
+//! Completed subtrees are merged on a stack as they fill, so the scratch
+//! space is one hash per level.
+//!
+//! \param pui8Leaves is the leaf data, laid out back to back
+//! \param ui32LeafLength is the size of each leaf in bytes
+//! \param ui32Leaves is the number of leaves (at most 2^MERKLE_MAX_DEPTH)
+//! \param pui8Root receives the root
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MerkleRootOf(const uint8_t *pui8Leaves, uint32_t ui32LeafLength,
+             uint32_t ui32Leaves, uint8_t *pui8Root)
+{
+    uint8_t ppui8Stack[MERKLE_MAX_DEPTH + 1][MERKLE_HASH_LEN];
+    uint32_t ui32Depth = 0;
+    uint32_t ui32Leaf, ui32Merge;
+
+    if(ui32Leaves == 0)
+    {
+        GenerateHash(SHAMD5_ALGO_SHA256, (unsigned char *)"", pui8Root, 0);
+        return;
+    }
+
+    for(ui32Leaf = 0; ui32Leaf < ui32Leaves; ui32Leaf++)
+    {
+        MerkleHashLeaf(pui8Leaves + (ui32Leaf * ui32LeafLength),
+                       ui32LeafLength, ppui8Stack[ui32Depth++]);
+
+        //
+        // One merge per trailing one bit of the new leaf count: those are
+        // the subtrees this leaf just completed.
+        //
+        for(ui32Merge = ui32Leaf + 1; !(ui32Merge & 1); ui32Merge >>= 1)
+        {
+            ui32Depth--;
+            MerkleHashNode(ppui8Stack[ui32Depth - 1], ppui8Stack[ui32Depth],
+                           ppui8Stack[ui32Depth - 1]);
+        }
+    }
+
+    //
+    // Fold the incomplete right edge, smallest subtree first.
+    //
+    while(ui32Depth > 1)
+    {
+        ui32Depth--;
+        MerkleHashNode(ppui8Stack[ui32Depth - 1], ppui8Stack[ui32Depth],
+                       ppui8Stack[ui32Depth - 1]);
+    }
+    memcpy(pui8Root, ppui8Stack[0], MERKLE_HASH_LEN);
+}
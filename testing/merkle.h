@@ -0,0 +1,101 @@
+//*****************************************************************************
+// merkle.h
+//
+// Append-only Merkle tree over a block's transactions. Appending a leaf
+// re-hashes only the path from that leaf to the root, and any leaf can be
+// proven against the root with an inclusion proof.
+//
+//*****************************************************************************
+
+#ifndef __MERKLE_H__
+#define __MERKLE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MERKLE_HASH_LEN         32
+
+//*****************************************************************************
+//
+// Domain separation: a leaf hash is SHA-256(0x00 || leaf), an interior node
+// SHA-256(0x01 || left || right). A node whose level has an odd count is
+// carried up unchanged.
+//
+//*****************************************************************************
+#define MERKLE_LEAF_PREFIX      0x00
+#define MERKLE_NODE_PREFIX      0x01
+
+//*****************************************************************************
+//
+// Deepest tree supported (2^16 leaves). Bounds the proof size and the
+// scratch space of MerkleRootOf().
+//
+//*****************************************************************************
+#define MERKLE_MAX_DEPTH        16
+
+//*****************************************************************************
+//
+// Node storage needed for a tree of ui32Leaves leaves: every level is kept
+// so that proofs can be produced for any leaf.
+//
+//*****************************************************************************
+#define MERKLE_NODES(ui32Leaves) ((2 * (ui32Leaves)) + MERKLE_MAX_DEPTH)
+
+//*****************************************************************************
+//
+// Tree shape. Leaves are hashed as H(0x00 || leaf) and interior nodes as
+// H(0x01 || left || right), so a leaf can never be passed off as a node. A
+// node without a right sibling is carried up unchanged, which gives the same
+// root as RFC 6962 for any leaf count.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t (*ppui8Nodes)[MERKLE_HASH_LEN];
+    uint32_t ui32Capacity;
+    uint32_t ui32Leaves;
+    uint8_t pui8Root[MERKLE_HASH_LEN];
+} tMerkleTree;
+
+typedef struct
+{
+    uint32_t ui32Steps;
+    uint8_t ppui8Sibling[MERKLE_MAX_DEPTH][MERKLE_HASH_LEN];
+} tMerkleProof;
+
+extern void MerkleInit(tMerkleTree *psTree,
+                       uint8_t (*ppui8Nodes)[MERKLE_HASH_LEN],
+                       uint32_t ui32Capacity);
+extern bool MerkleAppend(tMerkleTree *psTree, const uint8_t *pui8Leaf,
+                         uint32_t ui32Length);
+extern uint32_t MerkleLeafCount(const tMerkleTree *psTree);
+extern const uint8_t *MerkleRoot(const tMerkleTree *psTree);
+extern bool MerkleProve(const tMerkleTree *psTree, uint32_t ui32Index,
+                        tMerkleProof *psProof);
+extern bool MerkleVerify(const uint8_t *pui8Root, const uint8_t *pui8Leaf,
+                         uint32_t ui32Length, uint32_t ui32Index,
+                         uint32_t ui32Leaves, const tMerkleProof *psProof);
+extern void MerkleRootOf(const uint8_t *pui8Leaves, uint32_t ui32LeafLength,
+                         uint32_t ui32Leaves, uint8_t *pui8Root);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MERKLE_H__
@@ -0,0 +1,430 @@
+//*****************************************************************************
+// miner.c
+//
+// Proof-of-work nonce search
+//
+// With the software engine each attempt is a single SHA-256 compression of a
+// pre-padded tail block against the saved midstate, run one nonce per lane
+// of the multi-buffer kernel. With the SHAMD5 engine
+// the midstate context is resumed in the hardware and only the tail is fed.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+#include "hash_sw_mb.h"
+#include "blockchain.h"
+#include "block_auth.h"
+#include "perf_clock.h"
+#include "miner.h"
+
+//
+// Header bytes after the first 64-byte block.
+//
+#define MINER_TAIL_LEN          (BLOCK_HEADER_LEN - 64)
+#define MINER_TAIL_OFS_TIME     (BLOCK_HDR_OFS_TIME - 64)
+#define MINER_TAIL_OFS_NONCE    (BLOCK_HDR_OFS_NONCE - 64)
+
+static void
+MinerPutLE32(uint8_t *pui8Dst, uint32_t ui32Value)
+{
+    pui8Dst[0] = (uint8_t)ui32Value;
+    pui8Dst[1] = (uint8_t)(ui32Value >> 8);
+    pui8Dst[2] = (uint8_t)(ui32Value >> 16);
+    pui8Dst[3] = (uint8_t)(ui32Value >> 24);
+}
+
+//*****************************************************************************
+//
+//! Build a target from a difficulty in leading zero bits
+//!
+//! \param ui32Bits is the number of leading zero bits required (0 to 256)
+//! \param pui8Target receives the 32-byte big-endian target
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerTargetFromBits(uint32_t ui32Bits, uint8_t *pui8Target)
+{
+    uint32_t ui32Byte;
+
+    if(ui32Bits > 256)
+    {
+        ui32Bits = 256;
+    }
+    memset(pui8Target, 0xff, BLOCK_HASH_LEN);
+    memset(pui8Target, 0, ui32Bits / 8);
+    ui32Byte = ui32Bits / 8;
+    if(ui32Byte < BLOCK_HASH_LEN)
+    {
+        pui8Target[ui32Byte] = (uint8_t)(0xff >> (ui32Bits % 8));
+    }
+}
+
+//*****************************************************************************
+//
+//! Compare a hash against a target, both read as big-endian numbers
+//!
+//! \param pui8Hash is the block hash
+//! \param pui8Target is the target
+//!
+//! \return true if the hash does not exceed the target
+//
+//*****************************************************************************
+bool
+MinerMeetsTarget(const uint8_t *pui8Hash, const uint8_t *pui8Target)
+{
+    return memcmp(pui8Hash, pui8Target, BLOCK_HASH_LEN) <= 0;
+}
+
+//*****************************************************************************
+//
+//! Precompute the hash state of the fixed part of a header
+//!
+//! \param psMiner is the mining state
+//! \param psHdr is the header; its timestamp and nonce may change later
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerPrepare(tMiner *psMiner, const struct BlockHeader *psHdr)
+{
+    uint8_t pui8Raw[BLOCK_HEADER_LEN];
+
+    block_header_serialize(psHdr, pui8Raw);
+
+    HashInit(&psMiner->sMidstate, SHAMD5_ALGO_SHA256);
+    HashUpdate(&psMiner->sMidstate, pui8Raw, 64);
+
+    //
+    // Lay the tail out as a finished SHA-256 block so that the software
+    // kernel can compress it directly.
+    //
+    memset(psMiner->pui8Tail, 0, sizeof(psMiner->pui8Tail));
+    memcpy(psMiner->pui8Tail, pui8Raw + 64, MINER_TAIL_LEN);
+    psMiner->pui8Tail[MINER_TAIL_LEN] = 0x80;
+    psMiner->pui8Tail[62] = (uint8_t)((BLOCK_HEADER_LEN * 8) >> 8);
+    psMiner->pui8Tail[63] = (uint8_t)(BLOCK_HEADER_LEN * 8);
+}
+
+//*****************************************************************************
+//
+//! Change the timestamp of a prepared header
+//!
+//! \param psMiner is the mining state
+//! \param ui32Time is the new timestamp
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerSetTime(tMiner *psMiner, uint32_t ui32Time)
+{
+    MinerPutLE32(psMiner->pui8Tail + MINER_TAIL_OFS_TIME, ui32Time);
+}
+
+#if defined(HASH_ENGINE_SW)
+//*****************************************************************************
+//
+// One attempt: compress the tail block into a copy of the midstate.
+//
+//*****************************************************************************
+static void
+MinerHashTail(const tMiner *psMiner, uint8_t *pui8Block, uint8_t *pui8Hash)
+{
+    uint32_t pui32State[8];
+    uint32_t i;
+
+    memcpy(pui32State, psMiner->sMidstate.pui32State, sizeof(pui32State));
+    SWSHA256Blocks(pui32State, pui8Block, 1);
+    for(i = 0; i < 8; i++)
+    {
+        pui8Hash[(i * 4) + 0] = (uint8_t)(pui32State[i] >> 24);
+        pui8Hash[(i * 4) + 1] = (uint8_t)(pui32State[i] >> 16);
+        pui8Hash[(i * 4) + 2] = (uint8_t)(pui32State[i] >> 8);
+        pui8Hash[(i * 4) + 3] = (uint8_t)(pui32State[i]);
+    }
+}
+#else
+//*****************************************************************************
+//
+// One attempt: resume the midstate in the engine and feed the tail.
+//
+//*****************************************************************************
+static void
+MinerHashTail(const tMiner *psMiner, uint8_t *pui8Block, uint8_t *pui8Hash)
+{
+    tHashContext sCtx;
+
+    HashClone(&sCtx, &psMiner->sMidstate);
+    HashUpdate(&sCtx, pui8Block, MINER_TAIL_LEN);
+    HashFinal(&sCtx, pui8Hash);
+}
+#endif
+
+//*****************************************************************************
+//
+//! Hash a prepared header with a given nonce
+//!
+//! \param psMiner is the mining state
+//! \param ui32Nonce is the nonce
+//! \param pui8Hash receives the block hash
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerHashNonce(const tMiner *psMiner, uint32_t ui32Nonce, uint8_t *pui8Hash)
+{
+    uint8_t pui8Block[64];
+
+    memcpy(pui8Block, psMiner->pui8Tail, sizeof(pui8Block));
+    MinerPutLE32(pui8Block + MINER_TAIL_OFS_NONCE, ui32Nonce);
+    MinerHashTail(psMiner, pui8Block, pui8Hash);
+}
+
+//*****************************************************************************
+//
+//! Search a range of nonces for a hash meeting the target
+//!
+//! \param psMiner is the prepared mining state
+//! \param pui8Target is the target
+//! \param ui32Start is the first nonce to try
+//! \param ui32Count is the number of nonces to try
+//! \param psResult receives the outcome and the attempt count and time
+//!
+//! \return true if a nonce was found
+//
+//*****************************************************************************
+bool
+MinerSearch(const tMiner *psMiner, const uint8_t *pui8Target,
+            uint32_t ui32Start, uint32_t ui32Count, tMinerResult *psResult)
+{
+#if defined(HASH_ENGINE_SW)
+    const tSWSHA256MBKernel *psKernel = SWSHA256MBKernel();
+    uint8_t ppui8Block[SW_SHA256_MB_MAX_LANES][64];
+    const uint8_t *ppui8Blocks[SW_SHA256_MB_MAX_LANES];
+    uint32_t ppui32State[SW_SHA256_MB_MAX_LANES][8];
+    uint32_t ui32Target0, ui32Lanes, l, i;
+#else
+    uint8_t pui8Block[64];
+#endif
+    uint64_t ui64Start;
+    uint32_t ui32Nonce = ui32Start;
+    uint32_t ui32Tried = 0;
+
+    psResult->bFound = false;
+    ui64Start = PerfClockNow();
+
+#if defined(HASH_ENGINE_SW)
+    //
+    // Try one nonce per kernel lane. The first target word rejects nearly
+    // every candidate before the digest is serialized.
+    //
+    ui32Target0 = ((uint32_t)pui8Target[0] << 24) |
+                  ((uint32_t)pui8Target[1] << 16) |
+                  ((uint32_t)pui8Target[2] << 8) | (uint32_t)pui8Target[3];
+    for(l = 0; l < psKernel->ui32Lanes; l++)
+    {
+        memcpy(ppui8Block[l], psMiner->pui8Tail, 64);
+        ppui8Blocks[l] = ppui8Block[l];
+    }
+    while(ui32Tried < ui32Count)
+    {
+        ui32Lanes = ui32Count - ui32Tried;
+        if(ui32Lanes > psKernel->ui32Lanes)
+        {
+            ui32Lanes = psKernel->ui32Lanes;
+        }
+        for(l = 0; l < psKernel->ui32Lanes; l++)
+        {
+            memcpy(ppui32State[l], psMiner->sMidstate.pui32State,
+                   sizeof(ppui32State[l]));
+            MinerPutLE32(ppui8Block[l] + MINER_TAIL_OFS_NONCE, ui32Nonce + l);
+        }
+        psKernel->pfnCompress(ppui32State, ppui8Blocks);
+
+        for(l = 0; l < ui32Lanes; l++)
+        {
+            if(ppui32State[l][0] > ui32Target0)
+            {
+                continue;
+            }
+            for(i = 0; i < 8; i++)
+            {
+                psResult->pui8Hash[(i * 4) + 0] =
+                    (uint8_t)(ppui32State[l][i] >> 24);
+                psResult->pui8Hash[(i * 4) + 1] =
+                    (uint8_t)(ppui32State[l][i] >> 16);
+                psResult->pui8Hash[(i * 4) + 2] =
+                    (uint8_t)(ppui32State[l][i] >> 8);
+                psResult->pui8Hash[(i * 4) + 3] = (uint8_t)(ppui32State[l][i]);
+            }
+            if(MinerMeetsTarget(psResult->pui8Hash, pui8Target))
+            {
+                psResult->bFound = true;
+                psResult->ui32Nonce = ui32Nonce + l;
+                ui32Tried += l + 1;
+                break;
+            }
+        }
+        if(psResult->bFound)
+        {
+            break;
+        }
+        ui32Tried += ui32Lanes;
+        ui32Nonce += ui32Lanes;
+    }
+#else
+    memcpy(pui8Block, psMiner->pui8Tail, sizeof(pui8Block));
+    for(; ui32Tried < ui32Count; ui32Tried++, ui32Nonce++)
+    {
+        MinerPutLE32(pui8Block + MINER_TAIL_OFS_NONCE, ui32Nonce);
+        MinerHashTail(psMiner, pui8Block, psResult->pui8Hash);
+        if(MinerMeetsTarget(psResult->pui8Hash, pui8Target))
+        {
+            psResult->bFound = true;
+            psResult->ui32Nonce = ui32Nonce;
+            ui32Tried++;
+            break;
+        }
+    }
+#endif
+    psResult->ui32Hashes = ui32Tried;
+    psResult->ui64Ticks = PerfClockNow() - ui64Start;
+
+    return psResult->bFound;
+}
+
+//*****************************************************************************
+//
+//! Mine a block with a given nonce search: search nonces until its hash
+//! meets the target. When the nonce space runs out the timestamp is advanced
+//! and the search restarts.
+//!
+//! \param psBlock is the block; its header nonce, timestamp and hash are
+//! updated when a solution is found, and its tag in an authenticated chain
+//! \param pui8Target is the target
+//! \param ui32MaxTries bounds the total attempts
+//! \param pfnSearch searches one nonce range (MinerSearch or a parallel
+//! equivalent)
+//! \param psResult receives the outcome, total attempts and time
+//!
+//! \return true if the block was mined
+//
+//*****************************************************************************
+bool
+MinerMineBlockWith(struct Block *psBlock, const uint8_t *pui8Target,
+                   uint32_t ui32MaxTries, tMinerSearchFn pfnSearch,
+                   tMinerResult *psResult)
+{
+    tMiner sMiner;
+    tMinerResult sPass;
+    uint32_t ui32Left = ui32MaxTries;
+    uint32_t ui32Count;
+    uint64_t ui64Next;
+
+    memset(psResult, 0, sizeof(*psResult));
+    MinerPrepare(&sMiner, &psBlock->header);
+
+    //
+    // The next nonce to try, kept in 64 bits so that 0xFFFFFFFF is tried
+    // too: the space is used up when it reaches 2^32.
+    //
+    ui64Next = psBlock->header.nonce;
+    while(ui32Left)
+    {
+        if(ui64Next > 0xFFFFFFFFu)
+        {
+            psBlock->header.time++;
+            psBlock->header.nonce = 0;
+            ui64Next = 0;
+            MinerSetTime(&sMiner, psBlock->header.time);
+            continue;
+        }
+        ui32Count = ui32Left;
+        if(ui32Count > (0x100000000ull - ui64Next))
+        {
+            ui32Count = (uint32_t)(0x100000000ull - ui64Next);
+        }
+
+        pfnSearch(&sMiner, pui8Target, (uint32_t)ui64Next, ui32Count,
+                  &sPass);
+        psResult->ui32Hashes += sPass.ui32Hashes;
+        psResult->ui64Ticks += sPass.ui64Ticks;
+        ui32Left -= sPass.ui32Hashes;
+
+        if(sPass.bFound)
+        {
+            psBlock->header.nonce = sPass.ui32Nonce;
+            memcpy(psBlock->hash, sPass.pui8Hash, BLOCK_HASH_LEN);
+            psResult->bFound = true;
+            psResult->ui32Nonce = sPass.ui32Nonce;
+            memcpy(psResult->pui8Hash, sPass.pui8Hash, BLOCK_HASH_LEN);
+            break;
+        }
+        ui64Next += sPass.ui32Hashes;
+        psBlock->header.nonce = (uint32_t)ui64Next;
+    }
+
+    //
+    // Keep the stored hash in step with the header even when no solution
+    // was found.
+    //
+    if(!psResult->bFound)
+    {
+        block_hash_header(&psBlock->header, psBlock->hash);
+    }
+
+    //
+    // The nonce changed the hash, so in an authenticated chain the block is
+    // tagged again.
+    //
+    if(BlockAuthEnabled())
+    {
+        BlockAuthSign(psBlock);
+    }
+
+    return psResult->bFound;
+}
+
+//*****************************************************************************
+//
+//! Mine a block on the calling thread
+//!
+//! \param psBlock is the block
+//! \param pui8Target is the target
+//! \param ui32MaxTries bounds the total attempts
+//! \param psResult receives the outcome, total attempts and time
+//!
+//! \return true if the block was mined
+//
+//*****************************************************************************
+bool
+MinerMineBlock(struct Block *psBlock, const uint8_t *pui8Target,
+               uint32_t ui32MaxTries, tMinerResult *psResult)
+{
+    return MinerMineBlockWith(psBlock, pui8Target, ui32MaxTries, MinerSearch,
+                              psResult);
+}
+
+//*****************************************************************************
+//
+//! Attempts per second of a search
+//!
+//! \param psResult is the search outcome
+//!
+//! \return hashes per second
+//
+//*****************************************************************************
+uint64_t
+MinerHashRate(const tMinerResult *psResult)
+{
+    return PerfClockRate(psResult->ui32Hashes, psResult->ui64Ticks);
+}
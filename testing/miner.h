@@ -0,0 +1,91 @@
+//*****************************************************************************
+// miner.h
+//
+// Proof-of-work nonce search over the serialized block header
+//
+//*****************************************************************************
+
+#ifndef __MINER_H__
+#define __MINER_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hash_engine.h"
+#include "blockchain.h"
+
+//*****************************************************************************
+//
+// Default difficulty as a count of leading zero bits in the block hash.
+// Override from the project settings.
+//
+//*****************************************************************************
+#ifndef MINER_DEFAULT_BITS
+#define MINER_DEFAULT_BITS      12
+#endif
+
+//*****************************************************************************
+//
+// Mining state for one header. The first 64 header bytes never change while
+// searching, so their hash state is computed once in MinerPrepare(); each
+// attempt only hashes the 20-byte tail holding the timestamp and nonce.
+//
+//*****************************************************************************
+typedef struct
+{
+    tHashContext sMidstate;
+    uint8_t pui8Tail[64];
+} tMiner;
+
+typedef struct
+{
+    bool bFound;
+    uint32_t ui32Nonce;
+    uint32_t ui32Hashes;
+    uint64_t ui64Ticks;
+    uint8_t pui8Hash[BLOCK_HASH_LEN];
+} tMinerResult;
+
+typedef bool (*tMinerSearchFn)(const tMiner *psMiner,
+                               const uint8_t *pui8Target, uint32_t ui32Start,
+                               uint32_t ui32Count, tMinerResult *psResult);
+
+extern void MinerTargetFromBits(uint32_t ui32Bits, uint8_t *pui8Target);
+extern bool MinerMeetsTarget(const uint8_t *pui8Hash,
+                             const uint8_t *pui8Target);
+extern void MinerPrepare(tMiner *psMiner, const struct BlockHeader *psHdr);
+extern void MinerSetTime(tMiner *psMiner, uint32_t ui32Time);
+extern void MinerHashNonce(const tMiner *psMiner, uint32_t ui32Nonce,
+                           uint8_t *pui8Hash);
+extern bool MinerSearch(const tMiner *psMiner, const uint8_t *pui8Target,
+                        uint32_t ui32Start, uint32_t ui32Count,
+                        tMinerResult *psResult);
+extern bool MinerMineBlockWith(struct Block *psBlock,
+                               const uint8_t *pui8Target,
+                               uint32_t ui32MaxTries, tMinerSearchFn pfnSearch,
+                               tMinerResult *psResult);
+extern bool MinerMineBlock(struct Block *psBlock, const uint8_t *pui8Target,
+                           uint32_t ui32MaxTries, tMinerResult *psResult);
+extern uint64_t MinerHashRate(const tMinerResult *psResult);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MINER_H__
@@ -0,0 +1,409 @@
+//*****************************************************************************
+// miner_mt.c
+//
+// Parallel nonce search with work stealing (host build only)
+//
+// The nonce range is split evenly across the threads. Each thread claims
+// MINER_MT_BATCH nonces at a time from the front of its own range; a thread
+// whose range is empty steals the back half of the largest remaining range.
+// The first thread to find a solution raises a flag that the others check
+// between batches.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "blockchain.h"
+#include "perf_clock.h"
+#include "miner.h"
+#include "miner_mt.h"
+
+//*****************************************************************************
+//
+// Per-thread range [ui64Next, ui64End), guarded by sLock. The owner takes
+// from the front, thieves from the back.
+//
+//*****************************************************************************
+typedef struct sMinerMTSearch tMinerMTSearch;
+
+typedef struct
+{
+    pthread_mutex_t sLock;
+    uint64_t ui64Next;
+    uint64_t ui64End;
+    uint32_t ui32Hashes;
+    pthread_t sThread;
+    tMinerMTSearch *psSearch;
+} tMinerMTWorker;
+
+struct sMinerMTSearch
+{
+    const tMiner *psMiner;
+    const uint8_t *pui8Target;
+    uint32_t ui32Threads;
+    bool bFound;
+    pthread_mutex_t sResultLock;
+    tMinerResult *psResult;
+    tMinerMTWorker psWorkers[MINER_MT_MAX_THREADS];
+};
+
+static uint32_t g_ui32Threads;
+
+//*****************************************************************************
+//
+//! Number of online processors
+//!
+//! \param None
+//!
+//! \return the processor count, at least 1
+//
+//*****************************************************************************
+uint32_t
+MinerMTCPUCount(void)
+{
+    long lCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if(lCount < 1)
+    {
+        return 1;
+    }
+    if(lCount > MINER_MT_MAX_THREADS)
+    {
+        return MINER_MT_MAX_THREADS;
+    }
+
+    return (uint32_t)lCount;
+}
+
+//*****************************************************************************
+//
+//! Set the thread count of MinerMTSearch()
+//!
+//! \param ui32Threads is the thread count; 0 selects one per processor
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerMTSetThreads(uint32_t ui32Threads)
+{
+    if(ui32Threads > MINER_MT_MAX_THREADS)
+    {
+        ui32Threads = MINER_MT_MAX_THREADS;
+    }
+    g_ui32Threads = ui32Threads;
+}
+
+//*****************************************************************************
+//
+//! Thread count used by MinerMTSearch()
+//!
+//! \param None
+//!
+//! \return the thread count
+//
+//*****************************************************************************
+uint32_t
+MinerMTGetThreads(void)
+{
+    return g_ui32Threads ? g_ui32Threads : MinerMTCPUCount();
+}
+
+//*****************************************************************************
+//
+// Claim the next batch from a worker's own range.
+//
+//*****************************************************************************
+static bool
+MinerMTClaim(tMinerMTWorker *psWorker, uint64_t *pui64Start,
+             uint32_t *pui32Count)
+{
+    bool bClaimed = false;
+    uint64_t ui64Count;
+
+    pthread_mutex_lock(&psWorker->sLock);
+    if(psWorker->ui64Next < psWorker->ui64End)
+    {
+        ui64Count = psWorker->ui64End - psWorker->ui64Next;
+        if(ui64Count > MINER_MT_BATCH)
+        {
+            ui64Count = MINER_MT_BATCH;
+        }
+        *pui64Start = psWorker->ui64Next;
+        *pui32Count = (uint32_t)ui64Count;
+        psWorker->ui64Next += ui64Count;
+        bClaimed = true;
+    }
+    pthread_mutex_unlock(&psWorker->sLock);
+
+    return bClaimed;
+}
+
+//*****************************************************************************
+//
+// Refill an empty worker with the back half of the largest range left.
+//
+//*****************************************************************************
+static bool
+MinerMTSteal(tMinerMTWorker *psThief)
+{
+    tMinerMTSearch *psSearch = psThief->psSearch;
+    tMinerMTWorker *psVictim;
+    uint64_t ui64Best, ui64Left, ui64Split, ui64End;
+    uint32_t ui32Index, ui32Best;
+
+    for(;;)
+    {
+        ui64Best = 0;
+        ui32Best = 0;
+        for(ui32Index = 0; ui32Index < psSearch->ui32Threads; ui32Index++)
+        {
+            psVictim = &psSearch->psWorkers[ui32Index];
+            pthread_mutex_lock(&psVictim->sLock);
+            ui64Left = psVictim->ui64End - psVictim->ui64Next;
+            pthread_mutex_unlock(&psVictim->sLock);
+            if(ui64Left > ui64Best)
+            {
+                ui64Best = ui64Left;
+                ui32Best = ui32Index;
+            }
+        }
+        if(ui64Best == 0)
+        {
+            return false;
+        }
+
+        //
+        // The victim may have moved on since the scan; retry if it ran dry.
+        //
+        psVictim = &psSearch->psWorkers[ui32Best];
+        pthread_mutex_lock(&psVictim->sLock);
+        ui64Left = psVictim->ui64End - psVictim->ui64Next;
+        if(ui64Left == 0)
+        {
+            pthread_mutex_unlock(&psVictim->sLock);
+            continue;
+        }
+        ui64End = psVictim->ui64End;
+        ui64Split = psVictim->ui64Next + (ui64Left / 2);
+        psVictim->ui64End = ui64Split;
+        pthread_mutex_unlock(&psVictim->sLock);
+
+        pthread_mutex_lock(&psThief->sLock);
+        psThief->ui64Next = ui64Split;
+        psThief->ui64End = ui64End;
+        pthread_mutex_unlock(&psThief->sLock);
+
+        return true;
+    }
+}
+
+static void *
+MinerMTWorker(void *pvArg)
+{
+    tMinerMTWorker *psWorker = (tMinerMTWorker *)pvArg;
+    tMinerMTSearch *psSearch = psWorker->psSearch;
+    tMinerResult sBatch;
+    uint64_t ui64Start;
+    uint32_t ui32Count;
+
+    while(!__atomic_load_n(&psSearch->bFound, __ATOMIC_ACQUIRE))
+    {
+        if(!MinerMTClaim(psWorker, &ui64Start, &ui32Count))
+        {
+            if(!MinerMTSteal(psWorker))
+            {
+                break;
+            }
+            continue;
+        }
+
+        MinerSearch(psSearch->psMiner, psSearch->pui8Target,
+                    (uint32_t)ui64Start, ui32Count, &sBatch);
+        psWorker->ui32Hashes += sBatch.ui32Hashes;
+
+        if(sBatch.bFound)
+        {
+            pthread_mutex_lock(&psSearch->sResultLock);
+            if(!psSearch->bFound)
+            {
+                psSearch->psResult->bFound = true;
+                psSearch->psResult->ui32Nonce = sBatch.ui32Nonce;
+                memcpy(psSearch->psResult->pui8Hash, sBatch.pui8Hash,
+                       BLOCK_HASH_LEN);
+                __atomic_store_n(&psSearch->bFound, true, __ATOMIC_RELEASE);
+            }
+            pthread_mutex_unlock(&psSearch->sResultLock);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! Search a range of nonces on several threads. Has the same contract as
+//! MinerSearch(); any solution in the range may be returned, not
+//! necessarily the lowest. Not reentrant: one search runs at a time.
+//!
+//! \param psMiner is the prepared mining state
+//! \param pui8Target is the target
+//! \param ui32Start is the first nonce to try
+//! \param ui32Count is the number of nonces to try
+//! \param psResult receives the outcome and the attempt count and time
+//!
+//! \return true if a nonce was found
+//
+//*****************************************************************************
+bool
+MinerMTSearch(const tMiner *psMiner, const uint8_t *pui8Target,
+              uint32_t ui32Start, uint32_t ui32Count, tMinerResult *psResult)
+{
+    static tMinerMTSearch sSearch;
+    tMinerMTWorker *psWorker;
+    uint64_t ui64Start, ui64Share;
+    uint32_t ui32Index, ui32Started;
+
+    memset(psResult, 0, sizeof(*psResult));
+
+    sSearch.psMiner = psMiner;
+    sSearch.pui8Target = pui8Target;
+    sSearch.ui32Threads = MinerMTGetThreads();
+    sSearch.bFound = false;
+    sSearch.psResult = psResult;
+    pthread_mutex_init(&sSearch.sResultLock, 0);
+
+    if(sSearch.ui32Threads > ui32Count / MINER_MT_BATCH)
+    {
+        sSearch.ui32Threads = (ui32Count / MINER_MT_BATCH) + 1;
+    }
+
+    ui64Start = ui32Start;
+    ui64Share = ui32Count / sSearch.ui32Threads;
+    for(ui32Index = 0; ui32Index < sSearch.ui32Threads; ui32Index++)
+    {
+        psWorker = &sSearch.psWorkers[ui32Index];
+        pthread_mutex_init(&psWorker->sLock, 0);
+        psWorker->psSearch = &sSearch;
+        psWorker->ui32Hashes = 0;
+        psWorker->ui64Next = ui64Start;
+        psWorker->ui64End = (ui32Index == sSearch.ui32Threads - 1) ?
+                            (uint64_t)ui32Start + ui32Count :
+                            ui64Start + ui64Share;
+        ui64Start = psWorker->ui64End;
+    }
+
+    //
+    // Worker 0 runs on the calling thread. If a thread cannot be created
+    // its range is simply stolen by the others.
+    //
+    psResult->ui64Ticks = PerfClockNow();
+    ui32Started = 1;
+    for(ui32Index = 1; ui32Index < sSearch.ui32Threads; ui32Index++)
+    {
+        if(pthread_create(&sSearch.psWorkers[ui32Index].sThread, 0,
+                          MinerMTWorker, &sSearch.psWorkers[ui32Index]) != 0)
+        {
+            break;
+        }
+        ui32Started++;
+    }
+    MinerMTWorker(&sSearch.psWorkers[0]);
+    for(ui32Index = 1; ui32Index < ui32Started; ui32Index++)
+    {
+        pthread_join(sSearch.psWorkers[ui32Index].sThread, 0);
+    }
+    psResult->ui64Ticks = PerfClockNow() - psResult->ui64Ticks;
+
+    for(ui32Index = 0; ui32Index < sSearch.ui32Threads; ui32Index++)
+    {
+        psResult->ui32Hashes += sSearch.psWorkers[ui32Index].ui32Hashes;
+        pthread_mutex_destroy(&sSearch.psWorkers[ui32Index].sLock);
+    }
+    pthread_mutex_destroy(&sSearch.sResultLock);
+
+    return psResult->bFound;
+}
+
+//*****************************************************************************
+//
+//! Mine a block on MinerMTGetThreads() threads
+//!
+//! \param psBlock is the block
+//! \param pui8Target is the target
+//! \param ui32MaxTries bounds the total attempts
+//! \param psResult receives the outcome, total attempts and time
+//!
+//! \return true if the block was mined
+//
+//*****************************************************************************
+bool
+MinerMTMineBlock(struct Block *psBlock, const uint8_t *pui8Target,
+                 uint32_t ui32MaxTries, tMinerResult *psResult)
+{
+    return MinerMineBlockWith(psBlock, pui8Target, ui32MaxTries,
+                              MinerMTSearch, psResult);
+}
+
+//*****************************************************************************
+//
+//! Measure search throughput for 1, 2, 4, ... threads up to a limit. The
+//! target is unreachable so every run covers the full nonce count.
+//!
+//! \param psHdr is the header to search
+//! \param ui32Hashes is the number of nonces per run
+//! \param ui32MaxThreads is the largest thread count measured
+//! \param pfnReport receives the thread count and hashes per second of
+//! each run
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+MinerMTBenchmark(const struct BlockHeader *psHdr, uint32_t ui32Hashes,
+                 uint32_t ui32MaxThreads, tMinerMTReport pfnReport)
+{
+    uint8_t pui8Target[BLOCK_HASH_LEN];
+    uint32_t ui32Saved = g_ui32Threads;
+    uint32_t ui32Threads;
+    tMinerResult sResult;
+    tMiner sMiner;
+
+    memset(pui8Target, 0, sizeof(pui8Target));
+    MinerPrepare(&sMiner, psHdr);
+
+    if(ui32MaxThreads > MINER_MT_MAX_THREADS)
+    {
+        ui32MaxThreads = MINER_MT_MAX_THREADS;
+    }
+    ui32Threads = 1;
+    for(;;)
+    {
+        MinerMTSetThreads(ui32Threads);
+        MinerMTSearch(&sMiner, pui8Target, 0, ui32Hashes, &sResult);
+        pfnReport(ui32Threads, MinerHashRate(&sResult));
+        if(ui32Threads >= ui32MaxThreads)
+        {
+            break;
+        }
+
+        //
+        // Always include the exact limit, e.g. 6 after 1, 2 and 4.
+        //
+        ui32Threads *= 2;
+        if(ui32Threads > ui32MaxThreads)
+        {
+            ui32Threads = ui32MaxThreads;
+        }
+    }
+    g_ui32Threads = ui32Saved;
+}
+
+#endif // !cc3200
@@ -0,0 +1,72 @@
+//*****************************************************************************
+// miner_mt.h
+//
+// Multi-threaded nonce search for the host build (link with -pthread). The
+// host is the reference miner for the boards; on the board this header
+// declares nothing.
+//
+//*****************************************************************************
+
+#ifndef __MINER_MT_H__
+#define __MINER_MT_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if !defined(cc3200)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "miner.h"
+
+//*****************************************************************************
+//
+// Upper bound on search threads.
+//
+//*****************************************************************************
+#define MINER_MT_MAX_THREADS    64
+
+//*****************************************************************************
+//
+// Nonces a thread claims from its range at a time. Cancellation is checked
+// between batches, so this also bounds the work done after a solution has
+// been found elsewhere.
+//
+//*****************************************************************************
+#define MINER_MT_BATCH          1024
+
+typedef void (*tMinerMTReport)(uint32_t ui32Threads, uint64_t ui64HashRate);
+
+extern uint32_t MinerMTCPUCount(void);
+extern void MinerMTSetThreads(uint32_t ui32Threads);
+extern uint32_t MinerMTGetThreads(void);
+extern bool MinerMTSearch(const tMiner *psMiner, const uint8_t *pui8Target,
+                          uint32_t ui32Start, uint32_t ui32Count,
+                          tMinerResult *psResult);
+extern bool MinerMTMineBlock(struct Block *psBlock, const uint8_t *pui8Target,
+                             uint32_t ui32MaxTries, tMinerResult *psResult);
+extern void MinerMTBenchmark(const struct BlockHeader *psHdr,
+                             uint32_t ui32Hashes, uint32_t ui32MaxThreads,
+                             tMinerMTReport pfnReport);
+
+#endif // !cc3200
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MINER_MT_H__
@@ -0,0 +1,136 @@
+//*****************************************************************************
+// perf_clock.c
+//
+// Free-running timestamp counter
+//
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "perf_clock.h"
+
+#if defined(cc3200)
+
+#include <stdbool.h>
+
+// Driverlib includes
+#include "hw_types.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "interrupt.h"
+
+//
+// Cortex-M4 debug registers.
+//
+#define PERF_DEMCR              0xE000EDFC
+#define PERF_DEMCR_TRCENA       0x01000000
+#define PERF_DWT_CTRL           0xE0001000
+#define PERF_DWT_CTRL_CYCCNTENA 0x00000001
+#define PERF_DWT_CYCCNT         0xE0001004
+
+static uint32_t g_ui32LastCount;
+static uint64_t g_ui64High;
+
+//*****************************************************************************
+//
+//! Start the DWT cycle counter
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+PerfClockInit(void)
+{
+    HWREG(PERF_DEMCR) |= PERF_DEMCR_TRCENA;
+    HWREG(PERF_DWT_CYCCNT) = 0;
+    HWREG(PERF_DWT_CTRL) |= PERF_DWT_CTRL_CYCCNTENA;
+    g_ui32LastCount = 0;
+    g_ui64High = 0;
+}
+
+//*****************************************************************************
+//
+//! Read the clock. The 32-bit cycle counter wraps every 53 s at 80 MHz; it is
+//! extended to 64 bits on each read, so it must be read at least that often.
+//! The SHAMD5 interrupt handler reads it too, so the counter is sampled and
+//! the extension updated with interrupts masked; otherwise a thread
+//! preempted between the two would take its own older count for a wrap.
+//!
+//! \param None
+//!
+//! \return ticks of PERF_CLOCK_HZ since PerfClockInit()
+//
+//*****************************************************************************
+uint64_t
+PerfClockNow(void)
+{
+    uint64_t ui64Now;
+    uint32_t ui32Count;
+    bool bMasked;
+
+    bMasked = MAP_IntMasterDisable();
+    ui32Count = HWREG(PERF_DWT_CYCCNT);
+    if(ui32Count < g_ui32LastCount)
+    {
+        g_ui64High += 1ULL << 32;
+    }
+    g_ui32LastCount = ui32Count;
+    ui64Now = g_ui64High | ui32Count;
+    if(!bMasked)
+    {
+        MAP_IntMasterEnable();
+    }
+
+    return ui64Now;
+}
+
+#else
+
+#include <time.h>
+
+void
+PerfClockInit(void)
+{
+}
+
+uint64_t
+PerfClockNow(void)
+{
+    struct timespec sTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTs);
+    return ((uint64_t)sTs.tv_sec * 1000000000ULL) + (uint64_t)sTs.tv_nsec;
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! Convert a count over an interval into a per-second rate
+//!
+//! \param ui64Count is the number of events (bytes, hashes, ...)
+//! \param ui64Ticks is the interval in PerfClockNow() ticks
+//!
+//! \return events per second
+//
+//*****************************************************************************
+uint64_t
+PerfClockRate(uint64_t ui64Count, uint64_t ui64Ticks)
+{
+    if(ui64Ticks == 0)
+    {
+        return 0;
+    }
+
+    //
+    // Scale down first when the product would overflow.
+    //
+    if(ui64Count > (UINT64_MAX / PERF_CLOCK_HZ))
+    {
+        return (ui64Count / ui64Ticks) * PERF_CLOCK_HZ;
+    }
+
+    return (ui64Count * PERF_CLOCK_HZ) / ui64Ticks;
+}
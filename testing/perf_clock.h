@@ -0,0 +1,49 @@
+//*****************************************************************************
+// perf_clock.h
+//
+// Free-running timestamp counter for throughput measurements: the Cortex-M4
+// DWT cycle counter on the board, CLOCK_MONOTONIC on the host.
+//
+//*****************************************************************************
+
+#ifndef __PERF_CLOCK_H__
+#define __PERF_CLOCK_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Tick rate of PerfClockNow(). The CC3200 application core runs at 80 MHz.
+//
+//*****************************************************************************
+#if defined(cc3200)
+#define PERF_CLOCK_HZ           80000000ULL
+#else
+#define PERF_CLOCK_HZ           1000000000ULL
+#endif
+
+extern void PerfClockInit(void);
+extern uint64_t PerfClockNow(void);
+extern uint64_t PerfClockRate(uint64_t ui64Count, uint64_t ui64Ticks);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PERF_CLOCK_H__
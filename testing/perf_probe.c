@@ -0,0 +1,122 @@
+//*****************************************************************************
+// perf_probe.c
+//
+// Hot-path timing probes. Each site has one writer: the SHAMD5 interrupt for
+// PERF_SITE_HASH_IRQ, thread context for the others.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "perf_clock.h"
+#include "perf_probe.h"
+
+#if defined(PERF_PROBES)
+
+static tPerfProbe g_psProbes[PERF_SITE_COUNT];
+
+static const char * const g_ppcNames[PERF_SITE_COUNT] =
+{
+    "hash", "hash_irq", "uart_print", "gen_block", "block_alloc"
+};
+
+//*****************************************************************************
+//
+//! Record one interval at a site
+//!
+//! \param ui32Site is the site (PERF_SITE_*)
+//! \param ui64Ticks is the interval in PerfClockNow() ticks
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+PerfProbeRecord(uint32_t ui32Site, uint64_t ui64Ticks)
+{
+    tPerfProbe *psProbe = &g_psProbes[ui32Site];
+    uint32_t ui32Ticks, ui32Bucket;
+
+    ui32Ticks = (ui64Ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ui64Ticks;
+    if((psProbe->ui32Count == 0) || (ui32Ticks < psProbe->ui32Min))
+    {
+        psProbe->ui32Min = ui32Ticks;
+    }
+    if(ui32Ticks > psProbe->ui32Max)
+    {
+        psProbe->ui32Max = ui32Ticks;
+    }
+    psProbe->ui32Count++;
+    psProbe->ui64Ticks += ui32Ticks;
+
+    for(ui32Bucket = 0;
+        (ui32Ticks >= 4) && (ui32Bucket < (PERF_PROBE_BUCKETS - 1));
+        ui32Bucket++)
+    {
+        ui32Ticks >>= 2;
+    }
+    psProbe->pui32Histogram[ui32Bucket]++;
+}
+
+//*****************************************************************************
+//
+//! Count an event at a site that is not timed
+//!
+//! \param ui32Site is the site (PERF_SITE_*)
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+PerfProbeEvent(uint32_t ui32Site)
+{
+    g_psProbes[ui32Site].ui32Count++;
+}
+
+//*****************************************************************************
+//
+//! Copy out the counters of a site
+//!
+//! \param ui32Site is the site (PERF_SITE_*)
+//! \param psProbe receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+PerfProbeGet(uint32_t ui32Site, tPerfProbe *psProbe)
+{
+    *psProbe = g_psProbes[ui32Site];
+}
+
+//*****************************************************************************
+//
+//! Name of a site, as printed by the console
+//!
+//! \param ui32Site is the site (PERF_SITE_*)
+//!
+//! \return the name
+//
+//*****************************************************************************
+const char *
+PerfProbeName(uint32_t ui32Site)
+{
+    return g_ppcNames[ui32Site];
+}
+
+//*****************************************************************************
+//
+//! Clear every site
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+PerfProbeReset(void)
+{
+    memset(g_psProbes, 0, sizeof(g_psProbes));
+}
+
+#endif // PERF_PROBES
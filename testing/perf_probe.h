@@ -0,0 +1,104 @@
+//*****************************************************************************
+// perf_probe.h
+//
+// Timing probes on the hot paths. Each probe site keeps a count, the total,
+// minimum and maximum of the intervals it timed, and a histogram of them in
+// powers of four PerfClockNow() ticks (CPU cycles on the board). The console
+// "stats probes" command dumps them.
+//
+// Probes cost two clock reads and a few additions per interval. They are
+// compiled in only when PERF_PROBES is defined in the project settings;
+// otherwise the macros below expand to nothing and perf_probe.c is empty.
+//
+//*****************************************************************************
+
+#ifndef __PERF_PROBE_H__
+#define __PERF_PROBE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "perf_clock.h"
+
+//*****************************************************************************
+//
+// Probe sites.
+//
+//   PERF_SITE_HASH         GenerateHash(), submit to digest
+//   PERF_SITE_HASH_IRQ     SHAMD5 job start to its first interrupt (board)
+//   PERF_SITE_UART_PRINT   UartBufPrintf(), format and queue
+//   PERF_SITE_GEN_BLOCK    gen_block(), allocation to hashed block
+//   PERF_SITE_BLOCK_ALLOC  pool allocations made by gen_block() (a count)
+//
+//*****************************************************************************
+#define PERF_SITE_HASH          0
+#define PERF_SITE_HASH_IRQ      1
+#define PERF_SITE_UART_PRINT    2
+#define PERF_SITE_GEN_BLOCK     3
+#define PERF_SITE_BLOCK_ALLOC   4
+#define PERF_SITE_COUNT         5
+
+//*****************************************************************************
+//
+// Histogram buckets. Bucket i holds intervals of 4^i up to 4^(i+1)-1 ticks;
+// bucket 0 also holds empty intervals and the last one everything longer.
+//
+//*****************************************************************************
+#define PERF_PROBE_BUCKETS      16
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint64_t ui64Ticks;
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    uint32_t pui32Histogram[PERF_PROBE_BUCKETS];
+} tPerfProbe;
+
+#if defined(PERF_PROBES)
+
+//
+// PERF_PROBE_START declares the start timestamp, so it goes where a
+// declaration may; PERF_PROBE_STOP records the interval since it.
+//
+#define PERF_PROBE_START(v)         uint64_t v = PerfClockNow()
+#define PERF_PROBE_STOP(site, v)    PerfProbeRecord((site),                 \
+                                                    PerfClockNow() - (v))
+#define PERF_PROBE_MARK(v)          ((v) = PerfClockNow())
+#define PERF_PROBE_EVENT(site)      PerfProbeEvent(site)
+
+extern void PerfProbeRecord(uint32_t ui32Site, uint64_t ui64Ticks);
+extern void PerfProbeEvent(uint32_t ui32Site);
+extern void PerfProbeGet(uint32_t ui32Site, tPerfProbe *psProbe);
+extern const char *PerfProbeName(uint32_t ui32Site);
+extern void PerfProbeReset(void);
+
+#else
+
+#define PERF_PROBE_START(v)
+#define PERF_PROBE_STOP(site, v)
+#define PERF_PROBE_MARK(v)
+#define PERF_PROBE_EVENT(site)
+
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PERF_PROBE_H__
@@ -63,19 +63,33 @@
 #include "pinmux.h"
 #include "shamd5_userinput.h"
 #include "uart_if.h"
+#include "uart_buf.h"
+#include "hash_engine.h"
 
 
-#define UART_PRINT Report
+#define UART_PRINT UartBufPrintf
 
 
-unsigned int uiHMACKey[16],puiPlainMsg[16];
-extern unsigned int uiHMAC;
+//
+// The message buffer holds a whole input line; the result buffer the
+// largest digest. Both are reused by every command.
+//
+unsigned int uiHMACKey[16],puiPlainMsg[130],puiHashResult[16];
+unsigned int uiHMAC;
 char *HMACKey1,*HMACKey2,*HMACKey3;
 
+static char pcHMACKey1[] =
+    "p$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotr";
+static char pcHMACKey2[] =
+    "abababababababababababababababababababababababababababababababab";
+static char pcHMACKey3[] =
+    "cdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcd";
+
 
 //*****************************************************************************
 //
-//! Set Keys. Sets the Pre Defined Keys
+//! Set Keys. Sets the Pre Defined Keys. They live in static storage, so
+//! calling this again allocates nothing.
 //!
 //! \param None
 //!
@@ -85,12 +99,9 @@ char *HMACKey1,*HMACKey2,*HMACKey3;
 void
 SetKeys()
 {
-    HMACKey1 = MemAllocAndCpy(64, \
-            "p$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotrp$d0Kotr");
-    HMACKey2 = MemAllocAndCpy(64, \
-            "abababababababababababababababababababababababababababababababab");
-    HMACKey3 = MemAllocAndCpy(64, \
-            "cdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcd");
+    HMACKey1 = pcHMACKey1;
+    HMACKey2 = pcHMACKey2;
+    HMACKey3 = pcHMACKey3;
 }
 
 //*****************************************************************************
@@ -158,11 +169,11 @@ GetKey(char *pucKeyBuff)
         //
         // Get the option
         //
-        cChar = MAP_UARTCharGet(UARTA0_BASE);
+        cChar = UartBufGetChar();
         //
         // Echo the received character
         //
-        MAP_UARTCharPut(UARTA0_BASE, cChar);
+        UartBufPutChar(cChar);
         UART_PRINT("\n\r");
         if(cChar=='y' || cChar=='Y' )
         {
@@ -171,11 +182,11 @@ GetKey(char *pucKeyBuff)
             //
             UART_PRINT("\n\r Press 1 for Key - %s\n\r Press 2 for Key - %s \n\r"
                         " Press 3 for Key - %s\n\r",HMACKey1,HMACKey2,HMACKey3);
-            cChar = MAP_UARTCharGet(UARTA0_BASE);
+            cChar = UartBufGetChar();
             //
             // Echo the received character
             //
-            MAP_UARTCharPut(UARTA0_BASE, cChar);
+            UartBufPutChar(cChar);
             UART_PRINT("\n\r");
             if(cChar=='1' )
               memcpy(&uiHMACKey,HMACKey1,64);
@@ -196,12 +207,13 @@ GetKey(char *pucKeyBuff)
             // Ask for the Key
             //
             UART_PRINT("Enter the Key \n\r");
-            uiMsgLen=GetCmd(pucKeyBuff,520);
+            uiMsgLen=UartBufGetLine((char *)puiPlainMsg,sizeof(puiPlainMsg));
             if(uiMsgLen!=64)
             {
                 UART_PRINT("\n\r Enter Valid Key of length 64\n\r");
                 return false;
             }
+            memcpy(pucKeyBuff,puiPlainMsg,64);
        }
        else
        {
@@ -225,24 +237,38 @@ GetKey(char *pucKeyBuff)
 //*****************************************************************************
 unsigned char * GetMsg(char *pucMsgBuff,unsigned int *uiDataLength)
 {
-    unsigned int uiMsgLen,iSize;
-    unsigned char *uiData;
     UART_PRINT("\n\r Enter the Message \n\r");
     
     //
-    // Get Message
+    // Get Message. It is hashed where it lies; nothing is allocated.
     //
-    uiMsgLen=GetCmd(pucMsgBuff, 520);
-    iSize=uiMsgLen;
-    *uiDataLength=iSize;
-    
-    //
-    // Copy Messge into Data variable
-    //
-    uiData=(unsigned char *)malloc(*uiDataLength);
-    memset(uiData,0,*uiDataLength);
-    memcpy(uiData,pucMsgBuff,(uiMsgLen));
-    return uiData;
+    *uiDataLength=UartBufGetLine(pucMsgBuff, sizeof(puiPlainMsg));
+    return (unsigned char *)pucMsgBuff;
+}
+
+//*****************************************************************************
+//
+//! Verify Result - Compares a Result with the Expected one and reports it
+//!
+//! \param  puiResult is the Result
+//! \param  puiExpResult is the Expected Result
+//! \param  uiLength is the Length of the Result in bytes
+//!
+//! \return None
+//!
+//*****************************************************************************
+void
+VerifyResult(unsigned int *puiResult,unsigned int *puiExpResult,
+             unsigned int uiLength)
+{
+    if(memcmp(puiResult,puiExpResult,uiLength)==0)
+    {
+        UART_PRINT("\n\r Result Matched \n\r");
+    }
+    else
+    {
+        UART_PRINT("\n\r Result Mismatch \n\r");
+    }
 }
 
 //*****************************************************************************
@@ -258,86 +284,33 @@ unsigned char * GetMsg(char *pucMsgBuff,unsigned int *uiDataLength)
 //*****************************************************************************
 bool SHAMD5Parser( char *ucCMD,unsigned int *uiConfig,unsigned int *uiHashLength)
 {
+    const tHashAlgo *psAlgo;
     char *ucInpString;
     ucInpString = strtok(ucCMD, " ");
 
     //
     // Check Whether Command is valid
     //
-    if((ucInpString != NULL) && (!strcmp(ucInpString,"hash")))
+    if((ucInpString == NULL) || strcmp(ucInpString,"hash"))
     {
-        ucInpString=strtok(NULL," ");
-        //
-        // Get which Algorithm is using
-        //
-        if((ucInpString != NULL) && (!strcmp(ucInpString,"MD5") || \
-                                !strcmp(ucInpString,"md5")))
-        {
-            *uiConfig=SHAMD5_ALGO_MD5;
-            *uiHashLength=16;
-            uiHMAC=0;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"SHA1") || \
-                                !strcmp(ucInpString,"sha1")))
-        {
-            *uiConfig=SHAMD5_ALGO_SHA1;
-            *uiHashLength=20;
-            uiHMAC=0;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"SHA224") || \
-                                !strcmp(ucInpString,"sha224")))
-        {
-            *uiConfig=SHAMD5_ALGO_SHA224;
-            *uiHashLength=28;
-            uiHMAC=0;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"SHA256") || \
-                                !strcmp(ucInpString,"sha256")))
-        {
-            *uiConfig=SHAMD5_ALGO_SHA256;
-            *uiHashLength=32;
-            uiHMAC=0;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"HMAC_MD5") || \
-                            !strcmp(ucInpString,"hmac_md5")))
-        {
-            *uiConfig=SHAMD5_ALGO_HMAC_MD5;
-            *uiHashLength=16;
-            uiHMAC=1;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"HMAC_SHA1") || \
-                            !strcmp(ucInpString,"hmac_sha1")))
-        {
-            *uiConfig=SHAMD5_ALGO_HMAC_SHA1;
-            *uiHashLength=20;
-            uiHMAC=1;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"HMAC_SHA224") || \
-                        !strcmp(ucInpString,"hmac_sha224")))
-        {
-            *uiConfig=SHAMD5_ALGO_HMAC_SHA224;
-            *uiHashLength=28;
-            uiHMAC=1;
-        }
-        else if((ucInpString != NULL) && (!strcmp(ucInpString,"HMAC_SHA256") || \
-                        !strcmp(ucInpString,"hmac_sha256")))
-        {
-            *uiConfig=SHAMD5_ALGO_HMAC_SHA256;
-            *uiHashLength=32;
-            uiHMAC=1;
-        }
-        else
-        {
-            UART_PRINT("\n\r Invalid Algorithm\n\r");
-            return false;
-        }
-        return true;
+        UART_PRINT("\n\r Invalid Command \n\r");
+        return false;
     }
-    else
+
+    //
+    // Get which Algorithm is using, by name in either case
+    //
+    ucInpString=strtok(NULL," ");
+    psAlgo=(ucInpString != NULL) ? HashAlgoFind(ucInpString) : NULL;
+    if(psAlgo == NULL)
     {
-        UART_PRINT("\n\r Invalid Command \n\r");
+        UART_PRINT("\n\r Invalid Algorithm\n\r");
         return false;
     }
+    *uiConfig=psAlgo->ui32Config;
+    *uiHashLength=psAlgo->ui32DigestLength;
+    uiHMAC=psAlgo->bHMAC;
+    return true;
 }
 
 //*****************************************************************************
@@ -357,6 +330,7 @@ unsigned char *
 ReadFromUser(unsigned int *uiConfig,unsigned int *uiHashLength,unsigned 
               char **uiKey,unsigned int *uiDataLength,unsigned char **puiResult)
 {
+    static bool bStarted;
     char ucCmdBuffer[520],*pucKeyBuff,*pucMsgBuff;
     unsigned char *uiData;
 
@@ -368,27 +342,27 @@ ReadFromUser(unsigned int *uiConfig,unsigned int *uiHashLength,unsigned
     pucMsgBuff=( char*)&puiPlainMsg[0];
 
     //
-    // Set Default Values
-    //
-    SetKeys();
-
+    // Set Default Values and show the usage, once
     //
-    // Usage Display
-    //
-    UsageDisplay();
+    if(!bStarted)
+    {
+        SetKeys();
+        UsageDisplay();
+        bStarted = true;
+    }
 
     //
     // Get the Command
     //
     UART_PRINT("cmd# ");
-    GetCmd(ucCmdBuffer,520);
+    UartBufGetLine(ucCmdBuffer,520);
     if(SHAMD5Parser(ucCmdBuffer,uiConfig,uiHashLength))
     {
         if(GetKey(pucKeyBuff))
         {
             uiData=GetMsg(pucMsgBuff,uiDataLength);
-            *puiResult=(unsigned char *)malloc(64);
-            memset(*puiResult,0,64);
+            *puiResult=(unsigned char *)&puiHashResult[0];
+            memset(*puiResult,0,sizeof(puiHashResult));
         }
         else
         {
@@ -0,0 +1,72 @@
+//*****************************************************************************
+// bench.c
+//
+// Host runner of the benchmark suite (bench.h). Build from this directory:
+//
+//   gcc -O2 -pthread -I.. -o bench bench.c
+//       $(ls ../*.c | grep -v -e main.c -e pinmux.c -e shamd5_userinput.c)
+//
+// (one command line), then run
+//
+//   bench [scale] > results.csv
+//
+// The scale (default 16) multiplies every workload. The CSV goes to stdout;
+// two result files are compared column by column, case by case.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "hash_engine.h"
+#include "perf_clock.h"
+#include "chain_store.h"
+#include "bench.h"
+
+static tChainStore g_sChain;
+
+static void
+BenchPrint(const tBenchResult *psResult, void *pvArg)
+{
+    char pcLine[BENCH_LINE_MAX];
+
+    (void)pvArg;
+    if(BenchFormat(psResult, pcLine, sizeof(pcLine)))
+    {
+        printf("%s\n", pcLine);
+        fflush(stdout);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    char pcLine[BENCH_LINE_MAX];
+    uint32_t ui32Scale = 16;
+
+    if(argc > 1)
+    {
+        ui32Scale = (uint32_t)strtoul(argv[1], NULL, 0);
+        if(ui32Scale == 0)
+        {
+            fprintf(stderr, "usage: bench [scale]\n");
+            return 2;
+        }
+    }
+
+    PerfClockInit();
+    HashEngineInit();
+    if(BenchFormatInfo(ui32Scale, pcLine, sizeof(pcLine)))
+    {
+        printf("%s\n", pcLine);
+    }
+    BenchRun(&g_sChain, ui32Scale, BenchPrint, NULL);
+
+    return 0;
+}
+
+#endif
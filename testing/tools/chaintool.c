@@ -0,0 +1,387 @@
+//*****************************************************************************
+// chaintool.c
+//
+// Host command line tool for block logs pulled off a board, or generated
+// here for testing. Build from this directory with the host sources:
+//
+//   gcc -O2 -pthread -I.. -o chaintool chaintool.c
+//       $(ls ../*.c | grep -v -e main.c -e pinmux.c -e shamd5_userinput.c)
+//
+// (one command line).
+//
+//   chaintool info <log>                 record count, heights, damage
+//   chaintool verify <log>               full verification and throughput
+//   chaintool show <log> <height>        one block
+//   chaintool find <log> <hash>          look a block up by hash
+//   chaintool tags <log> <key>           check authentication tags
+//   chaintool gen <log> <blocks> [txs]   write a synthetic chain
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "hash_sw.h"
+#include "hash_sw_mb.h"
+#include "perf_clock.h"
+#include "blockchain.h"
+#include "merkle.h"
+#include "chain_log.h"
+#include "chain_map.h"
+
+static void
+PrintHash(const char *pcLabel, const uint8_t *pui8Hash)
+{
+    uint32_t ui32Idx;
+
+    printf("%s", pcLabel);
+    for(ui32Idx = 0; ui32Idx < BLOCK_HASH_LEN; ui32Idx++)
+    {
+        printf("%02x", pui8Hash[ui32Idx]);
+    }
+    printf("\n");
+}
+
+static bool
+ParseHash(const char *pcHex, uint8_t *pui8Hash)
+{
+    uint32_t ui32Idx;
+    unsigned int uiByte;
+
+    if(strlen(pcHex) != 2 * BLOCK_HASH_LEN)
+    {
+        return false;
+    }
+    for(ui32Idx = 0; ui32Idx < BLOCK_HASH_LEN; ui32Idx++)
+    {
+        if(sscanf(pcHex + (2 * ui32Idx), "%2x", &uiByte) != 1)
+        {
+            return false;
+        }
+        pui8Hash[ui32Idx] = (uint8_t)uiByte;
+    }
+
+    return true;
+}
+
+static void
+ShowBlock(const tChainMapBlock *psBlock)
+{
+    uint32_t ui32Tx;
+
+    printf("height    %u\n", (unsigned int)psBlock->sHeader.height);
+    printf("offset    %llu\n", (unsigned long long)psBlock->ui64Offset);
+    PrintHash("hash      ", psBlock->pui8Hash);
+    PrintHash("previous  ", psBlock->sHeader.pHash);
+    PrintHash("merkle    ", psBlock->sHeader.merkle);
+    printf("time      %u\n", (unsigned int)psBlock->sHeader.time);
+    printf("nonce     %u\n", (unsigned int)psBlock->sHeader.nonce);
+    if(psBlock->pui8Tag)
+    {
+        PrintHash("tag       ", psBlock->pui8Tag);
+    }
+    for(ui32Tx = 0; ui32Tx < psBlock->sHeader.data_len / BLOCK_TX_LEN;
+        ui32Tx++)
+    {
+        printf("tx %-6u %.*s\n", (unsigned int)ui32Tx, BLOCK_TX_LEN,
+               (const char *)psBlock->pui8Data + (ui32Tx * BLOCK_TX_LEN));
+    }
+}
+
+static int
+CmdInfo(tChainMap *psMap)
+{
+    tChainMapBlock sFirst, sLast;
+
+    ChainMapIndex(psMap);
+    printf("size      %llu bytes\n", (unsigned long long)psMap->ui64Size);
+    printf("blocks    %u\n", (unsigned int)psMap->ui32Blocks);
+    if(ChainMapAt(psMap, 0, &sFirst) &&
+       ChainMapAt(psMap, psMap->ui32Blocks - 1, &sLast))
+    {
+        printf("heights   %u .. %u\n", (unsigned int)sFirst.sHeader.height,
+               (unsigned int)sLast.sHeader.height);
+        PrintHash("tip       ", sLast.pui8Hash);
+    }
+    if(psMap->ui64Valid != psMap->ui64Size)
+    {
+        printf("damaged   %llu bytes after offset %llu\n",
+               (unsigned long long)(psMap->ui64Size - psMap->ui64Valid),
+               (unsigned long long)psMap->ui64Valid);
+    }
+
+    return 0;
+}
+
+static int
+CmdVerify(tChainMap *psMap)
+{
+    uint64_t ui64IndexTicks, ui64VerifyTicks, ui64Bytes;
+    uint32_t ui32Bad, ui32Checked;
+    bool bValid;
+
+    ui64IndexTicks = PerfClockNow();
+    ChainMapIndex(psMap);
+    ui64IndexTicks = PerfClockNow() - ui64IndexTicks;
+
+    ui64VerifyTicks = PerfClockNow();
+    bValid = ChainMapVerify(psMap, &ui32Bad);
+    ui64VerifyTicks = PerfClockNow() - ui64VerifyTicks;
+
+    //
+    // Rates cover the blocks actually checked.
+    //
+    ui32Checked = bValid ? psMap->ui32Blocks : ui32Bad;
+    ui64Bytes = bValid ? psMap->ui64Valid : psMap->pui64Offsets[ui32Bad];
+
+    printf("kernel    %s\n", SWSHA256MBKernel()->pcName);
+    printf("index     %u blocks, %llu blocks/s\n",
+           (unsigned int)psMap->ui32Blocks,
+           (unsigned long long)PerfClockRate(psMap->ui32Blocks,
+                                             ui64IndexTicks));
+    printf("verify    %llu blocks/s, %llu MB/s\n",
+           (unsigned long long)PerfClockRate(ui32Checked, ui64VerifyTicks),
+           (unsigned long long)(PerfClockRate(ui64Bytes,
+                                              ui64VerifyTicks) >> 20));
+    if(!bValid)
+    {
+        printf("invalid   block at position %u\n", (unsigned int)ui32Bad);
+        return 1;
+    }
+    if(psMap->ui64Valid != psMap->ui64Size)
+    {
+        printf("damaged   %llu bytes after offset %llu\n",
+               (unsigned long long)(psMap->ui64Size - psMap->ui64Valid),
+               (unsigned long long)psMap->ui64Valid);
+        return 1;
+    }
+    printf("valid\n");
+
+    return 0;
+}
+
+static int
+CmdShow(tChainMap *psMap, const char *pcHeight)
+{
+    tChainMapBlock sBlock;
+
+    ChainMapIndex(psMap);
+    if(!ChainMapFindHeight(psMap, (uint32_t)strtoul(pcHeight, NULL, 0),
+                           &sBlock))
+    {
+        printf("no block at height %s\n", pcHeight);
+        return 1;
+    }
+    ShowBlock(&sBlock);
+
+    return 0;
+}
+
+static int
+CmdFind(tChainMap *psMap, const char *pcHash)
+{
+    uint8_t pui8Hash[BLOCK_HASH_LEN];
+    tChainMapBlock sBlock;
+
+    if(!ParseHash(pcHash, pui8Hash))
+    {
+        printf("bad hash %s\n", pcHash);
+        return 1;
+    }
+    ChainMapIndex(psMap);
+    if(!ChainMapFind(psMap, pui8Hash, &sBlock))
+    {
+        printf("not found\n");
+        return 1;
+    }
+    ShowBlock(&sBlock);
+
+    return 0;
+}
+
+//
+// Check the tag of every block with the software HMAC, independently of the
+// engine that made it. pcKey is the device key as provisioned
+// (CHAIN_AUTH_KEY).
+//
+static int
+CmdTags(tChainMap *psMap, const char *pcKey)
+{
+    uint8_t pui8Tag[BLOCK_TAG_LEN];
+    tChainMapBlock sBlock;
+    uint32_t ui32Pos, ui32Tagged = 0, ui32Bad = 0;
+
+    ChainMapIndex(psMap);
+    for(ui32Pos = 0; ChainMapAt(psMap, ui32Pos, &sBlock); ui32Pos++)
+    {
+        if(sBlock.pui8Tag == NULL)
+        {
+            continue;
+        }
+        ui32Tagged++;
+        SWHMAC(SHAMD5_ALGO_SHA256, (const uint8_t *)pcKey, strlen(pcKey),
+               sBlock.pui8Hash, BLOCK_HASH_LEN, pui8Tag);
+        if(memcmp(pui8Tag, sBlock.pui8Tag, BLOCK_TAG_LEN))
+        {
+            if(ui32Bad++ == 0)
+            {
+                printf("bad tag   height %u\n",
+                       (unsigned int)sBlock.sHeader.height);
+            }
+        }
+    }
+    printf("tagged    %u of %u blocks\n", (unsigned int)ui32Tagged,
+           (unsigned int)psMap->ui32Blocks);
+    printf("bad tags  %u\n", (unsigned int)ui32Bad);
+
+    return ((ui32Bad == 0) && (ui32Tagged == psMap->ui32Blocks)) ? 0 : 1;
+}
+
+//
+// A synthetic chain in the board's log format: genesis, then blocks of
+// ui32Txs numbered transactions each.
+//
+static int
+CmdGen(const char *pcPath, uint32_t ui32Blocks, uint32_t ui32Txs)
+{
+    static struct Block sBlock;
+    static uint8_t pui8Out[1 << 20];
+    uint32_t ui32Out = 0, ui32Height, ui32Tx;
+    uint64_t ui64Ticks, ui64Bytes = 0;
+    FILE *psFile;
+    char pcTx[BLOCK_TX_LEN + 1];
+
+    if((ui32Txs == 0) || (ui32Txs > BLOCK_MAX_TX))
+    {
+        printf("1 to %u transactions per block\n", BLOCK_MAX_TX);
+        return 1;
+    }
+    psFile = fopen(pcPath, "wb");
+    if(psFile == NULL)
+    {
+        printf("cannot create %s\n", pcPath);
+        return 1;
+    }
+
+    ui64Ticks = PerfClockNow();
+    memset(&sBlock, 0, sizeof(sBlock));
+    sBlock.header.version = BLOCK_HEADER_VERSION;
+    for(ui32Height = 0; ui32Height < ui32Blocks; ui32Height++)
+    {
+        sBlock.header.height = ui32Height;
+        sBlock.header.time = ui32Height;
+        sBlock.header.data_len = ui32Txs * BLOCK_TX_LEN;
+        for(ui32Tx = 0; ui32Tx < ui32Txs; ui32Tx++)
+        {
+            snprintf(pcTx, sizeof(pcTx), "%03u%07u",
+                     (unsigned int)(ui32Tx % 1000),
+                     (unsigned int)(ui32Height % 10000000));
+            memcpy(sBlock.data + (ui32Tx * BLOCK_TX_LEN), pcTx,
+                   BLOCK_TX_LEN);
+        }
+        MerkleRootOf(sBlock.data, BLOCK_TX_LEN, ui32Txs, sBlock.header.merkle);
+        block_hash_header(&sBlock.header, sBlock.hash);
+
+        if(ui32Out + CHAIN_LOG_RECORD_MAX > sizeof(pui8Out))
+        {
+            if(fwrite(pui8Out, 1, ui32Out, psFile) != ui32Out)
+            {
+                break;
+            }
+            ui64Bytes += ui32Out;
+            ui32Out = 0;
+        }
+        ui32Out += ChainLogEncode(&sBlock, pui8Out + ui32Out);
+        memcpy(sBlock.header.pHash, sBlock.hash, BLOCK_HASH_LEN);
+    }
+    if(fwrite(pui8Out, 1, ui32Out, psFile) == ui32Out)
+    {
+        ui64Bytes += ui32Out;
+    }
+    fclose(psFile);
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+
+    printf("wrote %u blocks, %llu bytes, %llu blocks/s\n",
+           (unsigned int)ui32Height, (unsigned long long)ui64Bytes,
+           (unsigned long long)PerfClockRate(ui32Height, ui64Ticks));
+
+    return (ui32Height == ui32Blocks) ? 0 : 1;
+}
+
+static int
+Usage(void)
+{
+    printf("usage: chaintool info <log>\n"
+           "       chaintool verify <log>\n"
+           "       chaintool show <log> <height>\n"
+           "       chaintool find <log> <hash>\n"
+           "       chaintool tags <log> <key>\n"
+           "       chaintool gen <log> <blocks> [txs]\n");
+
+    return 2;
+}
+
+int
+main(int argc, char **argv)
+{
+    tChainMap sMap;
+    int iResult;
+
+    PerfClockInit();
+    HashEngineInit();
+    if(argc < 3)
+    {
+        return Usage();
+    }
+
+    if(!strcmp(argv[1], "gen"))
+    {
+        if(argc < 4)
+        {
+            return Usage();
+        }
+        return CmdGen(argv[2], (uint32_t)strtoul(argv[3], NULL, 0),
+                      (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : 1);
+    }
+
+    if(!ChainMapOpen(&sMap, argv[2]))
+    {
+        printf("cannot map %s\n", argv[2]);
+        return 1;
+    }
+    if(!strcmp(argv[1], "info"))
+    {
+        iResult = CmdInfo(&sMap);
+    }
+    else if(!strcmp(argv[1], "verify"))
+    {
+        iResult = CmdVerify(&sMap);
+    }
+    else if(!strcmp(argv[1], "show") && (argc > 3))
+    {
+        iResult = CmdShow(&sMap, argv[3]);
+    }
+    else if(!strcmp(argv[1], "find") && (argc > 3))
+    {
+        iResult = CmdFind(&sMap, argv[3]);
+    }
+    else if(!strcmp(argv[1], "tags") && (argc > 3))
+    {
+        iResult = CmdTags(&sMap, argv[3]);
+    }
+    else
+    {
+        iResult = Usage();
+    }
+    ChainMapClose(&sMap);
+
+    return iResult;
+}
+
+#endif
@@ -0,0 +1,229 @@
+//*****************************************************************************
+// indexstress.c
+//
+// Host stress test of the block hash index (block_index.h) as the chain
+// store drives it. Build from this directory:
+//
+//   gcc -O2 -pthread -I.. -o indexstress indexstress.c
+//       $(ls ../*.c | grep -v -e main.c -e pinmux.c -e shamd5_userinput.c)
+//
+// (one command line), then run
+//
+//   indexstress [blocks]
+//
+// A synthetic chain of the given length (default 300000) is appended to the
+// store, which prunes it down to the retained window as it goes. Along the
+// way, and for the whole window at the end, every retained block and its
+// parent must resolve through ChainStoreFind(); every pruned hash and a run
+// of random hashes must miss. The time per lookup is printed. The exit
+// status is 0 on success.
+//
+// The window of a default build is CHAIN_STORE_DEPTH blocks (154 with the
+// stock chain_config.h); add e.g. -DCHAIN_STORE_DEPTH=60000
+// -DCHAIN_INDEX_BITS=17 to the build line for a large one.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "hash_engine.h"
+#include "perf_clock.h"
+
+//
+// Default chain length, how often the window is checked while the chain
+// grows, and the number of random hashes looked up.
+//
+#define INDEX_STRESS_BLOCKS     300000
+#define INDEX_STRESS_CHECK_EVERY 4096
+#define INDEX_STRESS_MISSES     1000000
+
+static tChainStore g_sChain;
+static uint32_t g_ui32Seed = 0x2545f491;
+
+static uint32_t
+IndexStressRand(void)
+{
+    g_ui32Seed ^= g_ui32Seed << 13;
+    g_ui32Seed ^= g_ui32Seed >> 17;
+    g_ui32Seed ^= g_ui32Seed << 5;
+
+    return g_ui32Seed;
+}
+
+static int
+IndexStressFail(const char *pcWhat, uint32_t ui32Height)
+{
+    printf("indexstress: %s at height %u\n", pcWhat,
+           (unsigned int)ui32Height);
+
+    return 1;
+}
+
+//
+// Every retained block, and the parent of every retained block but the
+// oldest, must resolve to itself.
+//
+static bool
+IndexStressWindowOK(uint32_t *pui32BadHeight)
+{
+    struct Block *psBlock;
+    uint32_t ui32Height, ui32Base;
+
+    ui32Base = ChainStoreBaseHeight(&g_sChain);
+    for(ui32Height = ui32Base;
+        ui32Height < ui32Base + ChainStoreCount(&g_sChain); ui32Height++)
+    {
+        psBlock = ChainStoreGet(&g_sChain, ui32Height);
+        if((psBlock == NULL) ||
+           (ChainStoreFind(&g_sChain, psBlock->hash) != psBlock) ||
+           ((ui32Height > ui32Base) &&
+            (ChainStoreFind(&g_sChain, psBlock->header.pHash) !=
+             ChainStoreGet(&g_sChain, ui32Height - 1))))
+        {
+            *pui32BadHeight = ui32Height;
+            return false;
+        }
+    }
+
+    return g_sChain.sIndex.ui32Count == ChainStoreCount(&g_sChain);
+}
+
+int
+main(int argc, char **argv)
+{
+    unsigned char (*ppucHashes)[BLOCK_HASH_LEN];
+    unsigned char pucRandom[BLOCK_HASH_LEN];
+    struct Block *psBlock;
+    uint32_t ui32Blocks, ui32Height, ui32Base, ui32Idx, ui32Byte, ui32Word;
+    uint32_t ui32Lookups;
+    uint64_t ui64Start, ui64Ticks;
+
+    ui32Blocks = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) :
+                              INDEX_STRESS_BLOCKS;
+    if(ui32Blocks == 0)
+    {
+        printf("usage: indexstress [blocks]\n");
+        return 2;
+    }
+
+    //
+    // The hash of every block ever made, so that pruned ones can be looked
+    // up once they are gone.
+    //
+    ppucHashes = malloc((size_t)ui32Blocks * BLOCK_HASH_LEN);
+    if(ppucHashes == NULL)
+    {
+        printf("indexstress: out of memory\n");
+        return 1;
+    }
+
+    HashEngineInit();
+    PerfClockInit();
+    BlockPoolInit();
+    ChainStoreInit(&g_sChain);
+
+    for(ui32Height = 0; ui32Height < ui32Blocks; ui32Height++)
+    {
+        psBlock = BlockPoolAlloc();
+        if(psBlock == NULL)
+        {
+            return IndexStressFail("block pool exhausted", ui32Height);
+        }
+        memset(psBlock, 0, sizeof(*psBlock));
+        psBlock->header.version = BLOCK_HEADER_VERSION;
+        psBlock->header.height = ui32Height;
+        psBlock->header.nonce = IndexStressRand();
+        if(ui32Height > 0)
+        {
+            memcpy(psBlock->header.pHash, ppucHashes[ui32Height - 1],
+                   BLOCK_HASH_LEN);
+        }
+        block_hash_header(&psBlock->header, psBlock->hash);
+        memcpy(ppucHashes[ui32Height], psBlock->hash, BLOCK_HASH_LEN);
+
+        if(!ChainStoreAppend(&g_sChain, psBlock))
+        {
+            return IndexStressFail("append refused", ui32Height);
+        }
+        if((ChainStoreFind(&g_sChain, psBlock->hash) != psBlock) ||
+           ((ChainStoreCount(&g_sChain) > 1) &&
+            (ChainStoreFind(&g_sChain, psBlock->header.pHash) !=
+             ChainStoreGet(&g_sChain, ui32Height - 1))))
+        {
+            return IndexStressFail("new tip does not resolve", ui32Height);
+        }
+        if(((ui32Height % INDEX_STRESS_CHECK_EVERY) == 0) &&
+           !IndexStressWindowOK(&ui32Idx))
+        {
+            return IndexStressFail("retained block does not resolve",
+                                   ui32Idx);
+        }
+    }
+
+    if(!IndexStressWindowOK(&ui32Idx))
+    {
+        return IndexStressFail("retained block does not resolve", ui32Idx);
+    }
+
+    ui32Base = ChainStoreBaseHeight(&g_sChain);
+    for(ui32Height = 0; ui32Height < ui32Base; ui32Height++)
+    {
+        if(ChainStoreFind(&g_sChain, ppucHashes[ui32Height]) != NULL)
+        {
+            return IndexStressFail("pruned block still found", ui32Height);
+        }
+    }
+    for(ui32Idx = 0; ui32Idx < INDEX_STRESS_MISSES; ui32Idx++)
+    {
+        for(ui32Byte = 0; ui32Byte < BLOCK_HASH_LEN; ui32Byte += 4)
+        {
+            ui32Word = IndexStressRand();
+            memcpy(&pucRandom[ui32Byte], &ui32Word, sizeof(ui32Word));
+        }
+        if(ChainStoreFind(&g_sChain, pucRandom) != NULL)
+        {
+            return IndexStressFail("random hash found", ui32Base);
+        }
+    }
+
+    //
+    // Time hits over the window, a few passes so short windows still give
+    // a measurable run.
+    //
+    ui32Lookups = 0;
+    ui64Start = PerfClockNow();
+    while(ui32Lookups < INDEX_STRESS_MISSES)
+    {
+        for(ui32Height = ui32Base; ui32Height < ui32Blocks; ui32Height++)
+        {
+            if(ChainStoreFind(&g_sChain, ppucHashes[ui32Height]) == NULL)
+            {
+                return IndexStressFail("retained block lost", ui32Height);
+            }
+            ui32Lookups++;
+        }
+    }
+    ui64Ticks = PerfClockNow() - ui64Start;
+
+    printf("indexstress: %u blocks, window %u, %u index slots, "
+           "%u lookups at %u ns: ok\n", (unsigned int)ui32Blocks,
+           (unsigned int)ChainStoreCount(&g_sChain),
+           (unsigned int)CHAIN_INDEX_SIZE, (unsigned int)ui32Lookups,
+           (unsigned int)((ui64Ticks * (1000000000ULL / PERF_CLOCK_HZ)) /
+                          ui32Lookups));
+
+    free(ppucHashes);
+
+    return 0;
+}
+
+#endif
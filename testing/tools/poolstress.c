@@ -0,0 +1,182 @@
+//*****************************************************************************
+// poolstress.c
+//
+// Host stress test of the block pool (block_pool.h). Build from this
+// directory:
+//
+//   gcc -O2 -I.. -o poolstress poolstress.c ../block_pool.c
+//
+// then run
+//
+//   poolstress
+//
+// A fixed number of allocations and frees, in an order drawn from a fixed
+// seed, is run against the pool. Each block held carries a stamp that must
+// survive until it is freed, so a block handed out twice is caught. At the
+// end the free list is checked and the whole pool must be handed out once
+// more, every block exactly once. The exit status is 0 on success.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+
+//
+// Operations run, the length of a fill or drain phase, and how often the
+// free list is walked in between.
+//
+#define POOL_STRESS_CYCLES      8000000
+#define POOL_STRESS_PHASE       256
+#define POOL_STRESS_CHECK_EVERY 65536
+
+static struct Block *g_ppsHeld[BLOCK_POOL_CAPACITY];
+static uint32_t g_ui32Held;
+static uint32_t g_ui32Seed = 0x2545f491;
+
+static uint32_t
+PoolStressRand(void)
+{
+    g_ui32Seed ^= g_ui32Seed << 13;
+    g_ui32Seed ^= g_ui32Seed >> 17;
+    g_ui32Seed ^= g_ui32Seed << 5;
+
+    return g_ui32Seed;
+}
+
+//
+// A held block is stamped with its own pool index and the cycle it was
+// taken in.
+//
+static void
+PoolStressStamp(struct Block *psBlock, uint32_t ui32Cycle)
+{
+    psBlock->header.height = BlockPoolIndex(psBlock);
+    psBlock->header.nonce = ui32Cycle;
+}
+
+static bool
+PoolStressStampOK(const struct Block *psBlock, uint32_t ui32Cycle)
+{
+    return (psBlock->header.height == BlockPoolIndex(psBlock)) &&
+           (psBlock->header.nonce == ui32Cycle);
+}
+
+static int
+PoolStressFail(const char *pcWhat, uint32_t ui32Cycle)
+{
+    printf("poolstress: %s at cycle %u\n", pcWhat, (unsigned int)ui32Cycle);
+
+    return 1;
+}
+
+int
+main(void)
+{
+    static uint32_t pui32Taken[BLOCK_POOL_CAPACITY];
+    static uint8_t pui8Seen[BLOCK_POOL_CAPACITY];
+    tBlockPoolStats sStats;
+    struct Block *psBlock;
+    uint32_t ui32Cycle, ui32Slot, ui32Allocs = 0, ui32Frees = 0;
+    uint16_t ui16Idx;
+
+    BlockPoolInit();
+
+    for(ui32Cycle = 0; ui32Cycle < POOL_STRESS_CYCLES; ui32Cycle++)
+    {
+        //
+        // Phases that mostly allocate alternate with phases that mostly
+        // free, so that the number held sweeps from empty to exhausted and
+        // back, and the exhausted path is taken too.
+        //
+        if((g_ui32Held == 0) ||
+           ((PoolStressRand() % 16) <
+            (((ui32Cycle / POOL_STRESS_PHASE) & 1) ? 4u : 12u)))
+        {
+            psBlock = BlockPoolAlloc();
+            if(psBlock == NULL)
+            {
+                if(g_ui32Held != BLOCK_POOL_CAPACITY)
+                {
+                    return PoolStressFail("allocation failed early",
+                                          ui32Cycle);
+                }
+                continue;
+            }
+            if(g_ui32Held == BLOCK_POOL_CAPACITY)
+            {
+                return PoolStressFail("allocation past capacity", ui32Cycle);
+            }
+            PoolStressStamp(psBlock, ui32Cycle);
+            pui32Taken[g_ui32Held] = ui32Cycle;
+            g_ppsHeld[g_ui32Held++] = psBlock;
+            ui32Allocs++;
+        }
+        else
+        {
+            ui32Slot = PoolStressRand() % g_ui32Held;
+            psBlock = g_ppsHeld[ui32Slot];
+            if(!PoolStressStampOK(psBlock, pui32Taken[ui32Slot]))
+            {
+                return PoolStressFail("block handed out twice", ui32Cycle);
+            }
+            BlockPoolFree(psBlock);
+            g_ui32Held--;
+            g_ppsHeld[ui32Slot] = g_ppsHeld[g_ui32Held];
+            pui32Taken[ui32Slot] = pui32Taken[g_ui32Held];
+            ui32Frees++;
+        }
+
+        if(((ui32Cycle % POOL_STRESS_CHECK_EVERY) == 0) && !BlockPoolCheck())
+        {
+            return PoolStressFail("free list corrupt", ui32Cycle);
+        }
+    }
+
+    //
+    // Return everything, then the free list must hold the whole pool and
+    // give every block back exactly once.
+    //
+    while(g_ui32Held)
+    {
+        BlockPoolFree(g_ppsHeld[--g_ui32Held]);
+        ui32Frees++;
+    }
+    BlockPoolStatsGet(&sStats);
+    if(!BlockPoolCheck() || (sStats.ui32InUse != 0))
+    {
+        return PoolStressFail("free list corrupt", ui32Cycle);
+    }
+
+    memset(pui8Seen, 0, sizeof(pui8Seen));
+    for(ui16Idx = 0; ui16Idx < BLOCK_POOL_CAPACITY; ui16Idx++)
+    {
+        psBlock = BlockPoolAlloc();
+        if((psBlock == NULL) || pui8Seen[BlockPoolIndex(psBlock)])
+        {
+            return PoolStressFail("pool not whole after the run", ui32Cycle);
+        }
+        pui8Seen[BlockPoolIndex(psBlock)] = 1;
+    }
+    if(BlockPoolAlloc() != NULL)
+    {
+        return PoolStressFail("pool larger than its capacity", ui32Cycle);
+    }
+
+    BlockPoolStatsGet(&sStats);
+    printf("poolstress: %u cycles, %u allocs, %u frees, %u failures, "
+           "capacity %u: ok\n", (unsigned int)POOL_STRESS_CYCLES,
+           (unsigned int)ui32Allocs, (unsigned int)ui32Frees,
+           (unsigned int)sStats.ui32Failures,
+           (unsigned int)BLOCK_POOL_CAPACITY);
+
+    return 0;
+}
+
+#endif
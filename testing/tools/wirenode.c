@@ -0,0 +1,117 @@
+//*****************************************************************************
+// wirenode.c
+//
+// Host stand-in for the board on the framed protocol. It runs the board's
+// protocol handler, chain store, mempool and block log, and serves them on
+// a new pseudo-terminal (or a given serial device), so that a peer such as
+// wirepeer can be exercised without hardware. Build from this directory:
+//
+//   gcc -O2 -pthread -I.. -o wirenode wirenode.c
+//       $(ls ../*.c | grep -v -e main.c -e pinmux.c -e shamd5_userinput.c)
+//
+// (one command line), then run
+//
+//   wirenode [log] [device]
+//
+// It prints the device a peer should open and serves until interrupted.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+
+#include "hash_engine.h"
+#include "perf_clock.h"
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "chain_log.h"
+#include "block_auth.h"
+#include "mempool.h"
+#include "wire.h"
+
+static tChainStore g_sChain;
+static volatile sig_atomic_t g_bStop;
+
+static void
+StopHandler(int iSignal)
+{
+    (void)iSignal;
+    g_bStop = 1;
+}
+
+static bool
+NodeAppend(struct Block *psBlock)
+{
+    if(!ChainStoreAppend(&g_sChain, psBlock))
+    {
+        return false;
+    }
+    ChainLogAppend(psBlock);
+    WireNodeBlockAdded(psBlock);
+
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *pcLog = (argc > 1) ? argv[1] : "wirenode.log";
+    tWireStats sStats;
+
+    PerfClockInit();
+    HashEngineInit();
+    BlockPoolInit();
+    MempoolInit();
+    ChainStoreInit(&g_sChain);
+#if defined(CHAIN_AUTH_KEY)
+    BlockAuthLoadKey((const uint8_t *)CHAIN_AUTH_KEY,
+                     sizeof(CHAIN_AUTH_KEY) - 1);
+#endif
+    if(!ChainLogOpen(pcLog, &g_sChain, true))
+    {
+        printf("cannot open %s\n", pcLog);
+        return 1;
+    }
+    if(ChainStoreCount(&g_sChain) == 0)
+    {
+        NodeAppend(gen_genesis_block());
+    }
+    if(!WirePortOpen((argc > 2) ? argv[2] : NULL))
+    {
+        printf("cannot open the port\n");
+        ChainLogClose();
+        return 1;
+    }
+
+    signal(SIGINT, StopHandler);
+    signal(SIGTERM, StopHandler);
+    printf("%s\n", WirePortName());
+    fflush(stdout);
+
+    WireNodeInit(&g_sChain, NodeAppend);
+    while(!g_bStop)
+    {
+        WirePortWait(100);
+        WireNodePoll();
+    }
+
+    WireNodeStatsGet(&sStats);
+    fprintf(stderr, "wirenode: tip %u, %u frames, %u bad checksums, "
+            "%u bad lengths, %u bytes skipped\n",
+            (unsigned int)ChainStoreTip(&g_sChain)->header.height,
+            (unsigned int)sStats.ui32Frames,
+            (unsigned int)sStats.ui32CrcErrors,
+            (unsigned int)sStats.ui32LengthErrors,
+            (unsigned int)sStats.ui32Skipped);
+    WirePortClose();
+    ChainLogClose();
+
+    return 0;
+}
+
+#endif
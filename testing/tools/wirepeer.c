@@ -0,0 +1,552 @@
+//*****************************************************************************
+// wirepeer.c
+//
+// Host peer for the framed protocol: drives a board, or wirenode on a
+// pseudo-terminal, over its serial port. Build from this directory:
+//
+//   gcc -O2 -pthread -I.. -o wirepeer wirepeer.c
+//       $(ls ../*.c | grep -v -e main.c -e pinmux.c -e shamd5_userinput.c)
+//
+// (one command line).
+//
+//   wirepeer <device> tip                    print the tip header
+//   wirepeer <device> submit <prio> <tx>     queue one transaction
+//   wirepeer <device> seal                   seal a block now
+//   wirepeer <device> blocks <height> <n>    fetch up to n blocks
+//   wirepeer <device> watch <seconds>        print new headers as they come
+//   wirepeer <device> bench <n>              pipeline n submissions, then
+//                                            fetch the retained window
+//   wirepeer <device> cmd <command...>       run one console command
+//   wirepeer <device> script <file>          run a file of console commands
+//                                            ("-" for stdin), pipelined
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_engine.h"
+#include "perf_clock.h"
+#include "blockchain.h"
+#include "chain_log.h"
+#include "mempool.h"
+#include "console.h"
+#include "wire.h"
+
+//
+// Requests in flight during the benchmark; bounded so that neither side
+// can fill the line while the other is blocked writing.
+//
+#define PEER_WINDOW             32
+
+#define PEER_TIMEOUT_MS         2000
+
+static tWireDecoder g_sDecoder;
+static uint8_t g_pui8Rx[4096];
+static uint32_t g_ui32RxPos, g_ui32RxLen;
+static uint8_t g_pui8Tx[WIRE_FRAME_MAX];
+static uint8_t g_ui8Seq;
+static uint64_t g_ui64BytesOut, g_ui64BytesIn;
+
+static uint8_t
+PeerSend(uint8_t ui8Type, const uint8_t *pui8Payload, uint32_t ui32Length)
+{
+    uint32_t ui32Frame;
+
+    if(++g_ui8Seq == 0)
+    {
+        g_ui8Seq = 1;
+    }
+    ui32Frame = WireEncode(ui8Type, g_ui8Seq, pui8Payload, ui32Length,
+                           g_pui8Tx);
+    WirePortWrite(g_pui8Tx, ui32Frame);
+    g_ui64BytesOut += ui32Frame;
+
+    return g_ui8Seq;
+}
+
+//
+// Next frame from the board, or false after ui32Timeout ms of silence.
+//
+static bool
+PeerRecv(tWireFrame *psFrame, uint32_t ui32Timeout)
+{
+    uint32_t ui32Used;
+    bool bFrame;
+
+    for(;;)
+    {
+        if(g_ui32RxPos == g_ui32RxLen)
+        {
+            if(!WirePortWait(ui32Timeout))
+            {
+                return false;
+            }
+            g_ui32RxLen = WirePortRead(g_pui8Rx, sizeof(g_pui8Rx));
+            g_ui32RxPos = 0;
+            g_ui64BytesIn += g_ui32RxLen;
+        }
+        bFrame = WireDecode(&g_sDecoder, g_pui8Rx + g_ui32RxPos,
+                            g_ui32RxLen - g_ui32RxPos, &ui32Used, psFrame);
+        g_ui32RxPos += ui32Used;
+        if(bFrame)
+        {
+            return true;
+        }
+    }
+}
+
+static void
+PrintHeader(const tWireFrame *psFrame)
+{
+    struct BlockHeader sHeader;
+    uint32_t ui32Idx;
+
+    if((psFrame->ui16Length != WIRE_HEADER_LEN) ||
+       (block_header_deserialize(psFrame->pui8Payload, &sHeader) != 0))
+    {
+        printf("bad header\n");
+        return;
+    }
+    printf("height %u txs %u hash ", (unsigned int)sHeader.height,
+           (unsigned int)(sHeader.data_len / BLOCK_TX_LEN));
+    for(ui32Idx = 0; ui32Idx < BLOCK_HASH_LEN; ui32Idx++)
+    {
+        printf("%02x", psFrame->pui8Payload[BLOCK_HEADER_LEN + ui32Idx]);
+    }
+    printf("\n");
+}
+
+//
+// Send a request and wait for its reply, printing any headers streamed in
+// the meantime.
+//
+static bool
+PeerRequest(uint8_t ui8Type, const uint8_t *pui8Payload, uint32_t ui32Length,
+            tWireFrame *psReply)
+{
+    uint8_t ui8Seq = PeerSend(ui8Type, pui8Payload, ui32Length);
+
+    while(PeerRecv(psReply, PEER_TIMEOUT_MS))
+    {
+        if(psReply->ui8Seq == ui8Seq)
+        {
+            if(psReply->ui8Type == WIRE_ERROR)
+            {
+                printf("error %u\n", (unsigned int)psReply->pui8Payload[0]);
+                return false;
+            }
+            return true;
+        }
+        if(psReply->ui8Type == WIRE_HEADER)
+        {
+            PrintHeader(psReply);
+        }
+    }
+    printf("no reply\n");
+
+    return false;
+}
+
+static int
+CmdSubmit(uint32_t ui32Priority, const char *pcTx)
+{
+    uint8_t pui8Payload[WIRE_TX_SUBMIT_LEN];
+    tWireFrame sReply;
+    static const char * const ppcResult[] =
+    {
+        "added", "duplicate", "rejected"
+    };
+
+    memset(pui8Payload, 0, sizeof(pui8Payload));
+    WirePut32(pui8Payload, ui32Priority);
+    memcpy(pui8Payload + 4, pcTx, strnlen(pcTx, BLOCK_TX_LEN));
+    if(!PeerRequest(WIRE_TX_SUBMIT, pui8Payload, sizeof(pui8Payload),
+                    &sReply))
+    {
+        return 1;
+    }
+    printf("%s\n", (sReply.pui8Payload[0] <= MEMPOOL_REJECTED) ?
+           ppcResult[sReply.pui8Payload[0]] : "?");
+
+    return 0;
+}
+
+//
+// Fetch blocks; returns the number received and checked, or -1.
+//
+static int
+FetchBlocks(uint32_t ui32Height, uint32_t ui32Count, bool bPrint)
+{
+    static struct Block sBlock;
+    uint8_t pui8Payload[WIRE_GET_BLOCKS_LEN];
+    uint8_t ui8Seq;
+    tWireFrame sReply;
+    int iBlocks = 0;
+
+    WirePut32(pui8Payload, ui32Height);
+    pui8Payload[4] = (uint8_t)ui32Count;
+    ui8Seq = PeerSend(WIRE_GET_BLOCKS, pui8Payload, sizeof(pui8Payload));
+    while(PeerRecv(&sReply, PEER_TIMEOUT_MS))
+    {
+        if(sReply.ui8Seq != ui8Seq)
+        {
+            continue;
+        }
+        if(sReply.ui8Type == WIRE_DONE)
+        {
+            return iBlocks;
+        }
+        if((sReply.ui8Type != WIRE_BLOCK) ||
+           (ChainLogDecode(sReply.pui8Payload, sReply.ui16Length, &sBlock) !=
+            sReply.ui16Length))
+        {
+            printf("bad block frame\n");
+            return -1;
+        }
+        if(bPrint)
+        {
+            printf("height %u txs %u: %.*s\n",
+                   (unsigned int)sBlock.header.height,
+                   (unsigned int)block_tx_count(&sBlock), BLOCK_TX_LEN,
+                   (const char *)sBlock.data);
+        }
+        iBlocks++;
+    }
+
+    return -1;
+}
+
+static int
+CmdWatch(uint32_t ui32Seconds)
+{
+    uint8_t ui8On = 1;
+    tWireFrame sFrame;
+    uint64_t ui64End;
+
+    if(!PeerRequest(WIRE_SUBSCRIBE, &ui8On, 1, &sFrame))
+    {
+        return 1;
+    }
+    ui64End = PerfClockNow() + (ui32Seconds * PERF_CLOCK_HZ);
+    while(PerfClockNow() < ui64End)
+    {
+        if(PeerRecv(&sFrame, 100) && (sFrame.ui8Type == WIRE_HEADER))
+        {
+            PrintHeader(&sFrame);
+            fflush(stdout);
+        }
+    }
+    ui8On = 0;
+    PeerRequest(WIRE_SUBSCRIBE, &ui8On, 1, &sFrame);
+
+    return 0;
+}
+
+//
+// Submissions are pipelined PEER_WINDOW deep; the node seals a block each
+// time BLOCK_MAX_TX of them are queued. Then the retained window is read
+// back in full-size batches.
+//
+static int
+CmdBench(uint32_t ui32Count)
+{
+    uint8_t pui8Payload[WIRE_TX_SUBMIT_LEN];
+    uint32_t ui32Sent = 0, ui32Done = 0, ui32Added = 0;
+    uint32_t ui32Low, ui32Mid, ui32Height;
+    uint64_t ui64Ticks, ui64Bytes;
+    struct BlockHeader sTip;
+    tWireFrame sReply;
+    int iBlocks, iTotal = 0;
+    char pcTx[BLOCK_TX_LEN + 1];
+
+    g_ui64BytesOut = g_ui64BytesIn = 0;
+    ui64Ticks = PerfClockNow();
+    while(ui32Done < ui32Count)
+    {
+        while((ui32Sent < ui32Count) && (ui32Sent - ui32Done < PEER_WINDOW))
+        {
+            snprintf(pcTx, sizeof(pcTx), "w%09u",
+                     (unsigned int)(ui32Sent % 1000000000));
+            WirePut32(pui8Payload, ui32Sent % 7);
+            memcpy(pui8Payload + 4, pcTx, BLOCK_TX_LEN);
+            PeerSend(WIRE_TX_SUBMIT, pui8Payload, sizeof(pui8Payload));
+            ui32Sent++;
+        }
+        if(!PeerRecv(&sReply, PEER_TIMEOUT_MS))
+        {
+            printf("timeout after %u replies\n", (unsigned int)ui32Done);
+            return 1;
+        }
+        if(sReply.ui8Type == WIRE_TX_RESULT)
+        {
+            ui32Done++;
+            ui32Added += (sReply.pui8Payload[0] == MEMPOOL_ADDED);
+        }
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    printf("submit    %u txs (%u added), %llu tx/s, out %llu B/s, "
+           "in %llu B/s\n", (unsigned int)ui32Count, (unsigned int)ui32Added,
+           (unsigned long long)PerfClockRate(ui32Count, ui64Ticks),
+           (unsigned long long)PerfClockRate(g_ui64BytesOut, ui64Ticks),
+           (unsigned long long)PerfClockRate(g_ui64BytesIn, ui64Ticks));
+
+    if(!PeerRequest(WIRE_GET_TIP, NULL, 0, &sReply) ||
+       (block_header_deserialize(sReply.pui8Payload, &sTip) != 0))
+    {
+        return 1;
+    }
+    //
+    // Find the oldest retained height, untimed.
+    //
+    ui32Low = 0;
+    ui32Height = sTip.height;
+    while(ui32Low < ui32Height)
+    {
+        ui32Mid = ui32Low + ((ui32Height - ui32Low) / 2);
+        if(FetchBlocks(ui32Mid, 1, false) > 0)
+        {
+            ui32Height = ui32Mid;
+        }
+        else
+        {
+            ui32Low = ui32Mid + 1;
+        }
+    }
+
+    g_ui64BytesIn = 0;
+    ui64Ticks = PerfClockNow();
+    while(ui32Height <= sTip.height)
+    {
+        iBlocks = FetchBlocks(ui32Height, 255, false);
+        if(iBlocks <= 0)
+        {
+            break;
+        }
+        iTotal += iBlocks;
+        ui32Height += (uint32_t)iBlocks;
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    ui64Bytes = g_ui64BytesIn;
+    printf("fetch     %d blocks to height %u, %llu blocks/s, in %llu B/s\n",
+           iTotal, (unsigned int)sTip.height,
+           (unsigned long long)PerfClockRate(iTotal, ui64Ticks),
+           (unsigned long long)PerfClockRate(ui64Bytes, ui64Ticks));
+
+    return 0;
+}
+
+//
+// Print a WIRE_TEXT reply; returns its console status.
+//
+static int
+PrintText(const tWireFrame *psFrame)
+{
+    if((psFrame->ui8Type != WIRE_TEXT) || (psFrame->ui16Length == 0))
+    {
+        printf("bad text frame\n");
+        return CONSOLE_ERR_FAILED;
+    }
+    fwrite(psFrame->pui8Payload + 1, 1, psFrame->ui16Length - 1, stdout);
+
+    return psFrame->pui8Payload[0];
+}
+
+static int
+CmdCommand(int argc, char **argv)
+{
+    char pcLine[CONSOLE_LINE_MAX + 1];
+    uint32_t ui32Length = 0;
+    tWireFrame sReply;
+    int iArg;
+
+    pcLine[0] = '\0';
+    for(iArg = 0; iArg < argc; iArg++)
+    {
+        ui32Length += snprintf(pcLine + ui32Length,
+                               sizeof(pcLine) - ui32Length, "%s%s",
+                               iArg ? " " : "", argv[iArg]);
+        if(ui32Length >= CONSOLE_LINE_MAX)
+        {
+            printf("command too long\n");
+            return 1;
+        }
+    }
+    if(!PeerRequest(WIRE_COMMAND, (const uint8_t *)pcLine, ui32Length,
+                    &sReply))
+    {
+        return 1;
+    }
+
+    return (PrintText(&sReply) == CONSOLE_OK) ? 0 : 1;
+}
+
+//
+// Commands are pipelined PEER_WINDOW deep. The node runs them in order, so
+// replies arrive in the order of the script.
+//
+static int
+CmdScript(const char *pcPath)
+{
+    char pcLine[CONSOLE_LINE_MAX + 2];
+    uint32_t ui32Sent = 0, ui32Done = 0, ui32Errors = 0;
+    uint64_t ui64Ticks;
+    tWireFrame sReply;
+    size_t szLength;
+    FILE *psFile;
+    bool bEnd = false;
+
+    psFile = (strcmp(pcPath, "-") == 0) ? stdin : fopen(pcPath, "r");
+    if(psFile == NULL)
+    {
+        printf("cannot open %s\n", pcPath);
+        return 1;
+    }
+
+    ui64Ticks = PerfClockNow();
+    while(!bEnd || (ui32Done < ui32Sent))
+    {
+        while(!bEnd && ((ui32Sent - ui32Done) < PEER_WINDOW))
+        {
+            if(fgets(pcLine, sizeof(pcLine), psFile) == NULL)
+            {
+                bEnd = true;
+                break;
+            }
+            szLength = strcspn(pcLine, "\r\n");
+            if((szLength == 0) || (pcLine[0] == '#'))
+            {
+                continue;
+            }
+            if(szLength > CONSOLE_LINE_MAX)
+            {
+                szLength = CONSOLE_LINE_MAX;
+            }
+            PeerSend(WIRE_COMMAND, (const uint8_t *)pcLine, szLength);
+            ui32Sent++;
+        }
+        if(ui32Done == ui32Sent)
+        {
+            continue;
+        }
+        if(!PeerRecv(&sReply, PEER_TIMEOUT_MS))
+        {
+            printf("no reply\n");
+            break;
+        }
+        if(sReply.ui8Type == WIRE_HEADER)
+        {
+            continue;
+        }
+        if((sReply.ui8Type == WIRE_ERROR) || (PrintText(&sReply) != 0))
+        {
+            ui32Errors++;
+        }
+        ui32Done++;
+    }
+    ui64Ticks = PerfClockNow() - ui64Ticks;
+    if(psFile != stdin)
+    {
+        fclose(psFile);
+    }
+    fprintf(stderr, "%u commands, %u failed, %llu commands/s\n",
+            (unsigned int)ui32Done, (unsigned int)ui32Errors,
+            (unsigned long long)PerfClockRate(ui32Done, ui64Ticks));
+
+    return ((ui32Done == ui32Sent) && (ui32Errors == 0)) ? 0 : 1;
+}
+
+static int
+Usage(void)
+{
+    printf("usage: wirepeer <device> tip\n"
+           "       wirepeer <device> submit <prio> <tx>\n"
+           "       wirepeer <device> seal\n"
+           "       wirepeer <device> blocks <height> <n>\n"
+           "       wirepeer <device> watch <seconds>\n"
+           "       wirepeer <device> bench <n>\n"
+           "       wirepeer <device> cmd <command...>\n"
+           "       wirepeer <device> script <file>\n");
+
+    return 2;
+}
+
+int
+main(int argc, char **argv)
+{
+    tWireFrame sReply;
+    tWireStats sStats;
+    int iResult = 0;
+
+    PerfClockInit();
+    HashEngineInit();
+    if(argc < 3)
+    {
+        return Usage();
+    }
+    if(!WirePortOpen(argv[1]))
+    {
+        printf("cannot open %s\n", argv[1]);
+        return 1;
+    }
+    WireDecoderInit(&g_sDecoder);
+
+    if(!strcmp(argv[2], "tip"))
+    {
+        iResult = PeerRequest(WIRE_GET_TIP, NULL, 0, &sReply) ?
+                  (PrintHeader(&sReply), 0) : 1;
+    }
+    else if(!strcmp(argv[2], "submit") && (argc > 4))
+    {
+        iResult = CmdSubmit((uint32_t)strtoul(argv[3], NULL, 0), argv[4]);
+    }
+    else if(!strcmp(argv[2], "seal"))
+    {
+        iResult = PeerRequest(WIRE_SEAL, NULL, 0, &sReply) ?
+                  (PrintHeader(&sReply), 0) : 1;
+    }
+    else if(!strcmp(argv[2], "blocks") && (argc > 4))
+    {
+        iResult = (FetchBlocks((uint32_t)strtoul(argv[3], NULL, 0),
+                               (uint32_t)strtoul(argv[4], NULL, 0),
+                               true) < 0) ? 1 : 0;
+    }
+    else if(!strcmp(argv[2], "watch") && (argc > 3))
+    {
+        iResult = CmdWatch((uint32_t)strtoul(argv[3], NULL, 0));
+    }
+    else if(!strcmp(argv[2], "bench") && (argc > 3))
+    {
+        iResult = CmdBench((uint32_t)strtoul(argv[3], NULL, 0));
+    }
+    else if(!strcmp(argv[2], "cmd") && (argc > 3))
+    {
+        iResult = CmdCommand(argc - 3, argv + 3);
+    }
+    else if(!strcmp(argv[2], "script") && (argc > 3))
+    {
+        iResult = CmdScript(argv[3]);
+    }
+    else
+    {
+        iResult = Usage();
+    }
+
+    sStats = g_sDecoder.sStats;
+    if(sStats.ui32CrcErrors || sStats.ui32LengthErrors)
+    {
+        printf("%u bad checksums, %u bad lengths\n",
+               (unsigned int)sStats.ui32CrcErrors,
+               (unsigned int)sStats.ui32LengthErrors);
+    }
+    WirePortClose();
+
+    return iResult;
+}
+
+#endif
@@ -0,0 +1,821 @@
+//*****************************************************************************
+// uart_buf.c
+//
+// Ring-buffered console UART: uDMA-driven transmit, interrupt-driven
+// receive, and the simulated UART that stands in for UARTA0 on the host
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(cc3200)
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "hw_ints.h"
+#include "hw_uart.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "uart.h"
+#include "udma.h"
+#endif
+
+#include "uart_buf.h"
+#include "perf_probe.h"
+
+#if defined(cc3200)
+//*****************************************************************************
+//
+// uDMA channel wired to the UARTA0 transmit request. Override from the
+// project settings if the channel map differs.
+//
+//*****************************************************************************
+#ifndef UART_BUF_DMA_CHANNEL
+#define UART_BUF_DMA_CHANNEL    UDMA_CH9_UARTA0_TX
+#endif
+#endif
+
+static uint8_t g_pui8TxBuf[UART_BUF_TX_SIZE];
+static uint8_t g_pui8RxBuf[UART_BUF_RX_SIZE];
+static tUartRing g_sTxRing;
+static tUartRing g_sRxRing;
+static tUartBufStats g_sStats;
+
+//
+// Length of the transmit transfer in progress, 0 while the channel is idle.
+// Its bytes stay in the ring until the transfer completes.
+//
+static volatile uint32_t g_ui32TxInFlight;
+
+//*****************************************************************************
+//
+//! Set up a ring over a buffer
+//!
+//! \param psRing is the ring
+//! \param pui8Buf is the storage
+//! \param ui32Size is the storage length, a power of two
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartRingInit(tUartRing *psRing, uint8_t *pui8Buf, uint32_t ui32Size)
+{
+    psRing->pui8Buf = pui8Buf;
+    psRing->ui32Mask = ui32Size - 1;
+    psRing->ui32Head = 0;
+    psRing->ui32Tail = 0;
+    psRing->ui32HighWater = 0;
+}
+
+//*****************************************************************************
+//
+//! Bytes waiting in a ring
+//!
+//! \param psRing is the ring
+//!
+//! \return the fill level
+//
+//*****************************************************************************
+uint32_t
+UartRingUsed(const tUartRing *psRing)
+{
+    return psRing->ui32Head - psRing->ui32Tail;
+}
+
+//*****************************************************************************
+//
+//! Copy bytes into a ring. Producer side only.
+//!
+//! \param psRing is the ring
+//! \param pui8Data is the data
+//! \param ui32Length is the data length
+//!
+//! \return the number of bytes copied, fewer than ui32Length if the ring
+//! filled up
+//
+//*****************************************************************************
+uint32_t
+UartRingPut(tUartRing *psRing, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Head = psRing->ui32Head;
+    uint32_t ui32Free = psRing->ui32Mask + 1 - (ui32Head - psRing->ui32Tail);
+    uint32_t ui32Offset, ui32Run;
+
+    if(ui32Length > ui32Free)
+    {
+        ui32Length = ui32Free;
+    }
+
+    //
+    // At most two copies: up to the end of the storage, then from its start.
+    //
+    ui32Offset = ui32Head & psRing->ui32Mask;
+    ui32Run = psRing->ui32Mask + 1 - ui32Offset;
+    if(ui32Run > ui32Length)
+    {
+        ui32Run = ui32Length;
+    }
+    memcpy(psRing->pui8Buf + ui32Offset, pui8Data, ui32Run);
+    memcpy(psRing->pui8Buf, pui8Data + ui32Run, ui32Length - ui32Run);
+
+    ui32Head += ui32Length;
+    psRing->ui32Head = ui32Head;
+    if((ui32Head - psRing->ui32Tail) > psRing->ui32HighWater)
+    {
+        psRing->ui32HighWater = ui32Head - psRing->ui32Tail;
+    }
+
+    return ui32Length;
+}
+
+//*****************************************************************************
+//
+//! Copy bytes out of a ring. Consumer side only.
+//!
+//! \param psRing is the ring
+//! \param pui8Data receives the data
+//! \param ui32Max is the most to take
+//!
+//! \return the number of bytes taken
+//
+//*****************************************************************************
+uint32_t
+UartRingGet(tUartRing *psRing, uint8_t *pui8Data, uint32_t ui32Max)
+{
+    const uint8_t *pui8Run;
+    uint32_t ui32Taken = 0;
+    uint32_t ui32Run;
+
+    while(ui32Taken < ui32Max)
+    {
+        ui32Run = UartRingPeek(psRing, &pui8Run);
+        if(ui32Run == 0)
+        {
+            break;
+        }
+        if(ui32Run > (ui32Max - ui32Taken))
+        {
+            ui32Run = ui32Max - ui32Taken;
+        }
+        memcpy(pui8Data + ui32Taken, pui8Run, ui32Run);
+        UartRingSkip(psRing, ui32Run);
+        ui32Taken += ui32Run;
+    }
+
+    return ui32Taken;
+}
+
+//*****************************************************************************
+//
+//! Find the oldest contiguous run of bytes in a ring, for a DMA transfer
+//! straight out of its storage. Consumer side only.
+//!
+//! \param psRing is the ring
+//! \param ppui8Data receives the start of the run
+//!
+//! \return the run length, 0 if the ring is empty
+//
+//*****************************************************************************
+uint32_t
+UartRingPeek(const tUartRing *psRing, const uint8_t **ppui8Data)
+{
+    uint32_t ui32Used = psRing->ui32Head - psRing->ui32Tail;
+    uint32_t ui32Offset = psRing->ui32Tail & psRing->ui32Mask;
+    uint32_t ui32Run = psRing->ui32Mask + 1 - ui32Offset;
+
+    *ppui8Data = psRing->pui8Buf + ui32Offset;
+
+    return (ui32Run < ui32Used) ? ui32Run : ui32Used;
+}
+
+//*****************************************************************************
+//
+//! Release bytes from the front of a ring. Consumer side only.
+//!
+//! \param psRing is the ring
+//! \param ui32Length is the number of bytes consumed
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartRingSkip(tUartRing *psRing, uint32_t ui32Length)
+{
+    psRing->ui32Tail += ui32Length;
+}
+
+//*****************************************************************************
+//
+// Hardware primitives, one set per build. UartPortRxGet() pops the receive
+// FIFO, UartPortTxStart() starts a transfer that ends in a call to
+// UartBufTxService(), UartPortTxLock() keeps that call out while thread
+// code starts a transfer, and UartPortWait() lets time pass while a
+// blocking call waits on the rings.
+//
+//*****************************************************************************
+static long UartPortRxGet(void);
+static void UartPortTxStart(const uint8_t *pui8Data, uint32_t ui32Length);
+static void UartPortTxLock(bool bLock);
+static bool UartPortWait(void);
+
+//*****************************************************************************
+//
+//! Start transmitting the oldest queued bytes if the channel is idle.
+//! Called from the transmit-done interrupt, or with it locked out.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+UartBufTxStart(void)
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32Length;
+
+    if(g_ui32TxInFlight != 0)
+    {
+        return;
+    }
+    ui32Length = UartRingPeek(&g_sTxRing, &pui8Data);
+    if(ui32Length == 0)
+    {
+        return;
+    }
+    if(ui32Length > UART_BUF_DMA_MAX)
+    {
+        ui32Length = UART_BUF_DMA_MAX;
+    }
+    g_ui32TxInFlight = ui32Length;
+    g_sStats.ui32TxTransfers++;
+    UartPortTxStart(pui8Data, ui32Length);
+}
+
+//*****************************************************************************
+//
+//! Transmit-done interrupt: release the bytes sent and chain the next
+//! transfer.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+UartBufTxService(void)
+{
+    UartRingSkip(&g_sTxRing, g_ui32TxInFlight);
+    g_sStats.ui32TxBytes += g_ui32TxInFlight;
+    g_ui32TxInFlight = 0;
+    UartBufTxStart();
+}
+
+//*****************************************************************************
+//
+//! Receive interrupt: drain the FIFO into the receive ring. Bytes that do
+//! not fit are dropped and counted, so the FIFO never backs up.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+static void
+UartBufRxService(void)
+{
+    long lChar;
+    uint8_t ui8Char;
+
+    while((lChar = UartPortRxGet()) >= 0)
+    {
+        ui8Char = (uint8_t)lChar;
+        if(UartRingPut(&g_sRxRing, &ui8Char, 1))
+        {
+            g_sStats.ui32RxBytes++;
+        }
+        else
+        {
+            g_sStats.ui32RxOverruns++;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Queue bytes for transmission without waiting
+//!
+//! \param pui8Data is the data
+//! \param ui32Length is the data length
+//!
+//! \return the number of bytes queued
+//
+//*****************************************************************************
+uint32_t
+UartBufWriteNonBlocking(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Queued;
+
+    ui32Queued = UartRingPut(&g_sTxRing, pui8Data, ui32Length);
+    UartPortTxLock(true);
+    UartBufTxStart();
+    UartPortTxLock(false);
+
+    return ui32Queued;
+}
+
+//*****************************************************************************
+//
+//! Queue bytes for transmission. Returns as soon as the last byte is in the
+//! ring; waits only while the ring is full.
+//!
+//! \param pui8Data is the data
+//! \param ui32Length is the data length
+//!
+//! \return false if the line stopped before everything was queued
+//
+//*****************************************************************************
+bool
+UartBufWrite(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Queued;
+    bool bStalled = false;
+
+    for(;;)
+    {
+        ui32Queued = UartBufWriteNonBlocking(pui8Data, ui32Length);
+        pui8Data += ui32Queued;
+        ui32Length -= ui32Queued;
+        if(ui32Length == 0)
+        {
+            return true;
+        }
+        if(!bStalled)
+        {
+            g_sStats.ui32TxStalls++;
+            bStalled = true;
+        }
+        if(!UartPortWait())
+        {
+            return false;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Take received bytes without waiting
+//!
+//! \param pui8Data receives the data
+//! \param ui32Max is the most to take
+//!
+//! \return the number of bytes taken
+//
+//*****************************************************************************
+uint32_t
+UartBufRead(uint8_t *pui8Data, uint32_t ui32Max)
+{
+    return UartRingGet(&g_sRxRing, pui8Data, ui32Max);
+}
+
+//*****************************************************************************
+//
+//! Wait for one received character
+//!
+//! \param None
+//!
+//! \return the character, or 0 if the line stopped
+//
+//*****************************************************************************
+char
+UartBufGetChar(void)
+{
+    uint8_t ui8Char;
+
+    while(UartRingGet(&g_sRxRing, &ui8Char, 1) == 0)
+    {
+        if(!UartPortWait())
+        {
+            return 0;
+        }
+    }
+
+    return (char)ui8Char;
+}
+
+//*****************************************************************************
+//
+//! Queue one character
+//!
+//! \param cChar is the character
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufPutChar(char cChar)
+{
+    UartBufWrite((const uint8_t *)&cChar, 1);
+}
+
+//*****************************************************************************
+//
+//! Read a line with echo and backspace editing, as GetCmd() does
+//!
+//! \param pcLine receives the line, NUL terminated, without its terminator
+//! \param ui32Max is the size of pcLine
+//!
+//! \return the line length
+//
+//*****************************************************************************
+uint32_t
+UartBufGetLine(char *pcLine, uint32_t ui32Max)
+{
+    uint32_t ui32Len = 0;
+    char cChar;
+
+    for(;;)
+    {
+        cChar = UartBufGetChar();
+        if((cChar == '\r') || (cChar == '\n') || (cChar == 0))
+        {
+            break;
+        }
+        if((cChar == '\b') || (cChar == 0x7F))
+        {
+            if(ui32Len)
+            {
+                ui32Len--;
+                UartBufWrite((const uint8_t *)"\b \b", 3);
+            }
+            continue;
+        }
+        if(ui32Len + 1 < ui32Max)
+        {
+            pcLine[ui32Len++] = cChar;
+            UartBufPutChar(cChar);
+        }
+    }
+    pcLine[ui32Len] = '\0';
+    UartBufWrite((const uint8_t *)"\n\r", 2);
+
+    return ui32Len;
+}
+
+//*****************************************************************************
+//
+//! Format into the transmit ring; the replacement for Report(). The line is
+//! formatted once and queued in one copy instead of a UART write per byte.
+//!
+//! \param pcFormat is the printf format
+//!
+//! \return the number of characters queued
+//
+//*****************************************************************************
+int
+UartBufPrintf(const char *pcFormat, ...)
+{
+    char pcLine[UART_BUF_PRINTF_MAX];
+    va_list vaArgs;
+    int iLength;
+    PERF_PROBE_START(ui64Start);
+
+    va_start(vaArgs, pcFormat);
+    iLength = vsnprintf(pcLine, sizeof(pcLine), pcFormat, vaArgs);
+    va_end(vaArgs);
+    if(iLength < 0)
+    {
+        return iLength;
+    }
+    if(iLength >= (int)sizeof(pcLine))
+    {
+        iLength = sizeof(pcLine) - 1;
+    }
+    UartBufWrite((const uint8_t *)pcLine, (uint32_t)iLength);
+    PERF_PROBE_STOP(PERF_SITE_UART_PRINT, ui64Start);
+
+    return iLength;
+}
+
+//*****************************************************************************
+//
+//! Wait until everything queued has been sent
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufFlush(void)
+{
+    while(UartRingUsed(&g_sTxRing) != 0)
+    {
+        if(!UartPortWait())
+        {
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Get the counters
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufStatsGet(tUartBufStats *psStats)
+{
+    *psStats = g_sStats;
+    psStats->ui32TxHighWater = g_sTxRing.ui32HighWater;
+    psStats->ui32RxHighWater = g_sRxRing.ui32HighWater;
+}
+
+#if defined(cc3200)
+//*****************************************************************************
+//
+// Board: UARTA0, transmit by uDMA, receive on the FIFO level and timeout
+// interrupts
+//
+//*****************************************************************************
+static long
+UartPortRxGet(void)
+{
+    return MAP_UARTCharGetNonBlocking(UARTA0_BASE);
+}
+
+static void
+UartPortTxStart(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    MAP_uDMAChannelControlSet(UART_BUF_DMA_CHANNEL | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                              UDMA_DST_INC_NONE | UDMA_ARB_4);
+    MAP_uDMAChannelTransferSet(UART_BUF_DMA_CHANNEL | UDMA_PRI_SELECT,
+                               UDMA_MODE_BASIC, (void *)pui8Data,
+                               (void *)(UARTA0_BASE + UART_O_DR), ui32Length);
+    MAP_uDMAChannelEnable(UART_BUF_DMA_CHANNEL);
+}
+
+static void
+UartPortTxLock(bool bLock)
+{
+    if(bLock)
+    {
+        MAP_UARTIntDisable(UARTA0_BASE, UART_INT_DMATX);
+    }
+    else
+    {
+        MAP_UARTIntEnable(UARTA0_BASE, UART_INT_DMATX);
+    }
+}
+
+static bool
+UartPortWait(void)
+{
+    //
+    // The interrupts move the data; there is nothing to do but wait.
+    //
+    return true;
+}
+
+//*****************************************************************************
+//
+//! UARTA0 interrupt handler
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufIntHandler(void)
+{
+    unsigned long ulStatus;
+
+    ulStatus = MAP_UARTIntStatus(UARTA0_BASE, true);
+    MAP_UARTIntClear(UARTA0_BASE, ulStatus);
+
+    if(ulStatus & (UART_INT_RX | UART_INT_RT))
+    {
+        UartBufRxService();
+    }
+    if(ulStatus & UART_INT_DMATX)
+    {
+        UartBufTxService();
+    }
+}
+
+//*****************************************************************************
+//
+//! Take over the console UART. Call after InitTerm() and UDMAInit(); from
+//! then on all console I/O must go through this module.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufInit(void)
+{
+    UartRingInit(&g_sTxRing, g_pui8TxBuf, sizeof(g_pui8TxBuf));
+    UartRingInit(&g_sRxRing, g_pui8RxBuf, sizeof(g_pui8RxBuf));
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    g_ui32TxInFlight = 0;
+
+    MAP_uDMAChannelAssign(UART_BUF_DMA_CHANNEL);
+    MAP_uDMAChannelAttributeDisable(UART_BUF_DMA_CHANNEL,
+                                    UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                    UDMA_ATTR_HIGH_PRIORITY |
+                                    UDMA_ATTR_REQMASK);
+
+    //
+    // Interrupt on a half-full receive FIFO, or on the receive timeout for
+    // the bytes left below that level.
+    //
+    MAP_UARTFIFOLevelSet(UARTA0_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    MAP_UARTDMAEnable(UARTA0_BASE, UART_DMA_TX);
+    MAP_UARTIntRegister(UARTA0_BASE, UartBufIntHandler);
+    MAP_UARTIntClear(UARTA0_BASE, UART_INT_RX | UART_INT_RT | UART_INT_DMATX);
+    MAP_UARTIntEnable(UARTA0_BASE, UART_INT_RX | UART_INT_RT | UART_INT_DMATX);
+}
+#else
+//*****************************************************************************
+//
+// Host: simulated UART. Like UARTA0 it has a 16-byte receive FIFO that
+// interrupts at half full or when the line goes idle, and a transmit DMA
+// channel that raises its done interrupt once the last byte has gone.
+//
+//*****************************************************************************
+#define UART_SIM_FIFO           16
+#define UART_SIM_RX_LEVEL       8
+
+static tUartSimTx g_pfnSimTx;
+static tUartSimRx g_pfnSimRx;
+static void *g_pvSimArg;
+static const uint8_t *g_pui8SimTxData;
+static uint32_t g_ui32SimTxLeft;
+static uint8_t g_pui8SimRxFIFO[UART_SIM_FIFO];
+static uint32_t g_ui32SimRxHead;
+static uint32_t g_ui32SimRxCount;
+
+static long
+UartPortRxGet(void)
+{
+    uint8_t ui8Char;
+
+    if(g_ui32SimRxCount == 0)
+    {
+        return -1;
+    }
+    ui8Char = g_pui8SimRxFIFO[g_ui32SimRxHead];
+    g_ui32SimRxHead = (g_ui32SimRxHead + 1) % UART_SIM_FIFO;
+    g_ui32SimRxCount--;
+
+    return ui8Char;
+}
+
+static void
+UartPortTxStart(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    g_pui8SimTxData = pui8Data;
+    g_ui32SimTxLeft = ui32Length;
+}
+
+static void
+UartPortTxLock(bool bLock)
+{
+    //
+    // The simulated interrupts run on the caller's thread.
+    //
+    (void)bLock;
+}
+
+static bool
+UartPortWait(void)
+{
+    return UartBufSimStep(UART_SIM_FIFO);
+}
+
+//*****************************************************************************
+//
+//! Reset the rings and counters
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufInit(void)
+{
+    UartRingInit(&g_sTxRing, g_pui8TxBuf, sizeof(g_pui8TxBuf));
+    UartRingInit(&g_sRxRing, g_pui8RxBuf, sizeof(g_pui8RxBuf));
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    g_ui32TxInFlight = 0;
+    g_ui32SimTxLeft = 0;
+    g_ui32SimRxHead = 0;
+    g_ui32SimRxCount = 0;
+}
+
+//*****************************************************************************
+//
+//! Connect the simulated UART to a line
+//!
+//! \param pfnTx receives transmitted bytes
+//! \param pfnRx supplies received bytes, returning how many it gave
+//! \param pvArg is passed to both
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+UartBufSimAttach(tUartSimTx pfnTx, tUartSimRx pfnRx, void *pvArg)
+{
+    g_pfnSimTx = pfnTx;
+    g_pfnSimRx = pfnRx;
+    g_pvSimArg = pvArg;
+}
+
+//*****************************************************************************
+//
+//! Let byte times pass on the simulated line
+//!
+//! \param ui32Bytes is the number of byte times, in each direction
+//!
+//! \return false if nothing moved: no line is attached, or it is idle
+//
+//*****************************************************************************
+bool
+UartBufSimStep(uint32_t ui32Bytes)
+{
+    uint8_t pui8Rx[UART_SIM_FIFO];
+    uint32_t ui32Count, ui32Got, ui32Idx;
+    bool bMoved = false;
+
+    if((g_pfnSimTx == NULL) || (g_pfnSimRx == NULL))
+    {
+        return false;
+    }
+
+    //
+    // Transmit: the channel shifts out up to ui32Bytes, and interrupts when
+    // its transfer is done.
+    //
+    ui32Count = (g_ui32SimTxLeft < ui32Bytes) ? g_ui32SimTxLeft : ui32Bytes;
+    if(ui32Count)
+    {
+        g_pfnSimTx(g_pvSimArg, g_pui8SimTxData, ui32Count);
+        g_pui8SimTxData += ui32Count;
+        g_ui32SimTxLeft -= ui32Count;
+        bMoved = true;
+        if(g_ui32SimTxLeft == 0)
+        {
+            UartBufTxService();
+        }
+    }
+
+    //
+    // Receive: a FIFO's worth of byte times at a time, interrupting at the
+    // FIFO level, or on the timeout once the line has gone quiet.
+    //
+    while(ui32Bytes)
+    {
+        ui32Count = UART_SIM_FIFO - g_ui32SimRxCount;
+        if(ui32Count > ui32Bytes)
+        {
+            ui32Count = ui32Bytes;
+        }
+        ui32Got = g_pfnSimRx(g_pvSimArg, pui8Rx, ui32Count);
+        for(ui32Idx = 0; ui32Idx < ui32Got; ui32Idx++)
+        {
+            g_pui8SimRxFIFO[(g_ui32SimRxHead + g_ui32SimRxCount++) %
+                            UART_SIM_FIFO] = pui8Rx[ui32Idx];
+        }
+        ui32Bytes -= ui32Count;
+        if(ui32Got)
+        {
+            bMoved = true;
+        }
+        if((g_ui32SimRxCount >= UART_SIM_RX_LEVEL) ||
+           ((ui32Got < ui32Count) && g_ui32SimRxCount))
+        {
+            UartBufRxService();
+        }
+        if(ui32Got < ui32Count)
+        {
+            break;
+        }
+    }
+
+    return bMoved;
+}
+#endif
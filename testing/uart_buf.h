@@ -0,0 +1,150 @@
+//*****************************************************************************
+// uart_buf.h
+//
+// Ring-buffered console UART. Writers copy into a transmit ring that uDMA
+// drains into the UART; received bytes are moved from the FIFO into a
+// receive ring by the UART interrupt. Neither side touches the UART per
+// byte, so hashing and block production carry on while data flows.
+//
+// The rings and the interrupt-side service routines hold no hardware state:
+// the same code runs against UARTA0 on the board and against the simulated
+// UART (UartBufSim*) on the host.
+//
+//*****************************************************************************
+
+#ifndef __UART_BUF_H__
+#define __UART_BUF_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+//
+// Ring sizes, powers of two. The transmit ring holds a full protocol frame
+// (wire.h) with room to queue the next one behind it.
+//
+//*****************************************************************************
+#ifndef UART_BUF_TX_BITS
+#define UART_BUF_TX_BITS        12
+#endif
+#ifndef UART_BUF_RX_BITS
+#define UART_BUF_RX_BITS        10
+#endif
+
+#define UART_BUF_TX_SIZE        (1u << UART_BUF_TX_BITS)
+#define UART_BUF_RX_SIZE        (1u << UART_BUF_RX_BITS)
+
+//*****************************************************************************
+//
+// Largest single transmit transfer: the uDMA moves at most 1024 items.
+//
+//*****************************************************************************
+#define UART_BUF_DMA_MAX        1024
+
+//*****************************************************************************
+//
+// Longest line UartBufPrintf() formats; longer output is truncated.
+//
+//*****************************************************************************
+#define UART_BUF_PRINTF_MAX     256
+
+//*****************************************************************************
+//
+// Single-producer, single-consumer byte ring. The indices run freely and
+// are masked on use, so head - tail is always the fill level and a full
+// ring needs no spare slot. Each index is written by one side only.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Buf;
+    uint32_t ui32Mask;
+    volatile uint32_t ui32Head;
+    volatile uint32_t ui32Tail;
+    uint32_t ui32HighWater;
+} tUartRing;
+
+extern void UartRingInit(tUartRing *psRing, uint8_t *pui8Buf,
+                         uint32_t ui32Size);
+extern uint32_t UartRingUsed(const tUartRing *psRing);
+extern uint32_t UartRingPut(tUartRing *psRing, const uint8_t *pui8Data,
+                            uint32_t ui32Length);
+extern uint32_t UartRingGet(tUartRing *psRing, uint8_t *pui8Data,
+                            uint32_t ui32Max);
+extern uint32_t UartRingPeek(const tUartRing *psRing,
+                             const uint8_t **ppui8Data);
+extern void UartRingSkip(tUartRing *psRing, uint32_t ui32Length);
+
+//*****************************************************************************
+//
+// Counters since UartBufInit(). High-water marks are the fullest each ring
+// has been; TX stalls count writes that had to wait for room, RX overruns
+// bytes dropped because the receive ring was full.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32TxBytes;
+    uint32_t ui32RxBytes;
+    uint32_t ui32TxTransfers;
+    uint32_t ui32TxHighWater;
+    uint32_t ui32RxHighWater;
+    uint32_t ui32TxStalls;
+    uint32_t ui32RxOverruns;
+} tUartBufStats;
+
+extern void UartBufInit(void);
+extern bool UartBufWrite(const uint8_t *pui8Data, uint32_t ui32Length);
+extern uint32_t UartBufWriteNonBlocking(const uint8_t *pui8Data,
+                                        uint32_t ui32Length);
+extern uint32_t UartBufRead(uint8_t *pui8Data, uint32_t ui32Max);
+extern char UartBufGetChar(void);
+extern void UartBufPutChar(char cChar);
+extern uint32_t UartBufGetLine(char *pcLine, uint32_t ui32Max);
+extern int UartBufPrintf(const char *pcFormat, ...);
+extern void UartBufFlush(void);
+extern void UartBufStatsGet(tUartBufStats *psStats);
+
+#if defined(cc3200)
+extern void UartBufIntHandler(void);
+#else
+//*****************************************************************************
+//
+// Simulated UART for the host. The line is a pair of callbacks: pfnTx
+// receives what the UART shifts out, pfnRx supplies what arrives on its
+// receive pin. UartBufSimStep() lets up to ui32Bytes byte times pass on the
+// line, raising the receive and transmit-done "interrupts" as the hardware
+// would. Blocking calls step the line themselves while they wait.
+//
+//*****************************************************************************
+typedef void (*tUartSimTx)(void *pvArg, const uint8_t *pui8Data,
+                           uint32_t ui32Length);
+typedef uint32_t (*tUartSimRx)(void *pvArg, uint8_t *pui8Data,
+                               uint32_t ui32Max);
+
+extern void UartBufSimAttach(tUartSimTx pfnTx, tUartSimRx pfnRx,
+                             void *pvArg);
+extern bool UartBufSimStep(uint32_t ui32Bytes);
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_BUF_H__
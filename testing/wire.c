@@ -0,0 +1,192 @@
+//*****************************************************************************
+// wire.c
+//
+// Frame encoding and decoding for the board/host protocol
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "wire.h"
+#include "crc32.h"
+
+//*****************************************************************************
+//
+//! Store a 32-bit little-endian value
+//!
+//! \param pui8Out receives the four bytes
+//! \param ui32Value is the value
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WirePut32(uint8_t *pui8Out, uint32_t ui32Value)
+{
+    pui8Out[0] = (uint8_t)ui32Value;
+    pui8Out[1] = (uint8_t)(ui32Value >> 8);
+    pui8Out[2] = (uint8_t)(ui32Value >> 16);
+    pui8Out[3] = (uint8_t)(ui32Value >> 24);
+}
+
+//*****************************************************************************
+//
+//! Load a 32-bit little-endian value
+//!
+//! \param pui8In is the four bytes
+//!
+//! \return the value
+//
+//*****************************************************************************
+uint32_t
+WireGet32(const uint8_t *pui8In)
+{
+    return (uint32_t)pui8In[0] | ((uint32_t)pui8In[1] << 8) |
+           ((uint32_t)pui8In[2] << 16) | ((uint32_t)pui8In[3] << 24);
+}
+
+//*****************************************************************************
+//
+//! Build a frame
+//!
+//! \param ui8Type is the message type
+//! \param ui8Seq is the sequence number
+//! \param pui8Payload is the payload; it may already be in place at
+//! pui8Frame + WIRE_HDR_LEN
+//! \param ui32Length is the payload length, at most WIRE_MAX_PAYLOAD
+//! \param pui8Frame receives the frame, up to WIRE_FRAME_MAX bytes
+//!
+//! \return the frame length, or 0 if the payload is too long
+//
+//*****************************************************************************
+uint32_t
+WireEncode(uint8_t ui8Type, uint8_t ui8Seq, const uint8_t *pui8Payload,
+           uint32_t ui32Length, uint8_t *pui8Frame)
+{
+    if(ui32Length > WIRE_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    pui8Frame[0] = WIRE_SYNC;
+    pui8Frame[1] = ui8Type;
+    pui8Frame[2] = ui8Seq;
+    pui8Frame[3] = (uint8_t)ui32Length;
+    pui8Frame[4] = (uint8_t)(ui32Length >> 8);
+    if((ui32Length != 0) && (pui8Payload != pui8Frame + WIRE_HDR_LEN))
+    {
+        memmove(pui8Frame + WIRE_HDR_LEN, pui8Payload, ui32Length);
+    }
+    WirePut32(pui8Frame + WIRE_HDR_LEN + ui32Length,
+              Crc32(0, pui8Frame + 1, WIRE_HDR_LEN - 1 + ui32Length));
+
+    return WIRE_HDR_LEN + ui32Length + WIRE_CRC_LEN;
+}
+
+//*****************************************************************************
+//
+//! Reset a decoder to hunt for the next frame
+//!
+//! \param psDecoder is the decoder
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WireDecoderInit(tWireDecoder *psDecoder)
+{
+    memset(psDecoder, 0, sizeof(*psDecoder));
+    psDecoder->ui32Need = WIRE_HDR_LEN;
+}
+
+//*****************************************************************************
+//
+//! Feed received bytes to a decoder. Decoding stops at the end of the first
+//! complete, valid frame so that it can be handled before the rest of the
+//! data is fed in.
+//!
+//! \param psDecoder is the decoder
+//! \param pui8Data is the received data
+//! \param ui32Length is the number of bytes in pui8Data
+//! \param pui32Used receives the number of bytes consumed
+//! \param psFrame receives the frame
+//!
+//! \return true if a frame was completed
+//
+//*****************************************************************************
+bool
+WireDecode(tWireDecoder *psDecoder, const uint8_t *pui8Data,
+           uint32_t ui32Length, uint32_t *pui32Used, tWireFrame *psFrame)
+{
+    uint32_t ui32Pos = 0, ui32Chunk, ui32Payload;
+
+    while(ui32Pos < ui32Length)
+    {
+        if(psDecoder->ui32Have == 0)
+        {
+            if(pui8Data[ui32Pos++] != WIRE_SYNC)
+            {
+                psDecoder->sStats.ui32Skipped++;
+                continue;
+            }
+            psDecoder->pui8Frame[0] = WIRE_SYNC;
+            psDecoder->ui32Have = 1;
+            psDecoder->ui32Need = WIRE_HDR_LEN;
+            continue;
+        }
+
+        ui32Chunk = psDecoder->ui32Need - psDecoder->ui32Have;
+        if(ui32Chunk > ui32Length - ui32Pos)
+        {
+            ui32Chunk = ui32Length - ui32Pos;
+        }
+        memcpy(psDecoder->pui8Frame + psDecoder->ui32Have, pui8Data + ui32Pos,
+               ui32Chunk);
+        psDecoder->ui32Have += ui32Chunk;
+        ui32Pos += ui32Chunk;
+        if(psDecoder->ui32Have < psDecoder->ui32Need)
+        {
+            break;
+        }
+
+        //
+        // Header complete: now the payload and checksum are needed.
+        //
+        ui32Payload = psDecoder->pui8Frame[3] |
+                      ((uint32_t)psDecoder->pui8Frame[4] << 8);
+        if(psDecoder->ui32Need == WIRE_HDR_LEN)
+        {
+            if(ui32Payload > WIRE_MAX_PAYLOAD)
+            {
+                psDecoder->sStats.ui32LengthErrors++;
+                psDecoder->ui32Have = 0;
+                continue;
+            }
+            psDecoder->ui32Need = WIRE_HDR_LEN + ui32Payload + WIRE_CRC_LEN;
+            continue;
+        }
+
+        //
+        // Whole frame.
+        //
+        psDecoder->ui32Have = 0;
+        if(WireGet32(psDecoder->pui8Frame + WIRE_HDR_LEN + ui32Payload) !=
+           Crc32(0, psDecoder->pui8Frame + 1, WIRE_HDR_LEN - 1 + ui32Payload))
+        {
+            psDecoder->sStats.ui32CrcErrors++;
+            continue;
+        }
+        psDecoder->sStats.ui32Frames++;
+        psFrame->ui8Type = psDecoder->pui8Frame[1];
+        psFrame->ui8Seq = psDecoder->pui8Frame[2];
+        psFrame->ui16Length = (uint16_t)ui32Payload;
+        psFrame->pui8Payload = psDecoder->pui8Frame + WIRE_HDR_LEN;
+        *pui32Used = ui32Pos;
+        return true;
+    }
+
+    *pui32Used = ui32Pos;
+    return false;
+}
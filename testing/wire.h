@@ -0,0 +1,181 @@
+//*****************************************************************************
+// wire.h
+//
+// Binary framed protocol between the board and a host on the console UART.
+// Frames are length-prefixed and CRC-checked, so a host can pipeline
+// requests at full line rate and resynchronize after noise or a reset.
+//
+//*****************************************************************************
+
+#ifndef __WIRE_H__
+#define __WIRE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blockchain.h"
+#include "chain_log.h"
+
+//*****************************************************************************
+//
+// Frame. All integers are little-endian:
+//
+//   offset  size  field
+//        0     1  WIRE_SYNC
+//        1     1  message type
+//        2     1  sequence number, echoed in the reply; 0 in unsolicited
+//                 frames
+//        3     2  payload length n, at most WIRE_MAX_PAYLOAD
+//        5     n  payload
+//      5+n     4  CRC-32 of bytes 1 .. 4+n
+//
+// A receiver hunts for WIRE_SYNC, and drops the frame and hunts again on a
+// bad length or checksum; text on the line, such as the start-up report,
+// is skipped the same way.
+//
+//*****************************************************************************
+#define WIRE_SYNC               0xA5
+#define WIRE_HDR_LEN            5
+#define WIRE_CRC_LEN            4
+#define WIRE_MAX_PAYLOAD        CHAIN_LOG_RECORD_MAX
+#define WIRE_FRAME_MAX          (WIRE_HDR_LEN + WIRE_MAX_PAYLOAD +           \
+                                 WIRE_CRC_LEN)
+
+//*****************************************************************************
+//
+// Requests (host to board) and their payloads:
+//
+//   WIRE_TX_SUBMIT   priority (4), transaction (BLOCK_TX_LEN)
+//                    -> WIRE_TX_RESULT: MempoolAdd() status (1)
+//   WIRE_GET_BLOCKS  first height (4), count (1)
+//                    -> one WIRE_BLOCK per retained block in the range,
+//                       a log record (chain_log.h), then WIRE_DONE with
+//                       the number of blocks sent (4)
+//   WIRE_GET_TIP     none -> WIRE_HEADER of the tip
+//   WIRE_SUBSCRIBE   1 to stream new headers, 0 to stop -> WIRE_DONE
+//   WIRE_SEAL        none -> the new block's WIRE_HEADER, or WIRE_ERROR
+//                    if the mempool is empty
+//   WIRE_COMMAND     a console command line (console.h), at most
+//                    CONSOLE_LINE_MAX bytes
+//                    -> WIRE_TEXT: ConsoleExecute() status (1), then the
+//                       command's output, cut at WIRE_MAX_PAYLOAD
+//
+// WIRE_HEADER is a serialized header (BLOCK_HEADER_LEN) and the block hash.
+// While subscribed, every block added to the chain is sent as an
+// unsolicited WIRE_HEADER. WIRE_ERROR carries one of the WIRE_ERR_ codes.
+//
+//*****************************************************************************
+#define WIRE_TX_SUBMIT          0x01
+#define WIRE_GET_BLOCKS         0x02
+#define WIRE_GET_TIP            0x03
+#define WIRE_SUBSCRIBE          0x04
+#define WIRE_SEAL               0x05
+#define WIRE_COMMAND            0x06
+
+#define WIRE_REPLY              0x80
+#define WIRE_TX_RESULT          0x81
+#define WIRE_BLOCK              0x82
+#define WIRE_HEADER             0x83
+#define WIRE_DONE               0x84
+#define WIRE_TEXT               0x85
+#define WIRE_ERROR              0x8F
+
+#define WIRE_ERR_TYPE           1
+#define WIRE_ERR_LENGTH         2
+#define WIRE_ERR_NOT_FOUND      3
+#define WIRE_ERR_EMPTY          4
+
+#define WIRE_TX_SUBMIT_LEN      (4 + BLOCK_TX_LEN)
+#define WIRE_GET_BLOCKS_LEN     5
+#define WIRE_HEADER_LEN         (BLOCK_HEADER_LEN + BLOCK_HASH_LEN)
+
+//*****************************************************************************
+//
+// A received frame. The payload points into the decoder and is valid until
+// the next call to WireDecode().
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Type;
+    uint8_t ui8Seq;
+    uint16_t ui16Length;
+    const uint8_t *pui8Payload;
+} tWireFrame;
+
+typedef struct
+{
+    uint32_t ui32Frames;
+    uint32_t ui32CrcErrors;
+    uint32_t ui32LengthErrors;
+    uint32_t ui32Skipped;
+} tWireStats;
+
+typedef struct
+{
+    uint32_t ui32Have;
+    uint32_t ui32Need;
+    uint8_t pui8Frame[WIRE_FRAME_MAX];
+    tWireStats sStats;
+} tWireDecoder;
+
+extern uint32_t WireEncode(uint8_t ui8Type, uint8_t ui8Seq,
+                           const uint8_t *pui8Payload, uint32_t ui32Length,
+                           uint8_t *pui8Frame);
+extern void WireDecoderInit(tWireDecoder *psDecoder);
+extern bool WireDecode(tWireDecoder *psDecoder, const uint8_t *pui8Data,
+                       uint32_t ui32Length, uint32_t *pui32Used,
+                       tWireFrame *psFrame);
+extern void WirePut32(uint8_t *pui8Out, uint32_t ui32Value);
+extern uint32_t WireGet32(const uint8_t *pui8In);
+
+//*****************************************************************************
+//
+// Byte transport, one per build (wire_port.c): the console UART on the
+// board; on the host a pseudo-terminal or serial device. Reads never block.
+//
+//*****************************************************************************
+extern uint32_t WirePortRead(uint8_t *pui8Data, uint32_t ui32Max);
+extern bool WirePortWrite(const uint8_t *pui8Data, uint32_t ui32Length);
+#if !defined(cc3200)
+extern bool WirePortOpen(const char *pcPath);
+extern const char *WirePortName(void);
+extern bool WirePortWait(uint32_t ui32Milliseconds);
+extern void WirePortClose(void);
+#endif
+
+//*****************************************************************************
+//
+// Board side of the protocol (wire_node.c). pfnAppend adds a sealed block
+// to the chain and its log; WIRE_COMMAND lines run on the console
+// interpreter, which WireNodeInit() sets up with the same store.
+//
+//*****************************************************************************
+typedef bool (*tWireAppend)(struct Block *psBlock);
+
+extern void WireNodeInit(tChainStore *psStore, tWireAppend pfnAppend);
+extern void WireNodePoll(void);
+extern void WireNodeBlockAdded(const struct Block *psBlock);
+extern void WireNodeStatsGet(tWireStats *psStats);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WIRE_H__
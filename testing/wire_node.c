@@ -0,0 +1,319 @@
+//*****************************************************************************
+// wire_node.c
+//
+// Board side of the framed protocol: queue submitted transactions, serve
+// blocks and headers from the chain store, seal blocks from the mempool and
+// stream their headers to a subscribed host
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "blockchain.h"
+#include "block_pool.h"
+#include "chain_store.h"
+#include "chain_log.h"
+#include "mempool.h"
+#include "console.h"
+#include "wire.h"
+
+static tChainStore *g_psStore;
+static tWireAppend g_pfnAppend;
+static tWireDecoder g_sDecoder;
+static bool g_bSubscribed;
+
+//
+// Received bytes are taken from the port in chunks of this size; replies
+// are built in place in the transmit frame.
+//
+static uint8_t g_pui8Rx[64];
+static uint8_t g_pui8Tx[WIRE_FRAME_MAX];
+static struct BlockBuilder g_sBuilder;
+
+//
+// Output of a WIRE_COMMAND, gathered apart from the transmit frame since a
+// command that seals a block streams its header while it runs.
+//
+static char g_pcCommand[CONSOLE_LINE_MAX + 1];
+static uint8_t g_pui8Text[WIRE_MAX_PAYLOAD - 1];
+static uint32_t g_ui32TextLength;
+
+#define WIRE_NODE_PAYLOAD       (g_pui8Tx + WIRE_HDR_LEN)
+
+static void
+WireNodeSend(uint8_t ui8Type, uint8_t ui8Seq, uint32_t ui32Length)
+{
+    WirePortWrite(g_pui8Tx, WireEncode(ui8Type, ui8Seq, WIRE_NODE_PAYLOAD,
+                                       ui32Length, g_pui8Tx));
+}
+
+static void
+WireNodeError(uint8_t ui8Seq, uint8_t ui8Code)
+{
+    WIRE_NODE_PAYLOAD[0] = ui8Code;
+    WireNodeSend(WIRE_ERROR, ui8Seq, 1);
+}
+
+static void
+WireNodeHeader(uint8_t ui8Seq, const struct Block *psBlock)
+{
+    block_header_serialize(&psBlock->header, WIRE_NODE_PAYLOAD);
+    memcpy(WIRE_NODE_PAYLOAD + BLOCK_HEADER_LEN, psBlock->hash,
+           BLOCK_HASH_LEN);
+    WireNodeSend(WIRE_HEADER, ui8Seq, WIRE_HEADER_LEN);
+}
+
+//
+// Seal a block from the highest priority transactions in the mempool.
+//
+static struct Block *
+WireNodeSeal(void)
+{
+    struct Block *psBlock;
+
+    if((MempoolCount() == 0) || (g_pfnAppend == NULL) ||
+       (block_begin(&g_sBuilder, ChainStoreTip(g_psStore)) == NULL))
+    {
+        return NULL;
+    }
+    MempoolFillBlock(&g_sBuilder, MEMPOOL_ORDER_PRIORITY);
+    psBlock = block_seal(&g_sBuilder);
+    if(!g_pfnAppend(psBlock))
+    {
+        BlockPoolFree(psBlock);
+        MempoolRestoreFill();
+        return NULL;
+    }
+
+    return psBlock;
+}
+
+static void
+WireNodeGetBlocks(uint8_t ui8Seq, const uint8_t *pui8Payload)
+{
+    uint32_t ui32Height = WireGet32(pui8Payload);
+    uint32_t ui32Count = pui8Payload[4];
+    uint32_t ui32Sent = 0;
+    struct Block *psBlock;
+
+    while((ui32Sent < ui32Count) &&
+          ((psBlock = ChainStoreGet(g_psStore, ui32Height + ui32Sent)) !=
+           NULL))
+    {
+        WireNodeSend(WIRE_BLOCK, ui8Seq,
+                     ChainLogEncode(psBlock, WIRE_NODE_PAYLOAD));
+        ui32Sent++;
+    }
+    WirePut32(WIRE_NODE_PAYLOAD, ui32Sent);
+    WireNodeSend(WIRE_DONE, ui8Seq, 4);
+}
+
+static void
+WireNodeText(void *pvArg, const char *pcText, uint32_t ui32Length)
+{
+    (void)pvArg;
+    if(ui32Length > (sizeof(g_pui8Text) - g_ui32TextLength))
+    {
+        ui32Length = sizeof(g_pui8Text) - g_ui32TextLength;
+    }
+    memcpy(g_pui8Text + g_ui32TextLength, pcText, ui32Length);
+    g_ui32TextLength += ui32Length;
+}
+
+static void
+WireNodeCommand(uint8_t ui8Seq, const uint8_t *pui8Payload,
+                uint32_t ui32Length)
+{
+    memcpy(g_pcCommand, pui8Payload, ui32Length);
+    g_pcCommand[ui32Length] = '\0';
+    g_ui32TextLength = 0;
+    WIRE_NODE_PAYLOAD[0] = (uint8_t)ConsoleExecute(g_pcCommand, WireNodeText,
+                                                   NULL);
+    memcpy(WIRE_NODE_PAYLOAD + 1, g_pui8Text, g_ui32TextLength);
+    WireNodeSend(WIRE_TEXT, ui8Seq, 1 + g_ui32TextLength);
+}
+
+static void
+WireNodeHandle(const tWireFrame *psFrame)
+{
+    //
+    // Payload length of each request; WIRE_COMMAND is checked on its own.
+    //
+    static const uint8_t pui8Len[] =
+    {
+        0, WIRE_TX_SUBMIT_LEN, WIRE_GET_BLOCKS_LEN, 0, 1, 0, 0
+    };
+    struct Block *psBlock;
+
+    if((psFrame->ui8Type == 0) || (psFrame->ui8Type >= sizeof(pui8Len)))
+    {
+        WireNodeError(psFrame->ui8Seq, WIRE_ERR_TYPE);
+        return;
+    }
+    if((psFrame->ui8Type == WIRE_COMMAND) ?
+       ((psFrame->ui16Length == 0) ||
+        (psFrame->ui16Length > CONSOLE_LINE_MAX)) :
+       (psFrame->ui16Length != pui8Len[psFrame->ui8Type]))
+    {
+        WireNodeError(psFrame->ui8Seq, WIRE_ERR_LENGTH);
+        return;
+    }
+
+    switch(psFrame->ui8Type)
+    {
+        case WIRE_TX_SUBMIT:
+        {
+            WIRE_NODE_PAYLOAD[0] =
+                (uint8_t)MempoolAdd(psFrame->pui8Payload + 4, BLOCK_TX_LEN,
+                                    WireGet32(psFrame->pui8Payload));
+            WireNodeSend(WIRE_TX_RESULT, psFrame->ui8Seq, 1);
+            break;
+        }
+
+        case WIRE_GET_BLOCKS:
+        {
+            WireNodeGetBlocks(psFrame->ui8Seq, psFrame->pui8Payload);
+            break;
+        }
+
+        case WIRE_GET_TIP:
+        {
+            psBlock = ChainStoreTip(g_psStore);
+            if(psBlock == NULL)
+            {
+                WireNodeError(psFrame->ui8Seq, WIRE_ERR_NOT_FOUND);
+            }
+            else
+            {
+                WireNodeHeader(psFrame->ui8Seq, psBlock);
+            }
+            break;
+        }
+
+        case WIRE_SUBSCRIBE:
+        {
+            g_bSubscribed = (psFrame->pui8Payload[0] != 0);
+            WireNodeSend(WIRE_DONE, psFrame->ui8Seq, 0);
+            break;
+        }
+
+        case WIRE_SEAL:
+        {
+            psBlock = WireNodeSeal();
+            if(psBlock == NULL)
+            {
+                WireNodeError(psFrame->ui8Seq, WIRE_ERR_EMPTY);
+            }
+            else
+            {
+                WireNodeHeader(psFrame->ui8Seq, psBlock);
+            }
+            break;
+        }
+
+        case WIRE_COMMAND:
+        {
+            WireNodeCommand(psFrame->ui8Seq, psFrame->pui8Payload,
+                            psFrame->ui16Length);
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Start serving the protocol
+//!
+//! \param psStore is the chain store to serve from
+//! \param pfnAppend adds a sealed block to the chain and its log
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WireNodeInit(tChainStore *psStore, tWireAppend pfnAppend)
+{
+    g_psStore = psStore;
+    g_pfnAppend = pfnAppend;
+    g_bSubscribed = false;
+    WireDecoderInit(&g_sDecoder);
+    ConsoleInit(psStore, pfnAppend);
+}
+
+//*****************************************************************************
+//
+//! Handle every request waiting on the port, then seal a block if the
+//! mempool holds a full one. Never blocks on input.
+//!
+//! \param None
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WireNodePoll(void)
+{
+    uint32_t ui32Read, ui32Pos, ui32Used;
+    tWireFrame sFrame;
+
+    if(g_psStore == NULL)
+    {
+        return;
+    }
+
+    while((ui32Read = WirePortRead(g_pui8Rx, sizeof(g_pui8Rx))) != 0)
+    {
+        for(ui32Pos = 0; ui32Pos < ui32Read; ui32Pos += ui32Used)
+        {
+            if(WireDecode(&g_sDecoder, g_pui8Rx + ui32Pos, ui32Read - ui32Pos,
+                          &ui32Used, &sFrame))
+            {
+                WireNodeHandle(&sFrame);
+            }
+        }
+    }
+
+    while(MempoolCount() >= BLOCK_MAX_TX)
+    {
+        if(WireNodeSeal() == NULL)
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Stream a new block's header to a subscribed host
+//!
+//! \param psBlock is the block just added to the chain
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WireNodeBlockAdded(const struct Block *psBlock)
+{
+    if(g_bSubscribed)
+    {
+        WireNodeHeader(0, psBlock);
+    }
+}
+
+//*****************************************************************************
+//
+//! Read the framing counters of the receive side
+//!
+//! \param psStats receives the counters
+//!
+//! \return None
+//
+//*****************************************************************************
+void
+WireNodeStatsGet(tWireStats *psStats)
+{
+    *psStats = g_sDecoder.sStats;
+}
@@ -0,0 +1,238 @@
+//*****************************************************************************
+// wire_port.c
+//
+// Byte transport for the framed protocol
+//
+// On the board this is the console UART (UARTA0) through its rings
+// (uart_buf.h): reads take what the receive interrupt has gathered, and
+// writes return once a frame is queued for the transmit DMA. On the host it is a file
+// descriptor: either a serial device attached to a board, or the master
+// side of a new pseudo-terminal, whose slave name a peer opens as if it
+// were the board's serial port.
+//
+//*****************************************************************************
+
+#if !defined(cc3200)
+//
+// posix_openpt() and the other pseudo-terminal calls are XSI; cfmakeraw()
+// is BSD.
+//
+#define _XOPEN_SOURCE           600
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(cc3200)
+#include "uart_buf.h"
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "wire.h"
+
+#if defined(cc3200)
+//*****************************************************************************
+//
+// Board: console UART
+//
+//*****************************************************************************
+uint32_t
+WirePortRead(uint8_t *pui8Data, uint32_t ui32Max)
+{
+    return UartBufRead(pui8Data, ui32Max);
+}
+
+bool
+WirePortWrite(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    return UartBufWrite(pui8Data, ui32Length);
+}
+#else
+//*****************************************************************************
+//
+// Host: serial device or pseudo-terminal
+//
+//*****************************************************************************
+static int g_iPortFd = -1;
+
+//
+// Kept open so that the master side of a pseudo-terminal does not report
+// an error while no peer has the slave open.
+//
+static int g_iSlaveFd = -1;
+static char g_pcPortName[64];
+
+static void
+WirePortRaw(int iFd)
+{
+    struct termios sTerm;
+
+    if(tcgetattr(iFd, &sTerm) == 0)
+    {
+        cfmakeraw(&sTerm);
+        cfsetispeed(&sTerm, B921600);
+        cfsetospeed(&sTerm, B921600);
+        tcsetattr(iFd, TCSANOW, &sTerm);
+    }
+}
+
+//*****************************************************************************
+//
+//! Open the transport
+//!
+//! \param pcPath is a serial device, or NULL to create a pseudo-terminal
+//! whose slave name WirePortName() then returns
+//!
+//! \return false if the device cannot be opened
+//
+//*****************************************************************************
+bool
+WirePortOpen(const char *pcPath)
+{
+    const char *pcSlave;
+
+    WirePortClose();
+    if(pcPath != NULL)
+    {
+        g_iPortFd = open(pcPath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if(g_iPortFd < 0)
+        {
+            return false;
+        }
+        WirePortRaw(g_iPortFd);
+        snprintf(g_pcPortName, sizeof(g_pcPortName), "%s", pcPath);
+        return true;
+    }
+
+    g_iPortFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if((g_iPortFd < 0) || (grantpt(g_iPortFd) != 0) ||
+       (unlockpt(g_iPortFd) != 0) || ((pcSlave = ptsname(g_iPortFd)) == NULL))
+    {
+        WirePortClose();
+        return false;
+    }
+    snprintf(g_pcPortName, sizeof(g_pcPortName), "%s", pcSlave);
+    g_iSlaveFd = open(g_pcPortName, O_RDWR | O_NOCTTY);
+    if(g_iSlaveFd >= 0)
+    {
+        WirePortRaw(g_iSlaveFd);
+    }
+    fcntl(g_iPortFd, F_SETFL, fcntl(g_iPortFd, F_GETFL) | O_NONBLOCK);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Name of the open device: for a pseudo-terminal, the slave a peer opens
+//!
+//! \param None
+//!
+//! \return the device name
+//
+//*****************************************************************************
+const char *
+WirePortName(void)
+{
+    return g_pcPortName;
+}
+
+uint32_t
+WirePortRead(uint8_t *pui8Data, uint32_t ui32Max)
+{
+    ssize_t iRead;
+
+    if(g_iPortFd < 0)
+    {
+        return 0;
+    }
+    iRead = read(g_iPortFd, pui8Data, ui32Max);
+
+    return (iRead > 0) ? (uint32_t)iRead : 0;
+}
+
+bool
+WirePortWrite(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    struct pollfd sPoll;
+    ssize_t iWritten;
+
+    if(g_iPortFd < 0)
+    {
+        return false;
+    }
+
+    while(ui32Length != 0)
+    {
+        iWritten = write(g_iPortFd, pui8Data, ui32Length);
+        if(iWritten > 0)
+        {
+            pui8Data += iWritten;
+            ui32Length -= (uint32_t)iWritten;
+            continue;
+        }
+        if((iWritten < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            return false;
+        }
+
+        //
+        // Output is full: wait for room, as the board waits on its FIFO.
+        //
+        sPoll.fd = g_iPortFd;
+        sPoll.events = POLLOUT;
+        poll(&sPoll, 1, 100);
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+//! Wait for received data
+//!
+//! \param ui32Milliseconds is the longest wait
+//!
+//! \return true if data is waiting
+//
+//*****************************************************************************
+bool
+WirePortWait(uint32_t ui32Milliseconds)
+{
+    struct pollfd sPoll;
+
+    if(g_iPortFd < 0)
+    {
+        return false;
+    }
+    sPoll.fd = g_iPortFd;
+    sPoll.events = POLLIN;
+
+    return (poll(&sPoll, 1, (int)ui32Milliseconds) > 0) &&
+           (sPoll.revents & POLLIN);
+}
+
+void
+WirePortClose(void)
+{
+    if(g_iSlaveFd >= 0)
+    {
+        close(g_iSlaveFd);
+        g_iSlaveFd = -1;
+    }
+    if(g_iPortFd >= 0)
+    {
+        close(g_iPortFd);
+        g_iPortFd = -1;
+    }
+}
+#endif